@@ -0,0 +1,297 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// bbformats-bench [--entries N] [--entry-size BYTES] [--rounds N] [--level N] [--format NAME]
+//                 [--threads N]
+// runs every format of the merge stack over a synthetic vanilla file and two mods of it, no game
+// files needed, and prints one json document to compare between commits. peak rss is the process
+// high water mark after each format, --format runs a single one for numbers of its own. --threads
+// is the engine's budget like bbl-merge -j, BND4 merges its entries on that many threads
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "modules/BBFormats/Bnd.h"
+#include "modules/BBFormats/Dcx.h"
+#include "modules/BBFormats/Emevd.h"
+#include "modules/BBFormats/Esd.h"
+#include "modules/BBFormats/Fmg.h"
+#include "modules/BBFormats/FormatRegistry.h"
+#include "modules/BBFormats/GameParam.h"
+#include "modules/BBFormats/Msb.h"
+#include "modules/BBFormats/Tpf.h"
+#include "modules/MergeEngine.h"
+#include "settings/updater/BuildInfo.h"
+#include "synthetic_formats.h"
+
+using namespace FileHelper;
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// the formats report problems through the log, an error line fails the round trip
+class CountingLogger : public MergeLogger {
+public:
+    void Write(const QString&, Format format) override {
+        if (format == Format::BoldRed) {
+            errors++;
+        }
+    }
+
+    std::atomic<int> errors = 0;
+};
+
+// the corpus is built to merge cleanly, so any prompt is counted
+class CountingPolicy : public PriorityPolicy {
+public:
+    ModPriority Decide(const std::string&, const std::string&,
+                       const std::vector<std::string>&) override {
+        prompts++;
+        return ModPriority::Mod1;
+    }
+
+    std::atomic<int> prompts = 0;
+};
+
+struct ParseRepackTimes {
+    double parse;
+    double repack;
+};
+
+template <typename Format, bool (Format::*Repack)(std::vector<char>&)>
+ParseRepackTimes ParseRepack(std::span<const char> data, const std::string& name,
+                             MergeEngine* engine, std::vector<char>& output) {
+    auto parse = [&] {
+        if constexpr (std::is_constructible_v<Format, std::span<const char>, const std::string&,
+                                              MergeEngine*>) {
+            return Format(data, name, engine);
+        } else {
+            return Format(data, engine);
+        }
+    };
+
+    auto start = Clock::now();
+    Format parsed = parse();
+    auto parsedAt = Clock::now();
+    output.clear();
+    (parsed.*Repack)(output);
+    return {Seconds(start, parsedAt), Seconds(parsedAt, Clock::now())};
+}
+
+struct BenchFormat {
+    const char* name;
+    const char* entryName;
+    std::vector<char> (*generate)(const Synthetic::Shape&, int);
+    ParseRepackTimes (*parseRepack)(std::span<const char>, const std::string&, MergeEngine*,
+                                    std::vector<char>&);
+    size_t maxEntries = SIZE_MAX;
+};
+
+constexpr BenchFormat formats[] = {
+    {"BND4", "bench.bnd", &Synthetic::Bnd, &ParseRepack<Bnd, &Bnd::RepackBnd>},
+    {"TPF", "bench.tpf", &Synthetic::Tpf, &ParseRepack<Tpf, &Tpf::RepackTpf>},
+    {"FMG", "bench.fmg", &Synthetic::Fmg, &ParseRepack<Fmg, &Fmg::RepackFmg>},
+    // the row count is 16 bits and the second mod adds a row
+    {"PARAM", "bench.param", &Synthetic::Param,
+     &ParseRepack<GameParam, &GameParam::RepackGameParam>, 0xFFFE},
+    {"EMEVD", "bench.emevd", &Synthetic::Emevd, &ParseRepack<Emevd, &Emevd::RepackEmevd>},
+    {"ESD", "bench.esd", &Synthetic::Esd, &ParseRepack<Esd, &Esd::RepackEsd>},
+    {"MSB", "bench.msb", &Synthetic::Msb, &ParseRepack<Msb, &Msb::RepackMsb>},
+};
+
+struct Options {
+    Synthetic::Shape shape;
+    int rounds = 5;
+    int level = 9;
+    int threads = 0;
+    std::string only;
+};
+
+// best of the rounds for each stage, like checksum-bench
+struct Stage {
+    double best = 0.0;
+
+    void Add(double seconds) {
+        best = best == 0.0 ? seconds : std::min(best, seconds);
+    }
+};
+
+size_t PeakRssKiB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void WriteFile(const fs::path& path, const std::vector<char>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+}
+
+void PrintStage(const char* name, const Stage& stage, size_t bytes, size_t entries) {
+    std::printf(",\n      \"%s\": {\"seconds\": %.6f, \"mb_per_s\": %.2f", name, stage.best,
+                bytes / stage.best / 1e6);
+    if (entries) {
+        std::printf(", \"entries_per_s\": %.0f", entries / stage.best);
+    }
+    std::printf("}");
+}
+
+bool RunFormat(const BenchFormat& format, const Options& options, const fs::path& workFolder,
+               bool first) {
+    CountingLogger logger;
+    CountingPolicy policy;
+    MergeEngine engine({.threads = options.threads}, logger, policy);
+
+    Synthetic::Shape shape = options.shape;
+    shape.entries = std::min(shape.entries, format.maxEntries);
+    const std::vector<char> vanilla = format.generate(shape, 0);
+    const std::vector<char> mod1 = format.generate(shape, 1);
+    const std::vector<char> mod2 = format.generate(shape, 2);
+    const std::vector<char> vanillaDcx = Synthetic::Dcx(vanilla, options.level);
+    const fs::path dcxPath = workFolder / (std::string(format.entryName) + ".dcx");
+
+    const FormatHandler* handler = DetectFormat(vanilla, format.entryName);
+    Stage unpack, parse, merge, repack, recompress;
+    std::vector<char> repacked;
+    std::vector<char> merged;
+    bool roundTrip = handler != nullptr;
+    bool mergedOk = handler != nullptr;
+    bool dcxRoundTrip = true;
+
+    for (int round = 0; handler && round < options.rounds; round++) {
+        WriteFile(dcxPath, vanillaDcx);
+        Dcx dcx(&engine);
+        dcx.SetDeflateOptions({.level = options.level});
+
+        std::vector<char> payload;
+        auto start = Clock::now();
+        dcxRoundTrip &= dcx.UnpackDcx(dcxPath, payload);
+        unpack.Add(Seconds(start, Clock::now()));
+        dcxRoundTrip &= payload == vanilla;
+
+        ParseRepackTimes times = format.parseRepack(payload, format.entryName, &engine, repacked);
+        parse.Add(times.parse);
+        repack.Add(times.repack);
+        roundTrip &= repacked == vanilla;
+
+        merged = vanilla;
+        start = Clock::now();
+        mergedOk &= handler->merge(merged, mod1, mod2, format.entryName, &engine);
+        merge.Add(Seconds(start, Clock::now()));
+
+        start = Clock::now();
+        dcxRoundTrip &= dcx.RepackDcx(merged);
+        recompress.Add(Seconds(start, Clock::now()));
+
+        std::vector<char> reread;
+        Dcx check(&engine);
+        dcxRoundTrip &= check.UnpackDcx(dcxPath, reread) && reread == merged;
+    }
+
+    roundTrip &= logger.errors == 0;
+    std::printf("%s    {\n      \"format\": \"%s\",\n      \"bytes\": %zu,\n", first ? "" : ",\n",
+                format.name, vanilla.size());
+    std::printf("      \"entries\": %zu,\n      \"round_trip\": %s,\n", shape.entries,
+                roundTrip ? "true" : "false");
+    std::printf("      \"dcx_round_trip\": %s,\n      \"merged\": %s,\n",
+                dcxRoundTrip ? "true" : "false", mergedOk ? "true" : "false");
+    std::printf("      \"merged_bytes\": %zu,\n      \"prompts\": %d,\n      \"errors\": %d",
+                merged.size(), policy.prompts.load(), logger.errors.load());
+    if (handler) {
+        PrintStage("unpack", unpack, vanilla.size(), 0);
+        PrintStage("parse", parse, vanilla.size(), shape.entries);
+        PrintStage("merge", merge, vanilla.size(), shape.entries);
+        PrintStage("repack", repack, repacked.size(), shape.entries);
+        PrintStage("recompress", recompress, merged.size(), 0);
+
+        // what the engine spent handing lines to the logger, per round
+        MergeEngine::LogStats logStats = engine.GetLogStats();
+        std::printf(",\n      \"log\": {\"lines\": %llu, \"seconds\": %.6f}",
+                    static_cast<unsigned long long>(logStats.lines / options.rounds),
+                    logStats.seconds / options.rounds);
+    }
+    std::printf(",\n      \"peak_rss_kib\": %zu\n    }", PeakRssKiB());
+
+    return roundTrip && dcxRoundTrip && mergedOk;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--entries") {
+            options.shape.entries = std::max<size_t>(1, std::strtoul(value, nullptr, 10));
+        } else if (flag == "--entry-size") {
+            options.shape.entrySize = std::max<size_t>(1, std::strtoul(value, nullptr, 10));
+        } else if (flag == "--rounds") {
+            options.rounds = std::max(1, std::atoi(value));
+        } else if (flag == "--level") {
+            options.level = std::clamp(std::atoi(value), 0, 9);
+        } else if (flag == "--threads") {
+            options.threads = std::max(0, std::atoi(value));
+        } else if (flag == "--format") {
+            options.only = value;
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::error_code ec;
+    fs::path workFolder = fs::temp_directory_path() / "bbformats-bench";
+    fs::create_directories(workFolder, ec);
+
+    std::printf("{\n  \"revision\": \"%s\",\n  \"entries\": %zu,\n  \"entry_size\": %zu,\n",
+                Build::Rev, options.shape.entries, options.shape.entrySize);
+    std::printf("  \"rounds\": %d,\n  \"level\": %d,\n  \"threads\": %d,\n  \"formats\": [\n",
+                options.rounds, options.level, options.threads);
+
+    bool passed = true;
+    bool first = true;
+    for (const BenchFormat& format : formats) {
+        if (!options.only.empty() && options.only != format.name) {
+            continue;
+        }
+        passed &= RunFormat(format, options, workFolder, first);
+        first = false;
+    }
+    std::printf("\n  ]\n}\n");
+
+    fs::remove_all(workFolder, ec);
+    return passed ? 0 : 1;
+}
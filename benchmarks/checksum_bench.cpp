@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// checksum-bench [size in MiB]: throughput of each checksum kernel over a random buffer
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <miniz.h>
+
+#include "modules/Checksum.h"
+
+namespace {
+
+// volatile sink so the kernels are not optimised away
+volatile uint64_t sink = 0;
+
+template <typename Kernel>
+void Run(const char* name, const std::vector<char>& data, Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int rounds = 5;
+
+    kernel(); // warm up
+    double best = 0.0;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = Clock::now();
+        sink = sink + kernel();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+
+    std::printf("%-16s %8.2f GB/s\n", name, data.size() / best / 1e9);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t sizeMiB = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    std::vector<char> data(sizeMiB * 1024 * 1024);
+
+    std::mt19937_64 rng(0xBB);
+    for (char& byte : data) {
+        byte = static_cast<char>(rng());
+    }
+
+    if (Checksum::Adler32(data) != Checksum::Adler32Scalar(data)) {
+        std::printf("adler32 simd and scalar paths disagree\n");
+        return 1;
+    }
+
+    std::printf("buffer: %zu MiB\n", sizeMiB);
+    Run("adler32", data, [&] { return Checksum::Adler32(data); });
+    Run("adler32 scalar", data, [&] { return Checksum::Adler32Scalar(data); });
+    Run("adler32 miniz", data, [&] {
+        return mz_adler32(1, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    });
+    Run("hash64", data, [&] { return Checksum::Hash64(data); });
+    Run("sha256", data, [&] { return uint64_t{Checksum::Sha256(data)[0]}; });
+    return 0;
+}
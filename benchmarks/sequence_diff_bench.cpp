@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// sequence-diff-bench [events]: instruction diffs and three-way merges over synthetic event
+// scripts, from light mod edits to rewritten events, against the quadratic lcs table
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "modules/BBFormats/SequenceDiff.h"
+
+using FileHelper::DiffHunk;
+
+namespace {
+
+// instructions are stood in for by their token hashes, the way Emevd compares them
+using Script = std::vector<uint64_t>;
+
+// volatile sink so the passes are not optimised away
+volatile size_t sink = 0;
+
+struct Corpus {
+    std::vector<Script> base;
+    std::vector<Script> mod1;
+    std::vector<Script> mod2;
+};
+
+// mods insert, delete or rewrite `edits` instructions per event, mod1 in the first half of each
+// event and mod2 in the second so the merges come out clean
+Script Edit(std::mt19937_64& rng, const Script& base, size_t from, size_t to, int edits) {
+    Script mod = base;
+    for (int i = 0; i < edits && to > from; i++) {
+        size_t at = from + rng() % (to - from);
+        switch (rng() % 3) {
+        case 0:
+            mod.insert(mod.begin() + at, rng());
+            to++;
+            break;
+        case 1:
+            mod.erase(mod.begin() + at);
+            to--;
+            break;
+        default:
+            mod[at] = rng();
+            break;
+        }
+    }
+    return mod;
+}
+
+Corpus Generate(size_t events, size_t length, int edits) {
+    std::mt19937_64 rng(0xBB20);
+    Corpus corpus;
+    for (size_t e = 0; e < events; e++) {
+        Script base(length / 2 + rng() % (length + 1));
+        for (uint64_t& token : base) {
+            token = rng() % 64; // few distinct instructions, like real scripts
+        }
+        size_t half = base.size() / 2;
+        corpus.mod1.push_back(Edit(rng, base, 0, half, edits));
+        corpus.mod2.push_back(Edit(rng, base, half + 1, base.size(), edits));
+        corpus.base.push_back(std::move(base));
+    }
+    return corpus;
+}
+
+// textbook lcs table, the baseline and the check that the diffs are minimal
+size_t LcsEdits(const Script& a, const Script& b) {
+    std::vector<uint32_t> row(b.size() + 1, 0);
+    for (size_t i = 1; i <= a.size(); i++) {
+        uint32_t diagonal = 0;
+        for (size_t j = 1; j <= b.size(); j++) {
+            uint32_t up = row[j];
+            row[j] = a[i - 1] == b[j - 1] ? diagonal + 1 : std::max(row[j], row[j - 1]);
+            diagonal = up;
+        }
+    }
+    return a.size() + b.size() - 2 * row[b.size()];
+}
+
+size_t HunkEdits(const std::vector<DiffHunk>& hunks) {
+    size_t edits = 0;
+    for (const DiffHunk& hunk : hunks) {
+        edits += (hunk.baseEnd - hunk.baseBegin) + (hunk.modEnd - hunk.modBegin);
+    }
+    return edits;
+}
+
+template <typename Kernel>
+double Best(Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int rounds = 5;
+
+    double best = 0.0;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = Clock::now();
+        kernel();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+bool Run(size_t events, size_t length, int edits) {
+    Corpus corpus = Generate(events, length, edits);
+
+    size_t clean = 0;
+    for (size_t e = 0; e < events; e++) {
+        auto hunks = FileHelper::Diff<uint64_t>(corpus.base[e], corpus.mod1[e]);
+        if (HunkEdits(hunks) != LcsEdits(corpus.base[e], corpus.mod1[e])) {
+            std::printf("event %zu: diff is not minimal\n", e);
+            return false;
+        }
+        clean += FileHelper::ThreeWayMerge<uint64_t>(corpus.base[e], corpus.mod1[e],
+                                                     corpus.mod2[e])
+                     .clean;
+    }
+
+    double diff = Best([&] {
+        for (size_t e = 0; e < events; e++) {
+            sink = sink + FileHelper::Diff<uint64_t>(corpus.base[e], corpus.mod1[e]).size();
+        }
+    });
+    double merge = Best([&] {
+        for (size_t e = 0; e < events; e++) {
+            sink = sink + FileHelper::ThreeWayMerge<uint64_t>(corpus.base[e], corpus.mod1[e],
+                                                              corpus.mod2[e])
+                              .merged.size();
+        }
+    });
+    double lcs = Best([&] {
+        for (size_t e = 0; e < events; e++) {
+            sink = sink + LcsEdits(corpus.base[e], corpus.mod1[e]);
+        }
+    });
+
+    std::printf("%6zu %8d %10.3f %10.3f %10.3f %8zu/%zu\n", length, edits, diff * 1e3,
+                merge * 1e3, lcs * 1e3, clean, events);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+
+    std::printf("events: %zu, times in ms per pass over all events\n", events);
+    std::printf("%6s %8s %10s %10s %10s %10s\n", "length", "edits", "diff", "merge3", "lcs",
+                "clean");
+    for (auto [length, edits] : {std::pair{16, 1}, {16, 4}, {64, 1}, {64, 8}, {256, 2},
+                                 {256, 32}, {1024, 4}}) {
+        if (!Run(events, length, edits)) {
+            return 1;
+        }
+    }
+    return 0;
+}
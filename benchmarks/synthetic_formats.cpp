@@ -0,0 +1,837 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <miniz.h>
+
+#include "synthetic_formats.h"
+
+namespace Synthetic {
+
+namespace {
+
+// little endian by default, offsets are patched in once the data they point at is placed
+class Bytes {
+public:
+    template <typename T>
+    void Put(T value) {
+        char raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        data.insert(data.end(), raw, raw + sizeof(T));
+    }
+
+    template <typename T>
+    void PutBig(T value) {
+        char raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        data.insert(data.end(), std::rbegin(raw), std::rend(raw));
+    }
+
+    template <typename T>
+    void Patch(size_t at, T value) {
+        std::memcpy(data.data() + at, &value, sizeof(T));
+    }
+
+    void PutBytes(std::span<const char> bytes) {
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    }
+
+    void PutMagic(const char* magic, size_t size) {
+        data.insert(data.end(), magic, magic + size);
+    }
+
+    void PutUtf16(std::u16string_view text) {
+        for (char16_t ch : text) {
+            Put<uint16_t>(ch);
+        }
+        Put<uint16_t>(0);
+    }
+
+    void Fill(size_t count, char value = 0) {
+        data.insert(data.end(), count, value);
+    }
+
+    void Pad(size_t alignment) {
+        Fill((alignment - data.size() % alignment) % alignment);
+    }
+
+    size_t Size() const {
+        return data.size();
+    }
+
+    std::vector<char> data;
+};
+
+std::u16string Widen(const std::string& ascii) {
+    return std::u16string(ascii.begin(), ascii.end());
+}
+
+// every call reseeds, so a mod shares all the bytes it does not change with the vanilla file
+std::vector<char> RandomBytes(std::mt19937& rng, size_t size) {
+    std::vector<char> bytes(size);
+    for (char& byte : bytes) {
+        byte = static_cast<char>(rng());
+    }
+    return bytes;
+}
+
+struct ParamRow {
+    int32_t id;
+    std::u16string name;
+    std::vector<char> data;
+};
+
+std::vector<char> WriteParam(const std::vector<ParamRow>& rows) {
+    Bytes out;
+    out.Put<uint32_t>(0); // strings offset
+    out.Put<int16_t>(0);
+    out.Put<int16_t>(0);
+    out.Put<int16_t>(1);
+    out.Put<int16_t>(static_cast<int16_t>(rows.size()));
+    std::string paramType = "EQUIP_PARAM_WEAPON_ST";
+    paramType.resize(0x20);
+    out.PutMagic(paramType.data(), paramType.size());
+    out.PutMagic("\x00\x04\x01\x00", 4);
+    out.Fill(16);
+
+    size_t rowTable = out.Size();
+    out.Fill(24 * rows.size());
+    out.Patch<int64_t>(0x30, out.Size());
+
+    std::vector<int64_t> dataOffsets;
+    for (const ParamRow& row : rows) {
+        dataOffsets.push_back(out.Size());
+        out.PutBytes(row.data);
+    }
+
+    out.Patch<uint32_t>(0, static_cast<uint32_t>(out.Size()));
+    out.Put<uint16_t>(0);
+    std::vector<int64_t> nameOffsets;
+    for (const ParamRow& row : rows) {
+        nameOffsets.push_back(out.Size());
+        out.PutUtf16(row.name);
+    }
+    out.Put<uint16_t>(0);
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        size_t at = rowTable + 24 * i;
+        out.Patch<int32_t>(at, rows[i].id);
+        out.Patch<int64_t>(at + 8, dataOffsets[i]);
+        out.Patch<int64_t>(at + 16, nameOffsets[i]);
+    }
+
+    return std::move(out.data);
+}
+
+size_t RowSize(const Shape& shape) {
+    return std::max<size_t>(16, shape.entrySize / 4 * 4);
+}
+
+} // namespace
+
+std::vector<char> Param(const Shape& shape, int variant) {
+    std::mt19937 rng(0xBB01);
+    size_t rowSize = RowSize(shape);
+
+    std::vector<ParamRow> rows;
+    for (size_t i = 0; i < shape.entries; i++) {
+        ParamRow row{static_cast<int32_t>(i * 100), Widen("row" + std::to_string(i)),
+                     RandomBytes(rng, rowSize)};
+        if (variant == 1 && i % 5 == 0) {
+            row.data.assign(rowSize, 0x11);
+        } else if (variant == 2 && i % 5 == 1) {
+            row.data.assign(rowSize, 0x22);
+        }
+        rows.push_back(std::move(row));
+    }
+
+    if (variant == 2) {
+        rows.push_back({10'000'000, u"added", std::vector<char>(rowSize, 0x33)});
+    }
+
+    return WriteParam(rows);
+}
+
+std::vector<char> Bnd(const Shape& shape, int variant) {
+    std::mt19937 rng(0xBB02);
+    size_t rowSize = RowSize(shape);
+
+    struct File {
+        int32_t id;
+        std::u16string name;
+        std::vector<char> data;
+    };
+
+    // each entry is a small param. both mods change a different row of every third entry, which
+    // takes the nested merge, and whole entries of their own elsewhere
+    std::vector<File> files;
+    for (size_t i = 0; i < shape.entries; i++) {
+        std::vector<ParamRow> rows;
+        for (size_t j = 0; j < 3 + i % 3; j++) {
+            rows.push_back({static_cast<int32_t>(j), Widen("r" + std::to_string(j)),
+                            RandomBytes(rng, rowSize)});
+        }
+
+        if (variant != 0 && i % 3 == 0) {
+            rows[variant - 1].data.assign(rowSize, static_cast<char>(0x30 + variant));
+        } else if (variant == 1 && i % 5 == 1) {
+            rows.resize(2);
+        } else if (variant == 2 && i % 5 == 2) {
+            rows.pop_back();
+        }
+
+        files.push_back({static_cast<int32_t>(i),
+                         Widen("N:\\SPRJ\\data\\INTERROOT_ps4\\param\\gameparam\\P" +
+                               std::to_string(i) + ".param"),
+                         WriteParam(rows)});
+    }
+
+    if (variant == 2) {
+        files.push_back({100'000, u"N:\\SPRJ\\data\\INTERROOT_ps4\\param\\gameparam\\Added.param",
+                         WriteParam({{1, u"added", std::vector<char>(rowSize, 0x33)}})});
+    }
+
+    Bytes out;
+    out.PutMagic("BND4\0\0\0\0\0\0\1\0", 12);
+    out.Put<int32_t>(static_cast<int32_t>(files.size()));
+    out.Put<int64_t>(0x40);
+    out.PutMagic("07D7R6\0\0", 8);
+    out.Put<int64_t>(0x24);
+    out.Put<int64_t>(0); // headers end
+    out.PutMagic("\x01\x74\0\0\0\0\0\0", 8);
+    out.Put<int64_t>(0);
+
+    size_t entryTable = out.Size();
+    out.Fill(0x24 * files.size());
+
+    std::vector<int32_t> nameOffsets;
+    for (const File& file : files) {
+        nameOffsets.push_back(static_cast<int32_t>(out.Size()));
+        out.PutUtf16(file.name);
+    }
+    out.Patch<int64_t>(40, out.Size());
+
+    std::vector<int32_t> dataOffsets;
+    for (const File& file : files) {
+        out.Pad(16);
+        dataOffsets.push_back(static_cast<int32_t>(out.Size()));
+        out.PutBytes(file.data);
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        size_t at = entryTable + 0x24 * i;
+        out.Patch<uint8_t>(at, 0x40);
+        out.Patch<int32_t>(at + 4, -1);
+        out.Patch<int64_t>(at + 8, files[i].data.size());
+        out.Patch<int64_t>(at + 16, files[i].data.size());
+        out.Patch<int32_t>(at + 24, dataOffsets[i]);
+        out.Patch<int32_t>(at + 28, files[i].id);
+        out.Patch<int32_t>(at + 32, nameOffsets[i]);
+    }
+
+    return std::move(out.data);
+}
+
+std::vector<char> Tpf(const Shape& shape, int variant) {
+    std::mt19937 rng(0xBB03);
+
+    std::vector<std::pair<std::u16string, std::vector<char>>> textures;
+    for (size_t i = 0; i < shape.entries; i++) {
+        std::vector<char> data = RandomBytes(rng, shape.entrySize + 16 * (i % 5));
+        if (variant == 1 && i % 3 == 0) {
+            data.assign(shape.entrySize, 0x01);
+        } else if (variant == 2 && i % 3 == 1) {
+            data.assign(shape.entrySize, 0x02);
+        }
+        textures.emplace_back(Widen("tex_" + std::to_string(i)), std::move(data));
+    }
+
+    Bytes out;
+    out.PutMagic("TPF\0", 4);
+    out.Put<int32_t>(0); // data size
+    out.Put<int32_t>(static_cast<int32_t>(textures.size()));
+    out.PutMagic("\x04\x00\x01\x00", 4);
+
+    size_t entryTable = out.Size();
+    out.Fill(36 * textures.size());
+
+    std::vector<uint32_t> nameOffsets;
+    for (const auto& texture : textures) {
+        nameOffsets.push_back(static_cast<uint32_t>(out.Size()));
+        out.PutUtf16(texture.first);
+    }
+    out.Pad(16);
+
+    size_t dataStart = out.Size();
+    std::vector<uint32_t> dataOffsets;
+    for (const auto& texture : textures) {
+        if (!texture.second.empty()) {
+            out.Pad(4);
+        }
+        dataOffsets.push_back(static_cast<uint32_t>(out.Size()));
+        out.PutBytes(texture.second);
+    }
+    out.Patch<int32_t>(4, static_cast<int32_t>(out.Size() - dataStart));
+
+    for (size_t i = 0; i < textures.size(); i++) {
+        size_t at = entryTable + 36 * i;
+        out.Patch<uint32_t>(at, dataOffsets[i]);
+        out.Patch<uint32_t>(at + 4, static_cast<uint32_t>(textures[i].second.size()));
+        out.Patch<uint32_t>(at + 8, 0x00010066);
+        out.Patch<int16_t>(at + 12, 256);
+        out.Patch<int16_t>(at + 14, 256);
+        out.Patch<int32_t>(at + 16, 1);
+        out.Patch<int32_t>(at + 20, 0xD);
+        out.Patch<uint32_t>(at + 24, nameOffsets[i]);
+        out.Patch<int32_t>(at + 28, 0);
+        out.Patch<int32_t>(at + 32, 98);
+    }
+
+    return std::move(out.data);
+}
+
+std::vector<char> Fmg(const Shape& shape, int variant) {
+    // ids come in runs of four so the groups table has something to do, every 13th is empty
+    std::vector<std::pair<int32_t, std::u16string>> entries;
+    std::u16string filler(std::max<size_t>(1, shape.entrySize / 2), u'x');
+    for (size_t i = 0; i < shape.entries; i++) {
+        int32_t id = static_cast<int32_t>(i / 4 * 10 + i % 4);
+        std::u16string text;
+        if (id % 13 != 0) {
+            text = Widen("Text " + std::to_string(i) + " ") + (i % 7 == 0 ? u"ü€😀 " : u"") + filler;
+            if (variant == 1 && id % 5 == 0) {
+                text += u" m1";
+            } else if (variant == 2 && id % 5 == 1) {
+                text += u" m2";
+            }
+        }
+        entries.emplace_back(id, std::move(text));
+    }
+
+    if (variant != 0) {
+        entries.emplace_back(1'000'000 + variant, variant == 1 ? u"new1" : u"new2");
+    }
+
+    struct Group {
+        int32_t firstIndex;
+        int32_t firstId;
+        int32_t lastId;
+    };
+
+    std::vector<Group> groups;
+    for (size_t i = 0; i < entries.size();) {
+        size_t j = i;
+        while (j + 1 < entries.size() && entries[j + 1].first == entries[j].first + 1) {
+            j++;
+        }
+        groups.push_back({static_cast<int32_t>(i), entries[i].first, entries[j].first});
+        i = j + 1;
+    }
+
+    Bytes out;
+    out.PutMagic("\0\0\2\0", 4);
+    out.Put<int32_t>(0); // file size
+    out.PutMagic("\1\0\0\0", 4);
+    out.Put<int32_t>(static_cast<int32_t>(groups.size()));
+    out.Put<int32_t>(static_cast<int32_t>(entries.size()));
+    out.Put<int32_t>(0xFF);
+    out.Fill(16);
+
+    for (const Group& group : groups) {
+        out.Put<int32_t>(group.firstIndex);
+        out.Put<int32_t>(group.firstId);
+        out.Put<int32_t>(group.lastId);
+        out.Put<int32_t>(0);
+    }
+
+    size_t stringOffsets = out.Size();
+    out.Patch<int64_t>(0x18, stringOffsets);
+    out.Fill(8 * entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries[i].second.empty()) {
+            out.Patch<int64_t>(stringOffsets + 8 * i, out.Size());
+            out.PutUtf16(entries[i].second);
+        }
+    }
+    out.Patch<int32_t>(4, static_cast<int32_t>(out.Size()));
+
+    return std::move(out.data);
+}
+
+std::vector<char> Emevd(const Shape& shape, int variant) {
+    std::mt19937 rng(0xBB04);
+
+    struct Instruction {
+        int32_t bank;
+        int32_t id;
+        std::vector<char> args;
+    };
+    struct Event {
+        int64_t id;
+        int32_t rest;
+        std::vector<Instruction> instructions;
+        std::vector<std::array<int64_t, 4>> parameters; // instruction, target, source, bytes
+    };
+
+    size_t argSize = std::max<size_t>(4, shape.entrySize / 8 / 4 * 4);
+    std::vector<Event> events;
+    for (size_t e = 0; e < shape.entries; e++) {
+        Event event{static_cast<int64_t>(e * 10), static_cast<int32_t>(e % 3), {}, {}};
+        for (size_t k = 0; k < 5 + e % 4; k++) {
+            event.instructions.push_back({static_cast<int32_t>(2000 + k % 3),
+                                          static_cast<int32_t>(k),
+                                          RandomBytes(rng, argSize + 4 * (k % 4))});
+        }
+        if (e % 2) {
+            event.parameters.push_back({1, 4, 0, 4});
+        }
+
+        if (variant == 1 && e % 5 == 0) {
+            event.instructions.push_back({1, 1, std::vector<char>(8, static_cast<char>(0xAA))});
+        } else if (variant == 2 && e % 5 == 1) {
+            event.instructions.push_back({1, 2, std::vector<char>(8, static_cast<char>(0xBB))});
+        } else if (e % 5 == 2) {
+            // both mods touch these events in different places, merged instruction by instruction
+            if (variant == 1) {
+                event.instructions.push_back({1, 3, std::vector<char>(8, static_cast<char>(0xAA))});
+            } else if (variant == 2) {
+                event.instructions[0].args.assign(argSize, static_cast<char>(0xBB));
+            }
+        }
+        events.push_back(std::move(event));
+    }
+
+    size_t instructionCount = 0;
+    size_t parameterCount = 0;
+    for (const Event& event : events) {
+        instructionCount += event.instructions.size();
+        parameterCount += event.parameters.size();
+    }
+
+    const int64_t headerSize = 16 + 16 * 8;
+    const int64_t eventsOffset = headerSize;
+    const int64_t instructionsOffset = eventsOffset + 48 * events.size();
+    const int64_t argsOffset = instructionsOffset + 32 * instructionCount;
+
+    Bytes args;
+    std::vector<int64_t> argOffsets;
+    for (const Event& event : events) {
+        for (const Instruction& instruction : event.instructions) {
+            argOffsets.push_back(instruction.args.empty() ? -1 : args.Size());
+            args.PutBytes(instruction.args);
+            args.Pad(4);
+        }
+    }
+    args.Pad(16);
+
+    Bytes eventTable;
+    Bytes instructionTable;
+    Bytes parameterTable;
+    size_t argIndex = 0;
+    for (const Event& event : events) {
+        int64_t firstInstruction = event.instructions.empty() ? -1 : instructionTable.Size();
+        int32_t firstParameter =
+            event.parameters.empty() ? -1 : static_cast<int32_t>(parameterTable.Size());
+        for (const Instruction& instruction : event.instructions) {
+            instructionTable.Put<int32_t>(instruction.bank);
+            instructionTable.Put<int32_t>(instruction.id);
+            instructionTable.Put<int64_t>(instruction.args.size());
+            instructionTable.Put<int64_t>(argOffsets[argIndex++]);
+            instructionTable.Put<int32_t>(-1);
+            instructionTable.Put<int32_t>(0);
+        }
+        for (const auto& parameter : event.parameters) {
+            parameterTable.Put<int64_t>(parameter[0]);
+            parameterTable.Put<int64_t>(parameter[1]);
+            parameterTable.Put<int64_t>(parameter[2]);
+            parameterTable.Put<int32_t>(static_cast<int32_t>(parameter[3]));
+            parameterTable.Put<int32_t>(0);
+        }
+        eventTable.Put<int64_t>(event.id);
+        eventTable.Put<int64_t>(event.instructions.size());
+        eventTable.Put<int64_t>(firstInstruction);
+        eventTable.Put<int64_t>(event.parameters.size());
+        eventTable.Put<int32_t>(firstParameter);
+        eventTable.Put<int32_t>(0);
+        eventTable.Put<int32_t>(event.rest);
+        eventTable.Put<int32_t>(0);
+    }
+
+    const int64_t parametersOffset = argsOffset + args.Size();
+    const int64_t linkedOffset = parametersOffset + parameterTable.Size();
+    const int64_t stringsOffset = linkedOffset + 8;
+    Bytes strings;
+    strings.PutUtf16(u"synthetic");
+
+    Bytes out;
+    out.PutMagic("EVD\0\0\xFF\0\0", 8);
+    out.Put<int32_t>(204);
+    out.Put<int32_t>(static_cast<int32_t>(stringsOffset + strings.Size()));
+    for (int64_t value :
+         {static_cast<int64_t>(events.size()), eventsOffset,
+          static_cast<int64_t>(instructionCount), instructionsOffset, int64_t{0}, argsOffset,
+          int64_t{0}, argsOffset, static_cast<int64_t>(parameterCount), parametersOffset,
+          int64_t{1}, linkedOffset, static_cast<int64_t>(args.Size()), argsOffset,
+          static_cast<int64_t>(strings.Size()), stringsOffset}) {
+        out.Put<int64_t>(value);
+    }
+    out.PutBytes(eventTable.data);
+    out.PutBytes(instructionTable.data);
+    out.PutBytes(args.data);
+    out.PutBytes(parameterTable.data);
+    out.Put<int64_t>(0); // linked file
+    out.PutBytes(strings.data);
+
+    return std::move(out.data);
+}
+
+std::vector<char> Esd(const Shape& shape, int variant) {
+    std::mt19937 rng(0xBB05);
+
+    struct Command {
+        int32_t bank;
+        int32_t id;
+        std::vector<std::vector<char>> args;
+    };
+    struct State {
+        int64_t id;
+        std::vector<Command> entryCommands;
+        std::vector<Command> exitCommands;
+        std::vector<char> evaluator;
+        int64_t target;
+    };
+
+    // groups of up to 16 states, each state has one condition leading to the next one
+    constexpr size_t groupSize = 16;
+    size_t argSize = std::max<size_t>(4, shape.entrySize / 4);
+    std::vector<std::pair<int64_t, std::vector<State>>> groups;
+    for (size_t first = 0; first < shape.entries; first += groupSize) {
+        size_t count = std::min(groupSize, shape.entries - first);
+        std::vector<State> states;
+        for (size_t s = 0; s < count; s++) {
+            State state{static_cast<int64_t>(s), {}, {}, {}, static_cast<int64_t>((s + 1) % count)};
+            state.entryCommands.push_back({1, 0, {RandomBytes(rng, argSize)}});
+            state.entryCommands.push_back(
+                {1, static_cast<int32_t>(1 + s % 3), {RandomBytes(rng, argSize), {0x41, 0}}});
+            if (s % 2) {
+                state.exitCommands.push_back({5, 10, {RandomBytes(rng, 4)}});
+            }
+            state.evaluator = RandomBytes(rng, argSize / 2 + 1);
+
+            size_t index = first + s;
+            if ((variant == 1 && index % 5 == 0) || (variant == 2 && index % 5 == 1)) {
+                state.entryCommands[0].args[0].assign(argSize, static_cast<char>(0x50 + variant));
+            } else if (index % 5 == 2 && variant != 0) {
+                // both mods change these states, one a command and the other the condition
+                if (variant == 1) {
+                    state.entryCommands[1].args[1] = {0x51, 0};
+                } else {
+                    state.evaluator.assign(state.evaluator.size(), static_cast<char>(0x52));
+                }
+            }
+            states.push_back(std::move(state));
+        }
+        groups.emplace_back(static_cast<int64_t>(first / groupSize * 1000), std::move(states));
+    }
+
+    size_t stateCount = 0;
+    size_t commandCount = 0;
+    size_t argCount = 0;
+    for (const auto& group : groups) {
+        stateCount += group.second.size() + (group.second.size() > 1 ? 1 : 0);
+        for (const State& state : group.second) {
+            for (const auto* calls : {&state.entryCommands, &state.exitCommands}) {
+                commandCount += calls->size();
+                for (const Command& command : *calls) {
+                    argCount += command.args.size();
+                }
+            }
+        }
+    }
+
+    const std::u16string name = u"synthetic";
+    constexpr size_t headerSize = 0x6C;
+    Bytes out;
+    out.PutMagic("fsSL", 4);
+    out.Fill(headerSize - 4);
+    const size_t dataStart = out.Size();
+    auto offset = [&] { return static_cast<int64_t>(out.Size() - dataStart); };
+
+    out.Put<int32_t>(1);
+    for (int32_t unk : {1, 2, 3, 4, 0}) {
+        out.Put<int32_t>(unk);
+    }
+    const size_t groupsOffsetSlot = out.Size();
+    out.Put<int64_t>(0);
+    out.Put<int64_t>(groups.size());
+    const size_t nameOffsetSlot = out.Size();
+    out.Put<int64_t>(0);
+    out.Put<int64_t>(name.size() + 1);
+    out.Put<int64_t>(-1);
+    out.Put<int64_t>(-1);
+
+    out.Patch<int64_t>(groupsOffsetSlot, offset());
+    std::vector<size_t> groupSlots;
+    for (const auto& group : groups) {
+        out.Put<int64_t>(group.first);
+        groupSlots.push_back(out.Size());
+        out.Put<int64_t>(0);
+        out.Put<int64_t>(group.second.size());
+        out.Put<int64_t>(0);
+    }
+
+    // state records, then the dummy copy of a group's first state
+    struct StateSlots {
+        size_t record;
+        int64_t offset;
+    };
+    std::vector<std::vector<StateSlots>> stateSlots(groups.size());
+    std::vector<std::pair<size_t, size_t>> dummyStates;
+    for (size_t g = 0; g < groups.size(); g++) {
+        out.Patch<int64_t>(groupSlots[g], offset());
+        out.Patch<int64_t>(groupSlots[g] + 16, offset());
+        for (const State& state : groups[g].second) {
+            stateSlots[g].push_back({out.Size(), offset()});
+            out.Put<int64_t>(state.id);
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(1);
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(state.entryCommands.size());
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(state.exitCommands.size());
+            out.Put<int64_t>(-1);
+            out.Put<int64_t>(0);
+        }
+        if (groups[g].second.size() > 1) {
+            dummyStates.emplace_back(stateSlots[g][0].record, out.Size());
+            out.Fill(0x48);
+        }
+    }
+
+    std::vector<std::vector<size_t>> conditionSlots(groups.size());
+    std::vector<std::vector<int64_t>> conditionOffsets(groups.size());
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (const State& state : groups[g].second) {
+            conditionOffsets[g].push_back(offset());
+            conditionSlots[g].push_back(out.Size());
+            out.Put<int64_t>(stateSlots[g][state.target].offset);
+            out.Put<int64_t>(-1);
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(-1);
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(state.evaluator.size());
+        }
+    }
+
+    std::vector<const Command*> commands;
+    std::vector<size_t> argTableSlots;
+    auto writeCommands = [&](const std::vector<Command>& calls, size_t slot) {
+        if (calls.empty()) {
+            out.Patch<int64_t>(slot, -1);
+            return;
+        }
+
+        out.Patch<int64_t>(slot, offset());
+        for (const Command& command : calls) {
+            out.Put<int32_t>(command.bank);
+            out.Put<int32_t>(command.id);
+            argTableSlots.push_back(out.Size());
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(command.args.size());
+            commands.push_back(&command);
+        }
+    };
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t s = 0; s < groups[g].second.size(); s++) {
+            const State& state = groups[g].second[s];
+            writeCommands(state.entryCommands, stateSlots[g][s].record + 24);
+            writeCommands(state.exitCommands, stateSlots[g][s].record + 40);
+        }
+    }
+
+    std::vector<size_t> argSlots;
+    for (size_t i = 0; i < commands.size(); i++) {
+        out.Patch<int64_t>(argTableSlots[i], offset());
+        for (const auto& arg : commands[i]->args) {
+            argSlots.push_back(out.Size());
+            out.Put<int64_t>(0);
+            out.Put<int64_t>(arg.size());
+        }
+    }
+
+    const int64_t conditionOffsetsOffset = offset();
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t s = 0; s < groups[g].second.size(); s++) {
+            out.Patch<int64_t>(stateSlots[g][s].record + 8, offset());
+            out.Put<int64_t>(conditionOffsets[g][s]);
+        }
+    }
+
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t s = 0; s < groups[g].second.size(); s++) {
+            out.Patch<int64_t>(conditionSlots[g][s] + 40, offset());
+            out.PutBytes(groups[g].second[s].evaluator);
+        }
+    }
+
+    size_t argSlot = 0;
+    for (const Command* command : commands) {
+        for (const auto& arg : command->args) {
+            out.Patch<int64_t>(argSlots[argSlot++], offset());
+            out.PutBytes(arg);
+        }
+    }
+
+    const int64_t nameBlockOffset = offset();
+    out.Pad(2);
+    out.Patch<int64_t>(nameOffsetSlot, offset());
+    out.PutUtf16(name);
+    const int64_t dataSize = offset();
+
+    int32_t headerFields[] = {1,
+                              2,
+                              2,
+                              0x54,
+                              static_cast<int32_t>(dataSize),
+                              6,
+                              0x48,
+                              1,
+                              0x20,
+                              static_cast<int32_t>(groups.size()),
+                              0x48,
+                              static_cast<int32_t>(stateCount),
+                              0x38,
+                              static_cast<int32_t>(shape.entries),
+                              0x18,
+                              static_cast<int32_t>(commandCount),
+                              0x10,
+                              static_cast<int32_t>(argCount),
+                              static_cast<int32_t>(conditionOffsetsOffset),
+                              static_cast<int32_t>(shape.entries),
+                              static_cast<int32_t>(nameBlockOffset),
+                              static_cast<int32_t>(name.size() + 1),
+                              static_cast<int32_t>(dataSize),
+                              0,
+                              static_cast<int32_t>(dataSize),
+                              0};
+    for (size_t i = 0; i < std::size(headerFields); i++) {
+        out.Patch<int32_t>(4 + 4 * i, headerFields[i]);
+    }
+    out.Pad(0x10);
+
+    for (const auto& [first, dummy] : dummyStates) {
+        std::copy_n(out.data.begin() + first, 0x48, out.data.begin() + dummy);
+    }
+
+    return std::move(out.data);
+}
+
+std::vector<char> Msb(const Shape& shape, int variant) {
+    auto section = [](Bytes& out, std::u16string_view name,
+                      const std::vector<std::vector<char>>& entries, bool last) {
+        size_t base = out.Size();
+        size_t headerSize = 8 + 8 * (entries.size() + 2);
+        Bytes paddedName;
+        paddedName.PutUtf16(name);
+        paddedName.Pad(8);
+
+        out.Put<int32_t>(3);
+        out.Put<int32_t>(static_cast<int32_t>(entries.size() + 1));
+        int64_t cursor = base + headerSize;
+        out.Put<int64_t>(cursor);
+        cursor += paddedName.Size();
+        for (const auto& entry : entries) {
+            out.Put<int64_t>(cursor);
+            cursor += entry.size();
+        }
+        out.Put<int64_t>(last ? 0 : cursor);
+        out.PutBytes(paddedName.data);
+        for (const auto& entry : entries) {
+            out.PutBytes(entry);
+        }
+    };
+
+    // models are grouped by type with an index inside the type, as the repacker sorts them. the
+    // instance count is derived from the parts, and there are none, so the mods edit sib paths
+    std::vector<std::vector<char>> models;
+    int32_t typeIndex = 0;
+    for (size_t k = 0; k < shape.entries; k++) {
+        uint32_t type = static_cast<uint32_t>(k * 3 / shape.entries);
+        if (k > 0 && type != (k - 1) * 3 / shape.entries) {
+            typeIndex = 0;
+        }
+
+        char name[16];
+        std::snprintf(name, sizeof(name), "m%04zu", k);
+        std::string sibPath = "N:\\model\\" + std::string(name);
+        if (variant == 1 && k % 5 == 0) {
+            sibPath += "_mod1";
+        } else if (variant == 2 && k % 5 == 1) {
+            sibPath += "_mod2";
+        }
+
+        Bytes entry;
+        entry.Put<int64_t>(0x28);
+        entry.Put<uint32_t>(type);
+        entry.Put<int32_t>(typeIndex++);
+        entry.Put<int64_t>(0); // sib path offset
+        entry.Put<int32_t>(0);
+        entry.Fill(12);
+        entry.PutUtf16(Widen(name));
+        entry.Patch<int64_t>(16, entry.Size());
+        entry.PutUtf16(Widen(sibPath + ".sib"));
+        entry.Pad(8);
+        models.push_back(std::move(entry.data));
+    }
+
+    Bytes out;
+    out.PutMagic("MSB ", 4);
+    out.Put<int32_t>(1);
+    out.Put<int32_t>(0x10);
+    out.PutMagic("\0\0\1\xFF", 4);
+    section(out, u"MODEL_PARAM_ST", models, false);
+    section(out, u"EVENT_PARAM_ST", {}, false);
+    section(out, u"POINT_PARAM_ST", {}, false);
+    section(out, u"PARTS_PARAM_ST", {}, true);
+
+    return std::move(out.data);
+}
+
+std::vector<char> Dcx(std::span<const char> payload, int level) {
+    mz_ulong compressedSize = mz_compressBound(static_cast<mz_ulong>(payload.size()));
+    std::vector<char> compressed(compressedSize);
+    mz_compress2(reinterpret_cast<unsigned char*>(compressed.data()), &compressedSize,
+                 reinterpret_cast<const unsigned char*>(payload.data()),
+                 static_cast<mz_ulong>(payload.size()), level);
+
+    Bytes out;
+    out.PutMagic("DCX\0", 4);
+    for (int32_t value : {0x11000, 0x18, 0x24, 0x24, 0x2C}) {
+        out.PutBig<int32_t>(value);
+    }
+    out.PutMagic("DCS\0", 4);
+    out.PutBig<uint32_t>(static_cast<uint32_t>(payload.size()));
+    out.PutBig<uint32_t>(static_cast<uint32_t>(compressedSize));
+    out.PutMagic("DCP\0DFLT", 8);
+    out.PutBig<int32_t>(0x20);
+    out.PutMagic("\x09\0\0\0", 4);
+    out.PutBig<int32_t>(0);
+    out.PutMagic("\0\0\0\0", 4);
+    out.PutBig<int32_t>(0);
+    out.PutBig<int32_t>(0x00010100);
+    out.PutMagic("DCA\0", 4);
+    out.PutBig<int32_t>(8);
+    out.PutBytes(std::span(compressed.data(), compressedSize));
+
+    return std::move(out.data);
+}
+
+} // namespace Synthetic
@@ -0,0 +1,32 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// byte level writers for the formats in modules/BBFormats, laid out the way each repacker writes
+// them so parse followed by repack gives back the input byte for byte. variant 0 is the vanilla
+// file, 1 and 2 are two mods changing different entries of it, and for binders also different
+// rows of the same entries, so their three-way merge resolves without asking for a priority
+namespace Synthetic {
+
+struct Shape {
+    size_t entries = 1000;
+    size_t entrySize = 256; // payload bytes per entry: row, texture, text, arguments...
+};
+
+std::vector<char> Bnd(const Shape& shape, int variant);
+std::vector<char> Tpf(const Shape& shape, int variant);
+std::vector<char> Fmg(const Shape& shape, int variant);
+std::vector<char> Param(const Shape& shape, int variant);
+std::vector<char> Emevd(const Shape& shape, int variant);
+std::vector<char> Esd(const Shape& shape, int variant);
+std::vector<char> Msb(const Shape& shape, int variant);
+
+// zlib stream behind a DFLT dcx header
+std::vector<char> Dcx(std::span<const char> payload, int level);
+
+} // namespace Synthetic
@@ -0,0 +1,317 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// unicode-bench [strings]: reads and writes of nul terminated utf-16 strings the way the msgbnd
+// text banks and bnd4 name tables hold them, per code unit as BBFormat used to against the span
+// transcoder in scalar and simd form
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "modules/BBFormats/Codec.h"
+#include "modules/Unicode.h"
+
+namespace {
+
+using FileHelper::SpanReader;
+using FileHelper::SpanWriter;
+
+// volatile sink so the loops are not optimised away
+volatile size_t sink = 0;
+
+// BBFormat::ReadUtf16String before the transcoder: one Read per code unit into a u16string,
+// then one append per utf-8 byte
+std::string LegacyRead(SpanReader& reader) {
+    std::u16string u16;
+    char16_t ch;
+
+    while (reader.Read(&ch, sizeof(ch))) {
+        if (ch == 0) {
+            break;
+        }
+        u16.push_back(ch);
+    }
+
+    std::string utf8;
+    for (size_t i = 0; i < u16.size(); ++i) {
+        uint32_t cp = u16[i];
+
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < u16.size()) {
+            uint32_t low = u16[i + 1];
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+        }
+
+        if (cp <= 0x7F) {
+            utf8 += static_cast<char>(cp);
+        } else if (cp <= 0x7FF) {
+            utf8 += static_cast<char>(0xC0 | ((cp >> 6) & 0x1F));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp <= 0xFFFF) {
+            utf8 += static_cast<char>(0xE0 | ((cp >> 12) & 0x0F));
+            utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            utf8 += static_cast<char>(0xF0 | ((cp >> 18) & 0x07));
+            utf8 += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return utf8;
+}
+
+// BBFormat::WriteUtf16String before the transcoder: a temporary vector of units per call
+void LegacyWrite(SpanWriter& writer, std::string_view input) {
+    std::vector<char16_t> u16;
+    for (size_t i = 0; i < input.size();) {
+        uint32_t cp = 0;
+        uint8_t b1 = static_cast<uint8_t>(input[i]);
+
+        if (b1 <= 0x7F) {
+            cp = b1;
+            i += 1;
+        } else if ((b1 & 0xE0) == 0xC0) {
+            if (i + 1 >= input.size())
+                break;
+            cp = ((b1 & 0x1F) << 6) | (input[i + 1] & 0x3F);
+            i += 2;
+        } else if ((b1 & 0xF0) == 0xE0) {
+            if (i + 2 >= input.size())
+                break;
+            cp = ((b1 & 0x0F) << 12) | ((input[i + 1] & 0x3F) << 6) | (input[i + 2] & 0x3F);
+            i += 3;
+        } else if ((b1 & 0xF8) == 0xF0) {
+            if (i + 3 >= input.size())
+                break;
+            cp = ((b1 & 0x07) << 18) | ((input[i + 1] & 0x3F) << 12) |
+                 ((input[i + 2] & 0x3F) << 6) | (input[i + 3] & 0x3F);
+            i += 4;
+        } else {
+            i += 1;
+            continue;
+        }
+
+        if (cp <= 0xFFFF) {
+            u16.push_back(static_cast<char16_t>(cp));
+        } else if (cp <= 0x10FFFF) {
+            cp -= 0x10000;
+            u16.push_back(static_cast<char16_t>(0xD800 + ((cp >> 10) & 0x03FF)));
+            u16.push_back(static_cast<char16_t>(0xDC00 + (cp & 0x03FF)));
+        }
+    }
+
+    u16.push_back(0);
+    writer.Write(u16.data(), u16.size() * sizeof(char16_t));
+}
+
+using Utf16Length = size_t (*)(std::span<const char>);
+using Utf16ToUtf8 = size_t (*)(std::span<const char>, char*);
+using Utf8ToUtf16 = size_t (*)(std::string_view, char*);
+
+// the same two steps as BBFormat::ReadUtf16String and WriteUtf16String, with the kernels swapped
+std::string SpanRead(SpanReader& reader, Utf16Length length, Utf16ToUtf8 convert) {
+    std::span<const char> rest = reader.View(reader.Remaining());
+    const size_t units = length(rest);
+
+    std::string utf8(units * 3, '\0');
+    utf8.resize(convert(rest.first(units * 2), utf8.data()));
+    reader.Skip(units * 2 + 2);
+    return utf8;
+}
+
+void SpanWrite(SpanWriter& writer, std::string_view input, Utf8ToUtf16 convert) {
+    writer.WriteInPlace(input.size() * 2 + 2, [&](std::span<char> out) {
+        size_t used = convert(input, out.data());
+        out[used] = out[used + 1] = 0;
+        return used + 2;
+    });
+}
+
+// text pieces in the proportions of a msgbnd: item names and captions, mostly short, some
+// japanese, the odd emoji or stray surrogate from a broken mod, and the bnd4 entry paths
+const std::vector<std::u16string> englishWords = {
+    u"Blood", u"Vial", u"Hunter", u"Saw Cleaver", u"Insight", u"Old Yharnam", u"Beast",
+    u"Quicksilver Bullets", u"A vial of blood used to restore HP.", u"Cathedral Ward",
+};
+const std::vector<std::u16string> japaneseWords = {
+    u"輸血液", u"狩人", u"ノコギリ鉈", u"啓蒙", u"旧市街", u"獣", u"水銀弾", u"聖堂街",
+};
+const std::vector<std::u16string> oddWords = {u"ü€😀", u"Ωμέγα", u"\xD800", u"🩸🌙", u"\xDC00x"};
+
+std::u16string Sentence(std::mt19937& rng, const std::vector<std::u16string>& words,
+                        size_t count) {
+    std::u16string text;
+    for (size_t i = 0; i < count; i++) {
+        text += words[rng() % words.size()];
+        text += u' ';
+    }
+    return text;
+}
+
+struct Corpus {
+    const char* name = nullptr;
+    std::vector<char> utf16; // nul terminated strings back to back, as in an fmg string table
+    std::vector<std::string> utf8;
+    size_t strings = 0;
+};
+
+Corpus Build(const char* name, size_t strings, std::mt19937& rng, int mix) {
+    Corpus corpus;
+    corpus.name = name;
+    for (size_t i = 0; i < strings; i++) {
+        std::u16string text;
+        if (mix == 0) {
+            text = Sentence(rng, englishWords, 1 + rng() % (i % 4 == 0 ? 40 : 4));
+        } else if (mix == 1) {
+            text = Sentence(rng, japaneseWords, 1 + rng() % (i % 4 == 0 ? 30 : 3));
+        } else if (mix == 2) {
+            text = Sentence(rng, englishWords, 1 + rng() % 8);
+            text += i % 7 == 0 ? oddWords[rng() % oddWords.size()] : u"";
+            text += i % 3 == 0 ? Sentence(rng, japaneseWords, 2) : u"";
+        } else {
+            std::string path = "N:\\FDP\\data\\INTERROOT_ps4\\msg\\engUS\\item_" +
+                               std::to_string(i) + ".fmg";
+            text.assign(path.begin(), path.end());
+        }
+
+        for (char16_t unit : text) {
+            corpus.utf16.push_back(static_cast<char>(unit & 0xFF));
+            corpus.utf16.push_back(static_cast<char>(unit >> 8));
+        }
+        corpus.utf16.push_back(0);
+        corpus.utf16.push_back(0);
+    }
+    corpus.strings = strings;
+
+    SpanReader reader(corpus.utf16);
+    while (!reader.Eof()) {
+        corpus.utf8.push_back(LegacyRead(reader));
+    }
+    return corpus;
+}
+
+template <typename Kernel>
+double Best(Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int rounds = 5;
+
+    kernel(); // warm up
+    double best = 0.0;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = Clock::now();
+        sink = sink + kernel();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+template <typename ReadOne>
+size_t ReadAll(const Corpus& corpus, ReadOne readOne) {
+    SpanReader reader(corpus.utf16);
+    size_t bytes = 0;
+    while (!reader.Eof()) {
+        bytes += readOne(reader).size();
+    }
+    return bytes;
+}
+
+template <typename WriteOne>
+std::vector<char> WriteAll(const Corpus& corpus, WriteOne writeOne) {
+    SpanWriter writer;
+    for (const std::string& text : corpus.utf8) {
+        writeOne(writer, text);
+    }
+    return writer.Take();
+}
+
+bool Verify(const Corpus& corpus) {
+    SpanReader legacy(corpus.utf16);
+    SpanReader scalar(corpus.utf16);
+    SpanReader simd(corpus.utf16);
+    while (!legacy.Eof()) {
+        std::string expected = LegacyRead(legacy);
+        if (SpanRead(scalar, Unicode::Utf16LengthScalar, Unicode::Utf16ToUtf8Scalar) != expected ||
+            SpanRead(simd, Unicode::Utf16Length, Unicode::Utf16ToUtf8) != expected) {
+            return false;
+        }
+    }
+
+    std::vector<char> expected = WriteAll(corpus, LegacyWrite);
+    return expected == corpus.utf16 &&
+           WriteAll(corpus, [](SpanWriter& w, std::string_view text) {
+               SpanWrite(w, text, Unicode::Utf8ToUtf16Scalar);
+           }) == expected &&
+           WriteAll(corpus, [](SpanWriter& w, std::string_view text) {
+               SpanWrite(w, text, Unicode::Utf8ToUtf16);
+           }) == expected;
+}
+
+void Run(const Corpus& corpus) {
+    auto perString = [&](double seconds) { return seconds / corpus.strings * 1e9; };
+
+    double legacyRead = Best([&] { return ReadAll(corpus, LegacyRead); });
+    double scalarRead = Best([&] {
+        return ReadAll(corpus, [](SpanReader& r) {
+            return SpanRead(r, Unicode::Utf16LengthScalar, Unicode::Utf16ToUtf8Scalar);
+        });
+    });
+    double simdRead = Best([&] {
+        return ReadAll(corpus, [](SpanReader& r) {
+            return SpanRead(r, Unicode::Utf16Length, Unicode::Utf16ToUtf8);
+        });
+    });
+
+    double legacyWrite = Best([&] { return WriteAll(corpus, LegacyWrite).size(); });
+    double scalarWrite = Best([&] {
+        return WriteAll(corpus, [](SpanWriter& w, std::string_view text) {
+                   SpanWrite(w, text, Unicode::Utf8ToUtf16Scalar);
+               }).size();
+    });
+    double simdWrite = Best([&] {
+        return WriteAll(corpus, [](SpanWriter& w, std::string_view text) {
+                   SpanWrite(w, text, Unicode::Utf8ToUtf16);
+               }).size();
+    });
+
+    std::printf("%-10s %7.1f %7.1f %7.1f   %7.1f %7.1f %7.1f   %6.0f MB/s\n", corpus.name,
+                perString(legacyRead), perString(scalarRead), perString(simdRead),
+                perString(legacyWrite), perString(scalarWrite), perString(simdWrite),
+                corpus.utf16.size() / simdRead / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t strings = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+
+    std::mt19937 rng(0xBB);
+    std::vector<Corpus> corpora;
+    corpora.push_back(Build("english", strings, rng, 0));
+    corpora.push_back(Build("japanese", strings, rng, 1));
+    corpora.push_back(Build("mixed", strings, rng, 2));
+    corpora.push_back(Build("bnd4 names", strings, rng, 3));
+
+    for (const Corpus& corpus : corpora) {
+        if (!Verify(corpus)) {
+            std::printf("%s: transcoder output differs from the per unit path\n", corpus.name);
+            return 1;
+        }
+    }
+
+    std::printf("strings: %zu, ns per string\n", strings);
+    std::printf("%-10s %7s %7s %7s   %7s %7s %7s   %s\n", "", "read", "scalar", "simd", "write",
+                "scalar", "simd", "simd read");
+    for (const Corpus& corpus : corpora) {
+        Run(corpus);
+    }
+    return 0;
+}
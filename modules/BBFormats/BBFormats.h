@@ -3,26 +3,62 @@
 
 #pragma once
 
+#include <format>
 #include <fstream>
+#include <functional>
 #include <sstream>
-#include <QTextBrowser>
+#include <unordered_map>
+#include <QObject>
 
-class ModMerger;
+#include "Codec.h"
+
+class MergeEngine;
 
 namespace FileHelper {
 
+// position of each entry by key, built once after parsing so matching an entry against the
+// vanilla file and both mods is a hash probe instead of a scan. on duplicate keys the first entry
+// wins, like the scans it replaces. appending keeps positions valid, reordering does not
+template <typename Key>
+class EntryIndex {
+public:
+    template <typename Entry, typename Proj>
+    void Build(const std::vector<Entry>& entries, Proj key) {
+        positions.clear();
+        positions.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            positions.try_emplace(std::invoke(key, entries[i]), i);
+        }
+    }
+
+    template <typename Entry>
+    Entry* Find(const Key& key, std::vector<Entry>& entries) const {
+        auto it = positions.find(key);
+        return it != positions.end() ? &entries[it->second] : nullptr;
+    }
+
+    template <typename Entry>
+    const Entry* Find(const Key& key, const std::vector<Entry>& entries) const {
+        auto it = positions.find(key);
+        return it != positions.end() ? &entries[it->second] : nullptr;
+    }
+
+private:
+    std::unordered_map<Key, size_t> positions;
+};
+
 class BBFormat : public QObject {
     Q_OBJECT
 
 public:
-    explicit BBFormat(ModMerger* parent = nullptr);
+    explicit BBFormat(MergeEngine* parent = nullptr);
     ~BBFormat();
 
 protected:
 #ifndef DEBUG
-    bool debugLogEnabled = false;
+    static constexpr bool debugLogEnabled = false;
 #else
-    bool debugLogEnabled = true;
+    static constexpr bool debugLogEnabled = true;
 #endif
 
     enum class ModPriority : int { NotSet, Mod1, Mod2 };
@@ -39,13 +75,28 @@ protected:
     };
 
     void sendLog(const std::string& log, LogFormat format = LogFormat::Default);
-    void debugLog(const std::string& log, LogFormat format = LogFormat::Default);
 
-    void StepIn(std::streamoff offset, std::istream& stream);
-    void StepOut(std::istream& stream);
+    // trace output for format work. release builds compile the call away and the arguments are
+    // only formatted once the line is kept, so callers pass values instead of building strings
+    template <typename... Args>
+    void debugLog(std::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (debugLogEnabled) {
+            sendLog(std::format(fmt, std::forward<Args>(args)...));
+        }
+    }
+
+    template <typename... Args>
+    void debugLog(LogFormat format, std::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (debugLogEnabled) {
+            sendLog(std::format(fmt, std::forward<Args>(args)...), format);
+        }
+    }
+
+    void StepIn(std::streamoff offset, SpanReader& stream);
+    void StepOut(SpanReader& stream);
 
-    void StepIn(std::streamoff offset, std::ostream& stream);
-    void StepOut(std::ostream& stream);
+    void StepIn(std::streamoff offset, SpanWriter& stream);
+    void StepOut(SpanWriter& stream);
 
     void GetStr(std::string& buffer, int length);
     void WriteStr(std::string buffer, int length);
@@ -77,25 +128,92 @@ protected:
     void GetVector3(Vector3& vec3);
     void WriteVector3(Vector3& vec3);
 
-    void ReserveBytes(const std::string& name, const int& length);
-    void FillReservedInt64(const std::string& name, const uint64_t& value);
-    void FillReservedInt32(const std::string& name, const uint& value);
-    void FillReservedInt32(const std::string& name, const int& value);
+    // byte order is picked once per struct instead of once per field
+    template <HeaderStruct T>
+    bool ReadStruct(T& value) {
+        bool ok = reader.Read(&value, sizeof(T));
+        SwapStruct(value);
+        return ok;
+    }
+
+    template <HeaderStruct T>
+    void SwapStruct(T& value) {
+        bigEndian ? SwapFields<std::endian::big>(value) : SwapFields<std::endian::little>(value);
+    }
+
+    template <HeaderStruct T>
+    void WriteStruct(const T& value) {
+        bigEndian ? Writer<std::endian::big>(writer).Put(value)
+                  : Writer<std::endian::little>(writer).Put(value);
+    }
+
+    // rewrites a struct that was written earlier, e.g. a header once its offsets are known
+    template <HeaderStruct T>
+    void PatchStruct(size_t offset, const T& value) {
+        bigEndian ? Writer<std::endian::big>(writer).Patch(offset, value)
+                  : Writer<std::endian::little>(writer).Patch(offset, value);
+    }
+
+    // handle to a value left open in the output, filling it is a single in-place write
+    template <typename T>
+    struct Reserved {
+        size_t offset = 0;
+    };
+
+    template <typename T>
+    Reserved<T> Reserve() {
+        Reserved<T> slot{writer.Tell()};
+        writer.Fill('\xFE', sizeof(T));
+        return slot;
+    }
+
+    Reserved<int64_t> ReserveInt64() {
+        return Reserve<int64_t>();
+    }
+
+    Reserved<int32_t> ReserveInt32() {
+        return Reserve<int32_t>();
+    }
+
+    void FillReservedInt64(Reserved<int64_t> slot, int64_t value);
+    void FillReservedInt32(Reserved<int32_t> slot, int32_t value);
 
     std::string ReadUtf16String();
-    void WriteUtf16String(const std::string& input);
+    std::string ReadCString();
+    void WriteUtf16String(std::string_view input);
 
     uint8_t ReverseBits(uint8_t value);
     void PadStream(uint64_t alignment);
 
-    ModMerger* merger;
+    MergeEngine* merger;
 
     bool bigEndian = false;
-    std::unique_ptr<std::istream> istream = nullptr;
-    std::unique_ptr<std::ostream> ostream = nullptr;
+    SpanReader reader;
+    SpanWriter writer;
 
     std::vector<std::streamoff> steps = {};
-    std::vector<std::pair<std::string, std::streamoff>> res = {};
+
+private:
+    template <typename T>
+    T GetValue() {
+        return bigEndian ? Reader<std::endian::big>(reader).Get<T>()
+                         : Reader<std::endian::little>(reader).Get<T>();
+    }
+
+    template <typename T>
+    void WriteValue(T value) {
+        bigEndian ? Writer<std::endian::big>(writer).Put(value)
+                  : Writer<std::endian::little>(writer).Put(value);
+    }
+
+    template <typename T>
+    void PatchValue(size_t offset, T value) {
+        bool ok = bigEndian ? Writer<std::endian::big>(writer).Patch(offset, value)
+                            : Writer<std::endian::little>(writer).Patch(offset, value);
+        if (!ok) {
+            sendLog("ERROR: reserved offset is past the end of the output", LogFormat::BoldRed);
+        }
+    }
 };
 
 
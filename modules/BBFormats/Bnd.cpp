@@ -2,80 +2,68 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "Bnd.h"
+#include "modules/Checksum.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Bnd::Bnd(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+Bnd::Bnd(std::span<const char> data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     version = DateToBinderTimestamp();
     UnpackBnd(data);
 }
 
-bool Bnd::UnpackBnd(std::vector<char>& data) {
+bool Bnd::UnpackBnd(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty bnd input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
     std::string strBuffer;
-    int intBuffer = 0;
-    int64_t int64Buffer = 0;
 
-    if (!istream) {
-        sendLog("ERROR: Failed to open BND data buffer", LogFormat::BoldRed);
-        return false;
-    }
+    // byte order is given by the header itself, everything including the header follows it
+    bigEndian = data.size() > 9 && data[9] != 0;
+
+    Header header;
+    ReadStruct(header);
 
-    GetStr(strBuffer, 4);
-    debugLog("MAGIC: " + strBuffer);
+    strBuffer = std::string(header.magic, 4);
+    debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("BND4")) {
         sendLog("ERROR Invalid header magic: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    GetByte(unk04);
-    debugLog("Unk04: " + std::to_string(unk04));
-
-    GetByte(unk05);
-    debugLog("Unk05: " + std::to_string(unk05));
-
-    istream->ignore(3); // or assert 0;
-    GetByte(bigEndian);
-    debugLog("BigEndian: " + std::to_string(bigEndian));
-
-    GetByte(bitBigEndian);
-    bitBigEndian = !bitBigEndian;
-    debugLog("BitBigEndian: " + std::to_string(bitBigEndian));
+    unk04 = header.unk04;
+    debugLog("Unk04: {}", unk04);
 
-    istream->ignore(1); // or assert 0;
+    unk05 = header.unk05;
+    debugLog("Unk05: {}", unk05);
+    debugLog("BigEndian: {}", bigEndian);
 
-    int fileCount = 0;
-    GetInt32(fileCount);
-    debugLog("File count: " + std::to_string(fileCount));
+    bitBigEndian = !header.bitLittleEndian;
+    debugLog("BitBigEndian: {}", bitBigEndian);
 
-    GetInt64(int64Buffer);
-    debugLog("header size check: " + std::to_string(intBuffer)); // assert 64?
+    int fileCount = header.fileCount;
+    debugLog("File count: {}", fileCount);
+    debugLog("header size check: {}", header.headerSize); // assert 64?
 
-    GetStr(version, 8);
-    debugLog("version: " + version);
+    version.assign(header.version, 8);
+    version.erase(std::remove(version.begin(), version.end(), '\0'), version.end());
+    debugLog("version: {}", version);
 
-    uint64_t fileHeaderSize;
-    GetInt64(fileHeaderSize);
-    debugLog("fileHeaderSize: " + std::to_string(fileHeaderSize));
+    uint64_t fileHeaderSize = header.fileHeaderSize;
+    debugLog("fileHeaderSize: {}", fileHeaderSize);
 
-    istream->ignore(8); // Headers end (includes hash table)
+    unicode = header.unicode;
+    debugLog("Unicode: {}", unicode);
 
-    GetByte(unicode);
-    debugLog("Unicode: " + std::to_string(unicode));
-
-    format = ReadFormat(bitBigEndian);
-    debugLog("Format: " + std::to_string(format));
+    format = DecodeFormat(header.rawFormat, bitBigEndian);
+    debugLog("Format: {}", format);
 
     std::vector<Format> formatVec = GetFormatFlags(format);
     auto has_flag = [formatVec](Format flag) -> bool {
@@ -88,103 +76,51 @@ bool Bnd::UnpackBnd(std::vector<char>& data) {
     hasBinderNames = has_flag(Format::Names1) || has_flag(Format::Names2);
     binderFormatEqualsNames1 = format == static_cast<int>(Format::Names1);
 
-    debugLog("hasBinderCompression: " + std::to_string(hasBinderCompression));
-    debugLog("hasBinderLongOffsets: " + std::to_string(hasBinderLongOffsets));
-    debugLog("hasBinderIDs: " + std::to_string(hasBinderIDs));
-    debugLog("hasBinderNames: " + std::to_string(hasBinderNames));
-    debugLog("binderFormatEqualsNames1: " + std::to_string(binderFormatEqualsNames1));
+    debugLog("hasBinderCompression: {}", hasBinderCompression);
+    debugLog("hasBinderLongOffsets: {}", hasBinderLongOffsets);
+    debugLog("hasBinderIDs: {}", hasBinderIDs);
+    debugLog("hasBinderNames: {}", hasBinderNames);
+    debugLog("binderFormatEqualsNames1: {}", binderFormatEqualsNames1);
 
-    GetByte(extended);
-    debugLog("Extended: " + std::to_string(extended)); // or assert (0, 1, 4, 0x80);
+    extended = header.extended;
+    debugLog("Extended: {}", extended); // or assert (0, 1, 4, 0x80);
 
-    istream->ignore(5); // or assert 0
-
-    if (extended == 4) {
-        // hash table value originally asserted, but I think I can just skip this
-    } else {
-        istream->ignore(8); // or assert 0
-    }
+    // the hash table offset for extended == 4 was originally asserted, it is skipped here
 
     uint expectedHeaderSize = GetBND4FileHeaderSize(format);
-    debugLog("expectedHeaderSize: " + std::to_string(expectedHeaderSize));
+    debugLog("expectedHeaderSize: {}", expectedHeaderSize);
 
     if (fileHeaderSize != expectedHeaderSize) {
         sendLog("ERROR Header size does not match expected value", LogFormat::BoldRed);
         return false;
     }
 
-    for (int i = 0; i < fileCount; i++) {
-        BinderFile file;
-        file.flagsValue = ReadFileFlags(bitBigEndian);
-        debugLog("File Flags: " + std::to_string(file.flagsValue));
-
-        istream->ignore(3); // or assert 0
-        istream->ignore(4); // or assert -1
-
-        GetInt64(file.compressedSize);
-        debugLog("compressedSize: " + std::to_string(file.compressedSize));
-
-        if (hasBinderCompression) {
-            GetInt64(file.uncompressedSize);
-            debugLog("uncompressedSize: " + std::to_string(file.uncompressedSize));
-        }
-
-        if (hasBinderLongOffsets) {
-            GetInt64(file.dataOffsetLong);
-            debugLog("dataOffset (64bit): " + std::to_string(file.dataOffsetLong));
-        } else {
-            GetInt32(file.dataOffset);
-            debugLog("dataOffset (32bit): " + std::to_string(file.dataOffset));
-        }
-
-        file.id = -1;
-        if (hasBinderIDs) {
-            GetInt32(file.id);
-            debugLog("ID: " + std::to_string(file.id));
-        }
-
-        if (hasBinderNames) {
-            uint nameOffset;
-            GetInt32(nameOffset);
-            StepIn(nameOffset, *istream);
-
-            if (unicode) {
-                file.name = ReadUtf16String();
-            } else {
-                std::getline(*istream, file.name, '\0');
-            }
-
-            StepOut(*istream);
-
-            debugLog("Name: " + file.name);
-        }
-
-        if (binderFormatEqualsNames1) {
-            GetInt32(file.id);
-            istream->ignore(4); // or assert 0
-        }
-
-        files.push_back(file);
-    }
+    bigEndian ? ReadFileHeaders<std::endian::big>(fileCount)
+              : ReadFileHeaders<std::endian::little>(fileCount);
 
     rootPath = FindCommonBndRootPath(files);
-    debugLog("base path found: " + rootPath.string());
+    debugLog("base path found: {}", rootPath.string());
 
     for (auto& file : files) {
         std::vector<FileFlags> flags = GetFileFlags(file.flagsValue);
         bool fileCompressed =
             std::find(flags.begin(), flags.end(), FileFlags::Compressed) != flags.end();
 
-        hasBinderLongOffsets ? StepIn(file.dataOffsetLong, *istream)
-                             : StepIn(file.dataOffset, *istream);
+        hasBinderLongOffsets ? StepIn(file.dataOffsetLong, reader)
+                             : StepIn(file.dataOffset, reader);
         if (fileCompressed) {
             sendLog("ERROR unexpected compressed bnd file encountered", LogFormat::BoldRed);
             return false;
         } else {
-            file.data.resize(file.compressedSize);
-            istream->read(file.data.data(), file.compressedSize);
+            file.source = reader.View(file.compressedSize);
+            if (file.source.size() != file.compressedSize) {
+                sendLog("ERROR bnd file data runs past the end of the binder: " + file.name,
+                        LogFormat::BoldRed);
+                return false;
+            }
+            file.digest = Checksum::Hash64(file.source);
         }
-        StepOut(*istream);
+        StepOut(reader);
 
         /* tests only
         std::string relativePathString = fs::relative(file.name, rootPath).string();
@@ -197,51 +133,116 @@ bool Bnd::UnpackBnd(std::vector<char>& data) {
 
         std::ofstream outFile(destPath, std::ios::out | std::ios::binary);
         if (outFile.is_open()) {
-            outFile.write(file.data.data(), file.data.size());
+            outFile.write(file.source.data(), file.source.size());
             outFile.close();
-            debugLog("File written: " + relativePathString);
+            debugLog("File written: {}", relativePathString);
         }
         */
     }
 
-    istream.reset();
+    fileIndex.Build(files, &BinderFile::id);
+
+    reader.Reset();
     sendLog("Bnd extraction completed");
     return true;
 }
 
-bool Bnd::RepackBnd(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
+template <std::endian E>
+void Bnd::ReadFileHeaders(int fileCount) {
+    Reader<E> in(reader);
 
-    strBuffer = "BND4";
-    WriteStr(strBuffer, 4);
+    for (int i = 0; i < fileCount; i++) {
+        BinderFile file;
+        file.flagsValue = ReadFileFlags(bitBigEndian);
+        debugLog("File Flags: {}", file.flagsValue);
 
-    WriteByte(unk04);
-    WriteByte(unk05);
-    WriteByte(0);
-    WriteByte(0);
+        reader.Skip(3); // or assert 0
+        reader.Skip(4); // or assert -1
 
-    WriteByte(0);
-    WriteByte(bigEndian);
-    WriteByte(!bitBigEndian);
-    WriteByte(0);
+        in.Get(file.compressedSize);
+        debugLog("compressedSize: {}", file.compressedSize);
 
-    WriteInt32(static_cast<int>(files.size()));
-    WriteInt64(static_cast<int64_t>(0x40));
-    WriteStr(version, 8);
-    WriteInt64(static_cast<uint64_t>(GetBND4FileHeaderSize(format)));
-    ReserveBytes("HeadersEnd", 8); // headers end
+        if (hasBinderCompression) {
+            in.Get(file.uncompressedSize);
+            debugLog("uncompressedSize: {}", file.uncompressedSize);
+        }
+
+        if (hasBinderLongOffsets) {
+            in.Get(file.dataOffsetLong);
+            debugLog("dataOffset (64bit): {}", file.dataOffsetLong);
+        } else {
+            in.Get(file.dataOffset);
+            debugLog("dataOffset (32bit): {}", file.dataOffset);
+        }
 
-    WriteByte(unicode);
-    WriteFormat(format);
-    WriteByte(extended);
-    WriteByte(static_cast<int>(0));
+        file.id = -1;
+        if (hasBinderIDs) {
+            in.Get(file.id);
+            debugLog("ID: {}", file.id);
+        }
 
-    WriteInt32(static_cast<int>(0));
-    ReserveBytes("HashTableOffset", 8); // hash table offset
+        if (hasBinderNames) {
+            uint nameOffset;
+            in.Get(nameOffset);
+            StepIn(nameOffset, reader);
+
+            if (unicode) {
+                file.name = ReadUtf16String();
+            } else {
+                file.name = ReadCString();
+            }
+
+            StepOut(reader);
+
+            debugLog("Name: {}", file.name);
+        }
+
+        if (binderFormatEqualsNames1) {
+            in.Get(file.id);
+            reader.Skip(4); // or assert 0
+        }
+
+        files.push_back(file);
+    }
+}
+
+bool Bnd::RepackBnd(std::vector<char>& outputData) {
+    // layout pass: header, file table, names and aligned data, so the output never reallocates
+    size_t layoutSize = sizeof(Header) + files.size() * GetBND4FileHeaderSize(format);
+    for (const auto& file : files) {
+        layoutSize += (file.name.size() + 1) * (unicode ? 2 : 1) + file.Data().size() + 0x10;
+    }
+    writer = SpanWriter(layoutSize);
+
+    struct FileSlots {
+        Reserved<int64_t> compressedSize;
+        Reserved<int64_t> uncompressedSize;
+        Reserved<int64_t> dataOffsetLong;
+        Reserved<int32_t> dataOffset;
+        Reserved<int32_t> nameOffset;
+    };
+    std::vector<FileSlots> fileSlots(files.size());
+
+    Header header{};
+    std::memcpy(header.magic, "BND4", 4);
+    header.unk04 = unk04;
+    header.unk05 = unk05;
+    header.bigEndian = bigEndian;
+    header.bitLittleEndian = !bitBigEndian;
+    header.fileCount = static_cast<int32_t>(files.size());
+    header.headerSize = 0x40;
+    std::memcpy(header.version, version.data(), std::min<size_t>(version.size(), 8));
+    header.fileHeaderSize = GetBND4FileHeaderSize(format);
+    header.unicode = unicode;
+    header.rawFormat = EncodeFormat(format);
+    header.extended = extended;
+
+    // headers end and hash table offset are filled in once the name table is written
+    WriteStruct(header);
 
     for (int i = 0; i < files.size(); i++) {
-        BinderFile file = files[i];
+        const BinderFile& file = files[i];
+        FileSlots& slot = fileSlots[i];
 
         WriteFileFlags(file.flagsValue);
         WriteByte(static_cast<int>(0));
@@ -250,19 +251,16 @@ bool Bnd::RepackBnd(std::vector<char>& outputData) {
 
         WriteInt32(static_cast<int>(-1));
 
-        std::string resComp = "FileCompressedSize" + std::to_string(i);
-        ReserveBytes(resComp, 8);
+        slot.compressedSize = ReserveInt64();
 
         if (hasBinderCompression) {
-            std::string resUncomp = "FileUncompressedSize" + std::to_string(i);
-            ReserveBytes(resUncomp, 8);
+            slot.uncompressedSize = ReserveInt64();
         }
 
-        std::string resOff = "FileDataOffset" + std::to_string(i);
         if (hasBinderLongOffsets) {
-            ReserveBytes(resOff, 8);
+            slot.dataOffsetLong = ReserveInt64();
         } else {
-            ReserveBytes(resOff, 4);
+            slot.dataOffset = ReserveInt32();
         }
 
         if (hasBinderIDs) {
@@ -270,8 +268,7 @@ bool Bnd::RepackBnd(std::vector<char>& outputData) {
         }
 
         if (hasBinderNames) {
-            std::string resNames = "FileNameOffset" + std::to_string(i);
-            ReserveBytes(resNames, 4);
+            slot.nameOffset = ReserveInt32();
         }
 
         if (binderFormatEqualsNames1) {
@@ -281,12 +278,10 @@ bool Bnd::RepackBnd(std::vector<char>& outputData) {
     }
 
     for (int i = 0; i < files.size(); i++) {
-        BinderFile file = files[i];
+        const BinderFile& file = files[i];
 
         if (hasBinderNames) {
-            int pos = static_cast<int>(ostream->tellp());
-            std::string resNames = "FileNameOffset" + std::to_string(i);
-            FillReservedInt32(resNames, pos);
+            FillReservedInt32(fileSlots[i].nameOffset, static_cast<int>(writer.Tell()));
             if (unicode) {
                 WriteUtf16String(file.name);
             } else {
@@ -302,40 +297,38 @@ bool Bnd::RepackBnd(std::vector<char>& outputData) {
         sendLog("ERROR Unhandled Extended4 binder type encountered", LogFormat::BoldRed);
         return false;
     } else {
-        FillReservedInt64("HashTableOffset", static_cast<uint64_t>(0));
+        header.hashTableOffset = 0;
     }
 
-    int endPos = static_cast<uint64_t>(ostream->tellp());
-    FillReservedInt64("HeadersEnd", endPos);
+    header.headersEnd = static_cast<int64_t>(writer.Tell());
+    PatchStruct(0, header);
 
     for (int i = 0; i < files.size(); i++) {
-        BinderFile file = files[i];
-        if (!file.data.empty()) {
+        const BinderFile& file = files[i];
+        const FileSlots& slot = fileSlots[i];
+        std::span<const char> data = file.Data();
+        if (!data.empty()) {
             PadStream(0x10);
         }
 
-        std::streamoff offset = ostream->tellp();
-        ostream->write(file.data.data(), file.data.size());
+        // untouched entries are copied straight from the buffer they were unpacked from
+        size_t offset = writer.Tell();
+        writer.Write(data.data(), data.size());
 
-        std::string resComp = "FileUncompressedSize" + std::to_string(i);
-        FillReservedInt64(resComp, file.uncompressedSize);
+        FillReservedInt64(slot.compressedSize, file.compressedSize);
 
         if (hasBinderCompression) {
-            std::string resUncomp = "FileCompressedSize" + std::to_string(i);
-            FillReservedInt64(resUncomp, file.compressedSize);
+            FillReservedInt64(slot.uncompressedSize, file.uncompressedSize);
         }
 
-        std::string resOff = "FileDataOffset" + std::to_string(i);
         if (hasBinderLongOffsets) {
-            FillReservedInt64(resOff, static_cast<uint64_t>(offset));
+            FillReservedInt64(slot.dataOffsetLong, static_cast<int64_t>(offset));
         } else {
-            FillReservedInt32(resOff, static_cast<int>(offset));
+            FillReservedInt32(slot.dataOffset, static_cast<int>(offset));
         }
     }
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests only
     std::ofstream outFile("test.bnd", std::ios::binary);
@@ -345,7 +338,6 @@ bool Bnd::RepackBnd(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("BND4 Repacking complete\n");
     return true;
 }
@@ -381,22 +373,17 @@ std::string Bnd::DateToBinderTimestamp() {
     return result;
 }
 
-int Bnd::ReadFormat(bool bitBigEndian) {
-    int rawFormat;
-    GetByte(rawFormat);
-
+int Bnd::DecodeFormat(int rawFormat, bool bitBigEndian) {
     bool reverse = bitBigEndian || (((rawFormat & 1) != 0) && ((rawFormat & 0b10000000) == 0));
     return reverse ? rawFormat : ReverseBits(rawFormat);
 }
 
-void Bnd::WriteFormat(int value) {
+int Bnd::EncodeFormat(int value) {
     std::vector<Format> formats = GetFormatFlags(value);
     bool hasFlag6 = std::find(formats.begin(), formats.end(), Format::Flag6) != formats.end();
 
     bool reverse = bitBigEndian || (bigEndian && hasFlag6);
-    int rawFormat = reverse ? value : ReverseBits(value);
-
-    WriteByte(rawFormat);
+    return reverse ? value : ReverseBits(value);
 }
 
 int Bnd::ReadFileFlags(bool bitBigEndian) {
@@ -514,16 +501,14 @@ std::string Bnd::FindCommonBndRootPath(const std::vector<BinderFile>& files) {
     return root;
 }
 
-std::optional<Bnd::BinderFile> Bnd::GetSameFile(
-    const int& id, const std::vector<Bnd::BinderFile> otherBinderFiles) {
-    std::optional<Bnd::BinderFile> bFile = std::nullopt;
-    for (const auto& file : otherBinderFiles) {
-        if (file.id == id) {
-            return bFile.emplace(file);
-        }
-    }
+Bnd::BinderFile* Bnd::GetSameFile(int id) {
+    return fileIndex.Find(id, files);
+}
 
-    return bFile;
+// entries are compared by size and digest, the bytes themselves are only read once at unpack.
+// good enough to tell which entries a mod changed, not to swap one entry's bytes for another's
+bool Bnd::SameData(const BinderFile& a, const BinderFile& b) {
+    return a.Data().size() == b.Data().size() && a.digest == b.digest;
 }
 
 Bnd::~Bnd() {}
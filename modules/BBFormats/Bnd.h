@@ -13,12 +13,14 @@ class Bnd : public BBFormat {
     Q_OBJECT
 
 public:
-    explicit Bnd(std::vector<char>& data, ModMerger* parent);
+    explicit Bnd(std::span<const char> data, MergeEngine* parent);
     ~Bnd() override;
 
-    bool UnpackBnd(std::vector<char>& data);
+    bool UnpackBnd(std::span<const char> data);
     bool RepackBnd(std::vector<char>& outputData);
 
+    // an entry is a view into the buffer it was unpacked from until something edits it, so that
+    // buffer has to outlive the binder and every entry copied out of it
     struct BinderFile {
         /// Flags indicating compression, and possibly other things.
         int flagsValue;
@@ -28,13 +30,38 @@ public:
         uint64_t uncompressedSize;
         uint64_t dataOffsetLong;
         uint dataOffset;
-        std::vector<char> data;
+        std::span<const char> source;
+        std::vector<char> data; // only filled once the entry is edited
+        bool owned = false;
+        uint64_t digest = 0; // hash64 of the entry bytes, refreshed by whoever edits them
+
+        std::span<const char> Data() const {
+            return owned ? std::span<const char>(data) : source;
+        }
+
+        std::vector<char>& MutableData() {
+            if (!owned) {
+                data.assign(source.begin(), source.end());
+                owned = true;
+            }
+            return data;
+        }
+
+        // turns the entry back into a view of another entry holding the same bytes
+        void ShareData(const BinderFile& other) {
+            source = other.Data();
+            std::vector<char>().swap(data);
+            owned = false;
+            digest = other.digest;
+        }
     };
 
     // original class info
     std::vector<BinderFile> files;
-    std::optional<BinderFile> GetSameFile(const int& id,
-                                          const std::vector<BinderFile> otherBinderFiles);
+
+    // entry of this binder with the given id, nullptr when there is none
+    BinderFile* GetSameFile(int id);
+    static bool SameData(const BinderFile& a, const BinderFile& b);
 
 private:
     // everything marked Flag** is unknown
@@ -62,11 +89,40 @@ private:
         Flag7 = 0b10000000,
     };
 
+    struct Header {
+        char magic[4];
+        uint8_t unk04;
+        uint8_t unk05;
+        uint8_t pad06[3];
+        uint8_t bigEndian;
+        uint8_t bitLittleEndian;
+        uint8_t pad0B;
+        int32_t fileCount;
+        int64_t headerSize; // 0x40
+        char version[8];
+        int64_t fileHeaderSize;
+        int64_t headersEnd; // includes hash table
+        uint8_t unicode;
+        uint8_t rawFormat;
+        uint8_t extended;
+        uint8_t pad33[5];
+        int64_t hashTableOffset;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.fileCount, h.headerSize, h.fileHeaderSize, h.headersEnd,
+                            h.hashTableOffset);
+        }
+    };
+    static_assert(sizeof(Header) == 0x40);
+
+    template <std::endian E>
+    void ReadFileHeaders(int fileCount);
+
     std::string FindCommonBndRootPath(const std::vector<BinderFile>& files);
     std::string DateToBinderTimestamp();
     uint8_t ReverseBits(uint8_t value);
-    int ReadFormat(bool bitBigEndian);
-    void WriteFormat(int value);
+    int DecodeFormat(int rawFormat, bool bitBigEndian);
+    int EncodeFormat(int value);
     int ReadFileFlags(bool bitBigEndian);
     void WriteFileFlags(int value);
     std::vector<Bnd::Format> GetFormatFlags(int value);
@@ -84,6 +140,7 @@ private:
     std::filesystem::path rootPath;
 
     // other private members
+    EntryIndex<int> fileIndex;
     std::filesystem::path origPath;
     std::filesystem::path extractedFolder;
     bool hasBinderCompression;
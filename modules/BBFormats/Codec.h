@@ -0,0 +1,278 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace FileHelper {
+
+// Read cursor over a caller owned buffer, nothing is copied until a field is read out. Out of
+// bounds reads are zero filled and mark the reader as failed instead of reading past the end.
+class SpanReader {
+public:
+    SpanReader() = default;
+    explicit SpanReader(std::span<const char> data) : buffer(data) {}
+
+    bool Read(void* dest, size_t length) {
+        if (length > Remaining()) {
+            std::memset(dest, 0, length);
+            pos = buffer.size();
+            failed = true;
+            return false;
+        }
+
+        std::memcpy(dest, buffer.data() + pos, length);
+        pos += length;
+        return true;
+    }
+
+    bool Skip(size_t length) {
+        if (length > Remaining()) {
+            pos = buffer.size();
+            failed = true;
+            return false;
+        }
+
+        pos += length;
+        return true;
+    }
+
+    bool Seek(size_t offset) {
+        if (offset > buffer.size()) {
+            failed = true;
+            return false;
+        }
+
+        pos = offset;
+        return true;
+    }
+
+    // view of the next length bytes (clamped to the end of the buffer), cursor is not moved
+    std::span<const char> View(size_t length) const {
+        return buffer.subspan(pos, std::min(length, Remaining()));
+    }
+
+    size_t Tell() const {
+        return pos;
+    }
+
+    size_t Size() const {
+        return buffer.size();
+    }
+
+    size_t Remaining() const {
+        return buffer.size() - pos;
+    }
+
+    bool Good() const {
+        return !failed;
+    }
+
+    bool Eof() const {
+        return pos >= buffer.size();
+    }
+
+    void Reset() {
+        buffer = {};
+        pos = 0;
+        failed = false;
+    }
+
+private:
+    std::span<const char> buffer;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+// Write cursor over an owned, contiguous output buffer. Callers reserve the expected size up
+// front, writes past the end grow the buffer and seeking back overwrites in place.
+class SpanWriter {
+public:
+    SpanWriter() = default;
+    explicit SpanWriter(size_t capacity) {
+        buffer.reserve(capacity);
+    }
+
+    void Write(const void* src, size_t length) {
+        if (pos + length > buffer.size()) {
+            buffer.resize(pos + length);
+        }
+
+        std::memcpy(buffer.data() + pos, src, length);
+        pos += length;
+    }
+
+    void Fill(char value, size_t length) {
+        if (pos + length > buffer.size()) {
+            buffer.resize(pos + length);
+        }
+
+        std::memset(buffer.data() + pos, value, length);
+        pos += length;
+    }
+
+    // lets fill write up to maxLength bytes straight into the buffer. fill returns how many it
+    // used and the cursor moves past those only
+    template <typename Fill>
+    void WriteInPlace(size_t maxLength, Fill fill) {
+        const size_t oldSize = buffer.size();
+        if (pos + maxLength > buffer.size()) {
+            buffer.resize(pos + maxLength);
+        }
+
+        pos += fill(std::span<char>(buffer.data() + pos, maxLength));
+        buffer.resize(std::max(oldSize, pos));
+    }
+
+    bool Seek(size_t offset) {
+        if (offset > buffer.size()) {
+            return false;
+        }
+
+        pos = offset;
+        return true;
+    }
+
+    // overwrites already written bytes without moving the cursor
+    bool Patch(size_t offset, const void* src, size_t length) {
+        if (offset + length > buffer.size()) {
+            return false;
+        }
+
+        std::memcpy(buffer.data() + offset, src, length);
+        return true;
+    }
+
+    void Reserve(size_t capacity) {
+        buffer.reserve(capacity);
+    }
+
+    size_t Tell() const {
+        return pos;
+    }
+
+    size_t Size() const {
+        return buffer.size();
+    }
+
+    std::span<char> Data() {
+        return buffer;
+    }
+
+    // hands the written bytes over and leaves the writer empty
+    std::vector<char> Take() {
+        pos = 0;
+        return std::exchange(buffer, {});
+    }
+
+private:
+    std::vector<char> buffer;
+    size_t pos = 0;
+};
+
+// Converts between host order and the file order E. Resolved at compile time, so reading a file
+// that matches the host is a plain copy.
+template <std::endian E, typename T>
+constexpr T ByteOrder(T value) {
+    if constexpr (E == std::endian::native || sizeof(T) == 1) {
+        return value;
+    } else if constexpr (std::is_enum_v<T>) {
+        return static_cast<T>(ByteOrder<E>(std::to_underlying(value)));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        return std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+    } else {
+        return std::byteswap(value);
+    }
+}
+
+// On-disk structs list their multi byte fields in Fields(). The whole struct is copied in one go
+// and only the listed fields get swapped, magic strings and padding are left as they are.
+template <typename T>
+concept HeaderStruct =
+    std::is_trivially_copyable_v<T> && requires(T& header) { T::Fields(header); };
+
+template <std::endian E, HeaderStruct T>
+constexpr void SwapFields(T& header) {
+    if constexpr (E != std::endian::native) {
+        std::apply([](auto&... field) { ((field = ByteOrder<E>(field)), ...); },
+                   T::Fields(header));
+    }
+}
+
+template <std::endian E>
+class Reader {
+public:
+    explicit Reader(SpanReader& stream) : stream(stream) {}
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    T Get() {
+        T value{};
+        stream.Read(&value, sizeof(T));
+        return ByteOrder<E>(value);
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void Get(T& value) {
+        value = Get<T>();
+    }
+
+    template <HeaderStruct T>
+    bool Get(T& header) {
+        bool ok = stream.Read(&header, sizeof(T));
+        SwapFields<E>(header);
+        return ok;
+    }
+
+private:
+    SpanReader& stream;
+};
+
+template <std::endian E>
+class Writer {
+public:
+    explicit Writer(SpanWriter& stream) : stream(stream) {}
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void Put(T value) {
+        value = ByteOrder<E>(value);
+        stream.Write(&value, sizeof(T));
+    }
+
+    template <HeaderStruct T>
+    void Put(T header) {
+        SwapFields<E>(header);
+        stream.Write(&header, sizeof(T));
+    }
+
+    // fills a value reserved earlier, the cursor stays where it is
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    bool Patch(size_t offset, T value) {
+        value = ByteOrder<E>(value);
+        return stream.Patch(offset, &value, sizeof(T));
+    }
+
+    template <HeaderStruct T>
+    bool Patch(size_t offset, T header) {
+        SwapFields<E>(header);
+        return stream.Patch(offset, &header, sizeof(T));
+    }
+
+private:
+    SpanWriter& stream;
+};
+
+} // namespace FileHelper
@@ -1,180 +1,172 @@
 // SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
 #include "Bnd.h"
 #include "ConflictHandler.h"
-#include "Emevd.h"
-#include "Esd.h"
-#include "Fmg.h"
-#include "GameParam.h"
-#include "Msb.h"
-#include "Tpf.h"
-#include "modules/ModMerger.h"
+#include "FormatRegistry.h"
+#include "modules/Checksum.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-ConflictHandler::ConflictHandler(const std::string& fileType, ModMerger* merger)
-    : BBFormat(merger) {
-    type = fileType;
-}
-
-bool ConflictHandler::HandleItemConflict(std::vector<char>& origData, std::vector<char>& mod1Data,
-                                         std::vector<char>& mod2Data, const std::string& filename) {
-    if (type.contains("TPF") || type.contains("tpf")) {
-        Tpf origTpf(origData, merger);
-        if (!origTpf.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origTpf.RepackTpf(origData);
-        }
-    }
-
-    if (type.contains("fmg")) {
-        Fmg origFmg(origData, merger);
-        if (!origFmg.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origFmg.RepackFmg(origData);
-        }
-    }
-
-    if (type.contains("param")) {
-        GameParam origPrm(origData, filename, merger);
-        if (!origPrm.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origPrm.RepackGameParam(origData);
-        }
-    }
-
-    if (type.contains("MSB")) {
-        Msb origMsb(origData, merger);
-        if (!origMsb.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origMsb.RepackMsb(origData);
-        }
-    }
-    
-    if (type.contains("EVD")) {
-        Emevd origEvd(origData, merger);
-        if (!origEvd.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origEvd.RepackEmevd(origData);
-        }
-    }
-    
-    if (type.contains("fsSL") || type.contains("esd")) {
-        Esd origEsd(origData, merger);
-        if (!origEsd.HandleConflict(mod1Data, mod2Data)) {
-            return false;
-        } else {
-            origData.clear();
-            origEsd.RepackEsd(origData);
-        }
-    }
-
-    return true;
-}
+ConflictHandler::ConflictHandler(MergeEngine* merger) : BBFormat(merger) {}
 
-bool ConflictHandler::HandleBinderConflict(std::vector<char>& origData, std::vector<char>& mod1Data,
-                                           std::vector<char>& mod2Data) {
+bool ConflictHandler::HandleBinderConflict(std::vector<char>& origData,
+                                           std::span<const char> mod1Data,
+                                           std::span<const char> mod2Data) {
     Bnd origBnd = Bnd(origData, merger);
-    const Bnd mod1Bnd = Bnd(mod1Data, merger);
-    const std::vector<Bnd::BinderFile> mod1BndFiles = mod1Bnd.files;
-
-    const Bnd mod2Bnd = Bnd(mod2Data, merger);
-    const std::vector<Bnd::BinderFile> mod2BndFiles = mod2Bnd.files;
+    Bnd mod1Bnd = Bnd(mod1Data, merger);
+    Bnd mod2Bnd = Bnd(mod2Data, merger);
+
+    // entries are sorted first, only the ones both mods changed in a mergeable format need the
+    // expensive parse/merge/repack and those run in parallel. each entry logs into its own buffer
+    // so the output reads the same as a sequential merge
+    struct EntryTask {
+        Bnd::BinderFile* file;
+        Bnd::BinderFile* mod1file = nullptr;
+        Bnd::BinderFile* mod2file = nullptr;
+        const FormatHandler* format = nullptr;
+        std::vector<MergeEngine::LogLine> log;
+        bool merged = true;
+        bool settled = true; // false until an unresolvable entry gets a priority
+    };
+
+    std::vector<EntryTask> tasks;
+    tasks.reserve(origBnd.files.size());
+    std::vector<EntryTask*> mergeTasks;
+    std::vector<EntryTask*> unresolvedTasks;
 
     for (auto& file : origBnd.files) {
+        EntryTask& task = tasks.emplace_back();
+        task.file = &file;
+        std::vector<MergeEngine::LogLine>* previousLog = MergeEngine::RedirectLog(&task.log);
         sendLog("Checking BND file: " + file.name);
 
-        bool mod1Modified = false;
-        bool mod2Modified = false;
-
-        std::optional<Bnd::BinderFile> mod1file = origBnd.GetSameFile(file.id, mod1BndFiles);
-        std::optional<Bnd::BinderFile> mod2file = origBnd.GetSameFile(file.id, mod2BndFiles);
+        task.mod1file = mod1Bnd.GetSameFile(file.id);
+        task.mod2file = mod2Bnd.GetSameFile(file.id);
 
-        mod1Modified = mod1file && (mod1file->data != file.data);
-        mod2Modified = mod2file && (mod2file->data != file.data);
+        bool mod1Modified = task.mod1file && !Bnd::SameData(*task.mod1file, file);
+        bool mod2Modified = task.mod2file && !Bnd::SameData(*task.mod2file, file);
 
         if (mod1Modified && mod2Modified) {
-            std::string ext = std::filesystem::path(file.name).extension().string();
-            bool extractable = ext == ".fmg" || ext == ".tpf" || ext == ".param";
-
-            if (extractable) {
-                ConflictHandler fileHandler = ConflictHandler(ext, merger);
-                if (!fileHandler.HandleItemConflict(file.data, mod1file->data, mod2file->data,
-                                                    file.name)) {
-                    return false;
-                } else {
-                    file.compressedSize = file.data.size();
-                    file.uncompressedSize = file.data.size();
-                }
+            task.format = DetectFormat(file.Data(), file.name);
+
+            if (task.format && task.format->nested) {
+                mergeTasks.push_back(&task);
             } else {
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                              Qt::BlockingQueuedConnection);
-                    if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                        return false;
-                    }
-                }
-
-                if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                    file = mod1file.value();
-                    sendLog("Unresolvable conflict, using binder file " + mod1file.value().name +
-                                " from prioritized mod: " + merger->Mod1Name(),
-                            LogFormat::Yellow);
-                } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                    file = mod2file.value();
-                    sendLog("Unresolvable conflict, using binder file " + mod2file.value().name +
-                                " from prioritized mod: " + merger->Mod2Name(),
-                            LogFormat::Yellow);
-                }
+                task.settled = false;
+                unresolvedTasks.push_back(&task);
             }
-        }
-
-        if (mod1Modified && !mod2Modified) {
-            file = mod1file.value();
-            sendLog("Merging modified binder file " + mod1file.value().name +
+        } else if (mod1Modified) {
+            file = *task.mod1file;
+            sendLog("Merging modified binder file " + task.mod1file->name +
                     " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            file = mod2file.value();
-            sendLog("Merging modified binder file " + mod2file.value().name +
+        } else if (mod2Modified) {
+            file = *task.mod2file;
+            sendLog("Merging modified binder file " + task.mod2file->name +
                     " from mod: " + merger->Mod2Name());
         }
 
-        sendLog("File processed: " + file.name + "\n");
+        MergeEngine::RedirectLog(previousLog);
+    }
+
+    auto mergeEntry = [this](EntryTask* task) {
+        std::vector<MergeEngine::LogLine>* previousLog = MergeEngine::RedirectLog(&task->log);
+        task->merged = task->format->merge(task->file->MutableData(), task->mod1file->Data(),
+                                           task->mod2file->Data(), task->file->name, merger);
+        if (task->merged) {
+            Bnd::BinderFile& file = *task->file;
+            file.compressedSize = file.Data().size();
+            file.uncompressedSize = file.Data().size();
+            file.digest = Checksum::Hash64(file.Data());
+
+            // a merge that reproduces one mod's entry drops its copy and points at that mod's. the
+            // digest only rules mods out, the shared bytes are what ships so they are compared
+            auto sameBytes = [&file](const Bnd::BinderFile& mod) {
+                return Bnd::SameData(file, mod) && std::ranges::equal(file.Data(), mod.Data());
+            };
+            if (sameBytes(*task->mod1file)) {
+                file.ShareData(*task->mod1file);
+            } else if (sameBytes(*task->mod2file)) {
+                file.ShareData(*task->mod2file);
+            }
+        }
+        MergeEngine::RedirectLog(previousLog);
+    };
+
+    // the engine's pool keeps every binder merged at once within its thread budget
+    if (QThreadPool* pool = merger->EntryPool()) {
+        QtConcurrent::blockingMap(pool, mergeTasks, mergeEntry);
+    } else {
+        std::ranges::for_each(mergeTasks, mergeEntry);
+    }
+
+    bool merged = std::ranges::all_of(mergeTasks, &EntryTask::merged);
+
+    // whole entries that can't be merged are settled with a single prompt listing all of them
+    if (merged && !unresolvedTasks.empty()) {
+        std::vector<std::string> conflicts;
+        for (const EntryTask* task : unresolvedTasks) {
+            conflicts.push_back(task->file->name);
+        }
+
+        merged = merger->RequestPriority(conflicts) != MergeEngine::ModPriority::NotSet;
+        for (EntryTask* task : unresolvedTasks) {
+            task->merged = merged;
+            if (!merged) {
+                continue;
+            }
+
+            task->settled = true;
+            std::vector<MergeEngine::LogLine>* previousLog = MergeEngine::RedirectLog(&task->log);
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                *task->file = *task->mod1file;
+                sendLog("Unresolvable conflict, using binder file " + task->mod1file->name +
+                            " from prioritized mod: " + merger->Mod1Name(),
+                        LogFormat::Yellow);
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                *task->file = *task->mod2file;
+                sendLog("Unresolvable conflict, using binder file " + task->mod2file->name +
+                            " from prioritized mod: " + merger->Mod2Name(),
+                        LogFormat::Yellow);
+            }
+            MergeEngine::RedirectLog(previousLog);
+        }
     }
 
-    std::unordered_set<int> existingIds;
-    for (const auto& file : origBnd.files) {
-        existingIds.insert(file.id);
+    // entry logs are released in binder order, up to the first entry that failed
+    for (EntryTask& task : tasks) {
+        merger->AppendLog(task.log);
+        if (!task.merged) {
+            return false;
+        }
+        if (task.settled) {
+            sendLog("File processed: " + task.file->name + "\n");
+        }
     }
 
-    for (const auto& file : mod1BndFiles) {
-        if (existingIds.find(file.id) == existingIds.end()) {
+    // the index only covers the vanilla entries, so an id both mods add is kept from each
+    for (const auto& file : mod1Bnd.files) {
+        if (!origBnd.GetSameFile(file.id)) {
             origBnd.files.push_back(file);
             sendLog("Bnd file added: " + file.name);
         }
     }
 
-    for (const auto& file : mod2BndFiles) {
-        if (existingIds.find(file.id) == existingIds.end()) {
+    for (const auto& file : mod2Bnd.files) {
+        if (!origBnd.GetSameFile(file.id)) {
             origBnd.files.push_back(file);
             sendLog("Bnd file added: " + file.name);
         }
     }
 
-    origData.clear();
+    // entries still point into origData, it is only replaced once the repack is done
     origBnd.RepackBnd(origData);
 
     return true;
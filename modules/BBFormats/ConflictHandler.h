@@ -11,16 +11,12 @@ class ConflictHandler : public BBFormat {
     Q_OBJECT
 
 public:
-    explicit ConflictHandler(const std::string& type, ModMerger* merger);
+    explicit ConflictHandler(MergeEngine* merger);
     ~ConflictHandler() override;
 
-    bool HandleItemConflict(std::vector<char>& origData, std::vector<char>& mod1Data,
-                            std::vector<char>& mod2Data, const std::string& filename = "");
-    bool HandleBinderConflict(std::vector<char>& origData, std::vector<char>& mod1Data,
-                              std::vector<char>& mod2Data);
-
-private:
-    std::string type;
+    // merges entry by entry, entries both mods changed go through the format registry
+    bool HandleBinderConflict(std::vector<char>& origData, std::span<const char> mod1Data,
+                              std::span<const char> mod2Data);
 };
 
 } // namespace FileHelper
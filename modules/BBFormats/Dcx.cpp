@@ -1,19 +1,49 @@
 // SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
 #include <miniz.h>
 
 #include "Dcx.h"
+#include "modules/Checksum.h"
 #include "modules/Common.h"
 
 namespace fs = std::filesystem;
 
+namespace {
+
+constexpr size_t deflateWindow = 32 * 1024;
+
+// zlib header for a 32k window, FLEVEL matches what deflateInit would have written
+uint16_t ZlibHeader(int level) {
+    uint16_t flevel = level >= 7 ? 3 : level == 6 ? 2 : level >= 2 ? 1 : 0;
+    uint16_t header = (0x78 << 8) | (flevel << 6);
+    return header + (31 - header % 31) % 31;
+}
+
+} // namespace
+
 namespace FileHelper {
 
-Dcx::Dcx(ModMerger* parent) : BBFormat(parent) {
+Dcx::Dcx(MergeEngine* parent) : BBFormat(parent) {
     bigEndian = true;
 }
 
+void Dcx::SetDeflateOptions(const DeflateOptions& options) {
+    deflateOptions = options;
+    deflateOptions.level = std::clamp(deflateOptions.level, 1, 9);
+    deflateOptions.chunkSize = std::max(deflateOptions.chunkSize, deflateWindow);
+}
+
+void Dcx::SetCache(VanillaCache* cache, const std::filesystem::path& source) {
+    this->cache = cache;
+    cacheSource = source;
+}
+
 bool Dcx::UnpackDcx(std::filesystem::path file, std::vector<char>& output) {
     if (!std::filesystem::exists(file)) {
         sendLog("ERROR File does not exist: " + Common::PathToU8(file), LogFormat::BoldRed);
@@ -22,86 +52,61 @@ bool Dcx::UnpackDcx(std::filesystem::path file, std::vector<char>& output) {
 
     sendLog("Extracting Dcx: " + Common::PathToU8(file) + "...");
     origPath = file;
-    istream = std::make_unique<std::ifstream>(file, std::ios::binary);
-    uint32_t uintBuffer = 0;
+    std::ifstream inFile(file, std::ios::binary);
     std::string strBuffer;
 
-    if (!istream) {
+    if (!inFile) {
         sendLog("Failed to open file: " + file.string());
         return false;
     }
 
-    GetStr(strBuffer, 4);
-    debugLog("MAGIC: " + strBuffer);
+    // compressed data is read in one go, header and deflate stream are both parsed from it
+    std::vector<char> fileData(fs::file_size(file));
+    inFile.read(fileData.data(), fileData.size());
+    inFile.close();
+    reader = SpanReader(fileData);
+
+    // a truncated header is zero filled, so it fails the magic check below
+    ReadStruct(compInfo);
+
+    strBuffer = std::string(compInfo.magic, 4);
+    debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("DCX")) {
         sendLog("ERROR Invalid header magic: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    istream->seekg(0x28);
-    GetStr(strBuffer, 4);
-    debugLog("Format: " + strBuffer);
+    strBuffer = std::string(compInfo.format, 4);
+    debugLog("Format: {}", strBuffer);
 
     if (!strBuffer.contains("DFLT")) {
         sendLog("ERROR Invalid compression: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    istream->seekg(0x4);
-    GetInt32(compInfo.unk04);
-    debugLog("Comp info unk04: " + std::to_string(compInfo.unk04));
-
-    istream->seekg(0x10);
-    GetInt32(compInfo.unk10);
-    debugLog("Comp info unk10: " + std::to_string(compInfo.unk10));
-
-    istream->seekg(0x14);
-    GetInt32(compInfo.unk14);
-    debugLog("Comp info unk14: " + std::to_string(compInfo.unk14));
-
-    istream->seekg(0x30);
-    GetByte(compInfo.unk30);
-    debugLog("Comp info unk30: " + std::to_string(compInfo.unk30));
-
-    istream->seekg(0x38);
-    GetByte(compInfo.unk38);
-    debugLog("Comp info unk38: " + std::to_string(compInfo.unk38));
-
-    // reset position here
-    istream->seekg(0x8);
-
-    istream->ignore(4); // or assert 0x18
-    istream->ignore(4); // or assert 0x24
-    istream->ignore(8);
-
-    GetStr(strBuffer, 4);
-    debugLog("DCS check: " + strBuffer); // maybe assert if not DCS
-
-    GetInt32(uintBuffer);
-    debugLog("uncompressedSize: " + std::to_string(uintBuffer));
-
-    GetInt32(uintBuffer);
-    debugLog("compressedSize: " + std::to_string(uintBuffer));
-
-    GetStr(strBuffer, 4);
-    debugLog("DCP check: " + strBuffer); // maybe asset if not DCP
+    debugLog("Comp info unk04: {}", compInfo.unk04);
+    debugLog("Comp info unk10: {}", compInfo.unk10);
+    debugLog("Comp info unk14: {}", compInfo.unk14);
+    debugLog("Comp info unk30: {}", compInfo.unk30);
+    debugLog("Comp info unk38: {}", compInfo.unk38);
+    debugLog("uncompressedSize: {}", compInfo.uncompressedSize);
+    debugLog("compressedSize: {}", compInfo.compressedSize);
+    debugLog("compressedHeaderLength: {}", compInfo.dcaSize);
 
-    GetStr(strBuffer, 4);
-    debugLog("DFLT check: " + strBuffer); // maybe asset if not DFLT
-
-    istream->ignore(4); // or assert 0x20
-    istream->ignore(4); // unk30 value is here
-    istream->ignore(4); // or assert 0x0
-    istream->ignore(4); // unk38 value is here
-    istream->ignore(4); // or assert 0x0
-    istream->ignore(4); // or assert 0x00010100
-
-    GetStr(strBuffer, 4);
-    debugLog("DCA check: " + strBuffer); // maybe asset if not DCA
+    std::string extractedName = file.string();
+    extractedName.erase(extractedName.length() - 4);
+    extractedPath = extractedName;
 
-    GetInt32(uintBuffer);
-    debugLog("compressedHeaderLength: " + std::to_string(uintBuffer));
+    VanillaCache::Key cacheKey;
+    if (cache && cache->Enabled()) {
+        cacheKey = VanillaCache::MakeKey(cacheSource, fileData);
+        if (cache->Load(cacheKey, output)) {
+            reader.Reset();
+            sendLog("Dcx loaded from cache: " + Common::PathToU8(file) + "\n");
+            return true;
+        }
+    }
 
     // Decompress
     mz_stream strm;
@@ -112,30 +117,38 @@ bool Dcx::UnpackDcx(std::filesystem::path file, std::vector<char>& output) {
     strm.next_in = nullptr;
 
     if (mz_inflateInit2(&strm, 15) != MZ_OK) {
-        debugLog("ERROR: Failed to initialize miniz inflate stream", LogFormat::BoldRed);
+        debugLog(LogFormat::BoldRed, "ERROR: Failed to initialize miniz inflate stream");
         return false;
     }
 
-    constexpr size_t bufferSize = 32768;
-    std::vector<uint8_t> inBuffer(bufferSize);
-    std::vector<uint8_t> outBuffer(bufferSize);
-    size_t fileSize = fs::file_size(file);
-    int lastNotifiedPercent = 0;
+    std::span<const char> compressed = reader.View(reader.Remaining());
+    strm.next_in = reinterpret_cast<const uint8_t*>(compressed.data());
+    strm.avail_in = static_cast<uint32_t>(compressed.size());
+
+    // the DCS header has the exact size, so inflate straight into the destination. it is only
+    // grown if the header undercounts. the header comes from mod files, so it is capped against
+    // the compressed size before anything is allocated, a bogus one just grows slice by slice
+    constexpr size_t sliceSize = 1024 * 1024;
+    constexpr size_t maxTrustedRatio = 32;
+    output.resize(std::min<size_t>(compInfo.uncompressedSize,
+                                   compressed.size() * maxTrustedRatio + sliceSize));
+    size_t progressStep = std::max<size_t>(output.size() / 10, 1);
+    size_t nextProgress = progressStep;
     int ret;
 
     do {
-        if (strm.avail_in == 0 && !istream->eof()) {
-            istream->read(reinterpret_cast<char*>(inBuffer.data()), bufferSize);
-            strm.avail_in = static_cast<uint32_t>(istream->gcount());
-            strm.next_in = inBuffer.data();
+        size_t produced = strm.total_out;
+        if (produced == output.size()) {
+            output.resize(output.size() + sliceSize);
         }
 
-        strm.avail_out = bufferSize;
-        strm.next_out = outBuffer.data();
+        strm.next_out = reinterpret_cast<uint8_t*>(output.data()) + produced;
+        strm.avail_out = static_cast<uint32_t>(std::min(sliceSize, output.size() - produced));
 
         ret = mz_inflate(&strm, MZ_NO_FLUSH);
 
-        if (ret == MZ_NEED_DICT || ret == MZ_DATA_ERROR || ret == MZ_MEM_ERROR) {
+        if (ret == MZ_NEED_DICT || ret == MZ_DATA_ERROR || ret == MZ_MEM_ERROR ||
+            ret == MZ_BUF_ERROR) {
             mz_inflateEnd(&strm);
             sendLog("ERROR extraction failed due to corrupted stream data. Ret: " +
                         std::to_string(ret),
@@ -143,27 +156,20 @@ bool Dcx::UnpackDcx(std::filesystem::path file, std::vector<char>& output) {
             return false;
         }
 
-        size_t decompressedChunkSize = bufferSize - strm.avail_out;
-        if (decompressedChunkSize > 0) {
-            output.insert(output.end(), outBuffer.begin(),
-                          outBuffer.begin() + decompressedChunkSize);
-
-            int currentPercent =
-                static_cast<int>((static_cast<double>(strm.total_in) / fileSize) * 100);
-            if (currentPercent >= lastNotifiedPercent + 10) {
-                lastNotifiedPercent = currentPercent;
-                sendLog("Extraction progress: " + std::to_string(lastNotifiedPercent) + "% done.",
-                        LogFormat::Default);
-            }
+        if (strm.total_out >= nextProgress && ret == MZ_OK) {
+            int percent = static_cast<int>(strm.total_out / progressStep) * 10;
+            nextProgress = (strm.total_out / progressStep + 1) * progressStep;
+            sendLog("Extraction progress: " + std::to_string(percent) + "% done.",
+                    LogFormat::Default);
         }
+    } while (ret == MZ_OK);
 
-    } while (ret != MZ_STREAM_END && (strm.avail_in > 0 || !istream->eof() || ret == MZ_OK));
-
+    output.resize(strm.total_out);
     mz_inflateEnd(&strm);
 
-    std::string extractedName = file.string();
-    extractedName.erase(extractedName.length() - 4);
-    extractedPath = extractedName;
+    if (cache && cache->Enabled() && !cache->Store(cacheKey, output)) {
+        debugLog(LogFormat::Yellow, "Could not save dcx to cache: {}", Common::PathToU8(file));
+    }
 
     /* tests only
     std::ofstream outFile(extractedPath, std::ios::out | std::ios::binary);
@@ -171,8 +177,8 @@ bool Dcx::UnpackDcx(std::filesystem::path file, std::vector<char>& output) {
                   output.size());
     */
 
-    istream.reset();
-    debugLog("decompressed bytes: " + std::to_string(output.size()));
+    reader.Reset();
+    debugLog("decompressed bytes: {}", output.size());
     sendLog("Dcx extraction completed: " + Common::PathToU8(file) + "\n");
     return true;
 }
@@ -184,132 +190,184 @@ bool Dcx::RepackDcx(std::vector<char> input) {
     }
 
     sendLog("Repacking Dcx: " + Common::PathToU8(origPath) + ", this may take a bit of time...");
-    std::filesystem::remove(origPath);
-    ostream = std::make_unique<std::ofstream>(origPath, std::ios::out | std::ios::binary);
-    std::string strBuffer;
-
-    strBuffer = "DCX";
-    WriteStr(strBuffer, 4);
-
-    WriteInt32(compInfo.unk04);
-    WriteInt32(0x18);
-    WriteInt32(0x24);
-
-    WriteInt32(compInfo.unk10);
-    WriteInt32(compInfo.unk14);
+    // each chunk boundary costs a sync flush marker and a fresh block header
+    size_t chunkCount = (input.size() + deflateOptions.chunkSize - 1) / deflateOptions.chunkSize;
+    writer = SpanWriter(sizeof(Header) + mz_deflateBound(nullptr, input.size()) + chunkCount * 16 +
+                        10);
+
+    Header header{};
+    std::memcpy(header.magic, "DCX", 4);
+    header.unk04 = compInfo.unk04;
+    header.dcsOffset = 0x18;
+    header.dcpOffset = 0x24;
+    header.unk10 = compInfo.unk10;
+    header.unk14 = compInfo.unk14;
+
+    std::memcpy(header.dcsMagic, "DCS", 4);
+    header.uncompressedSize = static_cast<uint32_t>(input.size());
+
+    std::memcpy(header.dcpMagic, "DCP", 4);
+    std::memcpy(header.format, "DFLT", 4);
+    header.dcpSize = 0x20;
+    header.unk30 = compInfo.unk30;
+    header.unk38 = compInfo.unk38;
+    header.unk40 = 0x00010100;
+
+    std::memcpy(header.dcaMagic, "DCA", 4);
+    header.dcaSize = 8;
+
+    // compressed size is patched in once the stream is written
+    WriteStruct(header);
+
+    size_t compressedStart = writer.Tell();
+    uint32_t adler = 1;
+    if (!DeflateParallel(input, adler)) {
+        return false;
+    }
 
-    strBuffer = "DCS";
-    WriteStr(strBuffer, 4);
+    WriteInt32(adler);
+    header.compressedSize = static_cast<uint32_t>(writer.Tell() - compressedStart);
+    PatchStruct(0, header);
 
-    WriteInt32(static_cast<uint>(input.size()));
-    ReserveBytes("CompressedSize", 4);
+    std::vector<char> outputData = writer.Take();
+    std::filesystem::remove(origPath);
+    std::ofstream outFile(origPath, std::ios::out | std::ios::binary);
+    outFile.write(outputData.data(), outputData.size());
+    if (!outFile) {
+        sendLog("ERROR: failed to write dcx file: " + Common::PathToU8(origPath),
+                LogFormat::BoldRed);
+        return false;
+    }
 
-    strBuffer = "DCP";
-    WriteStr(strBuffer, 4);
+    sendLog("Dcx repacking completed: " + Common::PathToU8(origPath.string()) + "\n");
+    return true;
+}
 
-    strBuffer = "DFLT";
-    WriteStr(strBuffer, 4);
+bool Dcx::DeflateParallel(const std::vector<char>& input, uint32_t& adler) {
+    const size_t chunkSize = deflateOptions.chunkSize;
+    const int level = deflateOptions.level;
+
+    std::vector<DeflateChunk> chunks;
+    chunks.reserve((input.size() + chunkSize - 1) / chunkSize);
+    for (size_t offset = 0; offset < input.size(); offset += chunkSize) {
+        DeflateChunk chunk;
+        size_t dictionaryStart = offset - std::min(offset, deflateWindow);
+        chunk.dictionary = std::span<const char>(input).subspan(dictionaryStart,
+                                                                offset - dictionaryStart);
+        chunk.data = std::span<const char>(input).subspan(
+            offset, std::min(chunkSize, input.size() - offset));
+        chunk.last = offset + chunk.data.size() == input.size();
+        chunks.push_back(std::move(chunk));
+    }
 
-    WriteInt32(0x20);
+    int threads = deflateOptions.threads;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
 
-    WriteByte(compInfo.unk30);
-    WriteByte(0);
-    WriteByte(0);
-    WriteByte(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::min(threads, static_cast<int>(chunks.size())));
+
+    // workers only count finished chunks, progress is logged from this thread so it lands in
+    // the log of the file being merged
+    std::mutex progressMutex;
+    std::condition_variable progressChanged;
+    size_t chunksDone = 0;
+    QFuture<void> future = QtConcurrent::map(&pool, chunks, [&](DeflateChunk& chunk) {
+        chunk.status = DeflateChunkData(chunk, level);
+        {
+            std::lock_guard lock(progressMutex);
+            chunksDone++;
+        }
+        progressChanged.notify_one();
+    });
 
-    WriteInt32(0);
+    int lastNotifiedPercent = 0;
+    std::unique_lock lock(progressMutex);
+    while (chunksDone < chunks.size()) {
+        progressChanged.wait(lock);
+        int currentPercent = static_cast<int>(chunksDone * 100 / chunks.size());
+        if (currentPercent >= lastNotifiedPercent + 10) {
+            lastNotifiedPercent = currentPercent / 10 * 10;
+            sendLog("Compression progress: " + std::to_string(lastNotifiedPercent) + "% done.",
+                    LogFormat::Default);
+        }
+    }
+    lock.unlock();
+    future.waitForFinished();
 
-    WriteByte(compInfo.unk38);
-    WriteByte(0);
-    WriteByte(0);
-    WriteByte(0);
+    // chunks are raw deflate, only the stream as a whole carries the zlib header and trailer
+    WriteInt16(ZlibHeader(level));
 
-    WriteInt32(0);
-    WriteInt32(0x00010100);
+    adler = 1;
+    for (const DeflateChunk& chunk : chunks) {
+        if (chunk.status != MZ_OK) {
+            sendLog("ERROR dcx compression failed: " + std::to_string(chunk.status),
+                    LogFormat::BoldRed);
+            return false;
+        }
 
-    strBuffer = "DCA";
-    WriteStr(strBuffer, 4);
-    WriteInt32(8);
+        writer.Write(chunk.output.data(), chunk.output.size());
+        adler = Checksum::Adler32Combine(adler, chunk.adler, chunk.data.size());
+    }
 
-    std::streamoff compressedStart = ostream->tellp();
+    WriteInt32(adler);
+    return true;
+}
 
+int Dcx::DeflateChunkData(DeflateChunk& chunk, int level) {
     mz_stream stream;
     memset(&stream, 0, sizeof(stream));
 
-    int status = mz_deflateInit2(&stream, 9, MZ_DEFLATED, 15, 9, MZ_DEFAULT_STRATEGY);
+    int status = mz_deflateInit2(&stream, level, MZ_DEFLATED, -15, 9, MZ_DEFAULT_STRATEGY);
     if (status != MZ_OK) {
-        sendLog("ERROR dcx deflate stream not initiated: " + std::to_string(status),
-                LogFormat::BoldRed);
-        return false;
+        return status;
     }
 
-    constexpr size_t bufferSize = 32768;
-    std::vector<uint8_t> outBuffer(bufferSize);
-    size_t totalInputSize = input.size();
-    size_t bytesProcessed = 0;
-    int lastNotifiedPercent = 0;
-
-    while (bytesProcessed < totalInputSize) {
-        size_t currentChunkSize = std::min(bufferSize, totalInputSize - bytesProcessed);
-
-        stream.next_in = reinterpret_cast<const uint8_t*>(input.data() + bytesProcessed);
-        stream.avail_in = static_cast<unsigned int>(currentChunkSize);
-
-        bool isLastChunk = (bytesProcessed + currentChunkSize == totalInputSize);
-        int flush = isLastChunk ? MZ_FINISH : MZ_NO_FLUSH;
-
+    // miniz has no deflateSetDictionary, so the window is primed by compressing the previous
+    // chunk's tail and dropping that output. the sync flush leaves the stream byte aligned
+    if (!chunk.dictionary.empty()) {
+        std::vector<uint8_t> scratch(mz_deflateBound(&stream, chunk.dictionary.size()) + 16);
+        stream.next_in = reinterpret_cast<const uint8_t*>(chunk.dictionary.data());
+        stream.avail_in = static_cast<unsigned int>(chunk.dictionary.size());
         do {
-            stream.next_out = outBuffer.data();
-            stream.avail_out = static_cast<unsigned int>(bufferSize);
-
-            status = mz_deflate(&stream, flush);
-            if (status != MZ_OK && status != MZ_STREAM_END) {
-                mz_deflateEnd(&stream);
-                sendLog("ERROR dcx compression failed: " + std::to_string(status),
-                        LogFormat::BoldRed);
-                return false;
-            }
-
-            size_t compressedChunkSize = bufferSize - stream.avail_out;
-            if (compressedChunkSize > 0) {
-                ostream->write(reinterpret_cast<const char*>(outBuffer.data()),
-                               compressedChunkSize);
-            }
-        } while (stream.avail_out == 0);
-
-        bytesProcessed += currentChunkSize;
-
-        int currentPercent =
-            static_cast<int>((static_cast<double>(bytesProcessed) / totalInputSize) * 100);
-        if (currentPercent >= lastNotifiedPercent + 10) {
-            lastNotifiedPercent += 10;
-            sendLog("Compression progress: " + std::to_string(lastNotifiedPercent) + "% done.",
-                    LogFormat::Default);
+            stream.next_out = scratch.data();
+            stream.avail_out = static_cast<unsigned int>(scratch.size());
+            status = mz_deflate(&stream, MZ_SYNC_FLUSH);
+        } while (status == MZ_OK && stream.avail_out == 0);
+
+        if (status != MZ_OK) {
+            mz_deflateEnd(&stream);
+            return status;
         }
     }
 
-    mz_deflateEnd(&stream);
-
-    WriteInt32(Adler32(input));
-    FillReservedInt32("CompressedSize", static_cast<int>(ostream->tellp() - compressedStart));
-
-    ostream.reset();
-    sendLog("Dcx repacking completed: " + Common::PathToU8(origPath.string()) + "\n");
-    return true;
-}
+    // non final chunks end on a sync flush so the next chunk's output can be appended as is
+    int flush = chunk.last ? MZ_FINISH : MZ_SYNC_FLUSH;
+    chunk.output.resize(mz_deflateBound(&stream, chunk.data.size()) + 16);
+    stream.next_in = reinterpret_cast<const uint8_t*>(chunk.data.data());
+    stream.avail_in = static_cast<unsigned int>(chunk.data.size());
+    stream.next_out = chunk.output.data();
+    stream.avail_out = static_cast<unsigned int>(chunk.output.size());
+
+    status = mz_deflate(&stream, flush);
+    while (status == MZ_OK && (stream.avail_in > 0 || stream.avail_out == 0)) {
+        size_t used = chunk.output.size() - stream.avail_out;
+        chunk.output.resize(chunk.output.size() * 2);
+        stream.next_out = chunk.output.data() + used;
+        stream.avail_out = static_cast<unsigned int>(chunk.output.size() - used);
+        status = mz_deflate(&stream, flush);
+    }
 
-uint32_t Dcx::Adler32(const std::vector<char>& data) {
-    uint32_t adlerA = 1;
-    uint32_t adlerB = 0;
+    chunk.output.resize(chunk.output.size() - stream.avail_out);
+    mz_deflateEnd(&stream);
 
-    const uint8_t* udata = reinterpret_cast<const uint8_t*>(data.data());
-    size_t length = data.size();
-    for (size_t i = 0; i < length; ++i) {
-        adlerA = (adlerA + udata[i]) % 65521;
-        adlerB = (adlerB + adlerA) % 65521;
+    if (status != (chunk.last ? MZ_STREAM_END : MZ_OK)) {
+        return status == MZ_OK ? MZ_BUF_ERROR : status;
     }
 
-    return (adlerB << 16) | adlerA;
+    chunk.adler = Checksum::Adler32(chunk.data);
+    return MZ_OK;
 }
 
 Dcx::~Dcx() {}
@@ -6,6 +6,7 @@
 #include <filesystem>
 
 #include "BBFormats.h"
+#include "VanillaCache.h"
 
 namespace FileHelper {
 
@@ -13,26 +14,77 @@ class Dcx : public BBFormat {
     Q_OBJECT
 
 private:
-    struct CompressionInfo {
-        int unk04;
-        int unk10;
-        int unk14;
-        int unk30;
-        int unk38;
+    // DCX, DCS, DCP and DCA blocks in front of the deflate stream
+    struct Header {
+        char magic[4];
+        int32_t unk04;
+        int32_t dcsOffset; // 0x18
+        int32_t dcpOffset; // 0x24
+        int32_t unk10;
+        int32_t unk14;
+        char dcsMagic[4];
+        uint32_t uncompressedSize;
+        uint32_t compressedSize;
+        char dcpMagic[4];
+        char format[4];
+        int32_t dcpSize; // 0x20
+        uint8_t unk30;
+        uint8_t pad31[3];
+        int32_t unk34;
+        uint8_t unk38;
+        uint8_t pad39[3];
+        int32_t unk3C;
+        int32_t unk40; // 0x00010100
+        char dcaMagic[4];
+        int32_t dcaSize; // 8
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.unk04, h.dcsOffset, h.dcpOffset, h.unk10, h.unk14,
+                            h.uncompressedSize, h.compressedSize, h.dcpSize, h.unk34, h.unk3C,
+                            h.unk40, h.dcaSize);
+        }
+    };
+    static_assert(sizeof(Header) == 0x4C);
+
+    // one slice of the input, deflated on its own with the tail of the previous slice as its
+    // window so matches still reach across the boundary
+    struct DeflateChunk {
+        std::span<const char> dictionary;
+        std::span<const char> data;
+        bool last = false;
+        std::vector<uint8_t> output;
+        uint32_t adler = 1;
+        int status = 0;
     };
 
-    uint32_t Adler32(const std::vector<char>& data);
+    bool DeflateParallel(const std::vector<char>& input, uint32_t& adler);
+    static int DeflateChunkData(DeflateChunk& chunk, int level);
 
     std::filesystem::path origPath;
     std::filesystem::path extractedPath;
-    CompressionInfo compInfo;
+    Header compInfo;
 
 public:
-    explicit Dcx(ModMerger* parent);
+    struct DeflateOptions {
+        int level = 9;
+        int threads = 0; // 0 uses every hardware thread
+        size_t chunkSize = 128 * 1024;
+    };
+
+    explicit Dcx(MergeEngine* parent);
     ~Dcx() override;
 
+    void SetDeflateOptions(const DeflateOptions& options);
+    // decompressed output is looked up in and saved to the cache, keyed on the original file
+    void SetCache(VanillaCache* cache, const std::filesystem::path& source);
+
     bool UnpackDcx(std::filesystem::path file, std::vector<char>& output);
     bool RepackDcx(std::vector<char> input);
+
+private:
+    DeflateOptions deflateOptions;
+    VanillaCache* cache = nullptr;
+    std::filesystem::path cacheSource;
 };
 
 } // namespace FileHelper
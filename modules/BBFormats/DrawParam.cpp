@@ -9,25 +9,24 @@ namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-DrawParam::DrawParam(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+DrawParam::DrawParam(std::vector<char>& data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     ReadDrawParam(data);
 }
 
-bool DrawParam::ReadDrawParam(std::vector<char>& data) {
+bool DrawParam::ReadDrawParam(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty drawparam input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
     int intBuffer = 0;
     std::string strBuffer;
 
     GetStr(strBuffer, 8);
-    debugLog("MAGIC: " + strBuffer);
+    debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("filt")) {
         sendLog("ERROR invalid param header: " + strBuffer, LogFormat::BoldRed);
@@ -35,7 +34,7 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
     }
 
     GetInt32(intBuffer);
-    debugLog("Game: " + std::to_string(intBuffer));
+    debugLog("Game: {}", intBuffer);
 
     if (intBuffer != 3) {
         sendLog("ERROR invalid game ID: " + std::to_string(intBuffer), LogFormat::BoldRed);
@@ -43,27 +42,27 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
     }
 
     GetByte(intBuffer);
-    debugLog("Zero check: " + std::to_string(intBuffer));
+    debugLog("Zero check: {}", intBuffer);
 
     // handle if not 0?
 
     GetByte(unk0D);
-    debugLog("Unk0D: " + std::to_string(unk0D));
+    debugLog("Unk0D: {}", unk0D);
 
     GetInt16(intBuffer);
-    debugLog("Zero check: " + std::to_string(intBuffer));
+    debugLog("Zero check: {}", intBuffer);
 
     // handle if not 0?
 
     int groupCount = 0;
     GetInt32(groupCount);
-    debugLog("group count: " + std::to_string(groupCount));
+    debugLog("group count: {}", groupCount);
 
     GetInt32(unk14);
-    debugLog("unk14: " + std::to_string(unk14));
+    debugLog("unk14: {}", unk14);
 
     GetInt32(intBuffer);
-    debugLog("header check: " + std::to_string(intBuffer));
+    debugLog("header check: {}", intBuffer);
     // or assert targetValue == 0x40, 0x50, 0x54 (BB always 0x50?)
 
     Offsets offsets;
@@ -74,34 +73,34 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
     GetInt32(offsets.valueIDs);
     GetInt32(offsets.unk2);
 
-    debugLog("offsets groupheader: " + std::to_string(offsets.groupHeaders));
-    debugLog("offsets ParamHeaderOffsets: " + std::to_string(offsets.paramHeaderOffsets));
-    debugLog("offsets param headers: " + std::to_string(offsets.paramHeaders));
-    debugLog("offsets values: " + std::to_string(offsets.values));
-    debugLog("offsets ValueIDs: " + std::to_string(offsets.valueIDs));
-    debugLog("offsets Unk2: " + std::to_string(offsets.unk2));
+    debugLog("offsets groupheader: {}", offsets.groupHeaders);
+    debugLog("offsets ParamHeaderOffsets: {}", offsets.paramHeaderOffsets);
+    debugLog("offsets param headers: {}", offsets.paramHeaders);
+    debugLog("offsets values: {}", offsets.values);
+    debugLog("offsets ValueIDs: {}", offsets.valueIDs);
+    debugLog("offsets Unk2: {}", offsets.unk2);
 
     int unk3Count = 0;
     GetInt32(unk3Count);
-    debugLog("unk3Count: " + std::to_string(unk3Count));
+    debugLog("unk3Count: {}", unk3Count);
 
     GetInt32(offsets.unk3);
-    debugLog("offsets unk3: " + std::to_string(offsets.unk3));
+    debugLog("offsets unk3: {}", offsets.unk3);
 
     GetInt32(offsets.unk3ValueIDs);
-    debugLog("offsets unk3 value ids: " + std::to_string(offsets.unk3ValueIDs));
+    debugLog("offsets unk3 value ids: {}", offsets.unk3ValueIDs);
 
     GetFloat(unk40);
-    debugLog("unk40: " + std::format("{:.3f}", unk40));
+    debugLog("unk40: {:.3f}", unk40);
 
     GetInt32(offsets.commentOffsetsOffsets);
-    debugLog("offsets.CommentOffsetsOffsets: " + std::to_string(offsets.commentOffsetsOffsets));
+    debugLog("offsets.CommentOffsetsOffsets: {}", offsets.commentOffsetsOffsets);
 
     GetInt32(offsets.commentOffsets);
-    debugLog("offsets.CommentOffsets: " + std::to_string(offsets.commentOffsets));
+    debugLog("offsets.CommentOffsets: {}", offsets.commentOffsets);
 
     GetInt32(offsets.comments);
-    debugLog("offsets.Comments: " + std::to_string(offsets.comments));
+    debugLog("offsets.Comments: {}", offsets.comments);
 
     debugLog("");
 
@@ -109,61 +108,60 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
         ParamGroup group;
         int groupHeaderOffset = 0;
         GetInt32(groupHeaderOffset);
-        debugLog("Group header offset: " + std::to_string(groupHeaderOffset));
+        debugLog("Group header offset: {}", groupHeaderOffset);
 
-        StepIn(offsets.groupHeaders + groupHeaderOffset, *istream);
+        StepIn(offsets.groupHeaders + groupHeaderOffset, reader);
         {
             int paramCount = 0;
             GetInt32(paramCount);
-            debugLog(std::format("Group: {} Param count: {}", i, paramCount));
+            debugLog("Group: {} Param count: {}", i, paramCount);
 
             int paramHeaderOffsetsOffset = 0;
             GetInt32(paramHeaderOffsetsOffset);
-            debugLog(
-                std::format("Group: {} Param headeroffsetoffset: {}", i, paramHeaderOffsetsOffset));
+            debugLog("Group: {} Param headeroffsetoffset: {}", i, paramHeaderOffsetsOffset);
 
             group.name1 = ReadUtf16String();
             group.name2 = ReadUtf16String();
 
-            debugLog("groupName1: " + group.name1);
-            debugLog("groupName2: " + group.name2);
+            debugLog("groupName1: {}", group.name1);
+            debugLog("groupName2: {}", group.name2);
 
-            StepIn(offsets.paramHeaderOffsets + paramHeaderOffsetsOffset, *istream);
+            StepIn(offsets.paramHeaderOffsets + paramHeaderOffsetsOffset, reader);
             {
                 for (int i = 0; i < paramCount; ++i) {
                     Param param;
                     int paramHeaderOffset = 0;
                     GetInt32(paramHeaderOffset);
-                    debugLog("param header offset: " + std::to_string(paramHeaderOffset));
+                    debugLog("param header offset: {}", paramHeaderOffset);
 
-                    StepIn(offsets.paramHeaders + paramHeaderOffset, *istream);
+                    StepIn(offsets.paramHeaders + paramHeaderOffset, reader);
                     {
                         int valuesOffset = 0;
                         GetInt32(valuesOffset);
-                        debugLog("valuesoffset: " + std::to_string(valuesOffset));
+                        debugLog("valuesoffset: {}", valuesOffset);
 
                         int valueIdsOffset = 0;
                         GetInt32(valueIdsOffset);
-                        debugLog("valueIdsOffset: " + std::to_string(valueIdsOffset));
+                        debugLog("valueIdsOffset: {}", valueIdsOffset);
 
                         int intType = 0;
                         GetByte(intType);
                         param.type = static_cast<ParamType>(intType);
-                        debugLog("type: " + std::to_string(intType));
+                        debugLog("type: {}", intType);
 
                         int valueCount = 0;
                         GetByte(valueCount);
-                        debugLog("valueCount: " + std::to_string(valueCount));
+                        debugLog("valueCount: {}", valueCount);
 
-                        istream->ignore(2); // or check zero
+                        reader.Skip(2); // or check zero
 
                         param.name1 = ReadUtf16String();
                         param.name2 = ReadUtf16String();
 
-                        debugLog("paramName1: " + param.name1);
-                        debugLog("paramName2: " + param.name2);
+                        debugLog("paramName1: {}", param.name1);
+                        debugLog("paramName2: {}", param.name2);
 
-                        StepIn(offsets.values + valuesOffset, *istream);
+                        StepIn(offsets.values + valuesOffset, reader);
                         {
                             {
                                 for (int i = 0; i < valueCount; ++i) {
@@ -226,7 +224,7 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
                                         floatVec.push_back(f);
 
                                         value.value = floatVec;
-                                        istream->ignore(8); // or assert 0
+                                        reader.Skip(8); // or assert 0
 
                                         for (const auto& ent : floatVec) {
                                             s = s + std::format("{:.3f}", ent) + " ";
@@ -241,7 +239,7 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
                                         floatVec.push_back(f);
 
                                         value.value = floatVec;
-                                        istream->ignore(4); // or assert 0
+                                        reader.Skip(4); // or assert 0
 
                                         for (const auto& ent : floatVec) {
                                             s = s + std::format("{:.3f}", ent) + " ";
@@ -272,42 +270,42 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
                                     }
 
                                     param.values.push_back(value);
-                                    debugLog("Added value: " + s);
+                                    debugLog("Added value: {}", s);
                                 }
                             }
                         }
                         debugLog("");
-                        StepOut(*istream);
+                        StepOut(reader);
 
-                        StepIn(offsets.valueIDs + valueIdsOffset, *istream);
+                        StepIn(offsets.valueIDs + valueIdsOffset, reader);
                         {
                             for (int i = 0; i < valueCount; ++i) {
                                 GetInt32(param.values[i].id);
-                                debugLog("Value ID: " + std::to_string(param.values[i].id));
+                                debugLog("Value ID: {}", param.values[i].id);
                             }
                         }
-                        StepOut(*istream);
+                        StepOut(reader);
                     }
-                    StepOut(*istream);
+                    StepOut(reader);
 
                     group.params.push_back(param);
                     debugLog("");
                 }
             }
-            StepOut(*istream);
+            StepOut(reader);
         }
-        StepOut(*istream);
+        StepOut(reader);
         groups.push_back(group);
         debugLog("");
     }
 
-    istream->seekg(offsets.unk2);
+    reader.Seek(offsets.unk2);
     unkBlock2.resize(offsets.unk3 - offsets.unk2);
-    istream->read(unkBlock2.data(), offsets.unk3 - offsets.unk2);
+    reader.Read(unkBlock2.data(), offsets.unk3 - offsets.unk2);
 
-    debugLog("unk2 block saved size: " + std::to_string(unkBlock2.size()));
+    debugLog("unk2 block saved size: {}", unkBlock2.size());
 
-    istream->seekg(offsets.unk3);
+    reader.Seek(offsets.unk3);
     for (int i = 0; i < unk3Count; ++i) {
         Unk3 u;
         int count;
@@ -317,58 +315,58 @@ bool DrawParam::ReadDrawParam(std::vector<char>& data) {
         GetInt32(count);
         GetInt32(valueIdsOffset);
 
-        debugLog("unk3 group index: " + std::to_string(u.groupIndex));
-        debugLog("unk3 group count: " + std::to_string(count));
-        debugLog("unk3 group valueidoffset: " + std::to_string(valueIdsOffset));
+        debugLog("unk3 group index: {}", u.groupIndex);
+        debugLog("unk3 group count: {}", count);
+        debugLog("unk3 group valueidoffset: {}", valueIdsOffset);
 
-        StepIn(offsets.unk3ValueIDs + valueIdsOffset, *istream);
+        StepIn(offsets.unk3ValueIDs + valueIdsOffset, reader);
         for (int j = 0; j < count; ++j) {
             int id = 0;
             GetInt32(id);
             u.valueIDs.push_back(id);
 
-            debugLog("unk3 value id: " + std::to_string(id));
+            debugLog("unk3 value id: {}", id);
         }
-        StepOut(*istream);
+        StepOut(reader);
 
         unk3s.push_back(u);
     }
 
-    istream->seekg(offsets.commentOffsetsOffsets);
+    reader.Seek(offsets.commentOffsetsOffsets);
     std::vector<int> commentOffsetsOffsets;
     for (int i = 0; i < groupCount; ++i) {
         int off = 0;
         GetInt32(off);
         commentOffsetsOffsets.push_back(off);
 
-        debugLog("group: " + std::to_string(i) + " comment offset: " + std::to_string(off));
+        debugLog("group: {} comment offset: {}", i, off);
     }
 
     int commentOffsetsLength = offsets.comments - offsets.commentOffsets;
-    debugLog("comment offset length: " + std::to_string(commentOffsetsLength));
+    debugLog("comment offset length: {}", commentOffsetsLength);
 
     for (int i = 0; i < groupCount; ++i) {
         int commentCount = i != groupCount - 1
                                ? (commentOffsetsOffsets[i + 1] - commentOffsetsOffsets[i]) / 4
                                : (commentOffsetsLength - commentOffsetsOffsets[i]) / 4;
 
-        debugLog("group: " + std::to_string(i) + " comment count: " + std::to_string(commentCount));
-        istream->seekg(offsets.commentOffsets + commentOffsetsOffsets[i]);
+        debugLog("group: {} comment count: {}", i, commentCount);
+        reader.Seek(offsets.commentOffsets + commentOffsetsOffsets[i]);
 
         for (int j = 0; j < commentCount; ++j) {
             int32_t commentOffset = 0;
             GetInt32(commentOffset);
 
-            StepIn(offsets.comments + commentOffset, *istream);
+            StepIn(offsets.comments + commentOffset, reader);
             std::string comment = ReadUtf16String();
-            StepOut(*istream);
+            StepOut(reader);
 
             groups[i].comments.push_back(comment);
-            debugLog("group: " + std::to_string(i) + " comment: " + comment);
+            debugLog("group: {} comment: {}", i, comment);
         }
     }
 
-    istream.reset();
+    reader.Reset();
     sendLog("Drawparam loaded");
     return true;
 }
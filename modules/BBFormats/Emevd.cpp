@@ -4,263 +4,205 @@
 #include <vector>
 
 #include "Emevd.h"
-#include "modules/ModMerger.h"
+#include "MergeJoin.h"
+#include "SequenceDiff.h"
+#include "modules/Checksum.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Emevd::Emevd(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+Emevd::Emevd(std::span<const char> data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     ReadEmevd(data);
 }
 
-bool Emevd::ReadEmevd(std::vector<char>& data) {
+bool Emevd::ReadEmevd(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty fmg input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
     std::string strBuffer = "";
-    int intBuffer = 0;
-    int64_t int64Buffer = 0;
 
-    GetStr(strBuffer, 4);
-    debugLog("MAGIC: " + strBuffer);
+    Header header;
+    ReadStruct(header);
+
+    strBuffer = std::string(header.magic, 4);
+    debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("EVD")) {
         sendLog("ERROR invalid emevd header: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    GetByte(intBuffer); // bigendian, should be 0
-    debugLog("bigEndian: " + std::to_string(intBuffer));
-
-    char sByte;
-    istream->read(&sByte, 1);              // signed byte
-    int is64Bit = static_cast<int>(sByte); // is64bit, should be -1, assert 0/-1?
-    debugLog("is64bit: " + std::to_string(is64Bit));
-
-    GetByte(intBuffer); // unk06 should be 0
-    debugLog("unk06: " + std::to_string(intBuffer));
-
-    GetByte(intBuffer); // unk07 should be 0
-    debugLog("unk07: " + std::to_string(intBuffer));
-
-    GetInt32(intBuffer); // version should be 0xCC / 204
-    debugLog("version: " + std::to_string(intBuffer));
-
-    GetInt32(intBuffer);
-    debugLog("fileSize: " + std::to_string(intBuffer));
+    debugLog("bigEndian: {}", header.bigEndian); // should be 0
+    debugLog("is64bit: {}", header.is64Bit); // should be -1, assert 0/-1?
+    debugLog("unk06: {}", header.unk06);     // should be 0
+    debugLog("unk07: {}", header.unk07);     // should be 0
+    debugLog("version: {}", header.version); // should be 0xCC / 204
+    debugLog("fileSize: {}", header.fileSize);
 
     Offsets offsets;
 
-    int64_t eventCount = 0;
-    GetInt64(eventCount);
-    debugLog("eventCount: " + std::to_string(eventCount));
-
-    GetInt64(offsets.events);
-    debugLog("offsets.events: " + std::to_string(offsets.events));
-
-    GetInt64(int64Buffer);
-    debugLog("instruction count: " + std::to_string(int64Buffer));
-
-    GetInt64(offsets.instructions);
-    debugLog("offsets.instructions: " + std::to_string(offsets.instructions));
-
-    GetInt64(int64Buffer); // should be 0
-    debugLog("zero check: " + std::to_string(int64Buffer));
+    int64_t eventCount = header.eventCount;
+    debugLog("eventCount: {}", eventCount);
 
-    istream->ignore(8); // unknown struct offset
+    offsets.events = header.eventsOffset;
+    debugLog("offsets.events: {}", offsets.events);
+    debugLog("instruction count: {}", header.instructionCount);
 
-    GetInt64(int64Buffer);
-    debugLog("layer count: " + std::to_string(int64Buffer));
+    offsets.instructions = header.instructionsOffset;
+    debugLog("offsets.instructions: {}", offsets.instructions);
+    debugLog("zero check: {}", header.unk30);
+    debugLog("layer count: {}", header.layerCount);
 
-    GetInt64(offsets.layers);
-    debugLog("offsets.layers: " + std::to_string(offsets.layers));
+    offsets.layers = header.layersOffset;
+    debugLog("offsets.layers: {}", offsets.layers);
+    debugLog("parameter count: {}", header.parameterCount);
 
-    GetInt64(int64Buffer);
-    debugLog("parameter count: " + std::to_string(int64Buffer));
+    offsets.parameters = header.parametersOffset;
+    debugLog("offsets.parameters: {}", offsets.parameters);
 
-    GetInt64(offsets.parameters);
-    debugLog("offsets.parameters: " + std::to_string(offsets.parameters));
+    int64_t linkedFileCount = header.linkedFileCount;
+    debugLog("linkedFileCount: {}", linkedFileCount);
 
-    int64_t linkedFileCount = 0;
-    GetInt64(linkedFileCount);
-    debugLog("linkedFileCount: " + std::to_string(linkedFileCount));
+    offsets.linkedFiles = header.linkedFilesOffset;
+    debugLog("offsets.linkedFiles: {}", offsets.linkedFiles);
+    debugLog("arg data length: {}", header.argumentsLength);
 
-    GetInt64(offsets.linkedFiles);
-    debugLog("offsets.linkedFiles: " + std::to_string(offsets.linkedFiles));
+    offsets.arguments = header.argumentsOffset;
+    debugLog("offsets.arguments: {}", offsets.arguments);
 
-    GetInt64(int64Buffer);
-    debugLog("arg data length: " + std::to_string(int64Buffer));
+    int64_t stringsLength = header.stringsLength;
+    debugLog("stringsLength: {}", stringsLength);
 
-    GetInt64(offsets.arguments);
-    debugLog("offsets.arguments: " + std::to_string(offsets.arguments));
+    offsets.strings = header.stringsOffset;
+    debugLog("offsets.strings: {}", offsets.strings);
 
-    int64_t stringsLength = 0;
-    GetInt64(stringsLength);
-    debugLog("stringsLength: " + std::to_string(stringsLength));
-
-    GetInt64(offsets.strings);
-    debugLog("offsets.strings: " + std::to_string(offsets.strings));
-
-    istream->seekg(offsets.events);
+    reader.Seek(offsets.events);
     for (int i = 0; i < eventCount; i++) {
         Event ev;
+        EventHeader evHeader;
+        ReadStruct(evHeader);
 
-        GetInt64(ev.id);
-        debugLog("ev.id: " + std::to_string(ev.id));
-
-        int64_t instructionCount = 0;
-        GetInt64(instructionCount);
-        debugLog("instructionCount: " + std::to_string(instructionCount));
+        ev.id = evHeader.id;
+        debugLog("ev.id: {}", ev.id);
 
-        int64_t instructionsOffset = 0;
-        GetInt64(instructionsOffset);
-        debugLog("instructionOffset: " + std::to_string(instructionsOffset));
+        int64_t instructionCount = evHeader.instructionCount;
+        debugLog("instructionCount: {}", instructionCount);
 
-        int64_t parameterCount = 0;
-        GetInt64(parameterCount);
-        debugLog("parameterCount: " + std::to_string(parameterCount));
+        int64_t instructionsOffset = evHeader.instructionsOffset;
+        debugLog("instructionOffset: {}", instructionsOffset);
 
-        int64_t parametersOffset = 0;
-        GetInt64(parametersOffset);
-        debugLog("parametersOffset: " + std::to_string(parametersOffset));
+        int64_t parameterCount = evHeader.parameterCount;
+        debugLog("parameterCount: {}", parameterCount);
 
-        GetInt32(intBuffer);
-        ev.restBehavior = static_cast<RestBehaviorType>(intBuffer);
-        debugLog("ev.restBehavior: " + std::to_string(intBuffer));
+        int64_t parametersOffset = evHeader.parametersOffset;
+        debugLog("parametersOffset: {}", parametersOffset);
 
-        GetInt32(intBuffer);
-        debugLog("zero check: " + std::to_string(intBuffer));
+        ev.restBehavior = static_cast<RestBehaviorType>(evHeader.restBehavior);
+        debugLog("ev.restBehavior: {}", evHeader.restBehavior);
+        debugLog("zero check: {}", evHeader.pad2C);
 
         if (instructionCount > 0) {
-            StepIn(offsets.instructions + instructionsOffset, *istream);
+            StepIn(offsets.instructions + instructionsOffset, reader);
             {
                 for (int j = 0; j < instructionCount; j++) {
                     Instruction inst;
-                    GetInt32(inst.bank);
-                    debugLog("inst.bank: " + std::to_string(inst.bank));
+                    InstructionHeader instHeader;
+                    ReadStruct(instHeader);
 
-                    GetInt32(inst.id);
-                    debugLog("inst.id: " + std::to_string(inst.id));
+                    inst.bank = instHeader.bank;
+                    debugLog("inst.bank: {}", inst.bank);
 
-                    int64_t argsLength = 0;
-                    GetInt64(argsLength);
-                    debugLog("argsLength: " + std::to_string(argsLength));
+                    inst.id = instHeader.id;
+                    debugLog("inst.id: {}", inst.id);
 
-                    int64_t argsOffset = 0;
-                    GetInt64(argsOffset);
-                    debugLog("argsOffset: " + std::to_string(argsOffset));
+                    int64_t argsLength = instHeader.argsLength;
+                    debugLog("argsLength: {}", argsLength);
 
-                    int layerOffset = 0;
-                    GetInt32(layerOffset);
-                    debugLog("layerOffset: " + std::to_string(layerOffset));
+                    int64_t argsOffset = instHeader.argsOffset;
+                    debugLog("argsOffset: {}", argsOffset);
 
-                    istream->ignore(4); // or assert 0
+                    int layerOffset = instHeader.layerOffset;
+                    debugLog("layerOffset: {}", layerOffset);
 
                     if (argsLength > 0) {
-                        StepIn(offsets.arguments + argsOffset, *istream);
+                        StepIn(offsets.arguments + argsOffset, reader);
                         GetBytes(inst.argData, static_cast<int>(argsLength));
-                        StepOut(*istream);
+                        StepOut(reader);
                     } else {
                         inst.argData = {};
                     }
 
                     if (layerOffset != -1) {
-                        StepIn(offsets.layers + layerOffset, *istream);
+                        StepIn(offsets.layers + layerOffset, reader);
                         {
                             uint buf = 0;
                             GetInt32(buf);
                             inst.layer = buf;
-                            debugLog("inst.layer " + std::to_string(inst.layer.value()));
+                            debugLog("inst.layer {}", inst.layer.value());
 
                             // br.AssertVarint(0); not doing the asserts
                             // br.AssertVarint(-1);
                             // br.AssertVarint(1);
                         }
-                        StepOut(*istream);
+                        StepOut(reader);
                     }
 
                     ev.instructions.push_back(inst);
                 }
             }
-            StepOut(*istream);
+            StepOut(reader);
         }
 
         if (parameterCount > 0) {
-            StepIn(offsets.parameters + parametersOffset, *istream);
+            StepIn(offsets.parameters + parametersOffset, reader);
             {
                 for (int j = 0; j < parameterCount; j++) {
                     Parameter p;
+                    ReadStruct(p);
 
-                    GetInt64(p.instructionIndex);
-                    debugLog("p.instructionIndex: " + std::to_string(p.instructionIndex));
-
-                    GetInt64(p.targetStartByte);
-                    debugLog("p.targetStartByte: " + std::to_string(p.targetStartByte));
-
-                    GetInt64(p.sourceStartByte);
-                    debugLog("p.sourceStartByte: " + std::to_string(p.sourceStartByte));
-
-                    GetInt32(p.byteCount);
-                    debugLog("p.byteCount: " + std::to_string(p.byteCount));
-
-                    GetInt32(p.unkID);
-                    debugLog("p.unkID: " + std::to_string(p.unkID));
+                    debugLog("p.instructionIndex: {}", p.instructionIndex);
+                    debugLog("p.targetStartByte: {}", p.targetStartByte);
+                    debugLog("p.sourceStartByte: {}", p.sourceStartByte);
+                    debugLog("p.byteCount: {}", p.byteCount);
+                    debugLog("p.unkID: {}", p.unkID);
 
                     ev.parameters.push_back(p);
                 }
             }
-            StepOut(*istream);
+            StepOut(reader);
         }
 
         events.push_back(ev);
     }
 
-    istream->seekg(offsets.linkedFiles);
+    reader.Seek(offsets.linkedFiles);
     for (int i = 0; i < linkedFileCount; i++) {
         int64_t off;
         GetInt64(off);
-        debugLog("linkedfileoffset: " + std::to_string(off));
+        debugLog("linkedfileoffset: {}", off);
 
         linkedData.linkedFileOffsets.push_back(off);
     }
 
-    istream->seekg(offsets.strings);
+    reader.Seek(offsets.strings);
     GetBytes(linkedData.stringData, stringsLength);
 
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
 bool Emevd::RepackEmevd(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
-
-    strBuffer = "EVD";
-    WriteStr(strBuffer, 4);
-
-    WriteByte(0);
-    WriteByte(-1);
-    WriteByte(0);
-    WriteByte(0);
-
-    WriteInt32(204);
-    ReserveBytes("FileSize", 4);
-
-    Offsets offsets;
-
-    WriteInt64(static_cast<int64_t>(events.size()));
-    ReserveBytes("EventsOffset", 8);
-
     int64_t instCount = 0;
     int64_t layersCount = 0;
     int64_t parametersCount = 0;
+    size_t argumentsSize = 0;
 
     for (const Event& ev : events) {
         parametersCount += ev.parameters.size();
@@ -269,169 +211,171 @@ bool Emevd::RepackEmevd(std::vector<char>& outputData) {
             if (inst.layer.has_value()) {
                 layersCount += 1;
             }
+            argumentsSize += (inst.argData.size() + 3) & ~size_t{3};
         }
     }
-    WriteInt64(instCount);
-    ReserveBytes("InstructionsOffset", 8);
 
-    WriteInt64(static_cast<int64_t>(0));
-    ReserveBytes("Offset3", 8);
-    WriteInt64(layersCount);
-    ReserveBytes("LayersOffset", 8);
+    // layout pass: every block size is known from the counts above
+    writer = SpanWriter(sizeof(Header) + events.size() * sizeof(EventHeader) +
+                        (instCount + layersCount) * sizeof(InstructionHeader) + argumentsSize +
+                        0x10 + parametersCount * sizeof(Parameter) +
+                        linkedData.linkedFileOffsets.size() * 8 + linkedData.stringData.size());
+
+    struct EventSlots {
+        Reserved<int64_t> instrsOffset;
+        Reserved<int32_t> paramsOffset;
+    };
+    struct InstructionSlots {
+        Reserved<int32_t> argsOffset;
+        Reserved<int32_t> layerOffset;
+    };
+    std::vector<EventSlots> eventSlots(events.size());
+    std::vector<InstructionSlots> instSlots(instCount);
+
+    Header header{};
+    std::memcpy(header.magic, "EVD", 4);
+    header.is64Bit = -1;
+    header.version = 204;
+    header.eventCount = static_cast<int64_t>(events.size());
+    header.instructionCount = instCount;
+    header.layerCount = layersCount;
+    header.parameterCount = parametersCount;
+    header.linkedFileCount = static_cast<int64_t>(linkedData.linkedFileOffsets.size());
+    header.stringsLength = static_cast<int64_t>(linkedData.stringData.size());
+
+    // offsets and the file size are filled in at the end
+    WriteStruct(header);
 
-    WriteInt64(parametersCount);
-    ReserveBytes("ParametersOffset", 8);
-    WriteInt64(static_cast<int64_t>(linkedData.linkedFileOffsets.size()));
-    ReserveBytes("LinkedFilesOffset", 8);
-
-    ReserveBytes("ArgumentsLength", 8);
-    ReserveBytes("ArgumentsOffset", 8);
-    WriteInt64(static_cast<int64_t>(linkedData.stringData.size()));
-    ReserveBytes("StringsOffset", 8);
-
-    offsets.events = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("EventsOffset", offsets.events);
+    Offsets offsets;
+    offsets.events = static_cast<int64_t>(writer.Tell());
+    header.eventsOffset = offsets.events;
 
     for (int i = 0; i < events.size(); i++) {
-        Event ev = events[i];
+        const Event& ev = events[i];
 
         WriteInt64(ev.id);
         WriteInt64(static_cast<int64_t>(ev.instructions.size()));
 
-        std::string evInstOff = std::format("Event{}InstrsOffset", i);
-        ReserveBytes(evInstOff, 8);
+        eventSlots[i].instrsOffset = ReserveInt64();
 
         WriteInt64(static_cast<int64_t>(ev.parameters.size()));
 
-        std::string evParamsOff = std::format("Event{}ParamsOffset", i);
-        ReserveBytes(evParamsOff, 4);
+        eventSlots[i].paramsOffset = ReserveInt32();
         WriteInt32(0);
 
         WriteInt32(static_cast<uint>(ev.restBehavior));
         WriteInt32(0);
     }
 
-    offsets.instructions = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("InstructionsOffset", offsets.instructions);
+    offsets.instructions = static_cast<int64_t>(writer.Tell());
+    header.instructionsOffset = offsets.instructions;
 
+    // instruction slots are stored flat, in the same order the instructions are written
+    size_t slotIndex = 0;
     for (int i = 0; i < events.size(); i++) {
         const Event& ev = events[i];
 
-        int64_t currentPos = static_cast<int64_t>(ostream->tellp());
+        int64_t currentPos = static_cast<int64_t>(writer.Tell());
         int64_t instrsOffset = ev.instructions.size() > 0 ? currentPos - offsets.instructions : -1;
-
-        std::string evInstOff = std::format("Event{}InstrsOffset", i);
-        FillReservedInt64(evInstOff, instrsOffset);
+        FillReservedInt64(eventSlots[i].instrsOffset, instrsOffset);
 
         for (int j = 0; j < ev.instructions.size(); j++) {
             const Instruction& inst = ev.instructions[j];
+            InstructionSlots& slot = instSlots[slotIndex++];
 
             WriteInt32(inst.bank);
             WriteInt32(inst.id);
             WriteInt64(static_cast<int64_t>(inst.argData.size()));
 
-            std::string evInstArgOff = std::format("Event{}Instr{}ArgsOffset", i, j);
-            ReserveBytes(evInstArgOff, 4);
+            slot.argsOffset = ReserveInt32();
             WriteInt32(0);
 
-            std::string evInstLayerOff = std::format("Event{}Instr{}LayerOffset", i, j);
-            ReserveBytes(evInstLayerOff, 4);
+            slot.layerOffset = ReserveInt32();
             WriteInt32(0);
         }
     }
 
-    offsets.layers = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("Offset3", offsets.layers); // seems to always be equal to layers?
-    FillReservedInt64("LayersOffset", offsets.layers);
+    offsets.layers = static_cast<int64_t>(writer.Tell());
+    header.unknownOffset = offsets.layers; // seems to always be equal to layers?
+    header.layersOffset = offsets.layers;
 
+    slotIndex = 0;
     for (int i = 0; i < events.size(); i++) {
         const Event& ev = events[i];
         for (int j = 0; j < ev.instructions.size(); j++) {
             const Instruction& inst = ev.instructions[j];
+            const InstructionSlots& slot = instSlots[slotIndex++];
 
-            std::string evInstLayerOff = std::format("Event{}Instr{}LayerOffset", i, j);
             if (inst.layer.has_value()) {
-                FillReservedInt32(evInstLayerOff, static_cast<uint>(ostream->tellp()) -
-                                                      static_cast<uint>(offsets.layers));
+                FillReservedInt32(slot.layerOffset, static_cast<int32_t>(writer.Tell()) -
+                                                        static_cast<int32_t>(offsets.layers));
                 WriteInt32(2);
                 WriteInt32(inst.layer.value());
                 WriteInt64(static_cast<int64_t>(0));
                 WriteInt64(static_cast<int64_t>(-1));
                 WriteInt64(static_cast<int64_t>(1));
             } else {
-                FillReservedInt32(evInstLayerOff, 0xFFFFFFFF);
+                FillReservedInt32(slot.layerOffset, -1);
             }
         }
     }
 
-    offsets.arguments = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("ArgumentsOffset", offsets.arguments);
+    offsets.arguments = static_cast<int64_t>(writer.Tell());
+    header.argumentsOffset = offsets.arguments;
 
+    slotIndex = 0;
     for (int i = 0; i < events.size(); i++) {
         const Event& ev = events[i];
         for (int j = 0; j < ev.instructions.size(); j++) {
             const Instruction& inst = ev.instructions[j];
 
-            int32_t currentPos = static_cast<int32_t>(ostream->tellp());
+            int32_t currentPos = static_cast<int32_t>(writer.Tell());
             int32_t argsOffset =
                 inst.argData.size() > 0 ? currentPos - static_cast<int32_t>(offsets.arguments) : -1;
-            std::string evInstArgOff = std::format("Event{}Instr{}ArgsOffset", i, j);
-            FillReservedInt32(evInstArgOff, argsOffset);
+            FillReservedInt32(instSlots[slotIndex++].argsOffset, argsOffset);
 
-            ostream->write(inst.argData.data(), inst.argData.size());
+            writer.Write(inst.argData.data(), inst.argData.size());
             PadStream(4);
         }
     }
 
     // padding
-    uint32_t current_pos = static_cast<uint32_t>(ostream->tellp());
+    uint32_t current_pos = static_cast<uint32_t>(writer.Tell());
     uint32_t relative_offset = current_pos - static_cast<uint32_t>(offsets.arguments);
     uint32_t padding = (0x10 - (relative_offset % 0x10)) % 0x10;
+    writer.Fill(0x00, padding);
 
-    for (uint32_t i = 0; i < padding; ++i) {
-        ostream->put(0x00);
-    }
-
-    FillReservedInt64("ArgumentsLength",
-                      static_cast<int64_t>(ostream->tellp()) - offsets.arguments);
+    header.argumentsLength = static_cast<int64_t>(writer.Tell()) - offsets.arguments;
 
-    offsets.parameters = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("ParametersOffset", static_cast<int64_t>(ostream->tellp()));
+    offsets.parameters = static_cast<int64_t>(writer.Tell());
+    header.parametersOffset = offsets.parameters;
 
     for (int i = 0; i < events.size(); i++) {
         const Event& ev = events[i];
 
-        std::string evParamsOff = std::format("Event{}ParamsOffset", i);
         int32_t paramsOffset =
-            ev.parameters.size() > 0 ? static_cast<int>(ostream->tellp()) - offsets.parameters : -1;
-        FillReservedInt32(evParamsOff, paramsOffset);
+            ev.parameters.size() > 0 ? static_cast<int>(writer.Tell()) - offsets.parameters : -1;
+        FillReservedInt32(eventSlots[i].paramsOffset, paramsOffset);
 
         for (int j = 0; j < ev.parameters.size(); j++) {
-            const Parameter& par = ev.parameters[j];
-
-            WriteInt64(par.instructionIndex);
-            WriteInt64(par.targetStartByte);
-            WriteInt64(par.sourceStartByte);
-            WriteInt32(par.byteCount);
-            WriteInt32(par.unkID);
+            WriteStruct(ev.parameters[j]);
         }
     }
 
-    offsets.linkedFiles = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("LinkedFilesOffset", offsets.linkedFiles);
+    offsets.linkedFiles = static_cast<int64_t>(writer.Tell());
+    header.linkedFilesOffset = offsets.linkedFiles;
     for (const auto& offset : linkedData.linkedFileOffsets) {
         WriteInt64(offset);
     }
 
-    offsets.strings = static_cast<int64_t>(ostream->tellp());
-    FillReservedInt64("StringsOffset", offsets.strings);
-    ostream->write(linkedData.stringData.data(), linkedData.stringData.size());
+    offsets.strings = static_cast<int64_t>(writer.Tell());
+    header.stringsOffset = offsets.strings;
+    writer.Write(linkedData.stringData.data(), linkedData.stringData.size());
 
-    FillReservedInt32("FileSize", static_cast<uint>(ostream->tellp()));
+    header.fileSize = static_cast<int32_t>(writer.Tell());
+    PatchStruct(0, header);
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.emevd", std::ios::out | std::ios::binary);
@@ -441,73 +385,69 @@ bool Emevd::RepackEmevd(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("EMEVD Repacking complete\n");
     return true;
 }
 
-bool Emevd::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    Emevd mod1Emevd = Emevd(mod1Data, merger);
-    const std::vector mod1events = mod1Emevd.events;
+bool Emevd::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    const Emevd mod1Emevd = Emevd(mod1Data, merger);
+    const Emevd mod2Emevd = Emevd(mod2Data, merger);
 
-    Emevd mod2Emevd = Emevd(mod2Data, merger);
-    const std::vector mod2events = mod2Emevd.events;
+    const MergeJoinResult merge =
+        MergeJoin(events, mod1Emevd.events, mod2Emevd.events, &Event::id);
 
-    for (auto& event : events) {
-        std::optional mod1event = GetSameEvent(event.id, mod1events);
-        std::optional mod2event = GetSameEvent(event.id, mod2events);
+    for (const MergeStep& step : merge.steps) {
+        const Event* mod1event =
+            step.mod1 != MergeStep::none ? &mod1Emevd.events[step.mod1] : nullptr;
+        const Event* mod2event =
+            step.mod2 != MergeStep::none ? &mod2Emevd.events[step.mod2] : nullptr;
+        Event* event = step.base != MergeStep::none ? &events[step.base] : nullptr;
 
-        bool mod1Modified = mod1event && (mod1event.value() != event);
-        bool mod2Modified = mod2event && (mod2event.value() != event);
+        switch (step.action) {
+        case MergeAction::Conflict:
+            if (event && MergeEvent(*event, *mod1event, *mod2event)) {
+                break;
+            }
 
-        if (mod1Modified && mod2Modified) {
-            if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                          Qt::BlockingQueuedConnection);
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    return false;
-                }
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
             }
 
-            if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                event = mod1event.value();
-                sendLog("Unresolvable conflict, in event: " + mod1event.value().name +
+            if (!event) {
+                event = &events.emplace_back();
+            }
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                *event = *mod1event;
+                sendLog("Unresolvable conflict, in event: " + mod1event->name +
                             " using data from prioritized mod: " + merger->Mod1Name(),
                         LogFormat::Yellow);
-            } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                event = mod2event.value();
-                sendLog("Unresolvable conflict, in event: " + mod2event.value().name +
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                *event = *mod2event;
+                sendLog("Unresolvable conflict, in event: " + mod2event->name +
                             " using data from prioritized mod: " + merger->Mod2Name(),
                         LogFormat::Yellow);
             }
-        } else if (mod1Modified && !mod2Modified) {
-            event = mod1event.value();
-            sendLog("Merging modified event structure: " + std::to_string(event.id) +
+            break;
+        case MergeAction::TakeMod1:
+            *event = *mod1event;
+            sendLog("Merging modified event structure: " + std::to_string(event->id) +
                     " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            event = mod2event.value();
-            sendLog("Merging modified event structure: " + std::to_string(event.id) +
+            break;
+        case MergeAction::TakeMod2:
+            *event = *mod2event;
+            sendLog("Merging modified event structure: " + std::to_string(event->id) +
                     " from mod: " + merger->Mod2Name());
-        }
-    }
-
-    std::unordered_set<int> existingIds;
-    for (const auto& ev : events) {
-        existingIds.insert(ev.id);
-    }
-
-    for (const auto& event : mod1events) {
-        if (existingIds.find(event.id) == existingIds.end()) {
-            events.push_back(event);
-            sendLog("New custom event added id: " + std::to_string(event.id) +
+            break;
+        case MergeAction::AddMod1:
+            events.push_back(*mod1event);
+            sendLog("New custom event added id: " + std::to_string(mod1event->id) +
                     " from mod: " + merger->Mod1Name());
-        }
-    }
-    for (const auto& event : mod2events) {
-        if (existingIds.find(event.id) == existingIds.end()) {
-            events.push_back(event);
-            sendLog("New custom event added id: " + std::to_string(event.id) +
+            break;
+        case MergeAction::AddMod2:
+            events.push_back(*mod2event);
+            sendLog("New custom event added id: " + std::to_string(mod2event->id) +
                     " from mod: " + merger->Mod2Name());
+            break;
         }
     }
 
@@ -530,16 +470,121 @@ bool Emevd::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2D
     return true;
 }
 
-std ::optional<Emevd::Event> Emevd::GetSameEvent(const int& id,
-                                                 const std::vector<Event>& otherEntries) {
-    std::optional<Event> result = std::nullopt;
-    for (const auto& otherEntry : otherEntries) {
-        if (otherEntry.id == id) {
-            return result.emplace(otherEntry);
+bool Emevd::MergeEvent(Event& event, const Event& mod1Event, const Event& mod2Event) {
+    // the rest behavior and name merge like any field, only one mod may change them
+    auto pick = [](const auto& base, const auto& mod1, const auto& mod2, auto& merged) {
+        if (mod1 == base || mod1 == mod2) {
+            merged = mod2;
+            return true;
+        }
+        if (mod2 == base) {
+            merged = mod1;
+            return true;
+        }
+        return false;
+    };
+    RestBehaviorType restBehavior;
+    std::string name;
+    if (!pick(event.restBehavior, mod1Event.restBehavior, mod2Event.restBehavior, restBehavior) ||
+        !pick(event.name, mod1Event.name, mod2Event.name, name)) {
+        return false;
+    }
+
+    std::vector<InstructionToken> baseTokens;
+    std::vector<InstructionToken> mod1Tokens;
+    std::vector<InstructionToken> mod2Tokens;
+    if (!Tokenize(event, baseTokens) || !Tokenize(mod1Event, mod1Tokens) ||
+        !Tokenize(mod2Event, mod2Tokens)) {
+        return false;
+    }
+
+    const ThreeWayResult<InstructionToken> merge =
+        ThreeWayMerge<InstructionToken>(baseTokens, mod1Tokens, mod2Tokens);
+    if (!merge.clean) {
+        return false;
+    }
+
+    // parameters follow their instruction to its merged position
+    std::vector<Instruction> instructions;
+    std::vector<Parameter> parameters;
+    instructions.reserve(merge.merged.size());
+    for (const InstructionToken& token : merge.merged) {
+        for (const Parameter* parameter : token.parameters) {
+            Parameter& bound = parameters.emplace_back(*parameter);
+            bound.instructionIndex = static_cast<int64_t>(instructions.size());
+        }
+        instructions.push_back(*token.instruction);
+    }
+
+    const bool mod1Changed = merge.mod1Hunks > 0 || restBehavior != mod2Event.restBehavior ||
+                             name != mod2Event.name;
+    const bool mod2Changed = merge.mod2Hunks > 0 || restBehavior != mod1Event.restBehavior ||
+                             name != mod1Event.name;
+
+    event.restBehavior = restBehavior;
+    event.name = std::move(name);
+    event.instructions = std::move(instructions);
+    event.parameters = std::move(parameters);
+
+    if (mod1Changed) {
+        sendLog("Merging instructions of event: " + std::to_string(event.id) +
+                " from mod: " + merger->Mod1Name());
+    }
+    if (mod2Changed) {
+        sendLog("Merging instructions of event: " + std::to_string(event.id) +
+                " from mod: " + merger->Mod2Name());
+    }
+    return true;
+}
+
+bool Emevd::Tokenize(const Event& event, std::vector<InstructionToken>& tokens) {
+    tokens.resize(event.instructions.size());
+    for (size_t i = 0; i < tokens.size(); i++) {
+        tokens[i].instruction = &event.instructions[i];
+    }
+    for (const Parameter& parameter : event.parameters) {
+        if (parameter.instructionIndex < 0 ||
+            parameter.instructionIndex >= static_cast<int64_t>(tokens.size())) {
+            return false;
         }
+        tokens[parameter.instructionIndex].parameters.push_back(&parameter);
     }
 
-    return result;
+    // (bank, id, layer) seed the hash of the arguments, bound parameters are folded in after
+    auto mix = [](uint64_t hash, uint64_t value) { return (hash ^ value) * 0x100000001B3ull; };
+    for (InstructionToken& token : tokens) {
+        const Instruction& instruction = *token.instruction;
+        uint64_t seed = static_cast<uint64_t>(static_cast<uint32_t>(instruction.bank)) << 32 |
+                        static_cast<uint32_t>(instruction.id);
+        seed = mix(seed, instruction.layer ? *instruction.layer + 1ull : 0);
+
+        uint64_t hash = Checksum::Hash64(instruction.argData, seed);
+        for (const Parameter* parameter : token.parameters) {
+            hash = mix(hash, parameter->targetStartByte);
+            hash = mix(hash, parameter->sourceStartByte);
+            hash = mix(hash, static_cast<uint64_t>(parameter->byteCount) << 32 |
+                                 static_cast<uint32_t>(parameter->unkID));
+        }
+        token.hash = hash;
+    }
+    return true;
+}
+
+bool Emevd::InstructionToken::operator==(const InstructionToken& other) const {
+    if (hash != other.hash || parameters.size() != other.parameters.size() ||
+        *instruction != *other.instruction) {
+        return false;
+    }
+
+    for (size_t i = 0; i < parameters.size(); i++) {
+        const Parameter& a = *parameters[i];
+        const Parameter& b = *other.parameters[i];
+        if (std::tie(a.targetStartByte, a.sourceStartByte, a.byteCount, a.unkID) !=
+            std::tie(b.targetStartByte, b.sourceStartByte, b.byteCount, b.unkID)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 Emevd::~Emevd() {}
@@ -20,7 +20,14 @@ class Emevd : public BBFormat {
         int unkID;
 
         bool operator==(const Parameter&) const = default;
+
+        // stored on disk exactly as laid out here
+        static constexpr auto Fields(auto& p) {
+            return std::tie(p.instructionIndex, p.targetStartByte, p.sourceStartByte, p.byteCount,
+                            p.unkID);
+        }
     };
+    static_assert(sizeof(Parameter) == 0x20);
 
     struct Instruction {
         int bank;
@@ -41,6 +48,71 @@ class Emevd : public BBFormat {
         bool operator==(const Event&) const = default;
     };
 
+    struct Header {
+        char magic[4];
+        uint8_t bigEndian;
+        int8_t is64Bit; // -1
+        uint8_t unk06;
+        uint8_t unk07;
+        int32_t version; // 0xCC
+        int32_t fileSize;
+        int64_t eventCount;
+        int64_t eventsOffset;
+        int64_t instructionCount;
+        int64_t instructionsOffset;
+        int64_t unk30; // 0
+        int64_t unknownOffset;
+        int64_t layerCount;
+        int64_t layersOffset;
+        int64_t parameterCount;
+        int64_t parametersOffset;
+        int64_t linkedFileCount;
+        int64_t linkedFilesOffset;
+        int64_t argumentsLength;
+        int64_t argumentsOffset;
+        int64_t stringsLength;
+        int64_t stringsOffset;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.version, h.fileSize, h.eventCount, h.eventsOffset,
+                            h.instructionCount, h.instructionsOffset, h.unk30, h.unknownOffset,
+                            h.layerCount, h.layersOffset, h.parameterCount, h.parametersOffset,
+                            h.linkedFileCount, h.linkedFilesOffset, h.argumentsLength,
+                            h.argumentsOffset, h.stringsLength, h.stringsOffset);
+        }
+    };
+    static_assert(sizeof(Header) == 0x90);
+
+    struct EventHeader {
+        int64_t id;
+        int64_t instructionCount;
+        int64_t instructionsOffset;
+        int64_t parameterCount;
+        int64_t parametersOffset;
+        int32_t restBehavior;
+        int32_t pad2C;
+
+        static constexpr auto Fields(auto& e) {
+            return std::tie(e.id, e.instructionCount, e.instructionsOffset, e.parameterCount,
+                            e.parametersOffset, e.restBehavior, e.pad2C);
+        }
+    };
+    static_assert(sizeof(EventHeader) == 0x30);
+
+    struct InstructionHeader {
+        int32_t bank;
+        int32_t id;
+        int64_t argsLength;
+        int64_t argsOffset;
+        int32_t layerOffset; // -1 without a layer
+        int32_t pad1C;
+
+        static constexpr auto Fields(auto& i) {
+            return std::tie(i.bank, i.id, i.argsLength, i.argsOffset, i.layerOffset, i.pad1C);
+        }
+    };
+    static_assert(sizeof(InstructionHeader) == 0x20);
+
     struct Offsets {
         int64_t events;
         int64_t instructions;
@@ -59,23 +131,28 @@ class Emevd : public BBFormat {
     };
 
 public:
-    explicit Emevd(std::vector<char>& data, ModMerger* parent);
+    explicit Emevd(std::span<const char> data, MergeEngine* parent);
     ~Emevd() override;
 
-    bool ReadEmevd(std::vector<char>& data);
+    bool ReadEmevd(std::span<const char> data);
     bool RepackEmevd(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
 private:
-    enum class DiffOp { Match, Insert, Delete, Modify };
-
-    struct DiffElement {
-        DiffOp op;
-        size_t vanillaIdx;
-        size_t modIdx;
+    // an instruction with the parameters bound to it, the unit the instruction diff compares.
+    // parameters are compared without their instruction index, which shifts with insertions
+    struct InstructionToken {
+        uint64_t hash;
+        const Instruction* instruction;
+        std::vector<const Parameter*> parameters;
+
+        bool operator==(const InstructionToken& other) const;
     };
 
-    std::optional<Event> GetSameEvent(const int& id, const std::vector<Event>& otherEvents);
+    static bool Tokenize(const Event& event, std::vector<InstructionToken>& tokens);
+    // merges an event both mods changed when their instruction edits don't overlap
+    bool MergeEvent(Event& event, const Event& mod1Event, const Event& mod2Event);
+
     std::vector<Event> events;
     LinkedData linkedData;
 };
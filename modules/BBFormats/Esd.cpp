@@ -5,106 +5,80 @@
 #include <vector>
 
 #include "Esd.h"
-#include "modules/ModMerger.h"
+#include "modules/Checksum.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Esd::Esd(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+namespace {
+
+// chains a value into a structural hash
+template <typename T>
+uint64_t Chain(uint64_t hash, const T& value) {
+    return Checksum::Hash64({reinterpret_cast<const char*>(&value), sizeof(T)}, hash);
+}
+
+} // namespace
+
+Esd::Esd(std::span<const char> data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     ReadEsd(data);
 }
 
-bool Esd::ReadEsd(std::vector<char>& data) {
+bool Esd::ReadEsd(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty esd input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
     std::string strBuffer = "";
     int intBuffer = 0;
     int64_t int64Buffer = 0;
 
-    GetStr(strBuffer, 4);
-    debugLog("Magic: " + strBuffer); // should be fsSL
+    Header header;
+    ReadStruct(header);
+
+    strBuffer = std::string(header.magic, 4);
+    debugLog("Magic: {}", strBuffer); // should be fsSL
     longFormat = strBuffer == "fsSL";
     if (!longFormat) {
         sendLog("ERROR: unexpected esd format", LogFormat::BoldRed);
         return false;
     }
 
-    GetInt32(intBuffer);
-    GetInt32(gameNumber); // should be 2
-    GetInt32(intBuffer);  // should also be 2
-    GetInt32(intBuffer);  // should be 84
-
-    int dataSize = 0;
-    GetInt32(dataSize);
-
-    GetInt32(intBuffer); // should be 6
-    GetInt32(intBuffer); // since longformat should be true, should be 72
-
-    GetInt32(intBuffer); // should be 1
-
-    int stateGroupSize = 0;
-    GetInt32(stateGroupSize); // since longformat should be true, should be 32
-
-    int stateGroupCount = 0;
-    GetInt32(stateGroupCount);
-    debugLog("stateGroupCount: " + std::to_string(stateGroupCount));
-
-    int stateSize = 0;
-    GetInt32(stateSize); // since longformat should be true, should be 72
-
-    int stateCount = 0;
-    GetInt32(stateCount);
-    debugLog("stateCount: " + std::to_string(stateCount));
+    gameNumber = header.gameNumber; // should be 2
 
-    GetInt32(intBuffer); // since longformat should be true, should be 56
+    int stateGroupSize = header.stateGroupSize; // since longformat should be true, should be 32
 
-    int conditionCount = 0;
-    GetInt32(conditionCount);
-    debugLog("conditionCount: " + std::to_string(conditionCount));
+    int stateGroupCount = header.stateGroupCount;
+    debugLog("stateGroupCount: {}", stateGroupCount);
 
-    GetInt32(intBuffer); // since longformat should be true, should be 24
+    int stateSize = header.stateSize; // since longformat should be true, should be 72
 
-    int commandCallCount = 0;
-    GetInt32(commandCallCount);
-    debugLog("commandCallCount: " + std::to_string(commandCallCount));
+    int stateCount = header.stateCount;
+    debugLog("stateCount: {}", stateCount);
 
-    GetInt32(intBuffer); // since longformat should be true, should be 16
+    int conditionCount = header.conditionCount;
+    debugLog("conditionCount: {}", conditionCount);
 
-    int commandArgCount = 0;
-    GetInt32(commandArgCount);
-    debugLog("commandArgCount: " + std::to_string(commandArgCount));
+    int commandCallCount = header.commandCallCount;
+    debugLog("commandCallCount: {}", commandCallCount);
 
-    int beginConditionOffsetsOffset = 0;
-    GetInt32(beginConditionOffsetsOffset);
-    debugLog("beginConditionOffsetsOffset: " + std::to_string(beginConditionOffsetsOffset));
+    int commandArgCount = header.commandArgCount;
+    debugLog("commandArgCount: {}", commandArgCount);
 
-    int totalConditionOffsetsCount = 0;
-    GetInt32(totalConditionOffsetsCount);
-    debugLog("totalConditionOffsetsCount: " + std::to_string(totalConditionOffsetsCount));
+    int beginConditionOffsetsOffset = header.conditionOffsetsOffset;
+    debugLog("beginConditionOffsetsOffset: {}", beginConditionOffsetsOffset);
 
-    int nameBlockOffset = 0;
-    GetInt32(nameBlockOffset);
+    int totalConditionOffsetsCount = header.conditionOffsetsCount;
+    debugLog("totalConditionOffsetsCount: {}", totalConditionOffsetsCount);
 
-    int nameLength = 0;
-    GetInt32(nameLength);
+    int nameLength = header.nameLength;
 
-    int unkOffset1 = 0;
-    GetInt32(unkOffset1);
-
-    GetInt32(intBuffer);
-
-    int unkOffset2 = 0;
-    GetInt32(unkOffset2);
-    GetInt32(intBuffer);
-
-    int64_t dataStart = static_cast<uint64_t>(istream->tellg());
+    int64_t dataStart = static_cast<uint64_t>(reader.Tell());
 
     GetInt32(intBuffer); // should be 1
     GetInt32(Unk70);
@@ -115,7 +89,7 @@ bool Esd::ReadEsd(std::vector<char>& data) {
 
     int64_t stateGroupsOffset;
     GetInt64(stateGroupsOffset);
-    debugLog("stateGroupsOffset: " + std::to_string(stateGroupsOffset));
+    debugLog("stateGroupsOffset: {}", stateGroupsOffset);
 
     GetInt64(int64Buffer); // should be equal stateGroupCount
 
@@ -128,11 +102,11 @@ bool Esd::ReadEsd(std::vector<char>& data) {
     GetInt64(int64Buffer); // should also be -1
 
     if (nameLength > 0) {
-        StepIn(dataStart + nameOffset, *istream);
+        StepIn(dataStart + nameOffset, reader);
         name = ReadUtf16String();
-        StepOut(*istream);
+        StepOut(reader);
     }
-    debugLog("name: " + name);
+    debugLog("name: {}", name);
 
     std::map<int64_t, std::vector<int64_t>> stateGroupOffsets;
     for (int i = 0; i < stateGroupCount; i++) {
@@ -162,11 +136,32 @@ bool Esd::ReadEsd(std::vector<char>& data) {
         stateGroupOffsets[id] = offsets;
     }
 
-    debugLog("statesmap Offset: " + std::to_string(static_cast<uint64_t>(istream->tellg())));
-    std::map<int64_t, State> states;
+    // states and conditions point at each other by file offset. the links are read as offsets
+    // and turned into pool indices once every record is in
+    debugLog("statesmap Offset: {}", static_cast<uint64_t>(reader.Tell()));
+    std::unordered_map<int64_t, uint32_t> stateAt;
+    std::vector<int64_t> linkOffsets;
+    auto readLinks = [&](int64_t offset, int64_t count) {
+        Range links{static_cast<uint32_t>(linkOffsets.size()), static_cast<uint32_t>(count)};
+        reader.Seek(dataStart + offset);
+        for (int j = 0; j < count; j++) {
+            int64_t off;
+            GetInt64(off);
+            linkOffsets.push_back(off);
+        }
+        return links;
+    };
+    auto sortById = [this](Range calls) {
+        auto first = pool.commands.begin() + calls.first;
+        std::sort(first, first + calls.count, [](const CommandCall& a, const CommandCall& b) {
+            return a.commandId < b.commandId;
+        });
+    };
+
+    pool.states.reserve(stateCount);
     for (int i = 0; i < stateCount; i++) {
         State state;
-        int64_t offset = static_cast<int64_t>(istream->tellg()) - dataStart;
+        int64_t offset = static_cast<int64_t>(reader.Tell()) - dataStart;
 
         GetInt64(state.id);
 
@@ -194,56 +189,35 @@ bool Esd::ReadEsd(std::vector<char>& data) {
         int64_t whileCommandCount;
         GetInt64(whileCommandCount);
 
-        StepIn(0, *istream);
+        StepIn(0, reader);
         {
-            istream->seekg(dataStart + conditionOffsetsOffset);
-            for (int j = 0; j < conditionOffsetCount; j++) {
-                int64_t off;
-                GetInt64(off);
-                state.conditionOffsets.push_back(off);
-            }
-
-            istream->seekg(dataStart + entryCommandsOffset);
-            for (int j = 0; j < entryCommandCount; j++) {
-                AddCommandCall(state.entryCommands, dataStart);
-            }
+            state.conditions = readLinks(conditionOffsetsOffset, conditionOffsetCount);
 
-            std::sort(state.entryCommands.begin(), state.entryCommands.end(),
-                      [](const CommandCall& a, const CommandCall& b) {
-                          return a.commandId < b.commandId;
-                      });
+            state.entryCommands =
+                AddCommandCalls(entryCommandsOffset, entryCommandCount, dataStart);
+            sortById(state.entryCommands);
 
-            istream->seekg(dataStart + exitCommandsOffset);
-            for (int j = 0; j < exitCommandCount; j++) {
-                AddCommandCall(state.exitCommands, dataStart);
-            }
-
-            std::sort(state.exitCommands.begin(), state.exitCommands.end(),
-                      [](const CommandCall& a, const CommandCall& b) {
-                          return a.commandId < b.commandId;
-                      });
+            state.exitCommands = AddCommandCalls(exitCommandsOffset, exitCommandCount, dataStart);
+            sortById(state.exitCommands);
 
-            istream->seekg(dataStart + whileCommandsOffset);
-            for (int j = 0; j < whileCommandCount; j++) {
-                AddCommandCall(state.whileCommands, dataStart);
-            }
-
-            std::sort(state.whileCommands.begin(), state.whileCommands.end(),
-                      [](const CommandCall& a, const CommandCall& b) {
-                          return a.commandId < b.commandId;
-                      });
+            state.whileCommands =
+                AddCommandCalls(whileCommandsOffset, whileCommandCount, dataStart);
+            sortById(state.whileCommands);
         }
-        StepOut(*istream);
+        StepOut(reader);
 
-        states[offset] = state;
+        stateAt[offset] = static_cast<uint32_t>(pool.states.size());
+        pool.states.push_back(state);
     }
 
-    debugLog("conditionsmap Offset: " + std::to_string(static_cast<uint64_t>(istream->tellg())));
-    std::map<int64_t, Condition> conditions;
+    debugLog("conditionsmap Offset: {}", static_cast<uint64_t>(reader.Tell()));
+    std::unordered_map<int64_t, uint32_t> conditionAt;
+    std::vector<int64_t> targetOffsets(conditionCount);
+    pool.conditions.reserve(conditionCount);
     for (int i = 0; i < conditionCount; i++) {
         Condition cond;
-        int64_t offset = static_cast<int64_t>(istream->tellg()) - dataStart;
-        GetInt64(cond.stateOffset);
+        int64_t offset = static_cast<int64_t>(reader.Tell()) - dataStart;
+        GetInt64(targetOffsets[i]);
 
         int64_t passCommandsOffset;
         GetInt64(passCommandsOffset);
@@ -262,237 +236,417 @@ bool Esd::ReadEsd(std::vector<char>& data) {
         int64_t evaluatorLength;
         GetInt64(evaluatorLength);
 
-        StepIn(0, *istream);
+        StepIn(0, reader);
         {
-            istream->seekg(dataStart + passCommandsOffset);
-            for (int j = 0; j < passCommandCount; j++) {
-                AddCommandCall(cond.passCommands, dataStart);
-            }
+            cond.passCommands = AddCommandCalls(passCommandsOffset, passCommandCount, dataStart);
+            cond.subconditions = readLinks(conditionOffsetsOffset, conditionOffsetCount);
 
-            istream->seekg(dataStart + conditionOffsetsOffset);
-            for (int j = 0; j < conditionOffsetCount; j++) {
-                int64_t off;
-                GetInt64(off);
-                cond.conditionOffsets.push_back(off);
-            }
+            StepIn(dataStart + evaluatorOffset, reader);
+            cond.evaluator = AddBytes(evaluatorLength);
+            StepOut(reader);
+        }
+        StepOut(reader);
+        conditionAt[offset] = static_cast<uint32_t>(pool.conditions.size());
+        pool.conditions.push_back(cond);
+    }
 
-            StepIn(dataStart + evaluatorOffset, *istream);
-            GetBytes(cond.evaluator, evaluatorLength);
-            StepOut(*istream);
+    pool.conditionLinks.reserve(linkOffsets.size());
+    for (int64_t offset : linkOffsets) {
+        auto it = conditionAt.find(offset);
+        if (it == conditionAt.end()) {
+            sendLog("ERROR: State condition offset state not found.", LogFormat::BoldRed);
+            return false;
         }
-        StepOut(*istream);
-        cond.condId = i;
-        conditions[offset] = cond;
+        pool.conditionLinks.push_back(it->second);
     }
 
-    for (State& state : std::views::values(states)) {
-        for (const auto& offset : state.conditionOffsets) {
-            auto it = conditions.find(offset);
-            if (it == conditions.end()) {
-                sendLog("ERROR: State condition offset state not found.", LogFormat::BoldRed);
-                return false;
-            }
-            Condition cond = conditions[offset];
-            state.conditions.push_back(cond);
+    std::vector<bool> taken(pool.states.size());
+    std::unordered_map<int64_t, int64_t> stateIds;
+    for (const auto& [stateGroupID, stateOffsets] : stateGroupOffsets) {
+        StateGroup stateGroup;
+        if (!TakeStates(stateSize, stateOffsets, stateAt, taken, stateIds, stateGroup)) {
+            return false;
         }
-        state.conditionOffsets.clear();
+        stateGroups[stateGroupID] = std::move(stateGroup);
     }
 
-    for (const auto& stateGroupID : std::views::keys(stateGroupOffsets)) {
-        const std::vector<int64_t>& stateOffsets = stateGroupOffsets[stateGroupID];
-        std::map<int64_t, int64_t> stateIds;
-        std::map<int64_t, State> stateGroup;
+    if (std::ranges::find(taken, false) != taken.end()) {
+        sendLog("ERROR: Orphaned state/s left", LogFormat::BoldRed);
+        return false;
+    }
 
-        if (!TakeStates(stateSize, stateOffsets, states, stateIds, stateGroup)) {
-            return false;
+    for (size_t i = 0; i < pool.conditions.size(); i++) {
+        if (targetOffsets[i] == -1) {
+            continue;
         }
 
-        for (State& state : std::views::values(stateGroup)) {
-            for (Condition& cond : state.conditions) {
-                GetStateAndConditions(cond, stateIds, conditions);
-            }
+        auto it = stateIds.find(targetOffsets[i]);
+        if (it == stateIds.end()) {
+            sendLog("ERROR: Condition target state not found.", LogFormat::BoldRed);
+            continue;
         }
+        pool.conditions[i].targetStateId = it->second;
+    }
 
-        stateGroups[stateGroupID] = stateGroup;
+    if (!HashConditions()) {
+        return false;
+    }
+    for (State& state : pool.states) {
+        HashState(state);
     }
 
-    int totalCondCount = 0;
-    std::map<int64_t, std::vector<Condition>> conditionsMAP;
-    for (auto& group : stateGroups) {
-        std::vector<Condition> conds;
-        std::function<void(Condition&)> AddCondition = [&](Condition& cond) {
-            auto it = std::find_if(conds.begin(), conds.end(),
-                                   [&cond](Condition& c) { return c == cond; });
-
-            if (it == conds.end()) {
-                conds.push_back(cond);
-                for (auto& sub : cond.subconditions) {
-                    AddCondition(sub);
+    if (debugLogEnabled) {
+        size_t totalCondCount = 0;
+        for (const StateGroup& group : std::views::values(stateGroups)) {
+            std::unordered_set<uint64_t> conds;
+            std::function<void(uint32_t)> addCondition = [&](uint32_t index) {
+                const Condition& cond = pool.conditions[index];
+                if (conds.insert(cond.hash).second) {
+                    for (uint32_t i = 0; i < cond.subconditions.count; i++) {
+                        addCondition(pool.conditionLinks[cond.subconditions.first + i]);
+                    }
                 }
-            }
-        };
+            };
 
-        for (auto& statePair : group.second) {
-            State& st = statePair.second;
-            for (Condition& cond : st.conditions) {
-                AddCondition(cond);
+            for (uint32_t index : std::views::values(group)) {
+                const State& st = pool.states[index];
+                for (uint32_t i = 0; i < st.conditions.count; i++) {
+                    addCondition(pool.conditionLinks[st.conditions.first + i]);
+                }
             }
+            totalCondCount += conds.size();
         }
 
-        int64_t groupID = group.first;
-        conditionsMAP[groupID] = conds;
-        totalCondCount += conds.size();
+        debugLog(LogFormat::Yellow, "derived cond count 1: {}", stateGroups.size());
+        debugLog(LogFormat::Yellow, "derived cond count 2: {}", totalCondCount);
     }
 
-    debugLog("derived cond count 1: " + std::to_string(conditionsMAP.size()), LogFormat::Yellow);
-    debugLog("derived cond count 2: " + std::to_string(totalCondCount), LogFormat::Yellow);
-
-    if (states.size() > 0) {
-        sendLog("ERROR: Orphaned state/s left", LogFormat::BoldRed);
-        return false;
-    }
-
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
-void Esd::AddCommandCall(std::vector<CommandCall>& callsVector, const uint64_t& dataStart) {
-    CommandCall call;
+Esd::Range Esd::AddCommandCalls(int64_t offset, int64_t count, const uint64_t& dataStart) {
+    Range calls{static_cast<uint32_t>(pool.commands.size()), static_cast<uint32_t>(count)};
+    reader.Seek(dataStart + offset);
 
-    GetInt32(call.commandBank); // assert 1/3/5/7?
-    GetInt32(call.commandId);
+    for (int64_t c = 0; c < count; c++) {
+        CommandCall call;
 
-    int64_t argsOffset;
-    GetInt64(argsOffset);
+        GetInt32(call.commandBank); // assert 1/3/5/7?
+        GetInt32(call.commandId);
 
-    int64_t argsCount;
-    GetInt64(argsCount);
+        int64_t argsOffset;
+        GetInt64(argsOffset);
 
-    StepIn(dataStart + argsOffset, *istream);
-    {
-        for (int i = 0; i < argsCount; i++) {
-            int64_t argOffset;
-            GetInt64(argOffset);
+        int64_t argsCount;
+        GetInt64(argsCount);
 
-            int64_t argSize;
-            GetInt64(argSize);
+        call.arguments = {static_cast<uint32_t>(pool.arguments.size()),
+                          static_cast<uint32_t>(argsCount)};
+        call.hash = Chain(Chain(Chain(0, call.commandBank), call.commandId), argsCount);
 
-            StepIn(dataStart + argOffset, *istream);
-            std::vector<char> buff(argSize);
-            GetBytes(buff, argSize);
-            call.arguments.push_back(buff);
-            StepOut(*istream);
+        StepIn(dataStart + argsOffset, reader);
+        {
+            for (int i = 0; i < argsCount; i++) {
+                int64_t argOffset;
+                GetInt64(argOffset);
+
+                int64_t argSize;
+                GetInt64(argSize);
+
+                StepIn(dataStart + argOffset, reader);
+                Range arg = AddBytes(argSize);
+                pool.arguments.push_back(arg);
+                call.hash = Checksum::Hash64(Bytes(arg), call.hash);
+                StepOut(reader);
+            }
         }
+        StepOut(reader);
+
+        pool.commands.push_back(call);
     }
-    StepOut(*istream);
 
-    callsVector.push_back(call);
+    return calls;
+}
+
+Esd::Range Esd::AddBytes(int64_t length) {
+    Range range{static_cast<uint32_t>(pool.bytes.size()), static_cast<uint32_t>(length)};
+    std::span<const char> view = reader.View(length);
+    pool.bytes.insert(pool.bytes.end(), view.begin(), view.end());
+    pool.bytes.resize(range.first + range.count);
+    reader.Skip(length);
+    return range;
 }
 
 bool Esd::TakeStates(const int64_t& stateSize, const std::vector<int64_t>& stateOffsets,
-                     std::map<int64_t, State>& states, std::map<int64_t, int64_t>& stateIds,
-                     std::map<int64_t, Esd::State>& stateGroup) {
+                     const std::unordered_map<int64_t, uint32_t>& stateAt,
+                     std::vector<bool>& taken, std::unordered_map<int64_t, int64_t>& stateIds,
+                     StateGroup& stateGroup) {
+    auto take = [&](int64_t offset) -> std::optional<uint32_t> {
+        auto it = stateAt.find(offset);
+        if (it == stateAt.end() || taken[it->second]) {
+            return std::nullopt;
+        }
+        taken[it->second] = true;
+        return it->second;
+    };
+
     if (stateOffsets.size() > 1) {
         int64_t weirdStateOffset = stateOffsets[0] + stateSize * stateOffsets.size();
-        if (!states.erase(weirdStateOffset)) {
+        if (!take(weirdStateOffset)) {
             sendLog("ERROR: Weird state not found", LogFormat::BoldRed);
             return false;
         }
     }
 
     for (const auto& offset : stateOffsets) {
-        State state = states[offset];
-        if (stateGroup.contains(state.id)) {
+        std::optional<uint32_t> index = take(offset);
+        if (!index) {
+            sendLog("ERROR: State not found when taking states", LogFormat::BoldRed);
+            return false;
+        }
+
+        const int64_t id = pool.states[*index].id;
+        if (stateGroup.contains(id)) {
             sendLog("ERROR: Duplicate state id when taking states", LogFormat::BoldRed);
             return false;
         }
 
-        stateGroup[state.id] = state;
-        states.erase(offset);
-        stateIds[offset] = state.id;
+        stateGroup[id] = *index;
+        stateIds[offset] = id;
     }
 
     return true;
 }
 
-bool Esd::GetStateAndConditions(Condition& cond, const std::map<int64_t, int64_t>& stateOffsets,
-                                const std::map<int64_t, Condition>& conditionMap) {
-    if (cond.stateOffset == -2) {
-        debugLog("condition stateoffset already processed");
+bool Esd::HashConditions() {
+    // subconditions are hashed before the conditions holding them, a condition met again while
+    // its own subconditions are being hashed means the file loops
+    enum : uint8_t { Unhashed, Hashing, Hashed };
+    std::vector<uint8_t> visits(pool.conditions.size(), Unhashed);
+    std::function<bool(uint32_t)> hash = [&](uint32_t index) {
+        if (visits[index] != Unhashed) {
+            return visits[index] == Hashed;
+        }
+
+        visits[index] = Hashing;
+        const Range subconditions = pool.conditions[index].subconditions;
+        for (uint32_t i = 0; i < subconditions.count; i++) {
+            if (!hash(pool.conditionLinks[subconditions.first + i])) {
+                return false;
+            }
+        }
+        HashCondition(pool.conditions[index]);
+        visits[index] = Hashed;
         return true;
+    };
+
+    for (uint32_t i = 0; i < pool.conditions.size(); i++) {
+        if (!hash(i)) {
+            sendLog("ERROR: Condition is its own subcondition", LogFormat::BoldRed);
+            return false;
+        }
     }
+    return true;
+}
 
-    if (cond.stateOffset == -1) {
-        cond.targetStateId = std::nullopt;
-    } else if (stateOffsets.contains(cond.stateOffset)) {
-        cond.targetStateId = stateOffsets.at(cond.stateOffset);
-    } else {
-        sendLog("ERROR: Condition target state not found.", LogFormat::BoldRed);
-        return false;
+uint64_t Esd::CommandsHash(uint64_t hash, Range commands) const {
+    hash = Chain(hash, commands.count);
+    for (uint32_t i = 0; i < commands.count; i++) {
+        hash = Chain(hash, pool.commands[commands.first + i].hash);
     }
-    cond.stateOffset = -2;
+    return hash;
+}
 
-    for (const auto& offset : cond.conditionOffsets) {
-        Condition newcond = conditionMap.at(offset);
-        cond.subconditions.push_back(newcond);
+uint64_t Esd::ConditionsHash(uint64_t hash, Range links) const {
+    hash = Chain(hash, links.count);
+    for (uint32_t i = 0; i < links.count; i++) {
+        hash = Chain(hash, pool.conditions[pool.conditionLinks[links.first + i]].hash);
     }
-    cond.conditionOffsets.clear();
+    return hash;
+}
 
-    for (Condition& sub : cond.subconditions) {
-        GetStateAndConditions(sub, stateOffsets, conditionMap);
+void Esd::HashCondition(Condition& cond) const {
+    uint64_t hash = Chain(Chain(0, cond.targetStateId.has_value()), cond.targetStateId.value_or(0));
+    hash = Checksum::Hash64(Bytes(cond.evaluator), hash);
+    hash = CommandsHash(hash, cond.passCommands);
+    cond.hash = ConditionsHash(hash, cond.subconditions);
+}
+
+void Esd::HashState(State& state) const {
+    uint64_t hash = Chain(0, state.id);
+    hash = CommandsHash(hash, state.entryCommands);
+    hash = CommandsHash(hash, state.exitCommands);
+    hash = CommandsHash(hash, state.whileCommands);
+    state.hash = ConditionsHash(hash, state.conditions);
+}
+
+bool Esd::SameCommands(Range a, Range b) const {
+    if (a.count != b.count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.count; i++) {
+        if (pool.commands[a.first + i].hash != pool.commands[b.first + i].hash) {
+            return false;
+        }
     }
     return true;
 }
 
-bool Esd::RepackEsd(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::in | std::ios_base::out |
-                                                  std::ios_base::binary);
-    ostream->exceptions(std::ios_base::failbit | std::ios_base::badbit);
+bool Esd::SameConditions(Range a, Range b) const {
+    if (a.count != b.count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.count; i++) {
+        if (pool.conditions[pool.conditionLinks[a.first + i]].hash !=
+            pool.conditions[pool.conditionLinks[b.first + i]].hash) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    std::string strBuffer;
-    int64_t int64Buffer;
+uint32_t Esd::Pool::Append(const Pool& other) {
+    const auto base = [](const auto& records) { return static_cast<uint32_t>(records.size()); };
+    const uint32_t stateBase = base(states);
+    const uint32_t conditionBase = base(conditions);
+    const uint32_t linkBase = base(conditionLinks);
+    const uint32_t commandBase = base(commands);
+    const uint32_t argumentBase = base(arguments);
+    const uint32_t byteBase = base(bytes);
+    auto move = [](Range range, uint32_t by) { return Range{range.first + by, range.count}; };
+
+    states.reserve(states.size() + other.states.size());
+    for (State state : other.states) {
+        state.entryCommands = move(state.entryCommands, commandBase);
+        state.exitCommands = move(state.exitCommands, commandBase);
+        state.whileCommands = move(state.whileCommands, commandBase);
+        state.conditions = move(state.conditions, linkBase);
+        states.push_back(state);
+    }
 
-    WriteStr("fsSL", 4);
-    WriteInt32(1);
-    WriteInt32(2);
-    WriteInt32(2);
-    WriteInt32(0x54);
+    conditions.reserve(conditions.size() + other.conditions.size());
+    for (Condition cond : other.conditions) {
+        cond.evaluator = move(cond.evaluator, byteBase);
+        cond.passCommands = move(cond.passCommands, commandBase);
+        cond.subconditions = move(cond.subconditions, linkBase);
+        conditions.push_back(cond);
+    }
 
-    ReserveBytes("DataSize", 4);
-    WriteInt32(6);
-    WriteInt32(0x48);
-    WriteInt32(1);
-    WriteInt32(0x20);
-    WriteInt32(static_cast<int>(stateGroups.size()));
+    conditionLinks.reserve(conditionLinks.size() + other.conditionLinks.size());
+    for (uint32_t link : other.conditionLinks) {
+        conditionLinks.push_back(link + conditionBase);
+    }
 
+    commands.reserve(commands.size() + other.commands.size());
+    for (CommandCall call : other.commands) {
+        call.arguments = move(call.arguments, argumentBase);
+        commands.push_back(call);
+    }
+
+    arguments.reserve(arguments.size() + other.arguments.size());
+    for (Range arg : other.arguments) {
+        arguments.push_back(move(arg, byteBase));
+    }
+
+    bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+    return stateBase;
+}
+
+bool Esd::RepackEsd(std::vector<char>& outputData) {
     int stateSize = 0x48;
-    WriteInt32(stateSize);
 
     int sTotal = 0;
     for (const auto& pair : stateGroups) {
         auto& sg = pair.second;
         sTotal += sg.size() + (sg.size() == 1 ? 0 : 1);
     }
-    WriteInt32(sTotal);
-
-    WriteInt32(0x38);
-    ReserveBytes("ConditionCount", 4);
-    WriteInt32(0x18);
-    ReserveBytes("CommandCallCount", 4);
-    WriteInt32(0x10);
-    ReserveBytes("CommandArgCount", 4);
-    ReserveBytes("ConditionOffsetsOffset", 4);
-    ReserveBytes("ConditionOffsetsCount", 4);
-    ReserveBytes("NameBlockOffset", 4);
-    name == "" ? WriteInt32(static_cast<int>(0)) : WriteInt32(static_cast<int>(name.size() + 1));
-    ReserveBytes("UnkOffset1", 4);
-    WriteInt32(0);
-    ReserveBytes("UnkOffset2", 4);
-    WriteInt32(0);
 
-    const int64_t dataStart = static_cast<int64_t>(ostream->tellp());
+    // each group's states in id order, everything below is written group by group
+    std::vector<std::vector<uint32_t>> stateIndices;
+    for (const StateGroup& group : std::views::values(stateGroups)) {
+        std::vector<uint32_t>& states = stateIndices.emplace_back();
+        std::ranges::copy(std::views::values(group), std::back_inserter(states));
+    }
+
+    // conditions are written once per group however many states and conditions link them, in the
+    // order they are first reached
+    std::vector<std::vector<uint32_t>> conditions;
+    std::vector<uint32_t> reachedIn(pool.conditions.size(), UINT32_MAX);
+    for (const std::vector<uint32_t>& states : stateIndices) {
+        const uint32_t groupIndex = static_cast<uint32_t>(conditions.size());
+        std::vector<uint32_t>& conds = conditions.emplace_back();
+        std::function<void(uint32_t)> AddCondition = [&](uint32_t index) {
+            if (reachedIn[index] != groupIndex) {
+                reachedIn[index] = groupIndex;
+                conds.push_back(index);
+
+                const Range subconditions = pool.conditions[index].subconditions;
+                for (uint32_t i = 0; i < subconditions.count; i++) {
+                    AddCondition(pool.conditionLinks[subconditions.first + i]);
+                }
+            }
+        };
+
+        for (uint32_t index : states) {
+            const State& st = pool.states[index];
+            for (uint32_t i = 0; i < st.conditions.count; i++) {
+                AddCondition(pool.conditionLinks[st.conditions.first + i]);
+            }
+        }
+    }
+
+    // layout pass, with the conditions known this is the exact size before padding
+    size_t layoutSize = sizeof(Header) + 0x50 + stateGroups.size() * 0x20 + sTotal * stateSize;
+    auto commandsSize = [this](Range calls) {
+        size_t size = 0;
+        for (uint32_t c = 0; c < calls.count; c++) {
+            const Range args = pool.commands[calls.first + c].arguments;
+            size += 0x18;
+            for (uint32_t a = 0; a < args.count; a++) {
+                size += 0x10 + pool.arguments[args.first + a].count;
+            }
+        }
+        return size;
+    };
+    for (size_t g = 0; g < stateIndices.size(); g++) {
+        for (uint32_t index : stateIndices[g]) {
+            const State& st = pool.states[index];
+            layoutSize += commandsSize(st.entryCommands) + commandsSize(st.exitCommands) +
+                          commandsSize(st.whileCommands) + 8 * st.conditions.count;
+        }
+        for (uint32_t index : conditions[g]) {
+            const Condition& cond = pool.conditions[index];
+            layoutSize += 0x38 + cond.evaluator.count + commandsSize(cond.passCommands) +
+                          8 * cond.subconditions.count;
+        }
+    }
+    writer = SpanWriter(layoutSize + (name.size() + 1) * 2 + 0x10);
+
+    Header header{};
+    std::memcpy(header.magic, "fsSL", 4);
+    header.unk04 = 1;
+    header.gameNumber = 2;
+    header.unk0C = 2;
+    header.unk10 = 0x54;
+    header.unk18 = 6;
+    header.unk1C = 0x48;
+    header.unk20 = 1;
+    header.stateGroupSize = 0x20;
+    header.stateGroupCount = static_cast<int>(stateGroups.size());
+    header.stateSize = stateSize;
+    header.stateCount = sTotal;
+    header.conditionSize = 0x38;
+    header.commandCallSize = 0x18;
+    header.commandArgSize = 0x10;
+    header.nameLength = name == "" ? 0 : static_cast<int>(name.size() + 1);
+
+    // counts and block offsets are filled in once the data section is written
+    WriteStruct(header);
+
+    const int64_t dataStart = static_cast<int64_t>(writer.Tell());
     auto getDataOffset = [&dataStart, this]() {
-        return static_cast<int64_t>(ostream->tellp()) - dataStart;
+        return static_cast<int64_t>(writer.Tell()) - dataStart;
     };
 
     WriteInt32(1);
@@ -502,326 +656,249 @@ bool Esd::RepackEsd(std::vector<char>& outputData) {
     WriteInt32(Unk7C);
     WriteInt32(0);
 
-    ReserveBytes("StateGroupsOffset", 8);
+    Reserved<int64_t> stateGroupsOffset = ReserveInt64();
     WriteInt64(static_cast<int64_t>(stateGroups.size()));
-    ReserveBytes("NameOffset", 8);
+    Reserved<int64_t> nameOffset = ReserveInt64();
     name == "" ? WriteInt64(static_cast<int64_t>(0))
                : WriteInt64(static_cast<int64_t>(name.size() + 1));
     WriteInt64(static_cast<int64_t>(-1));
     WriteInt64(static_cast<int64_t>(-1));
 
-    std::map<int64_t, std::vector<int64_t>> stateIDs;
-    for (const auto& pair : stateGroups) {
-        const auto& group = pair.second;
-        const auto& groupID = pair.first;
-
-        std::vector<int64_t> idsVec;
-        idsVec.reserve(group.size());
-        std::ranges::copy(group | std::views::keys, std::back_inserter(idsVec));
+    struct GroupSlots {
+        Reserved<int64_t> statesOffset1;
+        Reserved<int64_t> statesOffset2;
+    };
+    struct StateSlots {
+        Reserved<int64_t> conditionsOffset;
+        Reserved<int64_t> entryCommandsOffset;
+        Reserved<int64_t> exitCommandsOffset;
+        Reserved<int64_t> whileCommandsOffset;
+    };
+    struct ConditionSlots {
+        Reserved<int64_t> passCommandsOffset;
+        Reserved<int64_t> conditionsOffset;
+        Reserved<int64_t> evaluatorOffset;
+    };
 
-        stateIDs[groupID] = idsVec;
-    }
+    // slots are kept per group in the same order as the group's states and conditions
+    std::vector<GroupSlots> groupSlots(stateGroups.size());
+    std::vector<std::vector<StateSlots>> stateSlots(stateGroups.size());
+    std::vector<std::vector<ConditionSlots>> conditionSlots(stateGroups.size());
 
     if (stateGroups.size() == 0) {
-        FillReservedInt64("StateGroupsOffset", -1);
+        FillReservedInt64(stateGroupsOffset, -1);
     } else {
-        FillReservedInt64("StateGroupsOffset", getDataOffset());
-        for (const auto& pair : stateGroups) {
-            int64_t groupID = pair.first;
-            WriteInt64(groupID);
-
-            std::string off1name = "StateGroup" + std::to_string(groupID) + ":StatesOffset1";
-            std::string off2name = "StateGroup" + std::to_string(groupID) + ":StatesOffset2";
+        FillReservedInt64(stateGroupsOffset, getDataOffset());
+        for (size_t g = 0; const auto& pair : stateGroups) {
+            WriteInt64(pair.first);
 
-            ReserveBytes(off1name, 8);
+            groupSlots[g].statesOffset1 = ReserveInt64();
             WriteInt64(static_cast<int64_t>(pair.second.size()));
-            ReserveBytes(off2name, 8);
+            groupSlots[g].statesOffset2 = ReserveInt64();
+            g++;
         }
     }
 
-    std::map<int64_t, std::map<int64_t, int64_t>> stateOffsets;
+    // data offset of each state written, by pool index
+    std::vector<int64_t> stateOffsets(pool.states.size(), -1);
     std::vector<std::pair<int64_t, int64_t>> weirdStateOffsets;
-    for (const auto& groupID : std::views::keys(stateGroups)) {
-        std::string off1name = "StateGroup" + std::to_string(groupID) + ":StatesOffset1";
-        std::string off2name = "StateGroup" + std::to_string(groupID) + ":StatesOffset2";
-
-        FillReservedInt64(off1name, getDataOffset());
-        FillReservedInt64(off2name, getDataOffset());
-
-        int64_t firstStateOffset = static_cast<int64_t>(ostream->tellp());
-        for (const auto& stateID : stateIDs[groupID]) {
-
-            stateOffsets[groupID][stateID] = getDataOffset();
-
-            const State& st = stateGroups[groupID][stateID];
-            std::string stateCondOff = std::format("State{}-{}:ConditionsOffset", groupID, stateID);
-            std::string stateEntryOff =
-                std::format("State{}-{}:EntryCommandsOffset", groupID, stateID);
-            std::string stateExitOff =
-                std::format("State{}-{}:ExitCommandsOffset", groupID, stateID);
-            std::string stateWhileOff =
-                std::format("State{}-{}:WhileCommandsOffset", groupID, stateID);
-
-            WriteInt64(stateID);
-            ReserveBytes(stateCondOff, 8);
-            WriteInt64(static_cast<int64_t>(st.conditions.size()));
-            ReserveBytes(stateEntryOff, 8);
-            WriteInt64(static_cast<int64_t>(st.entryCommands.size()));
-            ReserveBytes(stateExitOff, 8);
-            WriteInt64(static_cast<int64_t>(st.exitCommands.size()));
-            ReserveBytes(stateWhileOff, 8);
-            WriteInt64(static_cast<int64_t>(st.whileCommands.size()));
+    for (size_t g = 0; g < stateIndices.size(); g++) {
+        FillReservedInt64(groupSlots[g].statesOffset1, getDataOffset());
+        FillReservedInt64(groupSlots[g].statesOffset2, getDataOffset());
+
+        std::vector<StateSlots>& groupStates = stateSlots[g];
+        groupStates.resize(stateIndices[g].size());
+
+        int64_t firstStateOffset = static_cast<int64_t>(writer.Tell());
+        for (size_t s = 0; s < stateIndices[g].size(); s++) {
+            const uint32_t index = stateIndices[g][s];
+            stateOffsets[index] = getDataOffset();
+
+            const State& st = pool.states[index];
+            WriteInt64(st.id);
+            groupStates[s].conditionsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(st.conditions.count));
+            groupStates[s].entryCommandsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(st.entryCommands.count));
+            groupStates[s].exitCommandsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(st.exitCommands.count));
+            groupStates[s].whileCommandsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(st.whileCommands.count));
         }
 
-        if (stateGroups[groupID].size() > 1) {
-            weirdStateOffsets.push_back({firstStateOffset, static_cast<int64_t>(ostream->tellp())});
-            std::vector<char> nullBytes(stateSize, 0);
-            ostream->write(nullBytes.data(), nullBytes.size());
+        if (stateIndices[g].size() > 1) {
+            weirdStateOffsets.push_back({firstStateOffset, static_cast<int64_t>(writer.Tell())});
+            writer.Fill(0, stateSize);
         }
     }
 
-    std::map<int64_t, std::vector<Condition>> conditions;
-    for (auto& group : stateGroups) {
-        std::vector<Condition> conds;
-        std::function<void(Condition&)> AddCondition = [&](Condition& cond) {
-            auto it = std::find_if(conds.begin(), conds.end(),
-                                   [&cond](Condition& c) { return c.condId == cond.condId; });
-
-            if (it == conds.end()) {
-                conds.push_back(cond);
-                for (auto& sub : cond.subconditions) {
-                    AddCondition(sub);
-                }
-            }
-        };
-
-        for (auto& statePair : group.second) {
-            State& st = statePair.second;
-            for (Condition& cond : st.conditions) {
-                AddCondition(cond);
-            }
-        }
-
-        int64_t groupID = group.first;
-        conditions[groupID] = conds;
-    }
-
     int totalCondCount = 0;
-    for (const auto& conditions : std::views::values(conditions)) {
-        totalCondCount += conditions.size();
-    }
-
-    FillReservedInt32("ConditionCount", totalCondCount);
-    debugLog("totalCondCount: " + std::to_string(totalCondCount), LogFormat::BoldRed);
-
-    std::map<int, int64_t> conditionOffsets;
-    for (const auto& groupID : std::views::keys(stateGroups)) {
-        for (int i = 0; i < conditions[groupID].size(); i++) {
-            Condition& cond = conditions[groupID][i];
-            conditionOffsets[cond.condId] = getDataOffset();
-
-            const auto& stateOffsetsGroup = stateOffsets[groupID];
-            cond.targetStateId.has_value()
-                ? WriteInt64(stateOffsetsGroup.at(cond.targetStateId.value()))
-                : WriteInt64(static_cast<int64_t>(-1));
-
-            std::string passCommOff = std::format("Condition{}-{}:PassCommandsOffset", groupID, i);
-            std::string condOff = std::format("Condition{}-{}:ConditionsOffset", groupID, i);
-            std::string evalOff = std::format("Condition{}-{}:EvaluatorOffset", groupID, i);
-
-            ReserveBytes(passCommOff, 8);
-            WriteInt64(static_cast<int64_t>(cond.passCommands.size()));
-            ReserveBytes(condOff, 8);
-            WriteInt64(static_cast<int64_t>(cond.subconditions.size()));
-            ReserveBytes(evalOff, 8);
-            WriteInt64(static_cast<int64_t>(cond.evaluator.size()));
-        }
+    for (const auto& conds : conditions) {
+        totalCondCount += conds.size();
     }
 
-    std::vector<CommandCall> commands;
-    for (const auto& groupID : std::views::keys(stateGroups)) {
-        for (const auto& stateID : stateIDs[groupID]) {
-            const auto& st = stateGroups[groupID][stateID];
-            std::string stateEntryOff =
-                std::format("State{}-{}:EntryCommandsOffset", groupID, stateID);
-            std::string stateExitOff =
-                std::format("State{}-{}:ExitCommandsOffset", groupID, stateID);
-            std::string stateWhileOff =
-                std::format("State{}-{}:WhileCommandsOffset", groupID, stateID);
-
-            if (st.entryCommands.size() == 0) {
-                FillReservedInt64(stateEntryOff, -1);
-            } else {
-                FillReservedInt64(stateEntryOff, getDataOffset());
-
-                for (const auto& command : st.entryCommands) {
-                    WriteInt32(command.commandBank);
-                    WriteInt32(command.commandId);
-
-                    std::string commandOff = std::format("Command{}:ArgsOffset", commands.size());
-                    ReserveBytes(commandOff, 8);
-                    WriteInt64(static_cast<int64_t>(command.arguments.size()));
-                    commands.push_back(command);
+    header.conditionCount = totalCondCount;
+    debugLog(LogFormat::BoldRed, "totalCondCount: {}", totalCondCount);
+
+    // data offset of each condition by pool index, a condition shared across groups points at
+    // its copy in the last of them
+    std::vector<int64_t> conditionOffsets(pool.conditions.size(), -1);
+    for (size_t g = 0; const StateGroup& group : std::views::values(stateGroups)) {
+        std::vector<ConditionSlots>& groupConditions = conditionSlots[g];
+        groupConditions.resize(conditions[g].size());
+
+        for (size_t i = 0; i < conditions[g].size(); i++) {
+            const Condition& cond = pool.conditions[conditions[g][i]];
+            conditionOffsets[conditions[g][i]] = getDataOffset();
+
+            if (cond.targetStateId.has_value()) {
+                auto target = group.find(cond.targetStateId.value());
+                if (target == group.end()) {
+                    sendLog("ERROR: Condition target state not in its group", LogFormat::BoldRed);
+                    return false;
                 }
-            }
-
-            if (st.exitCommands.size() == 0) {
-                FillReservedInt64(stateExitOff, -1);
+                WriteInt64(stateOffsets[target->second]);
             } else {
-                FillReservedInt64(stateExitOff, getDataOffset());
-
-                for (const auto& command : st.exitCommands) {
-                    WriteInt32(command.commandBank);
-                    WriteInt32(command.commandId);
-
-                    std::string commandOff = std::format("Command{}:ArgsOffset", commands.size());
-                    ReserveBytes(commandOff, 8);
-                    WriteInt64(static_cast<int64_t>(command.arguments.size()));
-                    commands.push_back(command);
-                }
+                WriteInt64(static_cast<int64_t>(-1));
             }
 
-            if (st.whileCommands.size() == 0) {
-                FillReservedInt64(stateWhileOff, -1);
-            } else {
-                FillReservedInt64(stateWhileOff, getDataOffset());
-
-                for (const auto& command : st.whileCommands) {
-                    WriteInt32(command.commandBank);
-                    WriteInt32(command.commandId);
+            groupConditions[i].passCommandsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(cond.passCommands.count));
+            groupConditions[i].conditionsOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(cond.subconditions.count));
+            groupConditions[i].evaluatorOffset = ReserveInt64();
+            WriteInt64(static_cast<int64_t>(cond.evaluator.count));
+        }
+        g++;
+    }
 
-                    std::string commandOff = std::format("Command{}:ArgsOffset", commands.size());
-                    ReserveBytes(commandOff, 8);
-                    WriteInt64(static_cast<int64_t>(command.arguments.size()));
-                    commands.push_back(command);
-                }
-            }
+    std::vector<uint32_t> commands;
+    std::vector<Reserved<int64_t>> commandArgsOffsets;
+    auto writeCommands = [&](Range calls, Reserved<int64_t> slot) {
+        if (calls.count == 0) {
+            FillReservedInt64(slot, -1);
+            return;
         }
 
-        for (int i = 0; i < conditions[groupID].size(); i++) {
-            const auto& cond = conditions[groupID][i];
-            std::string passCommOff = std::format("Condition{}-{}:PassCommandsOffset", groupID, i);
+        FillReservedInt64(slot, getDataOffset());
+        for (uint32_t c = calls.first; c < calls.first + calls.count; c++) {
+            const CommandCall& command = pool.commands[c];
+            WriteInt32(command.commandBank);
+            WriteInt32(command.commandId);
 
-            if (cond.passCommands.size() == 0) {
-                FillReservedInt64(passCommOff, -1);
-            } else {
-                FillReservedInt64(passCommOff, getDataOffset());
+            commandArgsOffsets.push_back(ReserveInt64());
+            WriteInt64(static_cast<int64_t>(command.arguments.count));
+            commands.push_back(c);
+        }
+    };
 
-                for (const auto& command : cond.passCommands) {
-                    WriteInt32(command.commandBank);
-                    WriteInt32(command.commandId);
+    for (size_t g = 0; g < stateIndices.size(); g++) {
+        for (size_t s = 0; s < stateIndices[g].size(); s++) {
+            const State& st = pool.states[stateIndices[g][s]];
+            const StateSlots& stateSlot = stateSlots[g][s];
 
-                    std::string commandOff = std::format("Command{}:ArgsOffset", commands.size());
-                    ReserveBytes(commandOff, 8);
-                    WriteInt64(static_cast<int64_t>(command.arguments.size()));
-                    commands.push_back(command);
-                }
-            }
+            writeCommands(st.entryCommands, stateSlot.entryCommandsOffset);
+            writeCommands(st.exitCommands, stateSlot.exitCommandsOffset);
+            writeCommands(st.whileCommands, stateSlot.whileCommandsOffset);
+        }
+
+        for (size_t i = 0; i < conditions[g].size(); i++) {
+            writeCommands(pool.conditions[conditions[g][i]].passCommands,
+                          conditionSlots[g][i].passCommandsOffset);
         }
     }
 
-    FillReservedInt32("CommandCallCount", static_cast<int>(commands.size()));
+    header.commandCallCount = static_cast<int>(commands.size());
 
     int totalArgCount = 0;
-    for (const auto& comm : commands) {
-        totalArgCount += comm.arguments.size();
+    for (uint32_t c : commands) {
+        totalArgCount += pool.commands[c].arguments.count;
     }
-    FillReservedInt32("CommandArgCount", totalArgCount);
+    header.commandArgCount = totalArgCount;
 
-    for (int i = 0; i < commands.size(); i++) {
-        std::string commandOff = std::format("Command{}:ArgsOffset", i);
-        FillReservedInt64(commandOff, getDataOffset());
+    std::vector<Reserved<int64_t>> bytecodeOffsets;
+    bytecodeOffsets.reserve(totalArgCount);
+    for (size_t i = 0; i < commands.size(); i++) {
+        FillReservedInt64(commandArgsOffsets[i], getDataOffset());
 
-        for (int j = 0; j < commands[i].arguments.size(); j++) {
-            std::string argBytesOff = std::format("Command{}-{}:BytecodeOffset", i, j);
-            ReserveBytes(argBytesOff, 8);
-            WriteInt64(static_cast<int64_t>(commands[i].arguments[j].size()));
+        const Range args = pool.commands[commands[i]].arguments;
+        for (uint32_t a = args.first; a < args.first + args.count; a++) {
+            bytecodeOffsets.push_back(ReserveInt64());
+            WriteInt64(static_cast<int64_t>(pool.arguments[a].count));
         }
     }
 
-    FillReservedInt32("ConditionOffsetsOffset", static_cast<int>(getDataOffset()));
+    header.conditionOffsetsOffset = static_cast<int>(getDataOffset());
     int conditionOffsetsCount = 0;
-    for (const auto& groupID : std::views::keys(stateGroups)) {
-        for (const auto& stateID : stateIDs[groupID]) {
-            std::string stateCondOff = std::format("State{}-{}:ConditionsOffset", groupID, stateID);
-            FillReservedInt64(stateCondOff, getDataOffset());
-
-            const auto& st = stateGroups[groupID][stateID];
-            for (const auto& cond : st.conditions) {
-                WriteInt64(conditionOffsets[cond.condId]);
-                conditionOffsetsCount += 1;
-            }
+    auto writeLinks = [&](Range links) {
+        for (uint32_t l = links.first; l < links.first + links.count; l++) {
+            WriteInt64(conditionOffsets[pool.conditionLinks[l]]);
+            conditionOffsetsCount += 1;
+        }
+    };
+    for (size_t g = 0; g < stateIndices.size(); g++) {
+        for (size_t s = 0; s < stateIndices[g].size(); s++) {
+            FillReservedInt64(stateSlots[g][s].conditionsOffset, getDataOffset());
+            writeLinks(pool.states[stateIndices[g][s]].conditions);
         }
 
-        for (int i = 0; i < conditions[groupID].size(); i++) {
-            const auto& cond = conditions[groupID][i];
-            std::string condOff = std::format("Condition{}-{}:ConditionsOffset", groupID, i);
+        for (size_t i = 0; i < conditions[g].size(); i++) {
+            const Range subconditions = pool.conditions[conditions[g][i]].subconditions;
+            Reserved<int64_t> slot = conditionSlots[g][i].conditionsOffset;
 
-            if (cond.subconditions.size() == 0) {
-                FillReservedInt64(condOff, -1);
+            if (subconditions.count == 0) {
+                FillReservedInt64(slot, -1);
             } else {
-                FillReservedInt64(condOff, getDataOffset());
-
-                for (const auto& subCon : cond.subconditions) {
-                    WriteInt64(conditionOffsets[subCon.condId]);
-                    conditionOffsetsCount += 1;
-                }
+                FillReservedInt64(slot, getDataOffset());
+                writeLinks(subconditions);
             }
         }
     }
 
-    FillReservedInt32("ConditionOffsetsCount", conditionOffsetsCount);
-    for (const auto& groupID : std::views::keys(stateGroups)) {
-        for (int i = 0; i < conditions[groupID].size(); i++) {
-            const auto& cond = conditions[groupID][i];
-            std::string evalOff = std::format("Condition{}-{}:EvaluatorOffset", groupID, i);
+    header.conditionOffsetsCount = conditionOffsetsCount;
+    for (size_t g = 0; g < conditions.size(); g++) {
+        for (size_t i = 0; i < conditions[g].size(); i++) {
+            const std::span<const char> evaluator =
+                Bytes(pool.conditions[conditions[g][i]].evaluator);
 
-            FillReservedInt64(evalOff, getDataOffset());
-            ostream->write(cond.evaluator.data(), cond.evaluator.size());
+            FillReservedInt64(conditionSlots[g][i].evaluatorOffset, getDataOffset());
+            writer.Write(evaluator.data(), evaluator.size());
         }
     }
 
-    for (int i = 0; i < commands.size(); i++) {
-        for (int j = 0; j < commands[i].arguments.size(); j++) {
-            std::string argBytesOff = std::format("Command{}-{}:BytecodeOffset", i, j);
-            FillReservedInt64(argBytesOff, getDataOffset());
-            ostream->write(commands[i].arguments[j].data(), commands[i].arguments[j].size());
+    size_t argIndex = 0;
+    for (uint32_t c : commands) {
+        const Range args = pool.commands[c].arguments;
+        for (uint32_t a = args.first; a < args.first + args.count; a++) {
+            const std::span<const char> arg = Bytes(pool.arguments[a]);
+            FillReservedInt64(bytecodeOffsets[argIndex++], getDataOffset());
+            writer.Write(arg.data(), arg.size());
         }
     }
 
-    FillReservedInt32("NameBlockOffset", static_cast<int>(getDataOffset()));
+    header.nameBlockOffset = static_cast<int>(getDataOffset());
     if (name == "") {
-        FillReservedInt64("NameOffset", -1);
+        FillReservedInt64(nameOffset, -1);
     } else {
         PadStream(2);
-        FillReservedInt64("NameOffset", getDataOffset());
+        FillReservedInt64(nameOffset, getDataOffset());
         WriteUtf16String(name);
     }
 
-    FillReservedInt32("UnkOffset1", static_cast<int>(getDataOffset()));
-    FillReservedInt32("UnkOffset2", static_cast<int>(getDataOffset()));
-    FillReservedInt32("DataSize", static_cast<int>(getDataOffset()));
+    header.unkOffset1 = static_cast<int>(getDataOffset());
+    header.unkOffset2 = static_cast<int>(getDataOffset());
+    header.dataSize = static_cast<int>(getDataOffset());
 
+    PatchStruct(0, header);
     PadStream(0x10);
 
-    auto& ss = static_cast<std::stringstream&>(*ostream);
-    ss.seekg(0, std::ios::end);
-
-    std::vector<char> bytes(stateSize);
+    // the extra state of a multi state group is a copy of its first state, offsets included
+    std::span<char> out = writer.Data();
     for (const auto& offsets : weirdStateOffsets) {
-        ss.seekg(offsets.first);
-        ss.read(bytes.data(), stateSize);
-
-        ss.seekp(offsets.second);
-        ss.write(bytes.data(), stateSize);
+        std::memcpy(out.data() + offsets.second, out.data() + offsets.first, stateSize);
     }
 
-    ss.seekg(0, std::ios::end);
-    auto totalSize = ss.tellg();
-
-    outputData.resize(totalSize);
-    ss.seekg(0, std::ios::beg);
-    ss.read(outputData.data(), totalSize);
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.esd", std::ios::out | std::ios::binary);
@@ -831,109 +908,113 @@ bool Esd::RepackEsd(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("ESD Repacking complete\n");
     return true;
 }
 
-bool Esd::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    Esd mod1Esd = Esd(mod1Data, merger);
-    const std::map<int64_t, std::map<int64_t, State>> mod1StateGroups = mod1Esd.stateGroups;
-
-    Esd mod2Esd = Esd(mod2Data, merger);
-    const std::map<int64_t, std::map<int64_t, State>> mod2StateGroups = mod2Esd.stateGroups;
+bool Esd::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    const Esd mod1Esd = Esd(mod1Data, merger);
+    const auto& mod1StateGroups = mod1Esd.stateGroups;
+
+    const Esd mod2Esd = Esd(mod2Data, merger);
+    const auto& mod2StateGroups = mod2Esd.stateGroups;
+
+    // the mods' records join this pool, so every state below is an index into the one pool and
+    // taking a mod's state is taking its index
+    const uint32_t mod1Base = pool.Append(mod1Esd.pool);
+    const uint32_t mod2Base = pool.Append(mod2Esd.pool);
+    auto rebased = [](const StateGroup& group, uint32_t base) {
+        StateGroup moved;
+        for (const auto& [id, index] : group) {
+            moved.emplace_hint(moved.end(), id, index + base);
+        }
+        return moved;
+    };
 
     for (auto& groupPair : stateGroups) {
         auto& stateGroup = groupPair.second;
         const auto& stateGroupID = groupPair.first;
 
-        std::optional<std::map<int64_t, State>> mod1group =
-            GetSameStateGroup(stateGroupID, mod1StateGroups);
-        std::optional<std::map<int64_t, State>> mod2group =
-            GetSameStateGroup(stateGroupID, mod2StateGroups);
+        const auto* mod1group = GetSameStateGroup(stateGroupID, mod1StateGroups);
+        const auto* mod2group = GetSameStateGroup(stateGroupID, mod2StateGroups);
 
         for (auto& statePair : stateGroup) {
-            const int stateID = statePair.first;
-            State& st = statePair.second;
+            const int64_t stateID = statePair.first;
+            uint32_t& st = statePair.second;
 
-            bool mod1Modified = false;
-            bool mod2Modified = false;
+            const uint32_t* mod1Index = GetSameState(stateID, mod1group);
+            const uint32_t* mod2Index = GetSameState(stateID, mod2group);
+            const uint32_t mod1st = mod1Index ? *mod1Index + mod1Base : 0;
+            const uint32_t mod2st = mod2Index ? *mod2Index + mod2Base : 0;
 
-            std::optional<State> mod1st = GetSameState(stateID, mod1group);
-            std::optional<State> mod2st = GetSameState(stateID, mod2group);
-
-            mod1Modified = mod1st && (mod1st != st);
-            mod2Modified = mod2st && (mod2st != st);
+            const bool mod1Modified = mod1Index && pool.states[mod1st].hash != pool.states[st].hash;
+            const bool mod2Modified = mod2Index && pool.states[mod2st].hash != pool.states[st].hash;
 
             if (mod1Modified && mod2Modified) {
                 bool mergeSuccessful = true;
+                // copies, merging appends to the pool
+                const State vanilla = pool.states[st];
+                const State mod1 = pool.states[mod1st];
+                const State mod2 = pool.states[mod2st];
+
                 State mergedState;
                 mergedState.id = stateID;
-
                 mergedState.entryCommands =
-                    MergeCommands(st.entryCommands, mod1st->entryCommands, mod2st->entryCommands);
+                    MergeCommands(vanilla.entryCommands, mod1.entryCommands, mod2.entryCommands);
                 mergedState.exitCommands =
-                    MergeCommands(st.exitCommands, mod1st->exitCommands, mod2st->exitCommands);
+                    MergeCommands(vanilla.exitCommands, mod1.exitCommands, mod2.exitCommands);
                 mergedState.whileCommands =
-                    MergeCommands(st.whileCommands, mod1st->whileCommands, mod2st->whileCommands);
-                mergedState.conditions = MergeConditions(st.conditions, mod1st->conditions,
-                                                         mod2st->conditions, mergeSuccessful);
+                    MergeCommands(vanilla.whileCommands, mod1.whileCommands, mod2.whileCommands);
+                mergedState.conditions = MergeConditions(vanilla.conditions, mod1.conditions,
+                                                         mod2.conditions, mergeSuccessful);
 
                 if (mergeSuccessful) {
-                    st = mergedState;
+                    HashState(mergedState);
+                    st = static_cast<uint32_t>(pool.states.size());
+                    pool.states.push_back(mergedState);
                     sendLog("Successfully deep-merged contents of State ID: " +
                             std::to_string(stateID));
                 } else {
-                    if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                        QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                                  Qt::BlockingQueuedConnection);
-                        if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                            return false;
-                        }
+                    if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                        return false;
                     }
 
-                    if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                        st = mod1st.value();
+                    if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                        st = mod1st;
                         sendLog("Logical conflict in state id: " + std::to_string(stateID) +
                                     ", fallback to prioritized mod data: " + merger->Mod1Name(),
                                 LogFormat::Yellow);
-                    } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                        st = mod2st.value();
+                    } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                        st = mod2st;
                         sendLog("Logical conflict in state id: " + std::to_string(stateID) +
                                     ", fallback to prioritized mod data: " + merger->Mod2Name(),
                                 LogFormat::Yellow);
                     }
                 }
             } else if (mod1Modified && !mod2Modified) {
-                st = mod1st.value();
+                st = mod1st;
                 sendLog("Merging modified state: " + std::to_string(stateID) +
                         " from mod: " + merger->Mod1Name());
             } else if (mod2Modified && !mod1Modified) {
-                st = mod2st.value();
+                st = mod2st;
                 sendLog("Merging modified state: " + std::to_string(stateID) +
                         " from mod: " + merger->Mod2Name());
             }
         }
 
-        std::unordered_set<int> existingIds;
+        std::unordered_set<int64_t> existingIds;
         for (const auto& id : std::views::keys(stateGroup)) {
             existingIds.insert(id);
         }
 
-        if (mod1group.has_value()) {
-            for (const auto& stPair : mod1group.value()) {
-                if (existingIds.find(stPair.first) == existingIds.end()) {
-                    stateGroup[stPair.first] = stPair.second;
-                    sendLog("New state added to group : " + std::to_string(stateGroupID) +
-                            " state ID: " + std::to_string(stPair.first));
-                }
+        for (const auto& [modGroup, base] :
+             {std::pair{mod1group, mod1Base}, std::pair{mod2group, mod2Base}}) {
+            if (!modGroup) {
+                continue;
             }
-        }
-
-        if (mod2group.has_value()) {
-            for (const auto& stPair : mod2group.value()) {
+            for (const auto& stPair : *modGroup) {
                 if (existingIds.find(stPair.first) == existingIds.end()) {
-                    stateGroup[stPair.first] = stPair.second;
+                    stateGroup[stPair.first] = stPair.second + base;
                     sendLog("New state added to group : " + std::to_string(stateGroupID) +
                             " state ID: " + std::to_string(stPair.first));
                 }
@@ -941,21 +1022,21 @@ bool Esd::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Dat
         }
     }
 
-    std::unordered_set<int> existingGroupIds;
+    std::unordered_set<int64_t> existingGroupIds;
     for (const auto& id : std::views::keys(stateGroups)) {
         existingGroupIds.insert(id);
     }
 
     for (const auto& sg : mod1StateGroups) {
         if (existingGroupIds.find(sg.first) == existingGroupIds.end()) {
-            stateGroups[sg.first] = sg.second;
+            stateGroups[sg.first] = rebased(sg.second, mod1Base);
             sendLog("New state group added id: " + std::to_string(sg.first));
         }
     }
 
     for (const auto& sg : mod2StateGroups) {
         if (existingGroupIds.find(sg.first) == existingGroupIds.end()) {
-            stateGroups[sg.first] = sg.second;
+            stateGroups[sg.first] = rebased(sg.second, mod2Base);
             sendLog("New state group added id: " + std::to_string(sg.first));
         }
     }
@@ -963,75 +1044,99 @@ bool Esd::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Dat
     return true;
 }
 
-std::vector<Esd::CommandCall> Esd::MergeCommands(const std::vector<CommandCall>& vanilla,
-                                                 const std::vector<CommandCall>& mod1,
-                                                 const std::vector<CommandCall>& mod2) {
-    if (mod1 == vanilla && mod2 != vanilla)
+Esd::Range Esd::MergeCommands(Range vanilla, Range mod1, Range mod2) {
+    const bool mod1Same = SameCommands(mod1, vanilla);
+    const bool mod2Same = SameCommands(mod2, vanilla);
+    if (mod1Same && !mod2Same)
         return mod2;
-    if (mod2 == vanilla && mod1 != vanilla)
+    if (mod2Same && !mod1Same)
         return mod1;
 
-    std::vector<CommandCall> result = vanilla;
+    auto contains = [this](const std::vector<uint32_t>& calls, uint32_t call) {
+        return std::ranges::any_of(calls, [&](uint32_t c) {
+            return pool.commands[c].hash == pool.commands[call].hash;
+        });
+    };
 
-    for (const auto& cmd : mod1) {
-        if (std::find(vanilla.begin(), vanilla.end(), cmd) == vanilla.end()) {
-            result.push_back(cmd);
+    std::vector<uint32_t> result;
+    for (uint32_t c = vanilla.first; c < vanilla.first + vanilla.count; c++) {
+        result.push_back(c);
+    }
+    const std::vector<uint32_t> vanillaCalls = result;
+
+    for (uint32_t c = mod1.first; c < mod1.first + mod1.count; c++) {
+        if (!contains(vanillaCalls, c)) {
+            result.push_back(c);
         }
     }
 
-    for (const auto& cmd : mod2) {
-        if (std::find(vanilla.begin(), vanilla.end(), cmd) == vanilla.end() &&
-            std::find(result.begin(), result.end(), cmd) == result.end()) {
-            result.push_back(cmd);
+    for (uint32_t c = mod2.first; c < mod2.first + mod2.count; c++) {
+        if (!contains(vanillaCalls, c) && !contains(result, c)) {
+            result.push_back(c);
         }
     }
-    return result;
+
+    if (result.size() == vanilla.count) {
+        return vanilla;
+    }
+
+    // the merged list is a new run, the records are copied and keep pointing at their arguments
+    Range merged{static_cast<uint32_t>(pool.commands.size()), static_cast<uint32_t>(result.size())};
+    for (uint32_t c : result) {
+        const CommandCall call = pool.commands[c];
+        pool.commands.push_back(call);
+    }
+    return merged;
 }
 
-std::vector<Esd::Condition> Esd::MergeConditions(const std::vector<Condition>& vanilla,
-                                                 const std::vector<Condition>& mod1,
-                                                 const std::vector<Condition>& mod2,
-                                                 bool& success) {
+Esd::Range Esd::MergeConditions(Range vanilla, Range mod1, Range mod2, bool& success) {
     if (!success)
         return mod1;
-    if (mod1 == vanilla && mod2 != vanilla)
+    const bool mod1Same = SameConditions(mod1, vanilla);
+    const bool mod2Same = SameConditions(mod2, vanilla);
+    if (mod1Same && !mod2Same)
         return mod2;
-    if (mod2 == vanilla && mod1 != vanilla)
+    if (mod2Same && !mod1Same)
         return mod1;
 
-    std::vector<Condition> result;
+    std::vector<uint32_t> result;
+    auto link = [this](Range links, size_t i) { return pool.conditionLinks[links.first + i]; };
+    auto sameEvaluator = [this](const Condition& a, const Condition& b) {
+        return std::ranges::equal(Bytes(a.evaluator), Bytes(b.evaluator));
+    };
 
-    size_t vanillaSize = vanilla.size();
-    size_t maxSize = std::max(mod1.size(), mod2.size());
+    size_t vanillaSize = vanilla.count;
+    size_t maxSize = std::max(mod1.count, mod2.count);
 
     // index matching does not work, not sure what to do...
     for (size_t i = 0; i < maxSize; ++i) {
         bool inVanilla = (i < vanillaSize);
-        bool inMod1 = (i < mod1.size());
-        bool inMod2 = (i < mod2.size());
+        bool inMod1 = (i < mod1.count);
+        bool inMod2 = (i < mod2.count);
 
         if (inVanilla) {
-            const Condition& vanCond = vanilla[i];
+            // copies, the nested merges append to the pool
+            const Condition vanCond = pool.conditions[link(vanilla, i)];
 
             if (inMod1 && inMod2) {
-                const Condition& c1 = mod1[i];
-                const Condition& c2 = mod2[i];
+                const Condition c1 = pool.conditions[link(mod1, i)];
+                const Condition c2 = pool.conditions[link(mod2, i)];
 
-                if (c1.evaluator != c2.evaluator && c1.evaluator != vanCond.evaluator &&
-                    c2.evaluator != vanCond.evaluator) {
+                if (!sameEvaluator(c1, c2) && !sameEvaluator(c1, vanCond) &&
+                    !sameEvaluator(c2, vanCond)) {
                     success = false;
-                    return result;
+                    return {};
                 }
 
                 if (c1.targetStateId != c2.targetStateId &&
                     c1.targetStateId != vanCond.targetStateId &&
                     c2.targetStateId != vanCond.targetStateId) {
                     success = false;
-                    return result;
+                    return {};
                 }
 
                 Condition mergedCond =
-                    (c1.evaluator != vanCond.evaluator || c1.targetStateId != vanCond.targetStateId)
+                    (!sameEvaluator(c1, vanCond) || c1.targetStateId != vanCond.targetStateId)
                         ? c1
                         : c2;
 
@@ -1040,57 +1145,50 @@ std::vector<Esd::Condition> Esd::MergeConditions(const std::vector<Condition>& v
                 mergedCond.subconditions = MergeConditions(vanCond.subconditions, c1.subconditions,
                                                            c2.subconditions, success);
 
-                result.push_back(mergedCond);
+                HashCondition(mergedCond);
+                result.push_back(static_cast<uint32_t>(pool.conditions.size()));
+                pool.conditions.push_back(mergedCond);
             } else if (inMod1) {
-                result.push_back(mod1[i]);
+                result.push_back(link(mod1, i));
             } else if (inMod2) {
-                result.push_back(mod2[i]);
+                result.push_back(link(mod2, i));
             }
         } else {
             if (inMod1 && inMod2) {
-                if (mod1[i] == mod2[i]) {
-                    result.push_back(mod1[i]);
+                if (pool.conditions[link(mod1, i)].hash == pool.conditions[link(mod2, i)].hash) {
+                    result.push_back(link(mod1, i));
                 } else {
                     success = false;
-                    return result;
+                    return {};
                 }
             } else if (inMod1) {
-                result.push_back(mod1[i]);
+                result.push_back(link(mod1, i));
             } else if (inMod2) {
-                result.push_back(mod2[i]);
+                result.push_back(link(mod2, i));
             }
         }
     }
 
-    return result;
+    Range merged{static_cast<uint32_t>(pool.conditionLinks.size()),
+                 static_cast<uint32_t>(result.size())};
+    pool.conditionLinks.insert(pool.conditionLinks.end(), result.begin(), result.end());
+    return merged;
 }
 
-std::optional<Esd::State> Esd::GetSameState(
-    const int& id, const std::optional<std::map<int64_t, State>>& otherStates) {
-    if (!otherStates.has_value()) {
-        return std::nullopt;
+// groups and states are keyed on their ids, so both lookups go straight through the map
+const uint32_t* Esd::GetSameState(int64_t id, const StateGroup* otherStates) {
+    if (!otherStates) {
+        return nullptr;
     }
 
-    std::optional<State> result = std::nullopt;
-    for (const auto& otherEntry : otherStates.value()) {
-        if (otherEntry.second.id == id) {
-            return result.emplace(otherEntry.second);
-        }
-    }
-
-    return result;
+    auto it = otherStates->find(id);
+    return it != otherStates->end() ? &it->second : nullptr;
 }
 
-std::optional<std::map<int64_t, Esd::State>> Esd::GetSameStateGroup(
-    const int& id, const std::map<int64_t, std::map<int64_t, Esd::State>> otherGroups) {
-    std::optional<std::map<int64_t, Esd::State>> result = std::nullopt;
-    for (const auto& group : otherGroups) {
-        if (group.first == id) {
-            return result.emplace(group.second);
-        }
-    }
-
-    return result;
+const Esd::StateGroup* Esd::GetSameStateGroup(int64_t id,
+                                              const std::map<int64_t, StateGroup>& otherGroups) {
+    auto it = otherGroups.find(id);
+    return it != otherGroups.end() ? &it->second : nullptr;
 }
 
 Esd::~Esd() {}
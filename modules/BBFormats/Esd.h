@@ -10,75 +10,135 @@ namespace FileHelper {
 class Esd : public BBFormat {
     Q_OBJECT
 
+    // a run of records in one of the pool arrays, or of bytes in Pool::bytes
+    struct Range {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
     struct CommandCall {
         int commandBank; // Should be 1, 5, 6, or 7.
         int commandId;
-        std::vector<std::vector<char>> arguments;
-
-        bool operator==(const CommandCall&) const = default;
+        Range arguments; // into Pool::arguments
+        uint64_t hash;
     };
 
     struct Condition {
-        int condId; // for map only >.<
-        int64_t stateOffset;
         std::optional<int64_t> targetStateId = std::nullopt;
-        std::vector<char> evaluator;
-        std::vector<CommandCall> passCommands;
-        std::vector<Condition> subconditions;
-        std::vector<int64_t> conditionOffsets;
-
-        bool operator==(const Condition& other) const { // everything exc. the map Id
-            return stateOffset == other.stateOffset && targetStateId == other.targetStateId &&
-                   evaluator == other.evaluator && passCommands == other.passCommands &&
-                   subconditions == other.subconditions &&
-                   conditionOffsets == other.conditionOffsets;
-        }
+        Range evaluator;     // bytes
+        Range passCommands;  // into Pool::commands
+        Range subconditions; // into Pool::conditionLinks
+        uint64_t hash = 0;
     };
 
-    struct State { /// <summary>
+    struct State {
         int64_t id;
-        std::vector<CommandCall> entryCommands;
-        std::vector<CommandCall> exitCommands;
-        std::vector<CommandCall> whileCommands;
-        std::vector<int64_t> conditionOffsets;
-        std::vector<Condition> conditions;
+        Range entryCommands;
+        Range exitCommands;
+        Range whileCommands;
+        Range conditions; // into Pool::conditionLinks
+        uint64_t hash = 0;
+    };
 
-        bool operator==(const State&) const = default;
+    // every record of the state machine, addressed by index. hashes are structural, two states
+    // or conditions with the same hash hold the same commands, evaluators and targets, wherever
+    // they sit in the pool, so equality is a single compare
+    struct Pool {
+        std::vector<State> states;
+        std::vector<Condition> conditions;
+        std::vector<uint32_t> conditionLinks; // condition lists of states and conditions
+        std::vector<CommandCall> commands;
+        std::vector<Range> arguments; // bytes of each command argument
+        std::vector<char> bytes;      // argument and evaluator data
+
+        // appends other's records with their links moved along, returns the index other's
+        // first state got
+        uint32_t Append(const Pool& other);
     };
 
+    using StateGroup = std::map<int64_t, uint32_t>; // state id -> index in Pool::states
+
 public:
-    explicit Esd(std::vector<char>& data, ModMerger* parent);
+    explicit Esd(std::span<const char> data, MergeEngine* parent);
     ~Esd() override;
 
-    bool ReadEsd(std::vector<char>& data);
+    bool ReadEsd(std::span<const char> data);
     bool RepackEsd(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
 private:
-    std::vector<CommandCall> MergeCommands(const std::vector<CommandCall>& vanilla,
-                                           const std::vector<CommandCall>& mod1,
-                                           const std::vector<CommandCall>& mod2);
-    std::vector<Condition> MergeConditions(const std::vector<Condition>& vanilla,
-                                           const std::vector<Condition>& mod1,
-                                           const std::vector<Condition>& mod2, bool& success);
-
-    std::optional<State> GetSameState(const int& id,
-                                      const std::optional<std::map<int64_t, State>>& otherStates);
-    std::optional<std::map<int64_t, State>> GetSameStateGroup(
-        const int& id, const std::map<int64_t, std::map<int64_t, State>> stateGroups);
-
-    void AddCommandCall(std::vector<CommandCall>& callsVector, const uint64_t& dataStart);
+    // fixed part of the file header, the data section starts right after it
+    struct Header {
+        char magic[4]; // fsSL
+        int32_t unk04; // 1
+        int32_t gameNumber;
+        int32_t unk0C; // 2
+        int32_t unk10; // 0x54
+        int32_t dataSize;
+        int32_t unk18;          // 6
+        int32_t unk1C;          // 0x48
+        int32_t unk20;          // 1
+        int32_t stateGroupSize; // 0x20
+        int32_t stateGroupCount;
+        int32_t stateSize; // 0x48
+        int32_t stateCount;
+        int32_t conditionSize; // 0x38
+        int32_t conditionCount;
+        int32_t commandCallSize; // 0x18
+        int32_t commandCallCount;
+        int32_t commandArgSize; // 0x10
+        int32_t commandArgCount;
+        int32_t conditionOffsetsOffset;
+        int32_t conditionOffsetsCount;
+        int32_t nameBlockOffset;
+        int32_t nameLength;
+        int32_t unkOffset1;
+        int32_t unk5C;
+        int32_t unkOffset2;
+        int32_t unk64;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.unk04, h.gameNumber, h.unk0C, h.unk10, h.dataSize, h.unk18, h.unk1C,
+                            h.unk20, h.stateGroupSize, h.stateGroupCount, h.stateSize,
+                            h.stateCount, h.conditionSize, h.conditionCount, h.commandCallSize,
+                            h.commandCallCount, h.commandArgSize, h.commandArgCount,
+                            h.conditionOffsetsOffset, h.conditionOffsetsCount, h.nameBlockOffset,
+                            h.nameLength, h.unkOffset1, h.unk5C, h.unkOffset2, h.unk64);
+        }
+    };
+    static_assert(sizeof(Header) == 0x6C);
+
+    Range MergeCommands(Range vanilla, Range mod1, Range mod2);
+    Range MergeConditions(Range vanilla, Range mod1, Range mod2, bool& success);
+
+    static const uint32_t* GetSameState(int64_t id, const StateGroup* otherStates);
+    static const StateGroup* GetSameStateGroup(int64_t id,
+                                               const std::map<int64_t, StateGroup>& stateGroups);
+
+    Range AddCommandCalls(int64_t offset, int64_t count, const uint64_t& dataStart);
+    Range AddBytes(int64_t length);
     bool TakeStates(const int64_t& stateSize, const std::vector<int64_t>& stateOffsets,
-                    std::map<int64_t, State>& states, std::map<int64_t, int64_t>& stateIds,
-                    std::map<int64_t, Esd::State>& stateGroup);
-    bool GetStateAndConditions(Condition& condition, const std::map<int64_t, int64_t>& stateOffsets,
-                               const std::map<int64_t, Condition>& conditionMap);
+                    const std::unordered_map<int64_t, uint32_t>& stateAt,
+                    std::vector<bool>& taken, std::unordered_map<int64_t, int64_t>& stateIds,
+                    StateGroup& stateGroup);
+
+    std::span<const char> Bytes(Range range) const {
+        return {pool.bytes.data() + range.first, range.count};
+    }
+    bool SameCommands(Range a, Range b) const;
+    bool SameConditions(Range a, Range b) const;
+    uint64_t CommandsHash(uint64_t hash, Range commands) const;
+    uint64_t ConditionsHash(uint64_t hash, Range links) const;
+    void HashCondition(Condition& condition) const;
+    void HashState(State& state) const;
+    bool HashConditions();
 
     bool longFormat;
     int gameNumber = 2;
     int Unk70, Unk74, Unk78, Unk7C;
     std::string name = "";
-    std::map<int64_t, std::map<int64_t, State>> stateGroups;
+    Pool pool;
+    std::map<int64_t, StateGroup> stateGroups;
 };
 
 } // namespace FileHelper
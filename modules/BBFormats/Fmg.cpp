@@ -4,108 +4,94 @@
 #include <vector>
 
 #include "Fmg.h"
-#include "modules/ModMerger.h"
+#include "MergeJoin.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Fmg::Fmg(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+Fmg::Fmg(std::span<const char> data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     ReadFmg(data);
 }
 
-bool Fmg::ReadFmg(std::vector<char>& data) {
+bool Fmg::ReadFmg(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty fmg input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
-    std::string strBuffer = "";
-    int intBuffer = 0;
+    Header header;
+    auto* headerBytes = reinterpret_cast<char*>(&header);
 
-    GetByte(intBuffer);
-    debugLog("md5: " + std::to_string(intBuffer));
-    if (intBuffer != 0) {
+    reader.Read(headerBytes, 1);
+    debugLog("md5: {}", header.md5);
+    if (header.md5 != 0) {
         md5 = true;
-        istream->seekg(17); // md5 bytes exist, must be skipped
+        reader.Seek(17); // md5 bytes exist, must be skipped
     }
 
-    GetByte(bigEndian);
-    debugLog("bigEndian: " + std::to_string(bigEndian));
+    reader.Read(headerBytes + 1, sizeof(Header) - 1);
+    bigEndian = header.bigEndian;
+    SwapStruct(header);
+    debugLog("bigEndian: {}", bigEndian);
+    debugLog("version: {}", header.version);
 
-    GetByte(intBuffer);
-    debugLog("version: " + std::to_string(intBuffer));
-
-    if (intBuffer != 2) {
-        sendLog("ERROR: Unexpected FMG version: " + std::to_string(intBuffer), LogFormat::BoldRed);
+    if (header.version != 2) {
+        sendLog("ERROR: Unexpected FMG version: " + std::to_string(header.version),
+                LogFormat::BoldRed);
     }
 
-    istream->ignore(1); // or assert 0
-
-    GetInt32(intBuffer);
-    debugLog("filesize: " + std::to_string(intBuffer));
-
-    GetByte(unicode);
-    debugLog("unicode: " + std::to_string(unicode)); // should be 1?
-
-    istream->ignore(3); // or assert 0
-
-    int entryCount;
-    GetInt32(entryCount);
-    debugLog("entryCount: " + std::to_string(entryCount));
+    debugLog("filesize: {}", header.fileSize);
 
-    GetInt32(intBuffer);
-    debugLog("stringCount: " + std::to_string(intBuffer));
+    unicode = header.unicode;
+    debugLog("unicode: {}", unicode); // should be 1?
 
-    istream->ignore(4); // or assert 0xFF
+    int entryCount = header.groupCount;
+    debugLog("entryCount: {}", entryCount);
+    debugLog("stringCount: {}", header.stringCount);
 
-    uint64_t stringOffsetOffset;
-    GetInt64(stringOffsetOffset);
-    debugLog("stringOffsetOffset: " + std::to_string(stringOffsetOffset));
+    uint64_t stringOffsetOffset = header.stringOffsetsOffset;
+    debugLog("stringOffsetOffset: {}", stringOffsetOffset);
 
     if (md5) {
         stringOffsetOffset += 16;
     }
 
-    istream->ignore(8); // or assert 0
-
     for (int i = 0; i < entryCount; i++) {
-        int offsetIndex;
-        GetInt32(offsetIndex);
-        debugLog("offsetIndex: " + std::to_string(offsetIndex));
+        Group group;
+        ReadStruct(group);
 
-        int firstID;
-        GetInt32(firstID);
-        debugLog("firstID: " + std::to_string(firstID));
+        int offsetIndex = group.offsetIndex;
+        debugLog("offsetIndex: {}", offsetIndex);
 
-        int lastID;
-        GetInt32(lastID);
-        debugLog("lastID: " + std::to_string(lastID));
+        int firstID = group.firstId;
+        debugLog("firstID: {}", firstID);
 
-        istream->ignore(4); // or assert 0
+        int lastID = group.lastId;
+        debugLog("lastID: {}", lastID);
 
-        StepIn(stringOffsetOffset + offsetIndex * 8, *istream);
+        StepIn(stringOffsetOffset + offsetIndex * 8, reader);
         for (int j = 0; j < lastID - firstID + 1; j++) {
             uint64_t stringOffset;
             GetInt64(stringOffset);
-            debugLog("stringOffset: " + std::to_string(stringOffset));
+            debugLog("stringOffset: {}", stringOffset);
             if (md5)
                 stringOffset += 16;
 
             FmgEntry entry;
             entry.id = firstID + j;
-            debugLog("entry.id: " + std::to_string(entry.id));
+            debugLog("entry.id: {}", entry.id);
 
             if (stringOffset > 0) {
                 if (unicode) {
-                    StepIn(stringOffset, *istream);
+                    StepIn(stringOffset, reader);
                     entry.text = ReadUtf16String();
-                    debugLog("entry.text: " + entry.text);
-                    StepOut(*istream);
+                    debugLog("entry.text: {}", entry.text);
+                    StepOut(reader);
                 } else {
                     sendLog("ERROR unexpected fmg string encoding", LogFormat::BoldRed);
                     return false;
@@ -114,86 +100,78 @@ bool Fmg::ReadFmg(std::vector<char>& data) {
 
             fmgEntries.push_back(entry);
         }
-        StepOut(*istream);
+        StepOut(reader);
     }
 
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
 bool Fmg::RepackFmg(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
-
-    WriteByte(0);
-    WriteByte(0); // big endian = false
-    WriteByte(2); // version
-    WriteByte(0);
-
-    ReserveBytes("FileSize", 4);
-    WriteByte(1); // unicode = true
-    WriteByte(0);
-    WriteByte(0);
-    WriteByte(0);
+    // layout pass: header, worst case one group per entry, offset table and utf-16 text
+    size_t layoutSize = sizeof(Header) + fmgEntries.size() * (sizeof(Group) + 8);
+    for (const auto& entry : fmgEntries) {
+        layoutSize += (entry.text.size() + 1) * 2;
+    }
+    writer = SpanWriter(layoutSize);
 
-    ReserveBytes("GroupCount", 4);
-    WriteInt32(static_cast<int>(fmgEntries.size()));
-    WriteInt32(0xFF);
+    Header header{};
+    header.bigEndian = 0;
+    header.version = 2;
+    header.unicode = 1;
+    header.stringCount = static_cast<int32_t>(fmgEntries.size());
+    header.unk14 = 0xFF;
 
-    ReserveBytes("StringOffsets", 8);
-    WriteInt64(static_cast<uint64_t>(0));
+    // file size, group count and string offsets are filled in at the end
+    WriteStruct(header);
 
-    int entryCount = 0;
     std::sort(fmgEntries.begin(), fmgEntries.end(),
               [](const auto& e1, const auto& e2) { return e1.id < e2.id; });
 
     for (int i = 0; i < fmgEntries.size(); i++) {
-        WriteInt32(i);
-        WriteInt32(fmgEntries[i].id);
+        Group group{};
+        group.offsetIndex = i;
+        group.firstId = fmgEntries[i].id;
 
         while (i < fmgEntries.size() - 1 && fmgEntries[i + 1].id == fmgEntries[i].id + 1) {
             i++;
         }
 
-        WriteInt32(fmgEntries[i].id);
-        WriteInt32(0);
+        group.lastId = fmgEntries[i].id;
+        WriteStruct(group);
 
-        entryCount++;
+        header.groupCount++;
     }
 
-    FillReservedInt32("GroupCount", entryCount);
-    FillReservedInt64("StringOffsets", static_cast<uint64_t>(ostream->tellp()));
+    header.stringOffsetsOffset = static_cast<int64_t>(writer.Tell());
 
-    for (int i = 0; i < fmgEntries.size(); i++) {
-        strBuffer = "StringOffset" + std::to_string(i);
-        ReserveBytes(strBuffer, 8);
+    std::vector<Reserved<int64_t>> stringOffsets(fmgEntries.size());
+    for (auto& slot : stringOffsets) {
+        slot = ReserveInt64();
     }
 
     for (int i = 0; i < fmgEntries.size(); i++) {
-        strBuffer = "StringOffset" + std::to_string(i);
-
         if (!fmgEntries[i].text.empty()) {
-            FillReservedInt64(strBuffer, static_cast<uint64_t>(ostream->tellp()));
+            FillReservedInt64(stringOffsets[i], static_cast<int64_t>(writer.Tell()));
             if (unicode) {
                 WriteUtf16String(fmgEntries[i].text);
             } else {
                 // hardcoded not to encounter, should be ok
             }
         } else {
-            FillReservedInt64(strBuffer, static_cast<uint64_t>(0));
+            FillReservedInt64(stringOffsets[i], 0);
         }
     }
 
-    FillReservedInt32("FileSize", static_cast<int>(ostream->tellp()));
+    header.fileSize = static_cast<int32_t>(writer.Tell());
+    PatchStruct(0, header);
 
     if (md5) {
         sendLog("ERROR: unexpected md5 file encountered");
         return false;
     }
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.fmg", std::ios::out | std::ios::binary);
@@ -203,97 +181,71 @@ bool Fmg::RepackFmg(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("FMG Repacking complete\n");
     return true;
 }
 
-bool Fmg::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    Fmg mod1Fmg = Fmg(mod1Data, merger);
-    const std::vector<FmgEntry> mod1Fmgs = mod1Fmg.fmgEntries;
-
-    Fmg mod2Fmg = Fmg(mod2Data, merger);
-    const std::vector<FmgEntry> mod2Fmgs = mod2Fmg.fmgEntries;
-
-    for (int i = 0; i < fmgEntries.size(); i++) {
-        bool mod1Modified = false;
-        bool mod2Modified = false;
-
-        std::optional<FmgEntry> mod1entry = GetSameEntry(fmgEntries[i].id, mod1Fmgs);
-        std::optional<FmgEntry> mod2entry = GetSameEntry(fmgEntries[i].id, mod2Fmgs);
-
-        mod1Modified = mod1entry && (mod1entry->text != fmgEntries[i].text);
-        mod2Modified = mod2entry && (mod2entry->text != fmgEntries[i].text);
-
-        if (mod1Modified && mod2Modified) {
-            if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                          Qt::BlockingQueuedConnection);
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    return false;
-                }
+bool Fmg::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    const Fmg mod1Fmg = Fmg(mod1Data, merger);
+    const Fmg mod2Fmg = Fmg(mod2Data, merger);
+
+    const MergeJoinResult merge =
+        MergeJoin(fmgEntries, mod1Fmg.fmgEntries, mod2Fmg.fmgEntries, &FmgEntry::id,
+                  [](const FmgEntry& a, const FmgEntry& b) { return a.text == b.text; });
+
+    for (const MergeStep& step : merge.steps) {
+        const FmgEntry* mod1entry = step.mod1 != MergeStep::none ? &mod1Fmg.fmgEntries[step.mod1]
+                                                                 : nullptr;
+        const FmgEntry* mod2entry = step.mod2 != MergeStep::none ? &mod2Fmg.fmgEntries[step.mod2]
+                                                                 : nullptr;
+        FmgEntry* entry = step.base != MergeStep::none ? &fmgEntries[step.base] : nullptr;
+
+        switch (step.action) {
+        case MergeAction::Conflict:
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
             }
 
-            if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                fmgEntries[i].text = mod1entry->text;
+            if (!entry) {
+                entry = &fmgEntries.emplace_back(*mod1entry);
+            }
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                entry->text = mod1entry->text;
                 sendLog("Unresolvable conflict in id: " + std::to_string(mod1entry->id) +
                             ", using text: " + mod1entry->text +
                             " from prioritized mod: " + merger->Mod1Name(),
                         LogFormat::Yellow);
-            } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                fmgEntries[i].text = mod2entry->text;
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                entry->text = mod2entry->text;
                 sendLog("Unresolvable conflict in id: " + std::to_string(mod2entry->id) +
                             ", using text: " + mod2entry->text +
                             " from prioritized mod: " + merger->Mod2Name(),
                         LogFormat::Yellow);
             }
-        }
-
-        if (mod1Modified && !mod2Modified) {
-            fmgEntries[i].text = mod1entry->text;
+            break;
+        case MergeAction::TakeMod1:
+            entry->text = mod1entry->text;
             sendLog("Merging id: " + std::to_string(mod1entry->id) + " text: " + mod1entry->text +
                     " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            fmgEntries[i].text = mod2entry->text;
+            break;
+        case MergeAction::TakeMod2:
+            entry->text = mod2entry->text;
             sendLog("Merging id: " + std::to_string(mod2entry->id) + " text: " + mod2entry->text +
                     " from mod: " + merger->Mod2Name());
+            break;
+        case MergeAction::AddMod1:
+        case MergeAction::AddMod2: {
+            const FmgEntry& added = step.action == MergeAction::AddMod1 ? *mod1entry : *mod2entry;
+            fmgEntries.push_back(added);
+            sendLog("Fmg data added id: " + std::to_string(added.id) + " text: " + added.text);
+            break;
         }
-    }
-
-    std::unordered_set<int> existingIds;
-    for (const auto& entry : fmgEntries) {
-        existingIds.insert(entry.id);
-    }
-
-    for (const auto& fmg : mod1Fmgs) {
-        if (existingIds.find(fmg.id) == existingIds.end()) {
-            fmgEntries.push_back(fmg);
-            sendLog("Fmg data added id: " + std::to_string(fmg.id) + " text: " + fmg.text);
-        }
-    }
-
-    for (const auto& fmg : mod2Fmgs) {
-        if (existingIds.find(fmg.id) == existingIds.end()) {
-            fmgEntries.push_back(fmg);
-            sendLog("Fmg data added id: " + std::to_string(fmg.id) + " text: " + fmg.text);
         }
     }
 
     return true;
 }
 
-std::optional<Fmg::FmgEntry> Fmg::GetSameEntry(const int& id,
-                                               const std::vector<Fmg::FmgEntry>& otherEntries) {
-    std::optional<FmgEntry> result = std::nullopt;
-    for (const auto& otherEntry : otherEntries) {
-        if (otherEntry.id == id) {
-            return result.emplace(otherEntry);
-        }
-    }
-
-    return result;
-}
-
 Fmg::~Fmg() {}
 
 } // namespace FileHelper
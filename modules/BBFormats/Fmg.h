@@ -11,21 +11,51 @@ class Fmg : public BBFormat {
     Q_OBJECT
 
 public:
-    explicit Fmg(std::vector<char>& data, ModMerger* parent);
+    explicit Fmg(std::span<const char> data, MergeEngine* parent);
     ~Fmg() override;
 
-    bool ReadFmg(std::vector<char>& data);
+    bool ReadFmg(std::span<const char> data);
     bool RepackFmg(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
 private:
+    struct Header {
+        uint8_t md5; // 16 md5 bytes follow when set
+        uint8_t bigEndian;
+        uint8_t version;
+        uint8_t pad03;
+        int32_t fileSize;
+        uint8_t unicode;
+        uint8_t pad09[3];
+        int32_t groupCount;
+        int32_t stringCount;
+        int32_t unk14; // 0xFF
+        int64_t stringOffsetsOffset;
+        int64_t unk20;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.fileSize, h.groupCount, h.stringCount, h.unk14,
+                            h.stringOffsetsOffset, h.unk20);
+        }
+    };
+    static_assert(sizeof(Header) == 0x28);
+
+    struct Group {
+        int32_t offsetIndex;
+        int32_t firstId;
+        int32_t lastId;
+        int32_t pad0C;
+
+        static constexpr auto Fields(auto& g) {
+            return std::tie(g.offsetIndex, g.firstId, g.lastId, g.pad0C);
+        }
+    };
+
     struct FmgEntry {
         int id;
         std::string text;
     };
 
-    std::optional<FmgEntry> GetSameEntry(const int& id, const std::vector<FmgEntry>& otherEntries);
-
     int fmgversion = 2; // should always be 2 for BB
     bool unicode = true;
     bool md5 = false;
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <type_traits>
+
+#include "ConflictHandler.h"
+#include "Emevd.h"
+#include "Esd.h"
+#include "Fmg.h"
+#include "FormatRegistry.h"
+#include "GameParam.h"
+#include "Msb.h"
+#include "Tpf.h"
+
+namespace FileHelper {
+
+namespace {
+
+// the constructor parses, HandleConflict merges and Repack writes the result back
+template <typename Format, bool (Format::*Repack)(std::vector<char>&)>
+bool MergeFormat(std::vector<char>& origData, std::span<const char> mod1Data,
+                 std::span<const char> mod2Data, const std::string& name, MergeEngine* merger) {
+    auto parse = [&] {
+        if constexpr (std::is_constructible_v<Format, std::span<const char>, const std::string&,
+                                              MergeEngine*>) {
+            return Format(origData, name, merger);
+        } else {
+            return Format(origData, merger);
+        }
+    };
+
+    Format orig = parse();
+    if (!orig.HandleConflict(mod1Data, mod2Data)) {
+        return false;
+    }
+
+    // origData is only replaced once the repack succeeded, a failed one must not ship a
+    // truncated file
+    std::vector<char> out;
+    if (!(orig.*Repack)(out)) {
+        return false;
+    }
+    origData = std::move(out);
+    return true;
+}
+
+bool MergeBinder(std::vector<char>& origData, std::span<const char> mod1Data,
+                 std::span<const char> mod2Data, const std::string&, MergeEngine* merger) {
+    return ConflictHandler(merger).HandleBinderConflict(origData, mod1Data, mod2Data);
+}
+
+using namespace std::string_view_literals;
+
+// msb, emevd and esd parse and repack but are not merged yet
+constexpr std::array formats{
+    FormatHandler{"BND4", "BND4"sv, 0, ""sv, true, false, &MergeBinder},
+    FormatHandler{"TPF", "TPF\0"sv, 0, ".tpf"sv, true, true, &MergeFormat<Tpf, &Tpf::RepackTpf>},
+    FormatHandler{"FMG", ""sv, 0, ".fmg"sv, false, true, &MergeFormat<Fmg, &Fmg::RepackFmg>},
+    FormatHandler{"PARAM", ""sv, 0, ".param"sv, false, true,
+                  &MergeFormat<GameParam, &GameParam::RepackGameParam>},
+    FormatHandler{"MSB", "MSB "sv, 0, ".msb"sv, false, false, &MergeFormat<Msb, &Msb::RepackMsb>},
+    FormatHandler{"EMEVD", "EVD\0"sv, 0, ".emevd"sv, false, false,
+                  &MergeFormat<Emevd, &Emevd::RepackEmevd>},
+    FormatHandler{"ESD", "fsSL"sv, 0, ".esd"sv, false, false, &MergeFormat<Esd, &Esd::RepackEsd>},
+};
+
+std::string_view Extension(std::string_view entryName) {
+    size_t dot = entryName.rfind('.');
+    size_t separator = entryName.find_last_of("/\\");
+    if (dot == std::string_view::npos || (separator != std::string_view::npos && dot < separator)) {
+        return {};
+    }
+
+    return entryName.substr(dot);
+}
+
+} // namespace
+
+bool FormatHandler::Matches(std::span<const char> data) const {
+    if (magic.empty() || data.size() < magicOffset + magic.size()) {
+        return false;
+    }
+
+    return std::string_view(data.data() + magicOffset, magic.size()) == magic;
+}
+
+const FormatHandler* DetectFormat(std::span<const char> data) {
+    for (const FormatHandler& format : formats) {
+        if (format.Matches(data)) {
+            return &format;
+        }
+    }
+
+    return nullptr;
+}
+
+const FormatHandler* DetectFormat(std::span<const char> data, std::string_view entryName) {
+    if (const FormatHandler* format = DetectFormat(data)) {
+        return format;
+    }
+
+    std::string_view extension = Extension(entryName);
+    for (const FormatHandler& format : formats) {
+        if (!extension.empty() && format.extension == extension) {
+            return &format;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace FileHelper
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MergeEngine;
+
+namespace FileHelper {
+
+// one row per mergeable format, the table in FormatRegistry.cpp is the only place that knows
+// which class handles what. adding a format is adding a row there
+struct FormatHandler {
+    // parses all three inputs, merges both mods into origData and repacks it in place
+    using MergeFn = bool (*)(std::vector<char>& origData, std::span<const char> mod1Data,
+                             std::span<const char> mod2Data, const std::string& name,
+                             MergeEngine* merger);
+
+    std::string_view name;
+    std::string_view magic; // empty for formats without a signature
+    size_t magicOffset;
+    std::string_view extension; // fallback for binder entries
+    bool standalone;            // merged when it is the whole payload of a dcx
+    bool nested;                // merged when it is a binder entry
+    MergeFn merge;
+
+    bool Matches(std::span<const char> data) const;
+};
+
+// format of a decompressed file from its signature, nullptr when nothing matches
+const FormatHandler* DetectFormat(std::span<const char> data);
+// same, falling back to the extension of a binder entry name for formats without a signature
+const FormatHandler* DetectFormat(std::span<const char> data, std::string_view entryName);
+
+} // namespace FileHelper
@@ -1,125 +1,131 @@
 // SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <cstring>
+#include <optional>
 #include <vector>
 
 #include "GameParam.h"
-#include "modules/ModMerger.h"
+#include "MergeJoin.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-GameParam::GameParam(std::vector<char>& data, const std::string& name, ModMerger* parent)
+namespace {
+
+// bits of each row byte that no column owns, e.g. the rest of a bit field unit the paramdef
+// doesn't fill. a mod edit there can't be merged field by field
+std::vector<uint8_t> UnownedBits(const ParamDefs::Layout& layout) {
+    std::vector<uint8_t> unowned(layout.rowSize, 0xFF);
+    for (const ParamDefs::Column& column : layout.columns) {
+        for (uint32_t i = 0; i < column.size && column.offset + i < layout.rowSize; i++) {
+            uint8_t owned = column.mask == 0 ? 0xFF : static_cast<uint8_t>(column.mask >> (i * 8));
+            unowned[column.offset + i] &= ~owned;
+        }
+    }
+    return unowned;
+}
+
+} // namespace
+
+GameParam::GameParam(std::span<const char> data, const std::string& name, MergeEngine* parent)
     : fileName(name), BBFormat(parent) {
     bigEndian = false;
     ReadGameParam(data);
 }
 
-bool GameParam::ReadGameParam(std::vector<char>& data) {
+bool GameParam::ReadGameParam(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty fmg input data", LogFormat::BoldRed);
         return false;
     }
 
-    /*
-    def = GetParamDef(fileName);
-    if (!def.loaded) {
-        sendLog("ERROR: no paramdef found for " + fileName, LogFormat::BoldRed);
-        return false;
-    }
-    */
-
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
     std::string strBuffer = "";
-    int intBuffer = 0;
 
-    istream->seekg(0x2C);
-    GetByte(bigEndian); // assert 0/0xFF?
-    debugLog("bigEndian: " + std::to_string(bigEndian));
+    bigEndian = data.size() > 0x2C && data[0x2C] != 0; // assert 0/0xFF?
+    debugLog("bigEndian: {}", bigEndian);
+
+    Header header;
+    ReadStruct(header);
 
-    GetByte(format2D);
-    debugLog("format2D: " + std::to_string(format2D)); // might just hardcode to 4?
+    format2D = header.format2D;
+    debugLog("format2D: {}", format2D); // might just hardcode to 4?
     std::vector<GameParam::FormatFlags1> flags1 = GetFormatFlags1(format2D);
     auto has_flag = [flags1](FormatFlags1 flag) -> bool {
         return std::find(flags1.begin(), flags1.end(), flag) != flags1.end();
     };
 
     bool flags1HasFlag01 = has_flag(FormatFlags1::Flag01);
-    debugLog("flags1HasFlag01: " + std::to_string(flags1HasFlag01));
+    debugLog("flags1HasFlag01: {}", flags1HasFlag01);
 
     bool flags1HasIntDataOffset = has_flag(FormatFlags1::IntDataOffset);
-    debugLog("flags1HasIntDataOffset: " + std::to_string(flags1HasIntDataOffset));
+    debugLog("flags1HasIntDataOffset: {}", flags1HasIntDataOffset);
 
     bool flags1HasOffsetParamType = has_flag(FormatFlags1::OffsetParamType);
-    debugLog("flags1HasOffsetParamType: " + std::to_string(flags1HasOffsetParamType));
+    debugLog("flags1HasOffsetParamType: {}", flags1HasOffsetParamType);
 
     bool flags1HasLongDataOffset = has_flag(FormatFlags1::LongDataOffset);
-    debugLog("flags1HasLongDataOffset: " + std::to_string(flags1HasLongDataOffset));
+    debugLog("flags1HasLongDataOffset: {}", flags1HasLongDataOffset);
 
-    GetByte(format2E);
+    format2E = header.format2E;
     bool paramUnicode = IsUnicodeNames(format2E);
-    debugLog("paramUnicode: " + std::to_string(paramUnicode));
+    debugLog("paramUnicode: {}", paramUnicode);
 
-    GetByte(paramDefFormatVersion);
-    debugLog("paramdefformatversion: " + std::to_string(intBuffer)); // assert 0/0xFF?
-
-    istream->seekg(0);
+    paramDefFormatVersion = header.paramDefFormatVersion;
+    debugLog("paramdefformatversion: {}", paramDefFormatVersion);
 
     // The strings offset in the header is highly unreliable; only use it as a last resort
     uint actualStringsOffset = 0;
-    uint stringsOffset;
-    GetInt32(stringsOffset);
-    debugLog("stringsOffset: " + std::to_string(stringsOffset));
+    uint stringsOffset = header.stringsOffset;
+    debugLog("stringsOffset: {}", stringsOffset);
 
     if (flags1HasFlag01 && flags1HasIntDataOffset || flags1HasLongDataOffset) {
-        GetInt16(intBuffer);
-        debugLog("zero check: " + std::to_string(intBuffer));
+        debugLog("zero check: {}", header.unk04);
     } else {
         sendLog("ERROR: param flag types", LogFormat::BoldRed);
         return false;
     }
 
-    GetInt16(unk06);
-    debugLog("unk06: " + std::to_string(unk06));
+    unk06 = header.unk06;
+    debugLog("unk06: {}", unk06);
 
-    GetInt16(paramDefDataVersion);
-    debugLog("def.dataVersion: " + std::to_string(paramDefDataVersion));
+    paramDefDataVersion = header.dataVersion;
+    debugLog("def.dataVersion: {}", paramDefDataVersion);
 
-    int rowCount;
-    GetInt16(rowCount);
-    debugLog("rowCount: " + std::to_string(rowCount));
+    int rowCount = header.rowCount;
+    debugLog("rowCount: {}", rowCount);
 
     if (flags1HasOffsetParamType) {
         sendLog("ERROR: unexpected offset param type", LogFormat::BoldRed);
         return false;
     } else {
-        GetStr(paramType, 0x20);
+        paramType.assign(header.paramType, sizeof(header.paramType));
+        paramType.erase(std::remove(paramType.begin(), paramType.end(), '\0'), paramType.end());
     }
 
-    debugLog("paramType: " + paramType);
-    istream->ignore(4); // Format
+    debugLog("paramType: {}", paramType);
 
     uint64_t dataStartHeader = -1;
     if (flags1HasFlag01 && flags1HasIntDataOffset) {
         sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
         return false;
     } else if (flags1HasLongDataOffset) {
-        GetInt64(dataStartHeader);
-        debugLog("dataStartHeader: " + std::to_string(dataStartHeader));
-        istream->ignore(8); // or assert 0
+        dataStartHeader = header.dataStart;
+        debugLog("dataStartHeader: {}", dataStartHeader);
     }
 
-    uint64_t rowsStart = static_cast<uint64_t>(istream->tellg());
-    debugLog("rowsStart: " + std::to_string(rowsStart));
+    uint64_t rowsStart = static_cast<uint64_t>(reader.Tell());
+    debugLog("rowsStart: {}", rowsStart);
     auto GetRowDataOffset = [this, flags1HasLongDataOffset](uint64_t position) -> uint64_t {
         if (flags1HasLongDataOffset) {
             uint64_t offset;
-            StepIn(static_cast<std::streamoff>(istream->tellg()) + 8, *istream);
+            StepIn(static_cast<std::streamoff>(reader.Tell()) + 8, reader);
             GetInt64(offset);
-            StepOut(*istream);
+            StepOut(reader);
             return offset;
         } else {
             sendLog("ERROR: unexpected param w/ int offsets encountered", LogFormat::BoldRed);
@@ -130,7 +136,7 @@ bool GameParam::ReadGameParam(std::vector<char>& data) {
     bool unnamedRows = false;
     bool headerlessRows = false;
     uint64_t rowDataOffset1 = GetRowDataOffset(rowsStart);
-    debugLog("rowDataOffset1: " + std::to_string(rowDataOffset1));
+    debugLog("rowDataOffset1: {}", rowDataOffset1);
 
     uint64_t rowsSize = rowDataOffset1 - rowsStart;
     int rowHeaderSize = 12;
@@ -147,8 +153,8 @@ bool GameParam::ReadGameParam(std::vector<char>& data) {
         }
     }
 
-    debugLog("unnamedRows: " + std::to_string(unnamedRows));       // should be 0
-    debugLog("headerlessRows: " + std::to_string(headerlessRows)); // should be 0
+    debugLog("unnamedRows: {}", unnamedRows);       // should be 0
+    debugLog("headerlessRows: {}", headerlessRows); // should be 0
 
     if (headerlessRows) {
         sendLog("ERROR: unexpected param w/ headerless rows encountered", LogFormat::BoldRed);
@@ -158,16 +164,17 @@ bool GameParam::ReadGameParam(std::vector<char>& data) {
             GameParam::Row row;
             uint64_t nameOffset;
             if (flags1HasLongDataOffset) {
-                GetInt32(row.id);
-                debugLog("row.id: " + std::to_string(row.id));
+                RowHeader rowHeader;
+                ReadStruct(rowHeader);
+
+                row.id = rowHeader.id;
+                debugLog("row.id: {}", row.id);
 
-                istream->ignore(4); // or assert 0
-                GetInt64(row.dataOffset);
-                debugLog("row " + std::to_string(row.id) +
-                         " dataoffset: " + std::to_string(row.dataOffset));
+                row.dataOffset = rowHeader.dataOffset;
+                debugLog("row {} dataoffset: {}", row.id, row.dataOffset);
 
                 if (!unnamedRows) {
-                    GetInt64(nameOffset);
+                    nameOffset = rowHeader.nameOffset;
                 } else {
                     sendLog("ERROR: param w/ nameless rows encountered", LogFormat::BoldRed);
                     return false;
@@ -180,24 +187,24 @@ bool GameParam::ReadGameParam(std::vector<char>& data) {
             if (!unnamedRows && nameOffset != 0 && nameOffset != data.size()) {
                 if (actualStringsOffset == 0 || nameOffset < actualStringsOffset) {
                     actualStringsOffset = nameOffset;
-                    debugLog("actualStringsOffset: " + std::to_string(actualStringsOffset));
+                    debugLog("actualStringsOffset: {}", actualStringsOffset);
                 }
 
-                StepIn(nameOffset, *istream);
+                StepIn(nameOffset, reader);
                 if (paramUnicode) {
                     row.name = ReadUtf16String();
                 } else {
-                    std::getline(*istream, row.name, '\0');
+                    row.name = ReadCString();
                 }
-                StepOut(*istream);
+                StepOut(reader);
 
-                debugLog("row.name: " + row.name);
+                debugLog("row.name: {}", row.name);
             }
 
             rows.push_back(row);
         }
 
-        if (data.size() > 1) {
+        if (rows.size() > 1) {
             detectedSize = rows[1].dataOffset - rows[0].dataOffset;
         } else if (rows.size() == 1) {
             detectedSize = (actualStringsOffset == 0 ? stringsOffset : actualStringsOffset) -
@@ -206,23 +213,31 @@ bool GameParam::ReadGameParam(std::vector<char>& data) {
             detectedSize = -1;
         }
 
-        debugLog("detectedSize: " + std::to_string(detectedSize));
+        debugLog("detectedSize: {}", detectedSize);
     }
 
-    // for now process row data as a whole, so we don't need to read/write the individual cells lol
-    for (int i = 0; i < rowCount; i++) {
-        istream->seekg(rows[i].dataOffset);
-        GetBytes(rows[i].data, detectedSize);
+    // row data is kept whole, fields are only looked at when both mods change a row
+    const size_t cellSize = std::max(detectedSize, 0);
+    cells.resize(rows.size() * cellSize);
+    for (size_t i = 0; i < rows.size(); i++) {
+        rows[i].cell = i;
+        reader.Seek(rows[i].dataOffset);
+        reader.Read(cells.data() + i * cellSize, cellSize);
     }
 
     sendLog("Game Param loaded: " + fileName);
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
 bool GameParam::RepackGameParam(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
+    // layout pass: header, row table, fixed size row data and the name block
+    size_t rowSize = sizeof(RowHeader) + std::max(detectedSize, 0);
+    size_t layoutSize = sizeof(Header) + rows.size() * rowSize + 4;
+    for (const auto& row : rows) {
+        layoutSize += (row.name.size() + 1) * 2;
+    }
+    writer = SpanWriter(layoutSize);
 
     std::vector<GameParam::FormatFlags1> flags1 = GetFormatFlags1(format2D);
     auto has_flag = [flags1](FormatFlags1 flag) -> bool {
@@ -235,53 +250,48 @@ bool GameParam::RepackGameParam(std::vector<char>& outputData) {
     bool flags1HasLongDataOffset = has_flag(FormatFlags1::LongDataOffset);
     bool paramUnicode = IsUnicodeNames(format2E);
 
-    ReserveBytes("StringsOffset", 4);
-
-    if (flags1HasFlag01 && flags1HasIntDataOffset || flags1HasLongDataOffset) {
-        WriteInt16(0);
-    } else {
+    if (!(flags1HasFlag01 && flags1HasIntDataOffset || flags1HasLongDataOffset)) {
         sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
         return false;
     }
 
-    WriteInt16(unk06);
-    WriteInt16(paramDefDataVersion);
-    WriteInt16(rows.size());
-
     if (flags1HasOffsetParamType) {
         sendLog("ERROR: unexpected offset type param encountered", LogFormat::BoldRed);
         return false;
-    } else {
-        /*
-        if (HeaderlessRows) {
-            padding = 0x20;
-        } */
-        WriteStr(paramType, 0x20);
     }
 
-    WriteByte(0x00); // should be 0xFF if BigEndian, but that shouldn't be
-    WriteByte(format2D);
-    WriteByte(format2E);
-    WriteByte(paramDefFormatVersion);
-
     if (flags1HasFlag01 && flags1HasIntDataOffset) {
         sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
         return false;
-    } else if (flags1HasLongDataOffset) {
-        ReserveBytes("DataStart", 8);
-        WriteInt64(static_cast<uint64_t>(0));
     }
 
+    Header header{};
+    header.unk06 = unk06;
+    header.dataVersion = paramDefDataVersion;
+    header.rowCount = static_cast<uint16_t>(rows.size());
+    /*
+    if (HeaderlessRows) {
+        padding = 0x20;
+    } */
+    std::memcpy(header.paramType, paramType.data(),
+                std::min(paramType.size(), sizeof(header.paramType)));
+    header.bigEndian = 0x00; // should be 0xFF if BigEndian, but that shouldn't be
+    header.format2D = format2D;
+    header.format2E = format2E;
+    header.paramDefFormatVersion = paramDefFormatVersion;
+
+    // strings offset and data start are filled in once the rows are written
+    WriteStruct(header);
+
+    std::vector<Reserved<int64_t>> rowOffsets(rows.size());
+    std::vector<Reserved<int64_t>> nameOffsets(rows.size());
     for (int i = 0; i < rows.size(); i++) {
         if (flags1HasLongDataOffset) {
             WriteInt32(rows[i].id);
             WriteInt32(0);
 
-            strBuffer = "RowOffset" + std::to_string(i);
-            ReserveBytes(strBuffer, 8);
-
-            strBuffer = "NameOffset" + std::to_string(i);
-            ReserveBytes(strBuffer, 8);
+            rowOffsets[i] = ReserveInt64();
+            nameOffsets[i] = ReserveInt64();
         } else {
             sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
             return false;
@@ -293,55 +303,39 @@ bool GameParam::RepackGameParam(std::vector<char>& outputData) {
         return false;
     }
 
-    if (flags1HasFlag01 && flags1HasIntDataOffset) {
-        sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
-        return false;
-    } else if (flags1HasLongDataOffset) {
-        FillReservedInt64("DataStart", static_cast<uint64_t>(ostream->tellp()));
-    } else {
-        sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
-        return false;
-    }
+    header.dataStart = static_cast<int64_t>(writer.Tell());
 
     for (int i = 0; i < rows.size(); i++) {
         if (flags1HasLongDataOffset) {
-            strBuffer = "RowOffset" + std::to_string(i);
-            FillReservedInt64(strBuffer, static_cast<uint64_t>(ostream->tellp()));
-            ostream->write(rows[i].data.data(), detectedSize);
+            FillReservedInt64(rowOffsets[i], static_cast<int64_t>(writer.Tell()));
+            std::span<const char> data = RowData(rows[i]);
+            writer.Write(data.data(), data.size());
         } else {
             sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
             return false;
         }
     }
 
-    FillReservedInt32("StringsOffset", static_cast<uint>(ostream->tellp()));
-
-    if (flags1HasOffsetParamType) {
-        sendLog("ERROR: unexpected param format encountered", LogFormat::BoldRed);
-        return false;
-    }
+    header.stringsOffset = static_cast<uint32_t>(writer.Tell());
+    PatchStruct(0, header);
 
     WriteInt16(0);
 
     for (int i = 0; i < rows.size(); i++) {
-        strBuffer = "NameOffset" + std::to_string(i);
-        FillReservedInt64(strBuffer, static_cast<uint64_t>(ostream->tellp()));
+        FillReservedInt64(nameOffsets[i], static_cast<int64_t>(writer.Tell()));
 
         if (paramUnicode) {
             WriteUtf16String(rows[i].name);
         } else {
-            ostream->write(rows[i].name.data(), rows[i].name.size());
-            char null = '\0';
-            ostream->write(&null, 1);
+            writer.Write(rows[i].name.data(), rows[i].name.size());
+            writer.Fill('\0', 1);
         }
     }
 
     // BB sometimes (but not always) include some useless padding here
     WriteInt16(0);
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.param", std::ios::out | std::ios::binary);
@@ -351,106 +345,244 @@ bool GameParam::RepackGameParam(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("Param Repacking complete: " + fileName + "\n");
     return true;
 }
 
-bool GameParam::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    GameParam mod1Prm = GameParam(mod1Data, fileName, merger);
-    const std::vector<Row> mod1Rows = mod1Prm.rows;
-
-    GameParam mod2Prm = GameParam(mod2Data, fileName, merger);
-    const std::vector<Row> mod2Rows = mod2Prm.rows;
-
-    for (int i = 0; i < rows.size(); i++) {
-        bool mod1Modified = false;
-        bool mod2Modified = false;
-
-        std::optional<Row> mod1entry;
-        std::optional<Row> mod2entry;
+bool GameParam::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    const GameParam mod1Prm = GameParam(mod1Data, fileName, merger);
+    const GameParam mod2Prm = GameParam(mod2Data, fileName, merger);
 
-        mod1entry = GetSameRow(rows[i].id, mod1Rows);
-        mod2entry = GetSameRow(rows[i].id, mod2Rows);
+    if (mod1Prm.detectedSize != detectedSize || mod2Prm.detectedSize != detectedSize) {
+        sendLog("ERROR: row size of " + fileName + " differs between the mods and vanilla",
+                LogFormat::BoldRed);
+        return false;
+    }
 
-        mod1Modified = mod1entry && (mod1entry->data != rows[i].data);
-        mod2Modified = mod2entry && (mod2entry->data != rows[i].data);
+    const MergeJoinResult merge =
+        MergeJoin(RowViews(), mod1Prm.RowViews(), mod2Prm.RowViews(), &RowView::id,
+                  [](const RowView& a, const RowView& b) {
+                      return std::memcmp(a.data.data(), b.data.data(), a.data.size()) == 0;
+                  });
+
+    // field layout for rows both mods changed, by the param type in the header
+    const ParamDefs::Layout* layout = ParamDefs::Find(paramType);
+    if (layout && layout->rowSize != static_cast<uint32_t>(detectedSize)) {
+        debugLog("paramdef row size {} doesn't match {}", layout->rowSize, fileName);
+        layout = nullptr;
+    }
 
-        if (mod1Modified && mod2Modified) {
-            if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                          Qt::BlockingQueuedConnection);
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
+    const std::vector<uint8_t> unowned = layout ? UnownedBits(*layout) : std::vector<uint8_t>{};
+    auto changedOutsideLayout = [&](std::span<const char> vanilla, std::span<const char> mod) {
+        for (size_t i = 0; i < unowned.size(); i++) {
+            if (((vanilla[i] ^ mod[i]) & unowned[i]) != 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    bool reportedNoLayout = false;
+
+    // additions are appended to the cell table, sized once up front
+    const size_t baseCount = rows.size();
+    const size_t added =
+        std::count_if(merge.steps.begin(), merge.steps.end(),
+                      [](const MergeStep& step) { return step.base == MergeStep::none; });
+    rows.reserve(baseCount + added);
+    cells.reserve(cells.size() + added * std::max(detectedSize, 0));
+    for (const MergeStep& step : merge.steps) {
+        const Row* mod1entry = step.mod1 != MergeStep::none ? &mod1Prm.rows[step.mod1] : nullptr;
+        const Row* mod2entry = step.mod2 != MergeStep::none ? &mod2Prm.rows[step.mod2] : nullptr;
+
+        switch (step.action) {
+        case MergeAction::Conflict:
+            // a row with edits no column covers goes to the whole row priority instead
+            if (step.base != MergeStep::none && layout &&
+                !changedOutsideLayout(RowData(rows[step.base]), mod1Prm.RowData(*mod1entry)) &&
+                !changedOutsideLayout(RowData(rows[step.base]), mod2Prm.RowData(*mod2entry))) {
+                if (!MergeRowFields(rows[step.base], mod1Prm.RowData(*mod1entry),
+                                    mod2Prm.RowData(*mod2entry), *layout)) {
                     return false;
                 }
+                break;
+            }
+
+            if (!layout && !reportedNoLayout) {
+                reportedNoLayout = true;
+                sendLog("No paramdef for " + paramType + " in " + fileName +
+                            ", rows both mods changed are resolved by mod priority",
+                        LogFormat::Yellow);
+            }
+
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
             }
 
-            if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                rows[i].data = mod1entry->data;
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                SetRow(step.base, mod1Prm, *mod1entry);
                 sendLog("Unresolvable conflict in row: " + std::to_string(mod1entry->id) +
                             ", using row data from prioritized mod: " + merger->Mod1Name(),
                         LogFormat::Yellow);
-            } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                rows[i].data = mod2entry->data;
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                SetRow(step.base, mod2Prm, *mod2entry);
                 sendLog("Unresolvable conflict in row: " + std::to_string(mod2entry->id) +
                             ", using row data from prioritized mod: " + merger->Mod2Name(),
                         LogFormat::Yellow);
             }
-        }
-
-        if (mod1Modified && !mod2Modified) {
-            rows[i].data = mod1entry->data;
+            break;
+        case MergeAction::TakeMod1:
+            SetRow(step.base, mod1Prm, *mod1entry);
             sendLog("Merging row: " + std::to_string(mod1entry->id) +
                     " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            rows[i].data = mod2entry->data;
+            break;
+        case MergeAction::TakeMod2:
+            SetRow(step.base, mod2Prm, *mod2entry);
             sendLog("Merging row: " + std::to_string(mod2entry->id) +
                     " from mod: " + merger->Mod2Name());
+            break;
+        case MergeAction::AddMod1:
+            SetRow(step.base, mod1Prm, *mod1entry);
+            sendLog("New row added id: " + std::to_string(mod1entry->id) +
+                    " from mod: " + merger->Mod1Name());
+            break;
+        case MergeAction::AddMod2:
+            SetRow(step.base, mod2Prm, *mod2entry);
+            sendLog("New row added id: " + std::to_string(mod2entry->id) +
+                    " from mod: " + merger->Mod2Name());
+            break;
         }
     }
 
-    bool rowAdded = false;
-    std::unordered_set<int> existingIds;
-    for (const auto& row : rows) {
-        existingIds.insert(row.id);
+    // additions went to the end, rows are stored by id
+    if (rows.size() > baseCount) {
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.id < b.id; });
     }
 
-    for (const auto& row : mod1Rows) {
-        if (existingIds.find(row.id) == existingIds.end()) {
-            rowAdded = true;
-            rows.push_back(row);
-            existingIds.insert(row.id);
-            sendLog("New row added id: " + std::to_string(row.id) +
-                    " from mod: " + merger->Mod1Name());
+    return true;
+}
+
+void GameParam::SetRow(size_t base, const GameParam& source, const Row& row) {
+    std::span<const char> data = source.RowData(row);
+    if (base != MergeStep::none) {
+        std::memcpy(RowData(rows[base]).data(), data.data(), data.size());
+        return;
+    }
+
+    Row& added = rows.emplace_back(row);
+    added.cell = cells.size() / std::max<size_t>(data.size(), 1);
+    cells.insert(cells.end(), data.begin(), data.end());
+}
+
+bool GameParam::MergeRowFields(Row& row, std::span<const char> mod1Data,
+                               std::span<const char> mod2Data,
+                               const ParamDefs::Layout& layout) {
+    std::span<char> data = RowData(row);
+
+    auto unit = [](const char* bytes, uint32_t size) {
+        uint32_t value = 0;
+        std::memcpy(&value, bytes, size);
+        return value;
+    };
+    // bits of the column that differ between a and b
+    auto changed = [&](const Column& column, const char* a, const char* b) -> bool {
+        if (column.mask == 0) {
+            return std::memcmp(a + column.offset, b + column.offset, column.size) != 0;
+        }
+        return ((unit(a + column.offset, column.size) ^ unit(b + column.offset, column.size)) &
+                column.mask) != 0;
+    };
+    auto take = [&](const Column& column, const char* from) {
+        if (column.mask == 0) {
+            std::memcpy(data.data() + column.offset, from + column.offset, column.size);
+            return;
+        }
+        uint32_t value = (unit(data.data() + column.offset, column.size) & ~column.mask) |
+                         (unit(from + column.offset, column.size) & column.mask);
+        std::memcpy(data.data() + column.offset, &value, column.size);
+    };
+
+    // decided before anything is written, so every comparison is against the vanilla row
+    std::vector<const Column*> mod1Fields;
+    std::vector<const Column*> mod2Fields;
+    std::vector<const Column*> conflictFields;
+    for (const Column& column : layout.columns) {
+        bool mod1Changed = changed(column, mod1Data.data(), data.data());
+        bool mod2Changed = changed(column, mod2Data.data(), data.data());
+        if (mod1Changed && mod2Changed && changed(column, mod1Data.data(), mod2Data.data())) {
+            conflictFields.push_back(&column);
+        } else if (mod1Changed) {
+            mod1Fields.push_back(&column);
+        } else if (mod2Changed) {
+            mod2Fields.push_back(&column);
         }
     }
 
-    for (const auto& row : mod2Rows) {
-        if (existingIds.find(row.id) == existingIds.end()) {
-            rowAdded = true;
-            rows.push_back(row);
-            sendLog("New row added id: " + std::to_string(row.id) +
-                    " from mod: " + merger->Mod2Name());
+    bool useMod1 = true;
+    if (!conflictFields.empty()) {
+        std::vector<std::string> names;
+        for (const Column* column : conflictFields) {
+            names.push_back(fileName + " row " + std::to_string(row.id) + ": " +
+                            std::string(column->name));
+        }
+        if (merger->RequestPriority(names) == MergeEngine::ModPriority::NotSet) {
+            return false;
         }
+        useMod1 = merger->GetModPriority() == MergeEngine::ModPriority::Mod1;
     }
 
-    if (rowAdded) {
-        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.id < b.id; });
+    auto fieldList = [](const std::vector<const Column*>& columns) {
+        std::string list;
+        for (const Column* column : columns) {
+            list += (list.empty() ? "" : ", ") + std::string(column->name);
+        }
+        return list;
+    };
+
+    for (const Column* column : mod1Fields) {
+        take(*column, mod1Data.data());
+    }
+    for (const Column* column : mod2Fields) {
+        take(*column, mod2Data.data());
+    }
+    for (const Column* column : conflictFields) {
+        take(*column, useMod1 ? mod1Data.data() : mod2Data.data());
     }
 
+    if (!mod1Fields.empty()) {
+        sendLog("Merging row: " + std::to_string(row.id) + " fields: " + fieldList(mod1Fields) +
+                " from mod: " + merger->Mod1Name());
+    }
+    if (!mod2Fields.empty()) {
+        sendLog("Merging row: " + std::to_string(row.id) + " fields: " + fieldList(mod2Fields) +
+                " from mod: " + merger->Mod2Name());
+    }
+    if (!conflictFields.empty()) {
+        sendLog("Unresolvable conflict in row: " + std::to_string(row.id) +
+                    " fields: " + fieldList(conflictFields) +
+                    ", using data from prioritized mod: " +
+                    (useMod1 ? merger->Mod1Name() : merger->Mod2Name()),
+                LogFormat::Yellow);
+    }
     return true;
 }
 
-std::optional<GameParam::Row> GameParam::GetSameRow(const int& id,
-                                                    const std::vector<GameParam::Row>& otherRows) {
-    std::optional<Row> result = std::nullopt;
-    for (const auto& otherRow : otherRows) {
-        if (otherRow.id == id) {
-            return result.emplace(otherRow);
-        }
-    }
+std::span<char> GameParam::RowData(const Row& row) {
+    const size_t size = std::max(detectedSize, 0);
+    return {cells.data() + row.cell * size, size};
+}
 
-    return result;
+std::span<const char> GameParam::RowData(const Row& row) const {
+    const size_t size = std::max(detectedSize, 0);
+    return {cells.data() + row.cell * size, size};
+}
+
+std::vector<GameParam::RowView> GameParam::RowViews() const {
+    std::vector<RowView> views;
+    views.reserve(rows.size());
+    for (const Row& row : rows) {
+        views.push_back({row.id, RowData(row)});
+    }
+    return views;
 }
 
 std::vector<GameParam::FormatFlags1> GameParam::GetFormatFlags1(int flags1Value) {
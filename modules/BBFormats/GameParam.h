@@ -4,55 +4,13 @@
 #pragma once
 
 #include "BBFormats.h"
-
-#include "BBFormats.h"
+#include "ParamDefs.h"
 
 namespace FileHelper {
 
 class GameParam : public BBFormat {
     Q_OBJECT
 
-    /*
-    using cellValue =
-        std::variant<int, float, double, std::string, std::vector<std::string>, std::vector<int>>;
-
-    enum class DefType : int {
-        s8,      // Signed 1-byte integer.
-        u8,      // Unsigned 1-byte integer.
-        s16,     // Signed 2-byte integer.
-        u16,     // Unsigned 2-byte integer.
-        s32,     // Signed 4-byte integer.
-        u32,     // Unsigned 4-byte integer
-        b32,     //  4-byte integer representing a boolean (why? lol)
-        f32,     // Single-precision floating point value
-        angle32, // Single-precision floating point value representing an angle
-        f64,     // Double-precision floating point value
-        dummy8,  // Byte or array of bytes used for padding or placeholding
-        fixstr,  // Fixed-width Shift-JIS string.
-        fixstrW, // Fixed-width UTF-16 string.
-    };
-
-
-     struct Field {
-         // DefType defType;
-         std::string fieldName;
-         int arrayLength = 1;
-         int bitSize = -1;
-         int sortId;
-         // std::vector<cellValue> defaultValue;
-         // defaultThreshold?
-     };
-
-      struct ParamDef {
-          bool bigEndian = false;
-          bool uniCode = 1;
-          int formatVersion = 201;
-          bool loaded = true;
-          std::vector<Field> paramFields;
-      };
-
-       */
-
     enum class FormatFlags1 : int {
         None = 0,                     // No flags set.
         Flag01 = 0b00000001,          // Unknown.
@@ -77,29 +35,76 @@ class GameParam : public BBFormat {
         Flag80 = 0b10000000,          // Unused?
     };
 
+    struct Header {
+        uint32_t stringsOffset; // unreliable, only used as a last resort
+        uint16_t unk04;         // 0
+        uint16_t unk06;
+        uint16_t dataVersion;
+        uint16_t rowCount;
+        char paramType[0x20];
+        uint8_t bigEndian;
+        uint8_t format2D;
+        uint8_t format2E;
+        uint8_t paramDefFormatVersion;
+        int64_t dataStart; // LongDataOffset only
+        int64_t unk38;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.stringsOffset, h.unk04, h.unk06, h.dataVersion, h.rowCount,
+                            h.dataStart, h.unk38);
+        }
+    };
+    static_assert(sizeof(Header) == 0x40);
+
+    struct RowHeader {
+        int32_t id;
+        int32_t pad04;
+        int64_t dataOffset;
+        int64_t nameOffset;
+
+        static constexpr auto Fields(auto& r) {
+            return std::tie(r.id, r.pad04, r.dataOffset, r.nameOffset);
+        }
+    };
+
+    // row data lives in one table of detectedSize-byte cells, not in a buffer per row
     struct Row {
         int id;
         std::string name;
         uint64_t dataOffset;
-        std::vector<char> data;
-        // std::vector<cellValue> values;
+        size_t cell;
+    };
+
+    using Column = ParamDefs::Column;
+
+    // what the three-way join compares, a row id and its cell
+    struct RowView {
+        int id;
+        std::span<const char> data;
     };
 
 public:
-    explicit GameParam(std::vector<char>& data, const std::string& fileName, ModMerger* parent);
+    explicit GameParam(std::span<const char> data, const std::string& fileName,
+                       MergeEngine* parent);
     ~GameParam() override;
 
-    // ParamDef GetParamDef(const std::string& filename); // GameParamDef.cpp, big hardcodes
-    bool ReadGameParam(std::vector<char>& data);
+    bool ReadGameParam(std::span<const char> data);
     bool RepackGameParam(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
 private:
     std::vector<GameParam::FormatFlags1> GetFormatFlags1(int flagsValue);
     bool IsUnicodeNames(int flags2Value);
-    std::optional<Row> GetSameRow(const int& id, const std::vector<Row>& otherRows);
 
-    // ParamDef def;
+    std::span<char> RowData(const Row& row);
+    std::span<const char> RowData(const Row& row) const;
+    std::vector<RowView> RowViews() const;
+    // copies row from source over the vanilla row at base, or appends it when base is none
+    void SetRow(size_t base, const GameParam& source, const Row& row);
+    // merges the fields only one mod changed into row, fields both changed go to the mod priority
+    bool MergeRowFields(Row& row, std::span<const char> mod1Data, std::span<const char> mod2Data,
+                        const ParamDefs::Layout& layout);
+
     int format2D = 4; // hardcode?
     int format2E;
     int paramDefFormatVersion = 0;
@@ -109,6 +114,7 @@ private:
     std::string fileName;
     std::string paramType;
     std::vector<Row> rows;
+    std::vector<char> cells;
 };
 
 } // namespace FileHelper
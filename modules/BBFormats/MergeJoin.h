@@ -0,0 +1,200 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace FileHelper {
+
+// what a three-way merge does with one key
+enum class MergeAction : uint8_t {
+    TakeMod1, // only mod1 changed the vanilla entry
+    TakeMod2,
+    Conflict, // both mods changed the entry, or added it with different data
+    AddMod1,  // new in mod1, or added by both mods with the same data
+    AddMod2,
+};
+
+struct MergeStep {
+    static constexpr size_t none = static_cast<size_t>(-1);
+
+    MergeAction action;
+    size_t base = none; // none for additions
+    size_t mod1 = none;
+    size_t mod2 = none;
+};
+
+// steps come in vanilla order, then the additions in mod1 order and those only in mod2 in mod2
+// order, the order the formats log and append them in. entries a mod dropped stay in the merge
+// and are only counted
+struct MergeJoinResult {
+    std::vector<MergeStep> steps;
+    size_t modified = 0;
+    size_t added = 0;
+    size_t conflicts = 0;
+    size_t deleted = 0;
+};
+
+namespace MergeJoinDetail {
+
+// positions of entries in key order, the identity when the file is already sorted so the usual
+// id-ordered param or fmg costs one pass. equal keys keep their file order
+template <typename Entry, typename KeyFn>
+std::vector<size_t> KeyOrder(const std::vector<Entry>& entries, KeyFn& key) {
+    std::vector<size_t> order(entries.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+
+    auto less = [&](size_t a, size_t b) {
+        return std::invoke(key, entries[a]) < std::invoke(key, entries[b]);
+    };
+    if (!std::is_sorted(order.begin(), order.end(), less)) {
+        std::stable_sort(order.begin(), order.end(), less);
+    }
+    return order;
+}
+
+} // namespace MergeJoinDetail
+
+// single merge-join over vanilla and both mods sorted by key. key projects an entry to something
+// ordered by <, equal decides whether a mod changed an entry. on duplicate keys the first entry
+// of a file is the one matched and added, like an EntryIndex lookup
+template <typename Entry, typename KeyFn, typename EqualFn = std::equal_to<>>
+MergeJoinResult MergeJoin(const std::vector<Entry>& base, const std::vector<Entry>& mod1,
+                          const std::vector<Entry>& mod2, KeyFn key, EqualFn equal = {}) {
+    using MergeJoinDetail::KeyOrder;
+    const std::vector<size_t> baseOrder = KeyOrder(base, key);
+    const std::vector<size_t> mod1Order = KeyOrder(mod1, key);
+    const std::vector<size_t> mod2Order = KeyOrder(mod2, key);
+
+    auto keyOf = [&](const std::vector<Entry>& entries, size_t index) -> decltype(auto) {
+        return std::invoke(key, entries[index]);
+    };
+    // first entry of a run of equal keys in a sorted order
+    auto runStart = [&](const std::vector<Entry>& entries, const std::vector<size_t>& order,
+                        size_t pos) {
+        return pos == 0 || keyOf(entries, order[pos - 1]) < keyOf(entries, order[pos]);
+    };
+
+    MergeJoinResult result;
+    std::vector<MergeStep> baseSteps;
+    std::vector<size_t> mod1Only;
+    std::vector<size_t> mod2Only;
+
+    size_t pos1 = 0;
+    size_t pos2 = 0;
+    size_t match1 = MergeStep::none;
+    size_t match2 = MergeStep::none;
+    for (size_t pos = 0; pos < baseOrder.size(); pos++) {
+        const size_t b = baseOrder[pos];
+        const auto& baseKey = keyOf(base, b);
+
+        // a repeated vanilla key reuses the matches of the first one
+        if (runStart(base, baseOrder, pos)) {
+            while (pos1 < mod1Order.size() && keyOf(mod1, mod1Order[pos1]) < baseKey) {
+                if (runStart(mod1, mod1Order, pos1)) {
+                    mod1Only.push_back(mod1Order[pos1]);
+                }
+                pos1++;
+            }
+            while (pos2 < mod2Order.size() && keyOf(mod2, mod2Order[pos2]) < baseKey) {
+                if (runStart(mod2, mod2Order, pos2)) {
+                    mod2Only.push_back(mod2Order[pos2]);
+                }
+                pos2++;
+            }
+
+            match1 = MergeStep::none;
+            if (pos1 < mod1Order.size() && !(baseKey < keyOf(mod1, mod1Order[pos1]))) {
+                match1 = mod1Order[pos1];
+                while (pos1 < mod1Order.size() && !(baseKey < keyOf(mod1, mod1Order[pos1]))) {
+                    pos1++;
+                }
+            }
+            match2 = MergeStep::none;
+            if (pos2 < mod2Order.size() && !(baseKey < keyOf(mod2, mod2Order[pos2]))) {
+                match2 = mod2Order[pos2];
+                while (pos2 < mod2Order.size() && !(baseKey < keyOf(mod2, mod2Order[pos2]))) {
+                    pos2++;
+                }
+            }
+        }
+
+        result.deleted += (match1 == MergeStep::none) + (match2 == MergeStep::none);
+        const bool mod1Modified = match1 != MergeStep::none && !equal(mod1[match1], base[b]);
+        const bool mod2Modified = match2 != MergeStep::none && !equal(mod2[match2], base[b]);
+        if (mod1Modified && mod2Modified) {
+            baseSteps.push_back({MergeAction::Conflict, b, match1, match2});
+        } else if (mod1Modified) {
+            baseSteps.push_back({MergeAction::TakeMod1, b, match1, match2});
+        } else if (mod2Modified) {
+            baseSteps.push_back({MergeAction::TakeMod2, b, match1, match2});
+        }
+    }
+
+    for (; pos1 < mod1Order.size(); pos1++) {
+        if (runStart(mod1, mod1Order, pos1)) {
+            mod1Only.push_back(mod1Order[pos1]);
+        }
+    }
+    for (; pos2 < mod2Order.size(); pos2++) {
+        if (runStart(mod2, mod2Order, pos2)) {
+            mod2Only.push_back(mod2Order[pos2]);
+        }
+    }
+
+    // both lists are in key order, a key in both is an addition of both mods
+    std::vector<MergeStep> mod1Steps;
+    std::vector<MergeStep> mod2Steps;
+    size_t i2 = 0;
+    for (size_t m1 : mod1Only) {
+        const auto& addedKey = keyOf(mod1, m1);
+        while (i2 < mod2Only.size() && keyOf(mod2, mod2Only[i2]) < addedKey) {
+            mod2Steps.push_back({MergeAction::AddMod2, MergeStep::none, MergeStep::none,
+                                 mod2Only[i2++]});
+        }
+
+        if (i2 < mod2Only.size() && !(addedKey < keyOf(mod2, mod2Only[i2]))) {
+            const size_t m2 = mod2Only[i2++];
+            MergeAction action = equal(mod1[m1], mod2[m2]) ? MergeAction::AddMod1
+                                                           : MergeAction::Conflict;
+            mod1Steps.push_back({action, MergeStep::none, m1, m2});
+        } else {
+            mod1Steps.push_back({MergeAction::AddMod1, MergeStep::none, m1, MergeStep::none});
+        }
+    }
+    for (; i2 < mod2Only.size(); i2++) {
+        mod2Steps.push_back({MergeAction::AddMod2, MergeStep::none, MergeStep::none,
+                             mod2Only[i2]});
+    }
+
+    // back to file order, only the changed entries are sorted
+    std::sort(baseSteps.begin(), baseSteps.end(),
+              [](const MergeStep& a, const MergeStep& b) { return a.base < b.base; });
+    std::sort(mod1Steps.begin(), mod1Steps.end(),
+              [](const MergeStep& a, const MergeStep& b) { return a.mod1 < b.mod1; });
+    std::sort(mod2Steps.begin(), mod2Steps.end(),
+              [](const MergeStep& a, const MergeStep& b) { return a.mod2 < b.mod2; });
+
+    result.steps.reserve(baseSteps.size() + mod1Steps.size() + mod2Steps.size());
+    for (const auto* steps : {&baseSteps, &mod1Steps, &mod2Steps}) {
+        for (const MergeStep& step : *steps) {
+            result.steps.push_back(step);
+            if (step.action == MergeAction::Conflict) {
+                result.conflicts++;
+            } else if (step.base == MergeStep::none) {
+                result.added++;
+            } else {
+                result.modified++;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace FileHelper
@@ -1,182 +1,197 @@
 // SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include <regex>
+#include <unordered_set>
 #include <vector>
 
 #include "Msb.h"
-#include "modules/ModMerger.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Msb::Msb(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+Msb::Msb(std::span<const char> data, MergeEngine* parent)
+    : Msb(data, parent, std::make_shared<Store>(data.size())) {}
+
+Msb::Msb(std::span<const char> data, MergeEngine* parent, std::shared_ptr<Store> sharedStore)
+    : BBFormat(parent), store(std::move(sharedStore)) {
     bigEndian = false;
     ReadMsb(data);
 }
 
-bool Msb::ReadMsb(std::vector<char>& data) {
+// names and blobs take about as much room as the file they come from
+Msb::Store::Store(size_t sizeHint) : arena(std::max<size_t>(sizeHint, 4096)) {
+    Intern("");
+}
+
+Msb::Name Msb::Store::Intern(std::string_view text) {
+    auto it = handles.find(text);
+    if (it != handles.end()) {
+        return it->second;
+    }
+
+    char* copy = static_cast<char*>(arena.allocate(std::max<size_t>(text.size(), 1), 1));
+    std::memcpy(copy, text.data(), text.size());
+    std::string_view stored(copy, text.size());
+
+    Name name = static_cast<Name>(names.size());
+    names.push_back(stored);
+    handles.emplace(stored, name);
+    return name;
+}
+
+Msb::Blob Msb::Store::Copy(std::span<const char> bytes, size_t size) {
+    if (size == 0) {
+        return {};
+    }
+
+    char* copy = static_cast<char*>(arena.allocate(size, 1));
+    size_t copied = std::min(bytes.size(), size);
+    std::memcpy(copy, bytes.data(), copied);
+    std::memset(copy + copied, 0, size - copied);
+    return {copy, static_cast<uint32_t>(size)};
+}
+
+Msb::Name Msb::ReadName() {
+    return store->Intern(ReadUtf16String());
+}
+
+Msb::Blob Msb::ReadBlob(int length) {
+    Blob blob = store->Copy(reader.View(length), length);
+    reader.Skip(length);
+    return blob;
+}
+
+bool Msb::ReadMsb(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty fmg input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
     std::string strBuffer = "";
     int intBuffer = 0;
 
-    GetStr(strBuffer, 4);
-    // debugLog("MAGIC: " + strBuffer);
+    Header header{};
+    ReadStruct(header);
+    strBuffer = std::string(header.magic, 4);
+    // debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("MSB")) {
         sendLog("ERROR invalid param header: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    GetInt32(intBuffer);
-    // debugLog("1 check : " + std::to_string(intBuffer));
-
-    GetInt32(intBuffer);
-    // debugLog("16 check : " + std::to_string(intBuffer));
-
-    GetByte(intBuffer); // bigendian, should be false
-    // debugLog("zero check : " + std::to_string(intBuffer));
-
-    GetByte(intBuffer); // bigbigendian, should be false
-    // debugLog("zero check : " + std::to_string(intBuffer));
-
-    GetByte(intBuffer); // encoding, should be true
-    // debugLog("1 check : " + std::to_string(intBuffer));
-
-    GetByte(intBuffer); // 64 bit should be 255
-    // debugLog("255 check : " + std::to_string(intBuffer));
-
     std::vector<int64_t> modelOffsets;
     int64_t eventsOffset;
     GetSectionOffsets(modelOffsets, eventsOffset);
 
-    istream->seekg(eventsOffset);
+    reader.Seek(eventsOffset);
     std::vector<int64_t> eventOffsets;
     int64_t regionsOffset;
     GetSectionOffsets(eventOffsets, regionsOffset);
 
-    istream->seekg(regionsOffset);
+    reader.Seek(regionsOffset);
     std::vector<int64_t> regionOffsets;
     int64_t partsOffset;
     GetSectionOffsets(regionOffsets, partsOffset);
 
-    istream->seekg(partsOffset);
+    reader.Seek(partsOffset);
     std::vector<int64_t> partOffsets;
     int64_t int64Buffer;
     GetSectionOffsets(partOffsets, int64Buffer);
-    // debugLog("zeroCheck: " + std::to_string(int64Buffer));
+    // debugLog("zeroCheck: {}", int64Buffer);
+
+    models.reserve(modelOffsets.size());
+    events.reserve(eventOffsets.size());
+    regions.reserve(regionOffsets.size());
+    parts.reserve(partOffsets.size());
 
     for (const auto& off : modelOffsets) {
         Model model;
-        istream->seekg(off);
-        int64_t start = static_cast<int64_t>(istream->tellg());
-
-        int64_t nameOffset;
-        GetInt64(nameOffset);
-        // debugLog("nameOffset: " + std::to_string(nameOffset));
+        reader.Seek(off);
+        int64_t start = static_cast<int64_t>(reader.Tell());
 
-        GetInt32(model.type);
-        // debugLog("type: " + std::to_string(type));
-
-        GetInt32(intBuffer); // type id
-        // debugLog("typeid: " + std::to_string(intBuffer));
-
-        int64_t sibOffset;
-        GetInt64(sibOffset);
-        // debugLog("sibOffset: " + std::to_string(sibOffset));
-
-        GetInt32(model.instanceCount);
-        // debugLog("model.instanceCount: " + std::to_string(model.instanceCount));
-
-        GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
-
-        GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
-
-        GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        ModelHeader modelHeader;
+        ReadStruct(modelHeader);
+        model.type = modelHeader.type;
+        model.instanceCount = modelHeader.instanceCount;
+        int64_t nameOffset = modelHeader.nameOffset;
 
         // assert name/sib offsets are not 0?
 
-        istream->seekg(start + nameOffset);
-        model.name = ReadUtf16String();
-        // debugLog("model.name: " + model.name);
+        reader.Seek(start + nameOffset);
+        model.name = ReadName();
+        // debugLog("model.name: {}", model.name);
 
-        model.sibPath = ReadUtf16String();
-        // debugLog("model.sibPath: " + model.sibPath);
+        model.sibPath = ReadName();
+        // debugLog("model.sibPath: {}", model.sibPath);
 
         models.push_back(model);
     }
 
     for (const auto& off : eventOffsets) {
         Event event;
-        istream->seekg(off);
-        int64_t start = static_cast<int64_t>(istream->tellg());
+        reader.Seek(off);
+        int64_t start = static_cast<int64_t>(reader.Tell());
 
         int64_t nameOffset;
         GetInt64(nameOffset);
-        // debugLog("nameOffset: " + std::to_string(nameOffset));
+        // debugLog("nameOffset: {}", nameOffset);
 
         GetInt32(event.id);
-        // debugLog("event.id: " + std::to_string(event.id));
+        // debugLog("event.id: {}", event.id);
 
         GetInt32(event.type);
-        // debugLog("event.type: " + std::to_string(event.type));
+        // debugLog("event.type: {}", event.type);
 
         GetInt32(intBuffer); // type id
-        // debugLog("typeid: " + std::to_string(intBuffer));
+        // debugLog("typeid: {}", intBuffer);
 
         GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         int64_t entityDataOffset;
         GetInt64(entityDataOffset);
-        // debugLog("entityDataOffset: " + std::to_string(entityDataOffset));
+        // debugLog("entityDataOffset: {}", entityDataOffset);
 
         int64_t typeDataOffset;
         GetInt64(typeDataOffset);
-        // debugLog("typeDataOffset: " + std::to_string(typeDataOffset));
+        // debugLog("typeDataOffset: {}", typeDataOffset);
 
         // original asserts name/entity offsets can't be zero and xor assrts typedata offset is not
         // 0 when type is 0xFFFFFF
 
-        istream->seekg(start + nameOffset);
-        event.name = ReadUtf16String();
+        reader.Seek(start + nameOffset);
+        event.name = ReadName();
 
-        istream->seekg(start + entityDataOffset);
+        reader.Seek(start + entityDataOffset);
         GetInt32(event.partIndex);
-        // debugLog("event.partIndex: " + std::to_string(event.partIndex));
+        // debugLog("event.partIndex: {}", event.partIndex);
 
         GetInt32(event.regionIndex);
-        // debugLog("event.regionIndex: " + std::to_string(event.regionIndex));
+        // debugLog("event.regionIndex: {}", event.regionIndex);
 
         GetInt32(event.entityId);
-        // debugLog("event.entityId: " + std::to_string(event.entityId));
+        // debugLog("event.entityId: {}", event.entityId);
 
         GetByte(event.unkE0C);
-        // debugLog("event.unkE0C: " + std::to_string(event.unkE0C));
+        // debugLog("event.unkE0C: {}", event.unkE0C);
 
         GetByte(event.unkE0D);
-        // debugLog("event.unkE0D: " + std::to_string(event.unkE0D));
+        // debugLog("event.unkE0D: {}", event.unkE0D);
 
         GetByte(event.unkE0E);
-        // debugLog("event.unkE0E: " + std::to_string(event.unkE0E));
+        // debugLog("event.unkE0E: {}", event.unkE0E);
 
         GetByte(event.unkE0F);
-        // debugLog("event.unkE0F: " + std::to_string(event.unkE0F));
+        // debugLog("event.unkE0F: {}", event.unkE0F);
 
         if (event.type < 18) {
-            istream->seekg(start + typeDataOffset);
-            GetBytes(event.typeData, GetEventTypeDataLength(event.type));
+            reader.Seek(start + typeDataOffset);
+            event.typeData = ReadBlob(GetEventTypeDataLength(event.type));
         }
 
         events.push_back(event);
@@ -193,193 +208,193 @@ bool Msb::ReadMsb(std::vector<char>& data) {
 
     for (const auto& off : regionOffsets) {
         Region region;
-        istream->seekg(off);
-        int64_t start = static_cast<int64_t>(istream->tellg());
-        debugLog("regionstartoffset: " + std::to_string(start));
+        reader.Seek(off);
+        int64_t start = static_cast<int64_t>(reader.Tell());
+        debugLog("regionstartoffset: {}", start);
 
         int64_t nameOffset;
         GetInt64(nameOffset);
-        // debugLog("nameOffset: " + std::to_string(nameOffset));
+        // debugLog("nameOffset: {}", nameOffset);
 
         GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         GetInt32(intBuffer); // type id
-        // debugLog("id2: " + std::to_string(intBuffer));
+        // debugLog("id2: {}", intBuffer);
 
         GetInt32(region.shapeType);
-        // debugLog("type: " + std::to_string(shapeType));
+        // debugLog("type: {}", shapeType);
 
         GetVector3(region.position);
-        // debugLog("region.position.x: " + std::to_string(region.position.x));
-        //  debugLog("region.position.y: " + std::to_string(region.position.y));
-        //  debugLog("region.position.z: " + std::to_string(region.position.z));
+        // debugLog("region.position.x: {}", region.position.x);
+        //  debugLog("region.position.y: {}", region.position.y);
+        //  debugLog("region.position.z: {}", region.position.z);
 
         GetVector3(region.rotation);
-        // debugLog("region.rotation.x: " + std::to_string(region.rotation.x));
-        // debugLog("region.rotation.y: " + std::to_string(region.rotation.y));
-        // debugLog("region.rotation.z: " + std::to_string(region.rotation.z));
+        // debugLog("region.rotation.x: {}", region.rotation.x);
+        // debugLog("region.rotation.y: {}", region.rotation.y);
+        // debugLog("region.rotation.z: {}", region.rotation.z);
 
         GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         int64_t unkOffsetA;
         GetInt64(unkOffsetA);
-        // debugLog("unkOffsetA: " + std::to_string(unkOffsetA));
+        // debugLog("unkOffsetA: {}", unkOffsetA);
 
         int64_t unkOffsetB;
         GetInt64(unkOffsetB);
-        // debugLog("unkOffsetB: " + std::to_string(unkOffsetB));
+        // debugLog("unkOffsetB: {}", unkOffsetB);
 
         int64_t shapeDataOffset;
         GetInt64(shapeDataOffset);
-        // debugLog("shapeDataOffset: " + std::to_string(shapeDataOffset));
+        // debugLog("shapeDataOffset: {}", shapeDataOffset);
 
         int64_t entityDataOffset;
         GetInt64(entityDataOffset);
-        // debugLog("entityDataOffset: " + std::to_string(entityDataOffset));
+        // debugLog("entityDataOffset: {}", entityDataOffset);
 
         // original asserts nameoffset, unkoffsets can't be 0, and also xor asserts shapedata is not
         // 0 when shapetype is 0 or FFFFFF
 
-        istream->seekg(start + nameOffset);
-        region.name = ReadUtf16String();
-        // debugLog("region.name: " + region.name);
+        reader.Seek(start + nameOffset);
+        region.name = ReadName();
+        // debugLog("region.name: {}", region.name);
 
-        istream->seekg(start + unkOffsetA);
+        reader.Seek(start + unkOffsetA);
         GetInt16(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
-        istream->seekg(start + unkOffsetB);
+        reader.Seek(start + unkOffsetB);
         GetInt16(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         if (region.shapeType < 7 && region.shapeType != 0) {
-            istream->seekg(start + shapeDataOffset);
-            GetBytes(region.shapeData, GetShapeDataLength(region.shapeType));
+            reader.Seek(start + shapeDataOffset);
+            region.shapeData = ReadBlob(GetShapeDataLength(region.shapeType));
         }
 
-        istream->seekg(start + entityDataOffset);
+        reader.Seek(start + entityDataOffset);
         GetInt32(region.entityId);
-        // debugLog("region.entityId: " + std::to_string(region.entityId));
+        // debugLog("region.entityId: {}", region.entityId);
 
         regions.push_back(region);
     }
 
     for (const auto& off : partOffsets) {
         Part part;
-        istream->seekg(off);
-        int64_t start = static_cast<int64_t>(istream->tellg());
-        // debugLog("partOffsetstart: " + std::to_string(start), LogFormat::BoldGreen);
+        reader.Seek(off);
+        int64_t start = static_cast<int64_t>(reader.Tell());
+        // debugLog(LogFormat::BoldGreen, "partOffsetstart: {}", start);
 
         int64_t descOffset;
         GetInt64(descOffset);
-        // debugLog("descOffset: " + std::to_string(descOffset));
+        // debugLog("descOffset: {}", descOffset);
 
         int64_t nameOffset;
         GetInt64(nameOffset);
-        // debugLog("nameOffset: " + std::to_string(nameOffset));
+        // debugLog("nameOffset: {}", nameOffset);
 
         GetInt32(part.instanceId);
-        // debugLog("part.instanceId: " + std::to_string(part.instanceId));
+        // debugLog("part.instanceId: {}", part.instanceId);
 
         GetInt32(part.type);
-        // debugLog("type: " + std::to_string(part.type));
+        // debugLog("type: {}", part.type);
 
         GetInt32(intBuffer); // type id
-        // debugLog("typeid: " + std::to_string(intBuffer));
+        // debugLog("typeid: {}", intBuffer);
 
         GetInt32(part.modelIndex);
-        // debugLog("part.modelIndex: " + std::to_string(part.modelIndex));
+        // debugLog("part.modelIndex: {}", part.modelIndex);
 
         int64_t sibOffset;
         GetInt64(sibOffset);
-        // debugLog("sibOffset: " + std::to_string(sibOffset));
+        // debugLog("sibOffset: {}", sibOffset);
 
         GetVector3(part.position);
-        // debugLog("part.position.x: " + std::to_string(part.position.x));
-        // debugLog("part.position.y: " + std::to_string(part.position.y));
-        // debugLog("part.position.z: " + std::to_string(part.position.z));
+        // debugLog("part.position.x: {}", part.position.x);
+        // debugLog("part.position.y: {}", part.position.y);
+        // debugLog("part.position.z: {}", part.position.z);
 
         GetVector3(part.rotation);
-        // debugLog("part.rotation.x: " + std::to_string(part.rotation.x));
-        debugLog("part.rotation.y: " + std::to_string(part.rotation.y));
-        debugLog("part.rotation.z: " + std::to_string(part.rotation.z));
+        // debugLog("part.rotation.x: {}", part.rotation.x);
+        debugLog("part.rotation.y: {}", part.rotation.y);
+        debugLog("part.rotation.z: {}", part.rotation.z);
 
         GetVector3(part.scale);
-        // debugLog("part.scale.x: " + std::to_string(part.scale.x));
-        // debugLog("part.scale.y: " + std::to_string(part.scale.y));
-        // debugLog("part.scale.z: " + std::to_string(part.scale.z));
+        // debugLog("part.scale.x: {}", part.scale.x);
+        // debugLog("part.scale.y: {}", part.scale.y);
+        // debugLog("part.scale.z: {}", part.scale.z);
 
-        GetBytes(part.groupData, 96);
+        part.groupData = ReadBlob(96);
 
         GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         int64_t entityDataOffset;
         GetInt64(entityDataOffset);
-        // debugLog("entityDataOffset: " + std::to_string(entityDataOffset));
+        // debugLog("entityDataOffset: {}", entityDataOffset);
 
         int64_t typeDataOffset;
         GetInt64(typeDataOffset);
-        // debugLog("typeDataOffset: " + std::to_string(typeDataOffset));
+        // debugLog("typeDataOffset: {}", typeDataOffset);
 
         int64_t gparamOffset;
         GetInt64(gparamOffset);
-        // debugLog("gparamOffset: " + std::to_string(gparamOffset));
+        // debugLog("gparamOffset: {}", gparamOffset);
 
         int64_t sceneGparamOffset;
         GetInt64(sceneGparamOffset);
-        // debugLog("sceneGparamOffset: " + std::to_string(sceneGparamOffset));
+        // debugLog("sceneGparamOffset: {}", sceneGparamOffset);
 
         // original has various asserts similar to earlier sections
 
-        istream->seekg(start + descOffset);
-        part.desc = ReadUtf16String();
-        // debugLog("part.desc: " + part.desc);
+        reader.Seek(start + descOffset);
+        part.desc = ReadName();
+        // debugLog("part.desc: {}", part.desc);
 
-        istream->seekg(start + nameOffset);
-        part.name = ReadUtf16String();
-        // debugLog("part.name: " + part.name);
+        reader.Seek(start + nameOffset);
+        part.name = ReadName();
+        // debugLog("part.name: {}", part.name);
 
-        istream->seekg(start + sibOffset);
-        part.sibPath = ReadUtf16String();
-        // debugLog("part.sibPath: " + part.sibPath);
+        reader.Seek(start + sibOffset);
+        part.sibPath = ReadName();
+        // debugLog("part.sibPath: {}", part.sibPath);
 
-        istream->seekg(start + entityDataOffset);
+        reader.Seek(start + entityDataOffset);
         GetInt32(part.entityId);
-        // debugLog("part.entityId: " + std::to_string(part.entityId));
+        // debugLog("part.entityId: {}", part.entityId);
 
         GetByte(part.unkE04);
-        // debugLog("part.unkE04: " + std::to_string(part.unkE04));
+        // debugLog("part.unkE04: {}", part.unkE04);
 
         GetByte(part.unkE05);
-        // debugLog("part.unkE05: " + std::to_string(part.unkE05));
+        // debugLog("part.unkE05: {}", part.unkE05);
 
         GetByte(part.unkE06);
-        // debugLog("part.unkE06: " + std::to_string(part.unkE06));
+        // debugLog("part.unkE06: {}", part.unkE06);
 
         GetByte(part.unkE07);
-        // debugLog("part.unkE07: " + std::to_string(part.unkE07));
+        // debugLog("part.unkE07: {}", part.unkE07);
 
         GetInt32(intBuffer);
-        // debugLog("zero check: " + std::to_string(intBuffer));
+        // debugLog("zero check: {}", intBuffer);
 
         GetByte(part.lanternId);
-        // debugLog("part.lanternId: " + std::to_string(part.lanternId));
+        // debugLog("part.lanternId: {}", part.lanternId);
 
         GetByte(part.lodParamId);
-        // debugLog("part.lodParamId: " + std::to_string(part.lodParamId));
+        // debugLog("part.lodParamId: {}", part.lodParamId);
 
         GetByte(part.unkE0E);
-        // debugLog("part.unkE0E: " + std::to_string(part.unkE0E));
+        // debugLog("part.unkE0E: {}", part.unkE0E);
 
         GetByte(part.unkE0F);
-        // debugLog("part.unkE0F: " + std::to_string(part.unkE0F));
+        // debugLog("part.unkE0F: {}", part.unkE0F);
 
         if (part.type < 12) {
-            istream->seekg(start + typeDataOffset);
-            GetBytes(part.typeData, GetPartTypeDataLength(part.type));
+            reader.Seek(start + typeDataOffset);
+            part.typeData = ReadBlob(GetPartTypeDataLength(part.type));
         }
 
         bool hasGparamConfig = false;
@@ -388,13 +403,13 @@ bool Msb::ReadMsb(std::vector<char>& data) {
             hasGparamConfig = true;
 
         if (hasGparamConfig) {
-            istream->seekg(start + gparamOffset);
-            GetBytes(part.gParamConfig, 32);
+            reader.Seek(start + gparamOffset);
+            part.gParamConfig = ReadBlob(32);
         }
 
         if (part.type == 5) { // only this has has scene param config
-            istream->seekg(start + sceneGparamOffset);
-            GetBytes(part.sceneParamConfig, 80);
+            reader.Seek(start + sceneGparamOffset);
+            part.sceneParamConfig = ReadBlob(80);
         }
 
         parts.push_back(part);
@@ -409,14 +424,14 @@ bool Msb::ReadMsb(std::vector<char>& data) {
         if (pIndex >= 0 && pIndex < static_cast<int>(parts.size())) {
             event.partName = parts[pIndex].name;
         } else {
-            event.partName = "";
+            event.partName = 0;
         }
 
         int rIndex = event.regionIndex;
         if (rIndex >= 0 && rIndex < static_cast<int>(regions.size())) {
             event.regionName = regions[rIndex].name;
         } else {
-            event.regionName = "";
+            event.regionName = 0;
         }
     }
 
@@ -425,180 +440,190 @@ bool Msb::ReadMsb(std::vector<char>& data) {
         if (index >= 0 && index < static_cast<int>(models.size())) {
             part.modelName = models[index].name;
         } else {
-            part.modelName = ""; // Or clear it if pIndex is -1
+            part.modelName = 0; // Or clear it if pIndex is -1
         }
     }
 
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
+Msb::SectionSlots Msb::WriteSectionHeader(size_t count, const std::string& paramName) {
+    SectionSlots section;
+    WriteInt32(version);
+    WriteInt32(static_cast<int>(count + 1));
+    section.paramNameOffset = ReserveInt64();
+    section.entryOffsets.resize(count);
+    for (auto& slot : section.entryOffsets) {
+        slot = ReserveInt64();
+    }
+    section.nextParamOffset = ReserveInt64();
+
+    FillReservedInt64(section.paramNameOffset, static_cast<int64_t>(writer.Tell()));
+    WriteUtf16String(paramName);
+    PadStream(8);
+    return section;
+}
+
 void Msb::GetSectionOffsets(std::vector<int64_t>& sectionOffsets, int64_t& nextParamOffset) {
     GetInt32(version); // should be 3?
-    // debugLog("version: " + std::to_string(version));
+    // debugLog("version: {}", version);
 
     int offsetCount;
     GetInt32(offsetCount);
-    // debugLog("offsetCount: " + std::to_string(offsetCount));
+    // debugLog("offsetCount: {}", offsetCount);
 
     int64_t nameOffset;
     GetInt64(nameOffset);
-    // debugLog("nameOffset: " + std::to_string(nameOffset));
+    // debugLog("nameOffset: {}", nameOffset);
 
     for (int i = 0; i < offsetCount - 1; i++) {
         int64_t entryOffset;
         GetInt64(entryOffset);
-        // debugLog("entryOffset: " + std::to_string(entryOffset));
+        // debugLog("entryOffset: {}", entryOffset);
         sectionOffsets.push_back(entryOffset);
     }
 
     GetInt64(nextParamOffset);
-    // debugLog("nextParamOffset: " + std::to_string(nextParamOffset));
+    // debugLog("nextParamOffset: {}", nextParamOffset);
 
-    StepIn(nameOffset, *istream);
+    StepIn(nameOffset, reader);
     std::string name = ReadUtf16String();
-    // debugLog("name: " + name);
-    StepOut(*istream);
+    // debugLog("name: {}", name);
+    StepOut(reader);
 }
 
 bool Msb::RepackMsb(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
+    // rough layout pass: fixed entry sizes plus the variable strings and blobs
+    auto length = [&](Name name) { return store->View(name).size(); };
+    size_t layoutSize = sizeof(Header) + 4 * 0x40;
+    for (const auto& model : models) {
+        layoutSize += 0x30 + (length(model.name) + length(model.sibPath) + 8) * 2;
+    }
+    for (const auto& event : events) {
+        layoutSize += 0x50 + (length(event.name) + 8) * 2 + event.typeData.size;
+    }
+    for (const auto& region : regions) {
+        layoutSize += 0x70 + (length(region.name) + 8) * 2 + region.shapeData.size;
+    }
+    for (const auto& part : parts) {
+        layoutSize += 0xD0 + (length(part.name) + length(part.desc) + length(part.sibPath)) * 2 +
+                      part.groupData.size + part.typeData.size + part.gParamConfig.size +
+                      part.sceneParamConfig.size;
+    }
+    writer = SpanWriter(layoutSize);
 
+    // names are handles into one store, so per-name counts and lookups are plain arrays
+    std::vector<int> instanceCounts(store->NameCount(), 0);
+    for (const Part& part : parts) {
+        instanceCounts[part.modelName]++;
+    }
     for (auto& model : models) {
-        model.instanceCount = std::count_if(parts.begin(), parts.end(), [&model](const Part& part) {
-            return part.modelName == model.name;
-        });
+        model.instanceCount = instanceCounts[model.name];
     }
 
-    std::unordered_map<std::string, int> modelLookup;
-    for (int i = 0; i < models.size(); ++i) {
-        modelLookup[models[i].name] = i;
-    }
+    // entries of a type keep their order and the indices below point into the sorted lists
+    std::stable_sort(models.begin(), models.end(),
+                     [](const Model& a, const Model& b) { return a.type < b.type; });
 
-    std::unordered_map<std::string, int> partsLookup;
-    for (int i = 0; i < parts.size(); ++i) {
-        partsLookup[parts[i].name] = i;
-    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.type < b.type; });
 
-    std::unordered_map<std::string, int> regionsLookup;
-    for (int i = 0; i < regions.size(); ++i) {
-        regionsLookup[regions[i].name] = i;
-    }
+    std::stable_sort(parts.begin(), parts.end(),
+                     [](const Part& a, const Part& b) { return a.type < b.type; });
 
-    for (auto& evt : events) {
-        auto it = partsLookup.find(evt.partName);
-        evt.partIndex = (it != partsLookup.end()) ? it->second : -1;
+    auto indexByName = [&](const auto& entries) {
+        std::vector<int> lookup(store->NameCount(), -1);
+        for (int i = 0; i < static_cast<int>(entries.size()); ++i) {
+            lookup[entries[i].name] = i;
+        }
+        return lookup;
+    };
+    const std::vector<int> modelLookup = indexByName(models);
+    const std::vector<int> partsLookup = indexByName(parts);
+    const std::vector<int> regionsLookup = indexByName(regions);
 
-        auto it2 = regionsLookup.find(evt.regionName);
-        evt.regionIndex = (it2 != regionsLookup.end()) ? it2->second : -1;
+    for (auto& evt : events) {
+        evt.partIndex = partsLookup[evt.partName];
+        evt.regionIndex = regionsLookup[evt.regionName];
     }
 
     for (auto& part : parts) {
-        auto it = modelLookup.find(part.modelName);
-        part.modelIndex = (it != modelLookup.end()) ? it->second : -1;
+        part.modelIndex = modelLookup[part.modelName];
     }
 
-    std::sort(models.begin(), models.end(),
-              [](const Model& a, const Model& b) { return a.type < b.type; });
-
-    std::sort(events.begin(), events.end(),
-              [](const Event& a, const Event& b) { return a.type < b.type; });
-
-    std::sort(parts.begin(), parts.end(),
-              [](const Part& a, const Part& b) { return a.type < b.type; });
-
-    strBuffer = "MSB ";
-    WriteStr(strBuffer, 4);
-
-    WriteInt32(1);
-    WriteInt32(0x10);
-    WriteByte(false);
-    WriteByte(false);
-    WriteByte(1);
-    WriteByte(0xFF);
+    Header header{};
+    std::memcpy(header.magic, "MSB ", 4);
+    header.unk04 = 1;
+    header.headerSize = 0x10;
+    header.unicode = 1;
+    header.is64Bit = 0xFF;
+    WriteStruct(header);
+    SectionSlots section;
 
     //////////////// MODELS
-    WriteInt32(version);
-    WriteInt32(static_cast<int>(models.size() + 1));
-    ReserveBytes("ParamNameOffset", 8);
-    for (int i = 0; i < models.size(); i++)
-        ReserveBytes("EntryOffset" + std::to_string(i), 8);
-    ReserveBytes("NextParamOffset", 8);
-
-    FillReservedInt64("ParamNameOffset", static_cast<int64_t>(ostream->tellp()));
-    WriteUtf16String("MODEL_PARAM_ST");
-    PadStream(8);
+    section = WriteSectionHeader(models.size(), "MODEL_PARAM_ST");
 
     int modelCatId = 0;
     uint modelType = 100; // dummy value
     for (int i = 0; i < models.size(); i++) {
         Model& model = models[i];
-        int64_t start = static_cast<int64_t>(ostream->tellp());
-        FillReservedInt64("EntryOffset" + std::to_string(i), start);
+        int64_t start = static_cast<int64_t>(writer.Tell());
+        FillReservedInt64(section.entryOffsets[i], start);
 
         if (model.type != modelType) {
             modelCatId = 0;
             modelType = model.type;
         }
 
-        ReserveBytes("NameOffset", 8);
+        Reserved<int64_t> nameOffset = ReserveInt64();
         WriteInt32(model.type);
         WriteInt32(modelCatId);
-        ReserveBytes("SibOffset", 8);
+        Reserved<int64_t> sibOffset = ReserveInt64();
         WriteInt32(model.instanceCount);
         WriteInt32(0);
         WriteInt32(0);
         WriteInt32(0);
 
-        FillReservedInt64("NameOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(ReambiguateName(model.name));
-        FillReservedInt64("SibOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(model.sibPath);
+        FillReservedInt64(nameOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(ReambiguateName(store->View(model.name)));
+        FillReservedInt64(sibOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(store->View(model.sibPath));
         PadStream(8);
 
         modelCatId += 1;
     }
 
-    FillReservedInt64("NextParamOffset", static_cast<int64_t>(ostream->tellp()));
+    FillReservedInt64(section.nextParamOffset, static_cast<int64_t>(writer.Tell()));
 
     //////////////// EVENTS
-    WriteInt32(version);
-    WriteInt32(static_cast<int>(events.size() + 1));
-    ReserveBytes("ParamNameOffset", 8);
-    for (int i = 0; i < events.size(); i++)
-        ReserveBytes("EntryOffset" + std::to_string(i), 8);
-    ReserveBytes("NextParamOffset", 8);
-
-    FillReservedInt64("ParamNameOffset", static_cast<int64_t>(ostream->tellp()));
-    WriteUtf16String("EVENT_PARAM_ST");
-    PadStream(8);
+    section = WriteSectionHeader(events.size(), "EVENT_PARAM_ST");
 
     int eventCatId = 0;
     uint eventType = 100; // dummy value
     for (int i = 0; i < events.size(); i++) {
         Event& event = events[i];
-        int64_t start = static_cast<int64_t>(ostream->tellp());
-        FillReservedInt64("EntryOffset" + std::to_string(i), start);
+        int64_t start = static_cast<int64_t>(writer.Tell());
+        FillReservedInt64(section.entryOffsets[i], start);
 
         if (event.type != eventType) {
             eventCatId = 0;
             eventType = event.type;
         }
 
-        ReserveBytes("NameOffset", 8);
+        Reserved<int64_t> nameOffset = ReserveInt64();
         WriteInt32(event.id);
         WriteInt32(event.type);
         WriteInt32(eventCatId);
         WriteInt32(0);
 
-        ReserveBytes("EntityDataOffset", 8);
-        ReserveBytes("TypeDataOffset", 8);
-        FillReservedInt64("NameOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(event.name);
+        Reserved<int64_t> entityDataOffset = ReserveInt64();
+        Reserved<int64_t> typeDataOffset = ReserveInt64();
+        FillReservedInt64(nameOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(store->View(event.name));
         PadStream(8);
 
-        FillReservedInt64("EntityDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
+        FillReservedInt64(entityDataOffset, static_cast<int64_t>(writer.Tell()) - start);
         WriteInt32(event.partIndex);
         WriteInt32(event.regionIndex);
         WriteInt32(event.entityId);
@@ -609,35 +634,26 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
         WriteByte(event.unkE0F);
 
         if (event.type < 18) {
-            FillReservedInt64("TypeDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
-            ostream->write(event.typeData.data(), event.typeData.size());
+            FillReservedInt64(typeDataOffset, static_cast<int64_t>(writer.Tell()) - start);
+            writer.Write(event.typeData.data, event.typeData.size);
         } else {
-            FillReservedInt64("TypeDataOffset", 0);
+            FillReservedInt64(typeDataOffset, 0);
         }
 
         eventCatId += 1;
     }
 
-    FillReservedInt64("NextParamOffset", static_cast<int64_t>(ostream->tellp()));
+    FillReservedInt64(section.nextParamOffset, static_cast<int64_t>(writer.Tell()));
 
     //////////////// REGIONS
-    WriteInt32(version);
-    WriteInt32(static_cast<int>(regions.size() + 1));
-    ReserveBytes("ParamNameOffset", 8);
-    for (int i = 0; i < regions.size(); i++)
-        ReserveBytes("EntryOffset" + std::to_string(i), 8);
-    ReserveBytes("NextParamOffset", 8);
-
-    FillReservedInt64("ParamNameOffset", static_cast<int64_t>(ostream->tellp()));
-    WriteUtf16String("POINT_PARAM_ST");
-    PadStream(8);
+    section = WriteSectionHeader(regions.size(), "POINT_PARAM_ST");
 
     for (int i = 0; i < regions.size(); i++) {
         Region& region = regions[i];
-        int64_t start = static_cast<int64_t>(ostream->tellp());
-        FillReservedInt64("EntryOffset" + std::to_string(i), start);
+        int64_t start = static_cast<int64_t>(writer.Tell());
+        FillReservedInt64(section.entryOffsets[i], start);
 
-        ReserveBytes("NameOffset", 8);
+        Reserved<int64_t> nameOffset = ReserveInt64();
         WriteInt32(0);
         WriteInt32(i);
         WriteInt32(region.shapeType);
@@ -645,63 +661,54 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
         WriteVector3(region.rotation);
         WriteInt32(0);
 
-        ReserveBytes("UnkOffsetA", 8);
-        ReserveBytes("UnkOffsetB", 8);
-        ReserveBytes("ShapeDataOffset", 8);
-        ReserveBytes("EntityDataOffset", 8);
+        Reserved<int64_t> unkOffsetA = ReserveInt64();
+        Reserved<int64_t> unkOffsetB = ReserveInt64();
+        Reserved<int64_t> shapeDataOffset = ReserveInt64();
+        Reserved<int64_t> entityDataOffset = ReserveInt64();
 
-        FillReservedInt64("NameOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(ReambiguateName(region.name));
+        FillReservedInt64(nameOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(ReambiguateName(store->View(region.name)));
         PadStream(4);
 
-        FillReservedInt64("UnkOffsetA", static_cast<int64_t>(ostream->tellp()) - start);
+        FillReservedInt64(unkOffsetA, static_cast<int64_t>(writer.Tell()) - start);
         WriteInt16(0);
         PadStream(4);
 
-        FillReservedInt64("UnkOffsetB", static_cast<int64_t>(ostream->tellp()) - start);
+        FillReservedInt64(unkOffsetB, static_cast<int64_t>(writer.Tell()) - start);
         WriteInt16(0);
         PadStream(8);
 
         if (region.shapeType < 7 && region.shapeType != 0) {
-            FillReservedInt64("ShapeDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
-            ostream->write(region.shapeData.data(), region.shapeData.size());
+            FillReservedInt64(shapeDataOffset, static_cast<int64_t>(writer.Tell()) - start);
+            writer.Write(region.shapeData.data, region.shapeData.size);
         } else {
-            FillReservedInt64("ShapeDataOffset", 0);
+            FillReservedInt64(shapeDataOffset, 0);
         }
 
-        FillReservedInt64("EntityDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
+        FillReservedInt64(entityDataOffset, static_cast<int64_t>(writer.Tell()) - start);
         WriteInt32(region.entityId);
         PadStream(8);
     }
 
-    FillReservedInt64("NextParamOffset", static_cast<int64_t>(ostream->tellp()));
+    FillReservedInt64(section.nextParamOffset, static_cast<int64_t>(writer.Tell()));
 
     //////////////// PARTS
-    WriteInt32(version);
-    WriteInt32(static_cast<int>(parts.size() + 1));
-    ReserveBytes("ParamNameOffset", 8);
-    for (int i = 0; i < parts.size(); i++)
-        ReserveBytes("EntryOffset" + std::to_string(i), 8);
-    ReserveBytes("NextParamOffset", 8);
-
-    FillReservedInt64("ParamNameOffset", static_cast<int64_t>(ostream->tellp()));
-    WriteUtf16String("PARTS_PARAM_ST");
-    PadStream(8);
+    section = WriteSectionHeader(parts.size(), "PARTS_PARAM_ST");
 
     int partsCatId = 0;
     uint partType = 100; // dummy value
     for (int i = 0; i < parts.size(); i++) {
         Part& part = parts[i];
-        int64_t start = static_cast<int64_t>(ostream->tellp());
-        FillReservedInt64("EntryOffset" + std::to_string(i), start);
+        int64_t start = static_cast<int64_t>(writer.Tell());
+        FillReservedInt64(section.entryOffsets[i], start);
 
         if (part.type != partType) {
             partsCatId = 0;
             partType = part.type;
         }
 
-        ReserveBytes("DescOffset", 8);
-        ReserveBytes("NameOffset", 8);
+        Reserved<int64_t> descOffset = ReserveInt64();
+        Reserved<int64_t> nameOffset = ReserveInt64();
         WriteInt32(part.instanceId);
         WriteInt32(part.type);
 
@@ -712,36 +719,35 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
         }
 
         WriteInt32(part.modelIndex);
-        ReserveBytes("SibOffset", 8);
+        Reserved<int64_t> sibOffset = ReserveInt64();
         WriteVector3(part.position);
         WriteVector3(part.rotation);
         WriteVector3(part.scale);
 
-        ostream->write(part.groupData.data(), part.groupData.size());
+        writer.Write(part.groupData.data, part.groupData.size);
         WriteInt32(0);
 
-        ReserveBytes("EntityDataOffset", 8);
-        ReserveBytes("TypeDataOffset", 8);
-        ReserveBytes("GparamOffset", 8);
-        ReserveBytes("SceneGparamOffset", 8);
+        Reserved<int64_t> entityDataOffset = ReserveInt64();
+        Reserved<int64_t> typeDataOffset = ReserveInt64();
+        Reserved<int64_t> gparamOffset = ReserveInt64();
+        Reserved<int64_t> sceneGparamOffset = ReserveInt64();
 
-        int64_t stringsStart = static_cast<int64_t>(ostream->tellp());
-        FillReservedInt64("DescOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(part.desc);
-        FillReservedInt64("NameOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(ReambiguateName(part.name));
-        FillReservedInt64("SibOffset", static_cast<int64_t>(ostream->tellp()) - start);
-        WriteUtf16String(part.sibPath);
+        int64_t stringsStart = static_cast<int64_t>(writer.Tell());
+        FillReservedInt64(descOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(store->View(part.desc));
+        FillReservedInt64(nameOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(ReambiguateName(store->View(part.name)));
+        FillReservedInt64(sibOffset, static_cast<int64_t>(writer.Tell()) - start);
+        WriteUtf16String(store->View(part.sibPath));
 
-        int64_t patternPos = static_cast<int64_t>(ostream->tellp()) - stringsStart;
+        int64_t patternPos = static_cast<int64_t>(writer.Tell()) - stringsStart;
         if (patternPos <= 0x38) {
-            std::vector<char> zeros(0x3C - patternPos, 0x00);
-            ostream->write(zeros.data(), zeros.size());
+            writer.Fill(0x00, 0x3C - patternPos);
         } else {
             PadStream(8);
         }
 
-        FillReservedInt64("EntityDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
+        FillReservedInt64(entityDataOffset, static_cast<int64_t>(writer.Tell()) - start);
         WriteInt32(part.entityId);
         WriteByte(part.unkE04);
         WriteByte(part.unkE05);
@@ -758,10 +764,10 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
             PadStream(8);
 
         if (part.type < 12) {
-            FillReservedInt64("TypeDataOffset", static_cast<int64_t>(ostream->tellp()) - start);
-            ostream->write(part.typeData.data(), part.typeData.size());
+            FillReservedInt64(typeDataOffset, static_cast<int64_t>(writer.Tell()) - start);
+            writer.Write(part.typeData.data, part.typeData.size);
         } else {
-            FillReservedInt64("TypeDataOffset", 0);
+            FillReservedInt64(typeDataOffset, 0);
         }
         PadStream(8);
 
@@ -771,27 +777,25 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
             hasGparamConfig = true;
 
         if (hasGparamConfig) {
-            FillReservedInt64("GparamOffset", static_cast<int64_t>(ostream->tellp()) - start);
-            ostream->write(part.gParamConfig.data(), part.gParamConfig.size());
+            FillReservedInt64(gparamOffset, static_cast<int64_t>(writer.Tell()) - start);
+            writer.Write(part.gParamConfig.data, part.gParamConfig.size);
         } else {
-            FillReservedInt64("GparamOffset", 0);
+            FillReservedInt64(gparamOffset, 0);
         }
 
         if (part.type == 5) {
-            FillReservedInt64("SceneGparamOffset", static_cast<int64_t>(ostream->tellp()) - start);
-            ostream->write(part.sceneParamConfig.data(), part.sceneParamConfig.size());
+            FillReservedInt64(sceneGparamOffset, static_cast<int64_t>(writer.Tell()) - start);
+            writer.Write(part.sceneParamConfig.data, part.sceneParamConfig.size);
         } else {
-            FillReservedInt64("SceneGparamOffset", 0);
+            FillReservedInt64(sceneGparamOffset, 0);
         }
 
         partsCatId += 1;
     }
 
-    FillReservedInt64("NextParamOffset", 0);
+    FillReservedInt64(section.nextParamOffset, 0);
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.msb", std::ios::out | std::ios::binary);
@@ -801,168 +805,165 @@ bool Msb::RepackMsb(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("MSB Repacking complete\n");
     return true;
 }
 
-bool Msb::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    Msb mod1Msb = Msb(mod1Data, merger);
-    Msb mod2Msb = Msb(mod2Data, merger);
-
-    const std::vector<Model> mod1Models = mod1Msb.models;
-    const std::vector<Model> mod2Models = mod2Msb.models;
-
-    const std::vector<Event> mod1Events = mod1Msb.events;
-    const std::vector<Event> mod2Events = mod2Msb.events;
-
-    const std::vector<Region> mod1Regions = mod1Msb.regions;
-    const std::vector<Region> mod2Regions = mod2Msb.regions;
-
-    const std::vector<Part> mod1Parts = mod1Msb.parts;
-    const std::vector<Part> mod2Parts = mod2Msb.parts;
+bool Msb::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    // the mods intern into this store, so a name is the same handle in all three files
+    Msb mod1Msb = Msb(mod1Data, merger, store);
+    Msb mod2Msb = Msb(mod2Data, merger, store);
 
-    bool Success = true;
-
-    if (!MergeCollection(models, mod1Models, mod2Models, "model"))
+    if (!MergeCollection(models, mod1Msb.models, mod2Msb.models, &Model::name, "model"))
         return false;
-    if (!MergeCollection(parts, mod1Parts, mod2Parts, "part"))
+    if (!MergeCollection(parts, mod1Msb.parts, mod2Msb.parts, &Part::name, "part"))
         return false;
-    if (!MergeCollection(regions, mod1Regions, mod2Regions, "region"))
+    if (!MergeCollection(regions, mod1Msb.regions, mod2Msb.regions, &Region::name, "region"))
         return false;
-    if (!MergeCollection(events, mod1Events, mod2Events, "event"))
+    if (!MergeCollection(events, mod1Msb.events, mod2Msb.events, &Event::id, "event"))
         return false;
 
     return true;
 }
 
-template <typename T>
+template <typename T, typename Key>
 bool Msb::MergeCollection(std::vector<T>& baseItems, const std::vector<T>& mod1Items,
-                          const std::vector<T>& mod2Items, const std::string& typeName) {
-    // Build O(1) hash maps for instantaneous lookups
-    std::unordered_map<std::string, T> mod1Map;
-    for (const auto& item : mod1Items)
-        mod1Map[item.Identifier()] = item;
-
-    std::unordered_map<std::string, T> mod2Map;
-    for (const auto& item : mod2Items)
-        mod2Map[item.Identifier()] = item;
-
-    for (auto it = baseItems.begin(); it != baseItems.end();) {
-        T& item = *it;
-        std::string key = item.Identifier();
-
-        std::optional<T> mod1Item = GetSameItem(key, mod1Map);
-        std::optional<T> mod2Item = GetSameItem(key, mod2Map);
-
-        bool mod1Modified = mod1Item && (mod1Item.value() != item);
-        bool mod2Modified = mod2Item && (mod2Item.value() != item);
-
+                          const std::vector<T>& mod2Items, Key T::*key,
+                          const std::string& typeName) {
+    // position of each key in a mod, a later duplicate wins
+    auto indexOf = [&](const std::vector<T>& items) {
+        std::unordered_map<Key, size_t> index;
+        index.reserve(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            index[items[i].*key] = i;
+        }
+        return index;
+    };
+    const std::unordered_map<Key, size_t> mod1Index = indexOf(mod1Items);
+    const std::unordered_map<Key, size_t> mod2Index = indexOf(mod2Items);
+
+    auto find = [](const std::unordered_map<Key, size_t>& index, const std::vector<T>& items,
+                   const Key& itemKey) -> const T* {
+        auto it = index.find(itemKey);
+        return it != index.end() ? &items[it->second] : nullptr;
+    };
+
+    std::unordered_set<Key> baseKeys;
+    baseKeys.reserve(baseItems.size());
+
+    // entries both mods dropped are removed, the rest are compacted in place
+    size_t kept = 0;
+    for (size_t i = 0; i < baseItems.size(); i++) {
+        T& item = baseItems[i];
+        baseKeys.insert(item.*key);
+
+        const T* mod1Item = find(mod1Index, mod1Items, item.*key);
+        const T* mod2Item = find(mod2Index, mod2Items, item.*key);
         if (!mod1Item && !mod2Item) {
-            it = baseItems.erase(it);
             continue;
         }
 
-        if ((!mod1Item && !mod2Modified) || (!mod2Item && !mod1Modified)) {
-            it = baseItems.erase(it);
-            continue;
-        }
+        bool mod1Modified = mod1Item && *mod1Item != item;
+        bool mod2Modified = mod2Item && *mod2Item != item;
 
         if (mod1Modified && mod2Modified) {
-            if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                          Qt::BlockingQueuedConnection);
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    return false;
-                }
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
             }
 
-            if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                item = mod1Item.value();
-                sendLog("Unresolvable conflict in " + typeName + ": " + item.name +
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                item = *mod1Item;
+                sendLog("Unresolvable conflict in " + typeName + ": " + Text(item.name) +
                             ", using data from prioritized mod: " + merger->Mod1Name(),
                         LogFormat::Yellow);
-            } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                item = mod2Item.value();
-                sendLog("Unresolvable conflict in " + typeName + ": " + item.name +
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                item = *mod2Item;
+                sendLog("Unresolvable conflict in " + typeName + ": " + Text(item.name) +
                             ", using data from prioritized mod: " + merger->Mod2Name(),
                         LogFormat::Yellow);
             }
-        } else if (mod1Modified && !mod2Modified) {
-            item = mod1Item.value();
-            sendLog("Merging modified " + typeName + ": " + item.name +
+        } else if (mod1Modified) {
+            item = *mod1Item;
+            sendLog("Merging modified " + typeName + ": " + Text(item.name) +
                     " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            item = mod2Item.value();
-            sendLog("Merging modified " + typeName + ": " + item.name +
+        } else if (mod2Modified) {
+            item = *mod2Item;
+            sendLog("Merging modified " + typeName + ": " + Text(item.name) +
                     " from mod: " + merger->Mod2Name());
         }
 
-        ++it;
-    }
-
-    std::unordered_set<std::string> baseIdentifiers;
-    for (const auto& item : baseItems) {
-        baseIdentifiers.insert(item.Identifier());
-    }
-
-    std::unordered_set<std::string> brandNewKeys;
-    for (const auto& [key, _] : mod1Map) {
-        if (!baseIdentifiers.contains(key))
-            brandNewKeys.insert(key);
-    }
-
-    for (const auto& [key, _] : mod2Map) {
-        if (!baseIdentifiers.contains(key))
-            brandNewKeys.insert(key);
+        if (kept != i) {
+            baseItems[kept] = item;
+        }
+        kept++;
     }
+    baseItems.resize(kept);
 
-    for (const auto& key : brandNewKeys) {
-        bool inMod1 = mod1Map.contains(key);
-        bool inMod2 = mod2Map.contains(key);
+    // new entries in mod1 order, then the ones only mod2 has in mod2 order
+    for (size_t i = 0; i < mod1Items.size(); i++) {
+        const T& item1 = mod1Items[i];
+        if (baseKeys.contains(item1.*key) || mod1Index.at(item1.*key) != i) {
+            continue;
+        }
 
-        if (inMod1 && inMod2) {
-            const T& item1 = mod1Map[key];
-            const T& item2 = mod2Map[key];
+        const T* item2 = find(mod2Index, mod2Items, item1.*key);
+        if (!item2) {
+            baseItems.push_back(item1);
+            sendLog("Brand new " + typeName + " added from Mod 1: " + Text(item1.name));
+        } else if (item1 == *item2) {
+            baseItems.push_back(item1);
+            sendLog("Brand new " + typeName + " added (identical in both mods): " +
+                    Text(item1.name));
+        } else {
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
+            }
 
-            if (item1 == item2) {
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
                 baseItems.push_back(item1);
-                sendLog("Brand new " + typeName + " added (identical in both mods): " + item1.name);
+                sendLog("New asset conflict in " + typeName + ": " + Text(item1.name) +
+                            ", prioritizing Mod 1 data: " + merger->Mod1Name(),
+                        LogFormat::Yellow);
             } else {
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                              Qt::BlockingQueuedConnection);
-                    if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                        return false;
-                    }
-                }
-
-                if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                    baseItems.push_back(item1);
-                    sendLog("New asset conflict in " + typeName + ": " + item1.name +
-                                ", prioritizing Mod 1 data: " + merger->Mod1Name(),
-                            LogFormat::Yellow);
-                } else {
-                    baseItems.push_back(item2);
-                    sendLog("New asset conflict in " + typeName + ": " + item2.name +
-                                ", prioritizing Mod 2 data: " + merger->Mod2Name(),
-                            LogFormat::Yellow);
-                }
+                baseItems.push_back(*item2);
+                sendLog("New asset conflict in " + typeName + ": " + Text(item2->name) +
+                            ", prioritizing Mod 2 data: " + merger->Mod2Name(),
+                        LogFormat::Yellow);
             }
-        } else if (inMod1) {
-            baseItems.push_back(mod1Map[key]);
-            sendLog("Brand new " + typeName + " added from Mod 1: " + mod1Map[key].name);
-        } else if (inMod2) {
-            baseItems.push_back(mod2Map[key]);
-            sendLog("Brand new " + typeName + " added from Mod 2: " + mod2Map[key].name);
         }
     }
+
+    for (size_t i = 0; i < mod2Items.size(); i++) {
+        const T& item2 = mod2Items[i];
+        if (baseKeys.contains(item2.*key) || mod1Index.contains(item2.*key) ||
+            mod2Index.at(item2.*key) != i) {
+            continue;
+        }
+
+        baseItems.push_back(item2);
+        sendLog("Brand new " + typeName + " added from Mod 2: " + Text(item2.name));
+    }
     return true;
 }
 
-std::string Msb::ReambiguateName(const std::string& name) {
-    std::regex pattern(R"( \{\d+\})");
-    return std::regex_replace(name, pattern, "");
+// drops the " {n}" suffixes DisambiguateNames adds
+std::string Msb::ReambiguateName(std::string_view name) {
+    std::string result;
+    result.reserve(name.size());
+    for (size_t i = 0; i < name.size();) {
+        if (name[i] == ' ' && i + 1 < name.size() && name[i + 1] == '{') {
+            size_t end = i + 2;
+            while (end < name.size() && name[end] >= '0' && name[end] <= '9') {
+                end++;
+            }
+            if (end > i + 2 && end < name.size() && name[end] == '}') {
+                i = end + 1;
+                continue;
+            }
+        }
+        result += name[i++];
+    }
+    return result;
 }
 
 int Msb::GetShapeDataLength(int shapeType) {
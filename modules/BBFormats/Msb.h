@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <memory>
+#include <memory_resource>
+
 #include "BBFormats.h"
 
 namespace FileHelper {
@@ -10,37 +13,95 @@ namespace FileHelper {
 class Msb : public BBFormat {
     Q_OBJECT
 
+    struct Header {
+        char magic[4];        // MSB
+        int32_t unk04;        // 1
+        int32_t headerSize;   // 0x10
+        uint8_t bigEndian;    // should be false
+        uint8_t bitBigEndian; // should be false
+        uint8_t unicode;      // should be true
+        uint8_t is64Bit;      // should be 255
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.unk04, h.headerSize);
+        }
+    };
+    static_assert(sizeof(Header) == 0x10);
+
+    struct ModelHeader {
+        int64_t nameOffset;
+        uint32_t type;
+        int32_t typeId;
+        int64_t sibOffset;
+        int32_t instanceCount;
+        int32_t unk1C; // zero
+        int32_t unk20; // zero
+        int32_t unk24; // zero
+
+        static constexpr auto Fields(auto& m) {
+            return std::tie(m.nameOffset, m.type, m.typeId, m.sibOffset, m.instanceCount, m.unk1C,
+                            m.unk20, m.unk24);
+        }
+    };
+    static_assert(sizeof(ModelHeader) == 0x28);
+
+    using Name = uint32_t; // handle into the store, 0 is the empty name
+
+    // bytes in the store's arena, compared by content
+    struct Blob {
+        const char* data = nullptr;
+        uint32_t size = 0;
+
+        bool operator==(const Blob& other) const {
+            return size == other.size && std::equal(data, data + size, other.data);
+        }
+    };
+
+    // names and blobs of an msb and of the mods merged into it. entries only hold handles and
+    // spans into it, so they copy like plain structs and nothing is freed until the store goes
+    class Store {
+    public:
+        explicit Store(size_t sizeHint);
+
+        Name Intern(std::string_view text);
+        std::string_view View(Name name) const {
+            return names[name];
+        }
+        size_t NameCount() const {
+            return names.size();
+        }
+        // copy of bytes, zero padded to size
+        Blob Copy(std::span<const char> bytes, size_t size);
+
+    private:
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<std::string_view> names;
+        std::unordered_map<std::string_view, Name> handles;
+    };
+
     struct Model {
-        std::string name; // unique identifier, disambiguated
-        std::string sibPath;
+        Name name; // unique identifier, disambiguated
+        Name sibPath;
         int instanceCount;
         uint type;
 
-        std::string Identifier() const {
-            return name;
-        }
-
         bool operator==(const Model&) const = default;
     };
 
     struct Event {
-        std::string name;
+        Name name;
         int id; // unique identifier
         uint type;
-        std::string partName;
+        Name partName;
         int partIndex;
-        std::string regionName;
+        Name regionName;
         int regionIndex;
         int entityId;
         int unkE0C;
         int unkE0D;
         int unkE0E;
         int unkE0F;
-        std::vector<char> typeData = {};
-
-        std::string Identifier() const {
-            return std::to_string(id);
-        }
+        Blob typeData;
 
         // part and region index removed from equality
         bool operator==(const Event& other) const {
@@ -53,33 +114,29 @@ class Msb : public BBFormat {
     };
 
     struct Region {
-        std::string name;
+        Name name;
         Vector3 position;
         Vector3 rotation;
         int entityId;
         uint shapeType;
 
-        std::vector<char> shapeData = {};
-
-        std::string Identifier() const {
-            return name;
-        }
+        Blob shapeData;
 
         bool operator==(const Region&) const = default;
     };
 
-    struct Part {         // so tedious T_T
-        std::string name; // unique identifier, disambiguated
-        std::string desc; // can be empty
+    struct Part {  // so tedious T_T
+        Name name; // unique identifier, disambiguated
+        Name desc; // can be empty
         uint type;
         int instanceId;
-        std::string modelName;
+        Name modelName;
         int modelIndex;
-        std::string sibPath;
+        Name sibPath;
         Vector3 position;
         Vector3 rotation;
         Vector3 scale;
-        std::vector<char> groupData = {}; // drawg/display/backread groups
+        Blob groupData; // drawg/display/backread groups
         int entityId;
         int unkE04;
         int unkE05;
@@ -89,13 +146,9 @@ class Msb : public BBFormat {
         int lodParamId;
         int unkE0E;
         int unkE0F;
-        std::vector<char> typeData = {};
-        std::vector<char> gParamConfig = {};
-        std::vector<char> sceneParamConfig = {};
-
-        std::string Identifier() const {
-            return name;
-        }
+        Blob typeData;
+        Blob gParamConfig;
+        Blob sceneParamConfig;
 
         // remove model index removed from equality
         bool operator==(const Part& other) const {
@@ -112,58 +165,65 @@ class Msb : public BBFormat {
     };
 
 public:
-    explicit Msb(std::vector<char>& data, ModMerger* parent);
+    explicit Msb(std::span<const char> data, MergeEngine* parent);
     ~Msb() override;
 
-    bool ReadMsb(std::vector<char>& data);
+    bool ReadMsb(std::span<const char> data);
     bool RepackMsb(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
 private:
-    template <typename T>
-    std::optional<T> GetSameItem(const std::string& key,
-                                 const std::unordered_map<std::string, T>& lookupMap) {
-        auto it = lookupMap.find(key);
-        if (it != lookupMap.end()) {
-            return it->second;
-        }
-        return std::nullopt;
-    }
+    // mods are read into the store of the msb they're merged into
+    Msb(std::span<const char> data, MergeEngine* parent, std::shared_ptr<Store> sharedStore);
 
     template <typename T>
-    static void DisambiguateNames(std::vector<T>& entries, const std::string& className = "") {
+    void DisambiguateNames(std::vector<T>& entries) {
         bool ambiguous;
         do {
             ambiguous = false;
-            std::unordered_map<std::string, int> nameCounts;
-            nameCounts[""] = 0;
+            std::unordered_map<Name, int> nameCounts;
+            nameCounts.reserve(entries.size());
+            nameCounts[0] = 0;
 
             for (auto& entry : entries) {
-                std::string name = entry.name;
-
-                if (nameCounts.find(name) == nameCounts.end() && !name.empty()) {
-                    nameCounts[name] = 1;
-                } else {
+                auto [it, added] = nameCounts.try_emplace(entry.name, 1);
+                if (!added) {
                     ambiguous = true;
-                    nameCounts[name]++;
-                    entry.name = className + name + " {" + std::to_string(nameCounts[name]) + "}";
+                    it->second++;
+                    entry.name = store->Intern(std::string(store->View(entry.name)) + " {" +
+                                               std::to_string(it->second) + "}");
                 }
             }
         } while (ambiguous);
     }
 
-    template <typename T>
+    template <typename T, typename Key>
     bool MergeCollection(std::vector<T>& baseItems, const std::vector<T>& mod1Items,
-                         const std::vector<T>& mod2Items, const std::string& typeName);
+                         const std::vector<T>& mod2Items, Key T::*key,
+                         const std::string& typeName);
+
+    // offset table at the start of each param section
+    struct SectionSlots {
+        Reserved<int64_t> paramNameOffset;
+        std::vector<Reserved<int64_t>> entryOffsets;
+        Reserved<int64_t> nextParamOffset;
+    };
 
-    std::string ReambiguateName(const std::string& name);
+    std::string Text(Name name) const {
+        return std::string(store->View(name));
+    }
+    Name ReadName();
+    Blob ReadBlob(int length);
+    std::string ReambiguateName(std::string_view name);
     void GetSectionOffsets(std::vector<int64_t>& sectionOffsets, int64_t& nextParamOffet);
+    SectionSlots WriteSectionHeader(size_t count, const std::string& paramName);
 
     int GetShapeDataLength(int shapeType);
     int GetPartTypeDataLength(int partType);
     int GetEventTypeDataLength(int type);
 
     int version;
+    std::shared_ptr<Store> store;
     std::vector<Model> models;
     std::vector<Part> parts;
     std::vector<Event> events;
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// row layouts of the params we have paramdefs for. the xmls in ParamDefs/ are compiled into
+// constexpr tables by tools/paramdef_gen.cpp at build time, nothing is parsed at runtime.
+// only ActionButtonParam ships so far, more are added by dropping the Bloodborne paramdex xml of
+// a param into ParamDefs/. a def that splits a field wrong mixes two mods' values into one field,
+// so only defs checked against the game go there. params without a usable def keep the whole row
+// priority choice
+namespace FileHelper::ParamDefs {
+
+enum class DefType : uint8_t {
+    s8,      // Signed 1-byte integer.
+    u8,      // Unsigned 1-byte integer.
+    s16,     // Signed 2-byte integer.
+    u16,     // Unsigned 2-byte integer.
+    s32,     // Signed 4-byte integer.
+    u32,     // Unsigned 4-byte integer
+    b32,     // 4-byte integer representing a boolean
+    f32,     // Single-precision floating point value
+    angle32, // Single-precision floating point value representing an angle
+    f64,     // Double-precision floating point value
+    dummy8,  // Byte or array of bytes used for padding or placeholding
+    fixstr,  // Fixed-width Shift-JIS string.
+    fixstrW, // Fixed-width UTF-16 string.
+};
+
+// where a field sits in the row data. bit fields share their unit with the fields packed next to
+// them and own only the bits in mask
+struct Column {
+    std::string_view name;
+    DefType type;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t mask; // 0 for fields that own whole bytes
+};
+
+struct Layout {
+    std::string_view paramType;
+    uint32_t rowSize;
+    std::span<const Column> columns;
+};
+
+// fnv-1a with a seed, the generator searches for the seed that makes it perfect over the table
+constexpr uint32_t Hash(std::string_view text, uint32_t seed) {
+    uint32_t hash = 0x811C9DC5u ^ seed;
+    for (char c : text) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x01000193u;
+    }
+    return hash;
+}
+
+// layout for the param type in a param header, nullptr without a paramdef
+const Layout* Find(std::string_view paramType);
+
+} // namespace FileHelper::ParamDefs
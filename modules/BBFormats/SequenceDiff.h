@@ -0,0 +1,204 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace FileHelper {
+
+// one run of an edit script, base[baseBegin, baseEnd) becomes mod[modBegin, modEnd). an empty
+// base range is an insertion, an empty mod range a deletion
+struct DiffHunk {
+    size_t baseBegin;
+    size_t baseEnd;
+    size_t modBegin;
+    size_t modEnd;
+
+    bool operator==(const DiffHunk&) const = default;
+};
+
+namespace SequenceDiffDetail {
+
+// myers' greedy O(ND) search, D being the number of inserted and deleted elements. V holds the
+// furthest x reached on each diagonal k = x - y, and a copy of it is kept for every d so the path
+// can be walked back. past maxEdits the whole range is returned as a single hunk
+template <typename EqualAt>
+std::vector<DiffHunk> Myers(size_t baseBegin, size_t baseEnd, size_t modBegin, size_t modEnd,
+                            EqualAt& equalAt, int maxEdits) {
+    const int n = static_cast<int>(baseEnd - baseBegin);
+    const int m = static_cast<int>(modEnd - modBegin);
+    const int limit = std::min(n + m, maxEdits);
+
+    const int offset = limit + 1;
+    std::vector<int> v(2 * limit + 3, 0);
+    std::vector<int> trace; // V[-d..d] after each d, (d + 1)^2 values up to d
+    int edits = -1;
+    for (int d = 0; d <= limit && edits < 0; d++) {
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                        ? v[offset + k + 1]
+                        : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && equalAt(baseBegin + x, modBegin + y)) {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                edits = d;
+            }
+        }
+        trace.insert(trace.end(), v.begin() + offset - d, v.begin() + offset + d + 1);
+    }
+
+    if (edits < 0) {
+        return {{baseBegin, baseEnd, modBegin, modEnd}};
+    }
+
+    // walk back from the end, one insertion or deletion per d
+    struct Edit {
+        int x;
+        int y;
+        bool insert;
+    };
+    std::vector<Edit> path(edits);
+    int x = n;
+    int y = m;
+    for (int d = edits; d > 0; d--) {
+        const int* prev = trace.data() + static_cast<size_t>(d - 1) * (d - 1) + (d - 1);
+        const int k = x - y;
+        const bool insert = k == -d || (k != d && prev[k - 1] < prev[k + 1]);
+        const int prevK = insert ? k + 1 : k - 1;
+        const int prevX = prev[prevK];
+        path[d - 1] = {prevX, prevX - prevK, insert};
+        x = prevX;
+        y = prevX - prevK;
+    }
+
+    // consecutive edits that touch form one hunk
+    std::vector<DiffHunk> hunks;
+    for (const Edit& edit : path) {
+        const size_t baseAt = baseBegin + edit.x;
+        const size_t modAt = modBegin + edit.y;
+        if (hunks.empty() || hunks.back().baseEnd != baseAt || hunks.back().modEnd != modAt) {
+            hunks.push_back({baseAt, baseAt, modAt, modAt});
+        }
+        edit.insert ? hunks.back().modEnd++ : hunks.back().baseEnd++;
+    }
+    return hunks;
+}
+
+// whether two hunks of different mods touch the same base elements. an insertion sits between two
+// elements, so it only collides with a hunk that spans that point or inserts at it as well
+inline bool Overlaps(const DiffHunk& a, const DiffHunk& b) {
+    if (a.baseBegin < b.baseEnd && b.baseBegin < a.baseEnd) {
+        return true;
+    }
+    return a.baseBegin == a.baseEnd && b.baseBegin == b.baseEnd && a.baseBegin == b.baseBegin;
+}
+
+} // namespace SequenceDiffDetail
+
+// hunks turning base into mod, in base order. the common head and tail are skipped before the
+// search, so appending to or editing one spot of a long sequence costs a single pass
+template <typename T, typename EqualFn = std::equal_to<>>
+std::vector<DiffHunk> Diff(std::span<const T> base, std::span<const T> mod, EqualFn equal = {},
+                           int maxEdits = 1024) {
+    size_t head = 0;
+    while (head < base.size() && head < mod.size() && equal(base[head], mod[head])) {
+        head++;
+    }
+    size_t tail = 0;
+    while (tail < base.size() - head && tail < mod.size() - head &&
+           equal(base[base.size() - 1 - tail], mod[mod.size() - 1 - tail])) {
+        tail++;
+    }
+
+    const size_t baseEnd = base.size() - tail;
+    const size_t modEnd = mod.size() - tail;
+    if (head == baseEnd && head == modEnd) {
+        return {};
+    }
+    if (head == baseEnd || head == modEnd) {
+        return {{head, baseEnd, head, modEnd}};
+    }
+
+    auto equalAt = [&](size_t b, size_t m) { return equal(base[b], mod[m]); };
+    return SequenceDiffDetail::Myers(head, baseEnd, head, modEnd, equalAt, maxEdits);
+}
+
+template <typename T>
+struct ThreeWayResult {
+    bool clean = false; // false when the mods changed the same elements differently
+    std::vector<T> merged;
+    size_t mod1Hunks = 0;
+    size_t mod2Hunks = 0;
+};
+
+// applies the hunks of both mods to base. hunks that overlap are only taken when both mods made
+// the identical change, anything else leaves the result unclean for the caller to resolve
+template <typename T, typename EqualFn = std::equal_to<>>
+ThreeWayResult<T> ThreeWayMerge(std::span<const T> base, std::span<const T> mod1,
+                                std::span<const T> mod2, EqualFn equal = {}) {
+    using SequenceDiffDetail::Overlaps;
+    const std::vector<DiffHunk> hunks1 = Diff(base, mod1, equal);
+    const std::vector<DiffHunk> hunks2 = Diff(base, mod2, equal);
+
+    auto sameChange = [&](const DiffHunk& a, const DiffHunk& b) {
+        return a.baseBegin == b.baseBegin && a.baseEnd == b.baseEnd &&
+               std::equal(mod1.begin() + a.modBegin, mod1.begin() + a.modEnd,
+                          mod2.begin() + b.modBegin, mod2.begin() + b.modEnd, equal);
+    };
+    auto before = [](const DiffHunk& a, const DiffHunk& b) {
+        return a.baseBegin != b.baseBegin ? a.baseBegin < b.baseBegin : a.baseEnd < b.baseEnd;
+    };
+
+    ThreeWayResult<T> result;
+    result.merged.reserve(std::max(mod1.size(), mod2.size()));
+    size_t pos = 0;
+    auto apply = [&](const DiffHunk& hunk, std::span<const T> source) {
+        result.merged.insert(result.merged.end(), base.begin() + pos,
+                             base.begin() + hunk.baseBegin);
+        result.merged.insert(result.merged.end(), source.begin() + hunk.modBegin,
+                             source.begin() + hunk.modEnd);
+        pos = hunk.baseEnd;
+    };
+
+    // each list is ordered and disjoint, so a hunk can only collide with the next of the other
+    size_t i = 0;
+    size_t j = 0;
+    while (i < hunks1.size() || j < hunks2.size()) {
+        if (i < hunks1.size() && j < hunks2.size()) {
+            if (sameChange(hunks1[i], hunks2[j])) {
+                apply(hunks1[i++], mod1);
+                j++;
+                result.mod1Hunks++;
+                result.mod2Hunks++;
+                continue;
+            }
+            if (Overlaps(hunks1[i], hunks2[j])) {
+                result.merged.clear();
+                return result;
+            }
+        }
+
+        if (j == hunks2.size() || (i < hunks1.size() && before(hunks1[i], hunks2[j]))) {
+            apply(hunks1[i++], mod1);
+            result.mod1Hunks++;
+        } else {
+            apply(hunks2[j++], mod2);
+            result.mod2Hunks++;
+        }
+    }
+    result.merged.insert(result.merged.end(), base.begin() + pos, base.end());
+    result.clean = true;
+    return result;
+}
+
+} // namespace FileHelper
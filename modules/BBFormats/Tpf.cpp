@@ -3,116 +3,109 @@
 
 #include <vector>
 
+#include "MergeJoin.h"
 #include "Tpf.h"
-#include "modules/ModMerger.h"
+#include "modules/MergeEngine.h"
 
 namespace fs = std::filesystem;
 
 namespace FileHelper {
 
-Tpf::Tpf(std::vector<char>& data, ModMerger* parent) : BBFormat(parent) {
+Tpf::Tpf(std::span<const char> data, MergeEngine* parent) : BBFormat(parent) {
     bigEndian = false;
     ReadTpf(data);
 }
 
-bool Tpf::ReadTpf(std::vector<char>& data) {
+bool Tpf::ReadTpf(std::span<const char> data) {
     if (data.empty()) {
         sendLog("ERROR: empty tpf input data", LogFormat::BoldRed);
         return false;
     }
 
-    istream = std::make_unique<std::stringstream>(std::string(data.begin(), data.end()),
-                                                  std::ios_base::in | std::ios_base::binary);
+    reader = SpanReader(data);
 
-    int intBuffer = 0;
     std::string strBuffer;
 
-    GetStr(strBuffer, 4);
-    debugLog("MAGIC: " + strBuffer);
+    Header header;
+    ReadStruct(header);
+
+    strBuffer = std::string(header.magic, 4);
+    debugLog("MAGIC: {}", strBuffer);
 
     if (!strBuffer.contains("TPF")) {
         sendLog("ERROR invalid tpf header: " + strBuffer, LogFormat::BoldRed);
         return false;
     }
 
-    istream->ignore(4); // Data length
-
-    int fileCount = 0;
-    GetInt32(fileCount);
-    debugLog("fileCount: " + std::to_string(fileCount));
+    int fileCount = header.fileCount;
+    debugLog("fileCount: {}", fileCount);
 
-    GetByte(intBuffer);
-    if (intBuffer != 4) {
+    if (header.platform != 4) {
         sendLog("ERROR: tpf data not for PS4 platform", LogFormat::BoldRed);
         return false;
     }
 
-    GetByte(flag2);
-    debugLog("flag2: " + std::to_string(flag2)); // assert 0/1/2/3?
+    flag2 = header.flag2;
+    debugLog("flag2: {}", flag2); // assert 0/1/2/3?
 
-    GetByte(encoding);
-    debugLog("encoding: " + std::to_string(encoding)); // assert 0/1/2?
-
-    istream->ignore(1); // or assert 0
+    encoding = header.encoding;
+    debugLog("encoding: {}", encoding); // assert 0/1/2?
 
     for (int i = 0; i < fileCount; i++) {
         Texture tex;
-        uint fileOffset;
-        GetInt32(fileOffset);
-        debugLog("fileOffset: " + std::to_string(fileOffset));
+        TextureEntry entry;
+        ReadStruct(entry);
+
+        uint fileOffset = entry.fileOffset;
+        debugLog("fileOffset: {}", fileOffset);
 
-        uint fileSize;
-        GetInt32(fileSize);
-        debugLog("fileSize: " + std::to_string(fileSize));
+        uint fileSize = entry.fileSize;
+        debugLog("fileSize: {}", fileSize);
 
-        GetByte(tex.format);
-        debugLog("tex.format: " + std::to_string(tex.format));
+        tex.format = entry.format;
+        debugLog("tex.format: {}", tex.format);
 
-        GetByte(intBuffer);
-        debugLog("type: " + std::to_string(intBuffer));
-        tex.type = static_cast<TexType>(intBuffer);
+        tex.type = static_cast<TexType>(entry.type);
+        debugLog("type: {}", entry.type);
 
-        GetByte(tex.mipmaps);
-        debugLog("mipmaps: " + std::to_string(tex.mipmaps));
+        tex.mipmaps = entry.mipmaps;
+        debugLog("mipmaps: {}", tex.mipmaps);
 
-        GetByte(tex.Flags1);
-        debugLog("flags1: " + std::to_string(tex.Flags1)); // assert (0/1/2/3/0x80)?
+        tex.Flags1 = entry.flags1;
+        debugLog("flags1: {}", tex.Flags1); // assert (0/1/2/3/0x80)?
 
-        GetInt16(tex.header.width);
-        debugLog("tex.header.width: " + std::to_string(tex.header.width));
-        GetInt16(tex.header.height);
-        debugLog("tex.header.height: " + std::to_string(tex.header.height));
+        tex.header.width = entry.width;
+        debugLog("tex.header.width: {}", tex.header.width);
+        tex.header.height = entry.height;
+        debugLog("tex.header.height: {}", tex.header.height);
 
         // may not be needed?
         try {
             tex.header.dxgiFormat = formatMap.at(tex.format);
         } catch (const std::out_of_range& e) {
-            debugLog("Invalid dxgi format type: " + std::to_string(tex.header.dxgiFormat));
+            debugLog("Invalid dxgi format type: {}", static_cast<int>(tex.header.dxgiFormat));
             tex.header.dxgiFormat = DxgiFormat::UNKNOWN;
         }
 
-        GetInt32(tex.header.textureCount);
-        debugLog("textureCount: " + std::to_string(tex.header.textureCount));
-        GetInt32(tex.header.unk2); // assert 0/0x9/0xD?
-        debugLog("tex.header.unk2: " + std::to_string(tex.header.unk2));
+        tex.header.textureCount = entry.textureCount;
+        debugLog("textureCount: {}", tex.header.textureCount);
+        tex.header.unk2 = entry.unk2; // assert 0/0x9/0xD?
+        debugLog("tex.header.unk2: {}", tex.header.unk2);
 
-        uint nameOffset;
-        GetInt32(nameOffset);
-        debugLog("nameOffset: " + std::to_string(nameOffset));
+        uint nameOffset = entry.nameOffset;
+        debugLog("nameOffset: {}", nameOffset);
 
-        int hasFloatStruct;
-        GetInt32(hasFloatStruct); // assert 0/1 ==1?
-        debugLog("hasFloatStruct: " + std::to_string(hasFloatStruct));
+        int hasFloatStruct = entry.hasFloatStruct; // assert 0/1 ==1?
+        debugLog("hasFloatStruct: {}", hasFloatStruct);
 
-        GetInt32(intBuffer);
-        debugLog("dxgiFormat (mapped): " + std::to_string(intBuffer));
-        tex.header.dxgiFormat = static_cast<DxgiFormat>(intBuffer);
+        debugLog("dxgiFormat (mapped): {}", entry.dxgiFormat);
+        tex.header.dxgiFormat = static_cast<DxgiFormat>(entry.dxgiFormat);
 
         if (hasFloatStruct != 0) {
             sendLog("ERROR: unexpected texture fstruct", LogFormat::BoldRed);
             // not sure if needed, but just in case
             GetInt32(tex.fstruct.unk00);
-            debugLog("tex.fstruct.unk00: " + std::to_string(tex.fstruct.unk00));
+            debugLog("tex.fstruct.unk00: {}", tex.fstruct.unk00);
 
             int length;
             GetInt32(length);
@@ -129,9 +122,9 @@ bool Tpf::ReadTpf(std::vector<char>& data) {
             }
         }
 
-        StepIn(fileOffset, *istream);
+        StepIn(fileOffset, reader);
         GetBytes(tex.data, fileSize);
-        StepOut(*istream);
+        StepOut(reader);
 
         if (tex.Flags1 == 2 || tex.Flags1 == 3) {
             // decompress, should not be encountered in BB
@@ -141,10 +134,10 @@ bool Tpf::ReadTpf(std::vector<char>& data) {
         }
 
         if (encoding == 1) {
-            StepIn(nameOffset, *istream);
+            StepIn(nameOffset, reader);
             tex.name = ReadUtf16String();
-            debugLog("tex.name: " + tex.name);
-            StepOut(*istream);
+            debugLog("tex.name: {}", tex.name);
+            StepOut(reader);
         } else if (encoding == 2 || encoding == 3) {
             // should not encounter this in BB, GetShiftJIS(nameOffset);
             sendLog("ERROR unexpected name encoding: " + std::to_string(encoding),
@@ -155,29 +148,38 @@ bool Tpf::ReadTpf(std::vector<char>& data) {
         textures.push_back(tex);
     }
 
-    istream.reset();
+    reader.Reset();
     return true;
 }
 
 bool Tpf::RepackTpf(std::vector<char>& outputData) {
-    ostream = std::make_unique<std::stringstream>(std::ios_base::out | std::ios_base::binary);
-    std::string strBuffer;
+    // layout pass: header, entry table, names and padded texture data
+    size_t layoutSize = sizeof(Header) + textures.size() * sizeof(TextureEntry) + 0x10;
+    for (const auto& texture : textures) {
+        layoutSize += (texture.name.size() + 1) * 2 + texture.data.size() + 0x4;
+    }
+    writer = SpanWriter(layoutSize);
 
-    strBuffer = "TPF";
-    WriteStr(strBuffer, 4);
-    ReserveBytes("DataSize", 4);
-    WriteInt32(static_cast<int>(textures.size()));
-    WriteByte(4);
-    WriteByte(flag2);
-    WriteByte(encoding);
-    WriteByte(0);
+    struct TextureSlots {
+        Reserved<int32_t> fileOffset;
+        Reserved<int32_t> fileSize;
+        Reserved<int32_t> nameOffset;
+    };
+    std::vector<TextureSlots> textureSlots(textures.size());
 
-    for (int i = 0; i < textures.size(); i++) {
-        strBuffer = "FileData" + std::to_string(i);
-        ReserveBytes(strBuffer, 4);
+    Header header{};
+    std::memcpy(header.magic, "TPF", 4);
+    header.fileCount = static_cast<int32_t>(textures.size());
+    header.platform = 4;
+    header.flag2 = flag2;
+    header.encoding = encoding;
 
-        strBuffer = "FileSize" + std::to_string(i);
-        ReserveBytes(strBuffer, 4);
+    // data size is filled in after the texture data is written
+    WriteStruct(header);
+
+    for (int i = 0; i < textures.size(); i++) {
+        textureSlots[i].fileOffset = ReserveInt32();
+        textureSlots[i].fileSize = ReserveInt32();
 
         WriteByte(textures[i].format);
         WriteByte(static_cast<int>(textures[i].type));
@@ -190,8 +192,7 @@ bool Tpf::RepackTpf(std::vector<char>& outputData) {
         WriteInt32(textures[i].header.textureCount);
         WriteInt32(textures[i].header.unk2);
 
-        strBuffer = "FileName" + std::to_string(i);
-        ReserveBytes(strBuffer, 4);
+        textureSlots[i].nameOffset = ReserveInt32();
 
         int fstruct;
         fstruct = textures[i].fstruct.values.size() == 0 ? 0 : 1;
@@ -207,14 +208,13 @@ bool Tpf::RepackTpf(std::vector<char>& outputData) {
 
             for (int j = 0; j < textures[i].fstruct.values.size(); j++) {
                 float f = textures[i].fstruct.values[j];
-                ostream->write(reinterpret_cast<const char*>(&f), 4);
+                writer.Write(&f, 4);
             }
         }
     }
 
     for (int i = 0; i < textures.size(); i++) {
-        strBuffer = "FileName" + std::to_string(i);
-        FillReservedInt32(strBuffer, static_cast<uint>(ostream->tellp()));
+        FillReservedInt32(textureSlots[i].nameOffset, static_cast<int>(writer.Tell()));
 
         if (encoding == 1) {
             WriteUtf16String(textures[i].name);
@@ -229,34 +229,31 @@ bool Tpf::RepackTpf(std::vector<char>& outputData) {
     int texturePaddingSize = 0x4;
     PadStream(0x10);
 
-    std::streamoff dataStart = ostream->tellp();
+    size_t dataStart = writer.Tell();
     uint textureDataSize = 0;
 
     for (int i = 0; i < textures.size(); i++) {
         if (textures[i].data.size() > 0)
             PadStream(texturePaddingSize);
 
-        strBuffer = "FileData" + std::to_string(i);
-        FillReservedInt32(strBuffer, static_cast<uint>(ostream->tellp()));
+        FillReservedInt32(textureSlots[i].fileOffset, static_cast<int>(writer.Tell()));
 
         if (textures[i].Flags1 == 2 || textures[i].Flags1 == 3) {
             sendLog("ERROR: Encountered unexpected compressed texture format", LogFormat::BoldRed);
             return false;
         }
 
-        strBuffer = "FileSize" + std::to_string(i);
-        FillReservedInt32(strBuffer, static_cast<int>(textures[i].data.size()));
+        FillReservedInt32(textureSlots[i].fileSize, static_cast<int>(textures[i].data.size()));
 
-        ostream->write(textures[i].data.data(), textures[i].data.size());
+        writer.Write(textures[i].data.data(), textures[i].data.size());
 
         textureDataSize += textures[i].data.size();
     }
 
-    FillReservedInt32("DataSize", static_cast<int>(ostream->tellp() - dataStart));
+    header.dataSize = static_cast<int32_t>(writer.Tell() - dataStart);
+    PatchStruct(0, header);
 
-    auto& stringStream = static_cast<std::stringstream&>(*ostream);
-    std::string str = stringStream.str();
-    outputData = std::vector<char>(str.begin(), str.end());
+    outputData = writer.Take();
 
     /* tests
     std::ofstream outFile("test.tpf", std::ios::out | std::ios::binary);
@@ -266,95 +263,67 @@ bool Tpf::RepackTpf(std::vector<char>& outputData) {
     }
     */
 
-    ostream.reset();
     sendLog("TPF Repacking complete\n");
     return true;
 }
 
-bool Tpf::HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data) {
-    Tpf mod1Tpf = Tpf(mod1Data, merger);
-    const std::vector<Tpf::Texture> mod1Textures = mod1Tpf.textures;
+bool Tpf::HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data) {
+    const Tpf mod1Tpf = Tpf(mod1Data, merger);
+    const Tpf mod2Tpf = Tpf(mod2Data, merger);
 
-    Tpf mod2Tpf = Tpf(mod2Data, merger);
-    const std::vector<Tpf::Texture> mod2Textures = mod2Tpf.textures;
+    const MergeJoinResult merge =
+        MergeJoin(textures, mod1Tpf.textures, mod2Tpf.textures, &Texture::name,
+                  [](const Texture& a, const Texture& b) { return a.data == b.data; });
 
-    for (int i = 0; i < textures.size(); i++) {
-        bool mod1Modified = false;
-        bool mod2Modified = false;
-
-        std::optional<Tpf::Texture> mod1tex = GetSameTexture(textures[i].name, mod1Textures);
-        std::optional<Tpf::Texture> mod2tex = GetSameTexture(textures[i].name, mod2Textures);
-
-        mod1Modified = mod1tex && (mod1tex->data != textures[i].data);
-        mod2Modified = mod2tex && (mod2tex->data != textures[i].data);
-
-        if (mod1Modified && mod2Modified) {
-            if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                QMetaObject::invokeMethod(merger, &ModMerger::OpenPriorityDialog,
-                                          Qt::BlockingQueuedConnection);
-                if (merger->GetModPriority() == ModMerger::ModPriority::NotSet) {
-                    return false;
-                }
+    for (const MergeStep& step : merge.steps) {
+        const Texture* mod1tex =
+            step.mod1 != MergeStep::none ? &mod1Tpf.textures[step.mod1] : nullptr;
+        const Texture* mod2tex =
+            step.mod2 != MergeStep::none ? &mod2Tpf.textures[step.mod2] : nullptr;
+        Texture* texture = step.base != MergeStep::none ? &textures[step.base] : nullptr;
+
+        switch (step.action) {
+        case MergeAction::Conflict:
+            if (merger->RequestPriority() == MergeEngine::ModPriority::NotSet) {
+                return false;
             }
 
-            if (merger->GetModPriority() == ModMerger::ModPriority::Mod1) {
-                textures[i] = mod1tex.value();
-                sendLog("Unresolvable conflict, using texture " + mod1tex.value().name +
+            if (!texture) {
+                texture = &textures.emplace_back();
+            }
+            if (merger->GetModPriority() == MergeEngine::ModPriority::Mod1) {
+                *texture = *mod1tex;
+                sendLog("Unresolvable conflict, using texture " + mod1tex->name +
                             " from prioritized mod: " + merger->Mod1Name(),
                         LogFormat::Yellow);
-            } else if (merger->GetModPriority() == ModMerger::ModPriority::Mod2) {
-                textures[i] = mod2tex.value();
-                sendLog("Unresolvable conflict, using texture " + mod2tex.value().name +
+            } else if (merger->GetModPriority() == MergeEngine::ModPriority::Mod2) {
+                *texture = *mod2tex;
+                sendLog("Unresolvable conflict, using texture " + mod2tex->name +
                             " from prioritized mod: " + merger->Mod2Name(),
                         LogFormat::Yellow);
             }
+            break;
+        case MergeAction::TakeMod1:
+            *texture = *mod1tex;
+            sendLog("Texture data merged: " + mod1tex->name + " from mod: " + merger->Mod1Name());
+            break;
+        case MergeAction::TakeMod2:
+            *texture = *mod2tex;
+            sendLog("Texture data merged: " + mod2tex->name + " from mod: " + merger->Mod2Name());
+            break;
+        case MergeAction::AddMod1:
+        case MergeAction::AddMod2: {
+            const Texture& added = step.action == MergeAction::AddMod1 ? *mod1tex : *mod2tex;
+            textures.push_back(added);
+            sendLog("Texture data added: " + added.name);
+            break;
         }
-
-        if (mod1Modified && !mod2Modified) {
-            textures[i] = mod1tex.value();
-            sendLog("Texture data merged: " + mod1tex.value().name +
-                    " from mod: " + merger->Mod1Name());
-        } else if (mod2Modified && !mod1Modified) {
-            textures[i] = mod2tex.value();
-            sendLog("Texture data merged: " + mod2tex.value().name +
-                    " from mod: " + merger->Mod2Name());
-        }
-    }
-
-    std::unordered_set<std::string> existingNames;
-    for (const auto& tex : textures) {
-        existingNames.insert(tex.name);
-    }
-
-    for (const auto& tex : mod1Textures) {
-        if (existingNames.find(tex.name) == existingNames.end()) {
-            textures.push_back(tex);
-            sendLog("Texture data added: " + tex.name);
-        }
-    }
-
-    for (const auto& tex : mod2Textures) {
-        if (existingNames.find(tex.name) == existingNames.end()) {
-            textures.push_back(tex);
-            sendLog("Texture data added: " + tex.name);
         }
     }
 
     return true;
 }
 
-std::optional<Tpf::Texture> Tpf::GetSameTexture(const std::string& name,
-                                                const std::vector<Tpf::Texture>& otherTextures) {
-    std::optional<Tpf::Texture> tex = std::nullopt;
-    for (const auto& texture : otherTextures) {
-        if (texture.name == name) {
-            return tex.emplace(texture);
-        }
-    }
-
-    return tex;
-}
-
 Tpf::~Tpf() {}
 
 } // namespace FileHelper
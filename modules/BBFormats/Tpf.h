@@ -13,8 +13,46 @@ class Tpf : public BBFormat {
 private:
     int platform = 4; // PS4
 
+    struct Header {
+        char magic[4];
+        int32_t dataSize;
+        int32_t fileCount;
+        uint8_t platform;
+        uint8_t flag2;
+        uint8_t encoding;
+        uint8_t pad0F;
+
+        static constexpr auto Fields(auto& h) {
+            return std::tie(h.dataSize, h.fileCount);
+        }
+    };
+    static_assert(sizeof(Header) == 0x10);
+
+    // PS4 texture entry, an optional float struct follows when hasFloatStruct is set
+    struct TextureEntry {
+        uint32_t fileOffset;
+        uint32_t fileSize;
+        uint8_t format;
+        uint8_t type;
+        uint8_t mipmaps;
+        uint8_t flags1;
+        uint16_t width;
+        uint16_t height;
+        int32_t textureCount;
+        int32_t unk2;
+        uint32_t nameOffset;
+        int32_t hasFloatStruct;
+        int32_t dxgiFormat;
+
+        static constexpr auto Fields(auto& e) {
+            return std::tie(e.fileOffset, e.fileSize, e.width, e.height, e.textureCount, e.unk2,
+                            e.nameOffset, e.hasFloatStruct, e.dxgiFormat);
+        }
+    };
+    static_assert(sizeof(TextureEntry) == 0x24);
+
 public:
-    explicit Tpf(std::vector<char>& data, ModMerger* parent);
+    explicit Tpf(std::span<const char> data, MergeEngine* parent);
     ~Tpf() override;
 
     enum class TexType : int { Texture = 0, Cubemap = 1, Volume = 2, TextureArray = 3 };
@@ -179,12 +217,9 @@ public:
         std::vector<char> data = {};
     };
 
-    bool ReadTpf(std::vector<char>& data);
+    bool ReadTpf(std::span<const char> data);
     bool RepackTpf(std::vector<char>& outputData);
-    bool HandleConflict(std::vector<char>& mod1Data, std::vector<char>& mod2Data);
-
-    std::optional<Tpf::Texture> GetSameTexture(const std::string& name,
-                                               const std::vector<Tpf::Texture>& otherTex);
+    bool HandleConflict(std::span<const char> mod1Data, std::span<const char> mod2Data);
 
     std::vector<Texture> textures;
     int flag2;
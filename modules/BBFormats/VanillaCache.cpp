@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <thread>
+#include <zstd.h>
+
+#include "VanillaCache.h"
+#include "modules/Checksum.h"
+#include "modules/Common.h"
+
+namespace fs = std::filesystem;
+
+namespace FileHelper {
+
+VanillaCache::VanillaCache(fs::path folder, uint64_t maxBytes)
+    : folder(std::move(folder)), maxBytes(maxBytes) {}
+
+bool VanillaCache::Enabled() const {
+    return maxBytes > 0;
+}
+
+VanillaCache::Key VanillaCache::MakeKey(const fs::path& source, std::span<const char> compressed) {
+    std::error_code ec;
+    std::string identity = Common::PathToU8(source);
+    uint64_t size = fs::file_size(source, ec);
+    int64_t mtime = fs::last_write_time(source, ec).time_since_epoch().count();
+
+    identity.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    identity.append(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+    return Key{Checksum::Hash64(identity, Checksum::Hash64(compressed))};
+}
+
+fs::path VanillaCache::EntryPath(Key key) const {
+    return folder / std::format("{:016x}.zst", key.value);
+}
+
+bool VanillaCache::Load(Key key, std::vector<char>& output) {
+    if (!Enabled()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path entry = EntryPath(key);
+    uint64_t entrySize = fs::file_size(entry, ec);
+    if (ec) {
+        return false;
+    }
+
+    std::vector<char> compressed(entrySize);
+    std::ifstream inFile(entry, std::ios::binary);
+    if (!inFile.read(compressed.data(), compressed.size())) {
+        return false;
+    }
+
+    // the handle is closed before any remove, windows can't delete an open file. an entry can't
+    // be larger than the whole cache, a header claiming more is damaged
+    unsigned long long contentSize = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+        contentSize > maxBytes) {
+        inFile.close();
+        fs::remove(entry, ec);
+        return false;
+    }
+
+    // a damaged entry fails the frame checksum and is dropped
+    output.resize(contentSize);
+    size_t result =
+        ZSTD_decompress(output.data(), output.size(), compressed.data(), compressed.size());
+    if (ZSTD_isError(result) || result != contentSize) {
+        output.clear();
+        inFile.close();
+        fs::remove(entry, ec);
+        return false;
+    }
+
+    // mtime doubles as the lru timestamp
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool VanillaCache::Store(Key key, std::span<const char> data) {
+    // Load rejects entries bigger than the budget, storing one would only be wasted work
+    if (!Enabled() || data.size() > maxBytes) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(folder, ec);
+
+    std::vector<char> compressed(ZSTD_compressBound(data.size()));
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 3);
+    ZSTD_CCtx_setParameter(context, ZSTD_c_checksumFlag, 1);
+    size_t compressedSize = ZSTD_compress2(context, compressed.data(), compressed.size(),
+                                           data.data(), data.size());
+    ZSTD_freeCCtx(context);
+    if (ZSTD_isError(compressedSize)) {
+        return false;
+    }
+
+    // written under a temporary name so a concurrent reader never sees a partial entry
+    fs::path entry = EntryPath(key);
+    fs::path partial = entry;
+    partial += std::format(".{:x}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    std::ofstream outFile(partial, std::ios::binary | std::ios::trunc);
+    outFile.write(compressed.data(), compressedSize);
+    outFile.close();
+    if (!outFile) {
+        fs::remove(partial, ec);
+        return false;
+    }
+
+    fs::rename(partial, entry, ec);
+    if (ec) {
+        fs::remove(partial, ec);
+        return false;
+    }
+
+    Evict();
+    return true;
+}
+
+void VanillaCache::Evict() {
+    std::lock_guard lock(evictMutex);
+
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type lastUse;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    for (const auto& file : fs::directory_iterator(folder, ec)) {
+        if (!file.is_regular_file(ec) || file.path().extension() != ".zst") {
+            continue;
+        }
+
+        Entry entry{file.path(), file.file_size(ec), file.last_write_time(ec)};
+        totalSize += entry.size;
+        entries.push_back(std::move(entry));
+    }
+
+    if (totalSize <= maxBytes) {
+        return;
+    }
+
+    std::ranges::sort(entries, {}, &Entry::lastUse);
+    for (const Entry& entry : entries) {
+        if (totalSize <= maxBytes) {
+            break;
+        }
+
+        if (fs::remove(entry.path, ec)) {
+            totalSize -= entry.size;
+        }
+    }
+}
+
+} // namespace FileHelper
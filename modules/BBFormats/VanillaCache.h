@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace FileHelper {
+
+// on disk cache of decompressed game files, stored zstd compressed. entries are keyed on the
+// resolved source path, its size and mtime and a hash of the compressed bytes, so an updated or
+// replaced game file never hits a stale entry. least recently used entries are evicted once the
+// folder grows past the size cap
+class VanillaCache {
+public:
+    explicit VanillaCache(std::filesystem::path folder, uint64_t maxBytes);
+
+    struct Key {
+        uint64_t value = 0;
+    };
+
+    static Key MakeKey(const std::filesystem::path& source, std::span<const char> compressed);
+
+    bool Load(Key key, std::vector<char>& output);
+    bool Store(Key key, std::span<const char> data);
+    bool Enabled() const;
+
+private:
+    std::filesystem::path EntryPath(Key key) const;
+    void Evict();
+
+    std::filesystem::path folder;
+    uint64_t maxBytes;
+    std::mutex evictMutex;
+};
+
+} // namespace FileHelper
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+// lock-free hand-off of batches from any number of threads to a single consumer. producers push
+// whole batches, the consumer takes everything queued so far in push order with one exchange, so
+// there is no per item pop and nothing for producers to contend on but the head pointer
+template <typename T>
+class BatchQueue {
+public:
+    BatchQueue() = default;
+    BatchQueue(const BatchQueue&) = delete;
+    BatchQueue& operator=(const BatchQueue&) = delete;
+
+    ~BatchQueue() {
+        Drain();
+    }
+
+    // true when the queue was empty before, i.e. the consumer may need waking
+    bool Push(std::vector<T> items) {
+        // the node belongs to the consumer once it is published, only the local copy of the old
+        // head is read after that
+        Node* node = new Node{std::move(items), nullptr};
+        Node* previous = head.load(std::memory_order_relaxed);
+        do {
+            node->next = previous;
+        } while (!head.compare_exchange_weak(previous, node, std::memory_order_release,
+                                             std::memory_order_relaxed));
+        return previous == nullptr;
+    }
+
+    std::vector<T> Drain() {
+        // the chain is newest first, turned around before it is read out
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        Node* oldest = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+
+        std::vector<T> items;
+        while (oldest) {
+            Node* next = oldest->next;
+            if (items.empty()) {
+                items = std::move(oldest->items);
+            } else {
+                items.insert(items.end(), std::make_move_iterator(oldest->items.begin()),
+                             std::make_move_iterator(oldest->items.end()));
+            }
+            delete oldest;
+            oldest = next;
+        }
+        return items;
+    }
+
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        std::vector<T> items;
+        Node* next;
+    };
+
+    std::atomic<Node*> head = nullptr;
+};
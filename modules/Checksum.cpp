@@ -0,0 +1,263 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <cryptopp/sha.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+#include "Checksum.h"
+
+namespace {
+
+constexpr uint32_t adlerBase = 65521;
+// largest n such that 255n(n+1)/2 + (n+1)(base-1) still fits in 32 bits, so the modulo can be
+// deferred that many bytes
+constexpr size_t adlerNmax = 5552;
+
+constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+template <typename T>
+T ReadLE(const uint8_t* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+uint64_t HashRound(uint64_t acc, uint64_t input) {
+    acc += input * prime64_2;
+    acc = std::rotl(acc, 31);
+    return acc * prime64_1;
+}
+
+uint64_t HashMergeRound(uint64_t acc, uint64_t value) {
+    acc ^= HashRound(0, value);
+    return acc * prime64_1 + prime64_4;
+}
+
+void Adler32Tail(const uint8_t* data, size_t length, uint32_t& sum1, uint32_t& sum2) {
+    while (length > 0) {
+        size_t run = std::min(length, adlerNmax);
+        length -= run;
+        for (; run > 0; --run) {
+            sum1 += *data++;
+            sum2 += sum1;
+        }
+        sum1 %= adlerBase;
+        sum2 %= adlerBase;
+    }
+}
+
+#if defined(__AVX2__)
+
+// 32 byte blocks: sad sums the bytes for sum1, maddubs weighs them 32..1 for sum2 and the
+// running sum1 before each block is folded in once per nmax run
+void Adler32Blocks(const uint8_t*& data, size_t& length, uint32_t& sum1, uint32_t& sum2) {
+    constexpr size_t blockSize = 32;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights =
+        _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15,
+                         14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+
+    while (length >= blockSize) {
+        size_t blocks = std::min(length, adlerNmax) / blockSize;
+        length -= blocks * blockSize;
+
+        __m256i vsum1 = zero;
+        __m256i vsum2 = zero;
+        __m256i vprev = zero;
+        uint64_t block2 = static_cast<uint64_t>(sum1) * blocks * blockSize;
+
+        for (size_t i = 0; i < blocks; ++i) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            vprev = _mm256_add_epi32(vprev, vsum1);
+            vsum1 = _mm256_add_epi32(vsum1, _mm256_sad_epu8(bytes, zero));
+            vsum2 = _mm256_add_epi32(vsum2,
+                                     _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+            data += blockSize;
+        }
+
+        alignas(32) uint32_t lanes1[8];
+        alignas(32) uint32_t lanes2[8];
+        alignas(32) uint32_t lanesPrev[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes1), vsum1);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes2), vsum2);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanesPrev), vprev);
+
+        uint64_t total1 = 0;
+        uint64_t total2 = 0;
+        uint64_t totalPrev = 0;
+        for (int lane = 0; lane < 8; ++lane) {
+            total1 += lanes1[lane];
+            total2 += lanes2[lane];
+            totalPrev += lanesPrev[lane];
+        }
+
+        sum2 = static_cast<uint32_t>((sum2 + block2 + totalPrev * blockSize + total2) % adlerBase);
+        sum1 = static_cast<uint32_t>((sum1 + total1) % adlerBase);
+    }
+}
+
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+
+// same scheme as the avx2 path with 16 byte blocks and widening pairwise adds
+void Adler32Blocks(const uint8_t*& data, size_t& length, uint32_t& sum1, uint32_t& sum2) {
+    constexpr size_t blockSize = 16;
+    static constexpr uint8_t weightTable[16] = {16, 15, 14, 13, 12, 11, 10, 9,
+                                                8,  7,  6,  5,  4,  3,  2,  1};
+    const uint8x16_t weights = vld1q_u8(weightTable);
+
+    while (length >= blockSize) {
+        size_t blocks = std::min(length, adlerNmax) / blockSize;
+        length -= blocks * blockSize;
+
+        uint32x4_t vsum1 = vdupq_n_u32(0);
+        uint32x4_t vsum2 = vdupq_n_u32(0);
+        uint32x4_t vprev = vdupq_n_u32(0);
+        uint64_t block2 = static_cast<uint64_t>(sum1) * blocks * blockSize;
+
+        for (size_t i = 0; i < blocks; ++i) {
+            uint8x16_t bytes = vld1q_u8(data);
+            vprev = vaddq_u32(vprev, vsum1);
+            vsum1 = vpadalq_u16(vsum1, vpaddlq_u8(bytes));
+            vsum2 = vpadalq_u16(vsum2, vmull_u8(vget_low_u8(bytes), vget_low_u8(weights)));
+            vsum2 = vpadalq_u16(vsum2, vmull_u8(vget_high_u8(bytes), vget_high_u8(weights)));
+            data += blockSize;
+        }
+
+        uint64_t total1 = vaddlvq_u32(vsum1);
+        uint64_t total2 = vaddlvq_u32(vsum2);
+        uint64_t totalPrev = vaddlvq_u32(vprev);
+
+        sum2 = static_cast<uint32_t>((sum2 + block2 + totalPrev * blockSize + total2) % adlerBase);
+        sum1 = static_cast<uint32_t>((sum1 + total1) % adlerBase);
+    }
+}
+
+#else
+
+void Adler32Blocks(const uint8_t*&, size_t&, uint32_t&, uint32_t&) {}
+
+#endif
+
+} // namespace
+
+namespace Checksum {
+
+uint32_t Adler32(std::span<const char> data, uint32_t adler) {
+    uint32_t sum1 = adler & 0xFFFF;
+    uint32_t sum2 = adler >> 16;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t length = data.size();
+
+    Adler32Blocks(bytes, length, sum1, sum2);
+    Adler32Tail(bytes, length, sum1, sum2);
+    return (sum2 << 16) | sum1;
+}
+
+uint32_t Adler32Scalar(std::span<const char> data, uint32_t adler) {
+    uint32_t sum1 = adler & 0xFFFF;
+    uint32_t sum2 = adler >> 16;
+    Adler32Tail(reinterpret_cast<const uint8_t*>(data.data()), data.size(), sum1, sum2);
+    return (sum2 << 16) | sum1;
+}
+
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+    uint32_t rem = static_cast<uint32_t>(length2 % adlerBase);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (rem * sum1) % adlerBase;
+    sum1 += (adler2 & 0xFFFF) + adlerBase - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + adlerBase - rem;
+    if (sum1 >= adlerBase) {
+        sum1 -= adlerBase;
+    }
+    if (sum1 >= adlerBase) {
+        sum1 -= adlerBase;
+    }
+    if (sum2 >= adlerBase * 2) {
+        sum2 -= adlerBase * 2;
+    }
+    if (sum2 >= adlerBase) {
+        sum2 -= adlerBase;
+    }
+    return (sum2 << 16) | sum1;
+}
+
+uint64_t Hash64(std::span<const char> data, uint64_t seed) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    const uint8_t* end = bytes + data.size();
+    uint64_t hash;
+
+    if (data.size() >= 32) {
+        uint64_t acc1 = seed + prime64_1 + prime64_2;
+        uint64_t acc2 = seed + prime64_2;
+        uint64_t acc3 = seed;
+        uint64_t acc4 = seed - prime64_1;
+
+        do {
+            acc1 = HashRound(acc1, ReadLE<uint64_t>(bytes));
+            acc2 = HashRound(acc2, ReadLE<uint64_t>(bytes + 8));
+            acc3 = HashRound(acc3, ReadLE<uint64_t>(bytes + 16));
+            acc4 = HashRound(acc4, ReadLE<uint64_t>(bytes + 24));
+            bytes += 32;
+        } while (end - bytes >= 32);
+
+        hash = std::rotl(acc1, 1) + std::rotl(acc2, 7) + std::rotl(acc3, 12) + std::rotl(acc4, 18);
+        hash = HashMergeRound(hash, acc1);
+        hash = HashMergeRound(hash, acc2);
+        hash = HashMergeRound(hash, acc3);
+        hash = HashMergeRound(hash, acc4);
+    } else {
+        hash = seed + prime64_5;
+    }
+
+    hash += data.size();
+
+    for (; end - bytes >= 8; bytes += 8) {
+        hash ^= HashRound(0, ReadLE<uint64_t>(bytes));
+        hash = std::rotl(hash, 27) * prime64_1 + prime64_4;
+    }
+
+    if (end - bytes >= 4) {
+        hash ^= static_cast<uint64_t>(ReadLE<uint32_t>(bytes)) * prime64_1;
+        hash = std::rotl(hash, 23) * prime64_2 + prime64_3;
+        bytes += 4;
+    }
+
+    for (; bytes < end; ++bytes) {
+        hash ^= *bytes * prime64_5;
+        hash = std::rotl(hash, 11) * prime64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime64_2;
+    hash ^= hash >> 29;
+    hash *= prime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+Sha256Digest Sha256(std::span<const char> data) {
+    // cryptopp picks the sha extensions at runtime when the cpu has them
+    Sha256Digest digest;
+    CryptoPP::SHA256().CalculateDigest(digest.data(),
+                                       reinterpret_cast<const CryptoPP::byte*>(data.data()),
+                                       data.size());
+    return digest;
+}
+
+} // namespace Checksum
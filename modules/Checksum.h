@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace Checksum {
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+// zlib compatible adler32, continues from a previous value when given one
+uint32_t Adler32(std::span<const char> data, uint32_t adler = 1);
+
+// adler32 of two concatenated blocks from the adler32 of each and the length of the second
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2);
+
+// fast non cryptographic hash (xxh64), for content keys and change detection
+uint64_t Hash64(std::span<const char> data, uint64_t seed = 0);
+
+Sha256Digest Sha256(std::span<const char> data);
+
+// scalar reference path, kept exported so the simd path can be benchmarked against it
+uint32_t Adler32Scalar(std::span<const char> data, uint32_t adler = 1);
+
+} // namespace Checksum
@@ -1,9 +1,13 @@
 // SPDX-FileCopyrightText: Copyright 2024 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <atomic>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <thread>
 
+#include "BatchQueue.h"
 #include "Common.h"
 #include "Log.h"
 
@@ -17,17 +21,160 @@ const std::map<Log::Type, std::string> typeMap = {
     {Log::Type::Critical, "Critical"},
 };
 
+namespace {
+
+// log.txt is moved to log.1.txt once it grows past this, older ones shift up to keptLogs
+constexpr uintmax_t maxLogBytes = 4 << 20;
+constexpr int keptLogs = 2;
+// callers wait for the writer to catch up while this much is still queued
+constexpr size_t maxQueuedBytes = 1 << 20;
+
+struct Entry {
+    std::string text;
+    // set once the line is on disk, for callers that wait for it. shared with the entry so the
+    // writer can still notify after the caller saw the store and returned
+    std::shared_ptr<std::atomic<bool>> written;
+};
+
+// one thread owns log.txt. callers queue finished lines without locking and only error level
+// lines wait, until the writer has flushed them
+class FileLogger {
+public:
+    FileLogger() : writer([this] { Run(); }) {}
+
+    // whatever is still queued at exit is written and flushed before the thread ends
+    ~FileLogger() {
+        stopping = true;
+        Wake();
+        writer.join();
+    }
+
+    void Push(std::string text, bool flush) {
+        while (queuedBytes.load(std::memory_order_relaxed) > maxQueuedBytes) {
+            uint32_t seen = batchesWritten.load(std::memory_order_acquire);
+            if (queuedBytes.load(std::memory_order_relaxed) <= maxQueuedBytes) {
+                break;
+            }
+            batchesWritten.wait(seen, std::memory_order_acquire);
+        }
+        queuedBytes.fetch_add(text.size(), std::memory_order_relaxed);
+
+        std::shared_ptr<std::atomic<bool>> written;
+        if (flush) {
+            written = std::make_shared<std::atomic<bool>>(false);
+        }
+        if (queue.Push({{std::move(text), written}})) {
+            Wake();
+        }
+
+        while (written && !written->load(std::memory_order_acquire)) {
+            written->wait(false, std::memory_order_acquire);
+        }
+    }
+
+private:
+    void Wake() {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+
+    void Run() {
+        while (true) {
+            // read before draining, a push that lands after the drain always changes it
+            uint32_t seen = wakeups.load(std::memory_order_acquire);
+            std::vector<Entry> entries = queue.Drain();
+            if (!entries.empty()) {
+                Write(entries);
+            } else if (stopping) {
+                break;
+            } else {
+                wakeups.wait(seen, std::memory_order_acquire);
+            }
+        }
+    }
+
+    void Write(std::vector<Entry>& entries) {
+        std::string batch;
+        bool flush = stopping || queue.Empty();
+        for (const Entry& entry : entries) {
+            batch += entry.text;
+            flush |= entry.written != nullptr;
+        }
+
+        if (!file.is_open() || fileBytes + batch.size() > maxLogBytes) {
+            Open(file.is_open() && fileBytes > 0);
+        }
+        file.write(batch.data(), batch.size());
+        fileBytes += batch.size();
+
+        // a burst goes out in one write once the queue runs dry, errors right away
+        if (flush) {
+            file.flush();
+        }
+
+        size_t queued = 0;
+        for (Entry& entry : entries) {
+            queued += entry.text.size();
+            if (entry.written) {
+                entry.written->store(true, std::memory_order_release);
+                entry.written->notify_all();
+            }
+        }
+        queuedBytes.fetch_sub(queued, std::memory_order_relaxed);
+        batchesWritten.fetch_add(1, std::memory_order_release);
+        batchesWritten.notify_all();
+    }
+
+    void Open(bool rotate) {
+        file.close();
+
+        std::error_code ec;
+        if (rotate) {
+            auto rotated = [](int index) {
+                return logFile.parent_path() / ("log." + std::to_string(index) + ".txt");
+            };
+            for (int i = keptLogs - 1; i > 0; i--) {
+                std::filesystem::rename(rotated(i), rotated(i + 1), ec);
+            }
+            std::filesystem::rename(logFile, rotated(1), ec);
+        }
+
+        file.open(logFile, std::ios_base::out | std::ios_base::app);
+        fileBytes = std::filesystem::file_size(logFile, ec);
+        if (ec) {
+            fileBytes = 0;
+        }
+    }
+
+    BatchQueue<Entry> queue;
+    std::atomic<size_t> queuedBytes = 0;
+    std::atomic<uint32_t> wakeups = 0;
+    std::atomic<uint32_t> batchesWritten = 0;
+    std::atomic<bool> stopping = false;
+
+    // only touched by the writer thread
+    std::ofstream file;
+    uintmax_t fileBytes = 0;
+
+    // last, everything the thread uses exists before it starts
+    std::thread writer;
+};
+
+} // namespace
+
 void LogMsg(Log::Type type, const std::string& logMsg, const std::source_location location) {
+    static FileLogger logger;
+
     std::string_view name = location.file_name();
     size_t last_slash = name.find_last_of("/\\"); // Handle both Unix and Windows separators
     if (last_slash != std::string_view::npos) {
         name.remove_prefix(last_slash + 1);
     }
 
-    std::ofstream ofs(logFile, std::ios_base::out | std::ios_base::app);
-    ofs << "[" << typeMap.at(type) << "] " << name << " line " << location.line() << ": " << logMsg
-        << '\n';
-    ofs.close();
+    std::string line = "[" + typeMap.at(type) + "] ";
+    line += name;
+    line += " line " + std::to_string(location.line()) + ": " + logMsg + '\n';
+    logger.Push(std::move(line), type >= Log::Type::Error);
 }
 
 }; // namespace Log
@@ -0,0 +1,447 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <chrono>
+#include <numeric>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include "MergeEngine.h"
+#include "modules/BBFormats/BBFormats.h"
+#include "modules/BBFormats/Dcx.h"
+#include "modules/BBFormats/FormatRegistry.h"
+#include "modules/BBFormats/VanillaCache.h"
+#include "modules/Common.h"
+#include "modules/Zar/game_backend.h"
+
+using namespace FileHelper;
+
+thread_local std::vector<MergeEngine::LogLine>* MergeEngine::activeFileLog = nullptr;
+namespace fs = std::filesystem;
+
+MergeEngine::MergeEngine(Options engineOptions, MergeLogger& mergeLogger,
+                         PriorityPolicy& priorityPolicy)
+    : options(std::move(engineOptions)), logger(mergeLogger), policy(priorityPolicy) {
+    // "Mods/name/" has no filename, the name comes from the folder itself
+    for (fs::path* folder : {&options.mod1Folder, &options.mod2Folder}) {
+        if (!folder->has_filename()) {
+            *folder = folder->parent_path();
+        }
+    }
+
+    mod1Name = Common::PathToU8(options.mod1Folder.filename());
+    mod2Name = Common::PathToU8(options.mod2Folder.filename());
+    mod1BasePath = StandardizeBasePath(options.mod1Folder);
+    mod2BasePath = StandardizeBasePath(options.mod2Folder);
+
+    baseTempPath = options.workFolder / "merged";
+    mod1TempPath = options.workFolder / "1";
+    mod2TempPath = options.workFolder / "2";
+
+    // a file merged on its own gets the whole budget, its caller plus the pool
+    entryPool.setMaxThreadCount(ThreadBudget() - 1);
+}
+
+bool MergeEngine::Run() {
+    std::error_code ec;
+    fs::remove_all(options.workFolder, ec);
+
+    bool merged = MergeAll();
+
+    fs::remove_all(options.workFolder, ec);
+    if (ec) {
+        Log(QString("Cleanup delayed: %1").arg(QString::fromStdString(ec.message())));
+    }
+
+    return merged;
+}
+
+bool MergeEngine::MergeAll() {
+    if (!GetMergeFiles()) {
+        return false;
+    }
+
+    // decompressed vanilla files survive between merges, only mod files are inflated every time
+    VanillaCache vanillaCache(options.cacheFolder, options.cacheBytes);
+
+    // files are merged concurrently, whatever is left of the thread budget goes to each file's
+    // deflate so the total stays bounded. the file workers merge binder entries themselves, the
+    // entry pool only adds the threads they leave over
+    int threads = ThreadBudget();
+    int fileThreads = std::clamp(threads, 1, std::max(1, static_cast<int>(conflictedFiles.size())));
+    entryPool.setMaxThreadCount(threads - fileThreads);
+    int deflateThreads = options.compressionThreads > 0 ? options.compressionThreads
+                                                        : std::max(1, threads / fileThreads);
+
+    fileLogs.assign(conflictedFiles.size(), {});
+    fileLogsDone.assign(conflictedFiles.size(), false);
+    nextFileLog = 0;
+
+    std::vector<size_t> fileIndices(conflictedFiles.size());
+    std::iota(fileIndices.begin(), fileIndices.end(), 0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(fileThreads);
+    std::atomic<bool> aborted = false;
+    QtConcurrent::blockingMap(&pool, fileIndices, [&](size_t index) {
+        if (!aborted) {
+            activeFileLog = &fileLogs[index];
+            if (!MergeFile(conflictedFiles[index], vanillaCache, deflateThreads)) {
+                aborted = true;
+            }
+            activeFileLog = nullptr;
+        }
+        FlushFileLogs(index);
+    });
+
+    if (aborted) {
+        return false;
+    }
+
+    return CombineModFiles();
+}
+
+bool MergeEngine::MergeFile(const std::string& file, FileHelper::VanillaCache& vanillaCache,
+                            int deflateThreads) {
+    bool canExtract = true;
+    fs::path basefile = baseTempPath / file;
+    fs::path mod1file = mod1TempPath / file;
+    fs::path mod2file = mod2TempPath / file;
+
+    if (!fs::exists(basefile)) {
+        Log("Skipping file not present in original game " + QString::fromStdString(file),
+            Format::Yellow);
+        return true;
+    }
+
+    std::string fileExt = file.substr(file.length() - 3);
+    std::transform(fileExt.begin(), fileExt.end(), fileExt.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    std::vector<char> baseData;
+
+    Dcx origDcx(this);
+    origDcx.SetDeflateOptions({.level = options.compressionLevel, .threads = deflateThreads});
+    origDcx.SetCache(&vanillaCache, GetUpdatedFile(file));
+    // first level extration, only dcx (maybe hks later on)
+    if (fileExt == "dcx") {
+        if (!origDcx.UnpackDcx(basefile, baseData)) {
+            return false;
+        }
+    } else {
+        canExtract = false;
+    }
+
+    // what can be merged after DCX is decided by the format registry
+    const FormatHandler* format = nullptr;
+    if (canExtract) {
+        format = DetectFormat(baseData);
+        canExtract = format && format->standalone;
+    }
+
+    if (!canExtract) {
+        return ChooseBaseFile(basefile, mod1file, mod2file);
+    }
+
+    std::vector<char> mod1Data;
+    std::vector<char> mod2Data;
+
+    Dcx mod1Dcx(this);
+    if (!mod1Dcx.UnpackDcx(mod1file, mod1Data)) {
+        return false;
+    }
+
+    Dcx mod2Dcx(this);
+    if (!mod2Dcx.UnpackDcx(mod2file, mod2Data)) {
+        return false;
+    }
+
+    if (!format->merge(baseData, mod1Data, mod2Data, file, this)) {
+        return false;
+    }
+
+    // a merge that reproduces one mod's file byte for byte keeps that mod's compressed file
+    // instead of deflating the same data again
+    bool mod1Same = mod1Data == baseData;
+    if (mod1Same || mod2Data == baseData) {
+        const fs::path& passthroughFile = mod1Same ? mod1file : mod2file;
+        try {
+            fs::copy_file(passthroughFile, basefile, fs::copy_options::overwrite_existing);
+        } catch (const std::exception& e) {
+            Log("Filesystem error copying files: " + QString(e.what()), Format::BoldRed);
+            return false;
+        }
+
+        Log(QString("Merged file matches mod: %1, keeping its compressed file: %2\n")
+                .arg(mod1Same ? mod1Name : mod2Name, Common::PathToU8(basefile.filename())));
+        return true;
+    }
+
+    return origDcx.RepackDcx(baseData);
+}
+
+bool MergeEngine::GetMergeFiles() {
+    try {
+        for (const auto& file : conflictedFiles) {
+            fs::path origFilePathOld = GetUpdatedFile(file);
+            fs::path origFilePath = baseTempPath / file;
+
+            if (!fs::exists(origFilePath.parent_path())) {
+                fs::create_directories(origFilePath.parent_path());
+            }
+
+            if (fs::exists(origFilePathOld)) {
+                fs::copy_file(origFilePathOld, origFilePath);
+            } else {
+                Log("Skipping file not present in original game " + QString::fromStdString(file),
+                    Format::Yellow);
+                continue;
+            }
+
+            fs::path mod1filePathOld = mod1BasePath / file;
+            fs::path mod1filePath = mod1TempPath / file;
+
+            if (!fs::exists(mod1filePath.parent_path())) {
+                fs::create_directories(mod1filePath.parent_path());
+            }
+            fs::copy_file(mod1filePathOld, mod1filePath);
+
+            fs::path mod2filePathOld = mod2BasePath / file;
+            fs::path mod2filePath = mod2TempPath / file;
+
+            if (!fs::exists(mod2filePath.parent_path())) {
+                fs::create_directories(mod2filePath.parent_path());
+            }
+            fs::copy_file(mod2filePathOld, mod2filePath);
+
+            Log(QString("Copied %1 to temporary folder").arg(file));
+        }
+    } catch (const std::exception& e) {
+        Log("ERROR: File operations failed: " + QString(e.what()), Format::BoldRed);
+        return false;
+    }
+
+    return true;
+}
+
+bool MergeEngine::CombineModFiles() {
+    for (const auto& FileEntry : fs::recursive_directory_iterator(mod1BasePath)) {
+        if (!FileEntry.is_directory()) {
+            const auto relativePath = fs::relative(FileEntry, mod1BasePath);
+            if (!fs::exists(baseTempPath / relativePath)) {
+                if (!fs::exists(baseTempPath / relativePath.parent_path())) {
+                    fs::create_directories(baseTempPath / relativePath.parent_path());
+                }
+                fs::copy_file(FileEntry, baseTempPath / relativePath);
+            }
+        }
+    }
+
+    for (const auto& FileEntry : fs::recursive_directory_iterator(mod2BasePath)) {
+        if (!FileEntry.is_directory()) {
+            const auto relativePath = fs::relative(FileEntry, mod2BasePath);
+            if (!fs::exists(baseTempPath / relativePath)) {
+
+                if (!fs::exists(baseTempPath / relativePath.parent_path())) {
+                    fs::create_directories(baseTempPath / relativePath.parent_path());
+                }
+                fs::copy_file(FileEntry, baseTempPath / relativePath);
+            }
+        }
+    }
+
+    fs::path mergedFolder = MergedFolder();
+
+    try {
+        if (fs::exists(mergedFolder))
+            fs::remove_all(mergedFolder);
+
+        fs::create_directories(options.outputFolder);
+        fs::rename(baseTempPath, mergedFolder);
+    } catch (std::exception& e) {
+        Log("Moving mod files to mod folder failed: " + QString(e.what()), Format::BoldRed);
+        return false;
+    }
+
+    return true;
+}
+
+const std::vector<std::string>& MergeEngine::FindConflicts() {
+    conflictedFiles.clear();
+
+    std::vector<std::string> fileListMod1;
+    for (const auto& FileEntry : fs::recursive_directory_iterator(mod1BasePath)) {
+        if (!FileEntry.is_directory()) {
+            auto relative_path = fs::relative(FileEntry, mod1BasePath);
+            const auto u8_string = Common::PathToU8(relative_path);
+            std::string relative_path_string{u8_string.begin(), u8_string.end()};
+            fileListMod1.push_back(relative_path_string);
+        }
+    }
+
+    for (const auto& entry : fs::recursive_directory_iterator(mod2BasePath)) {
+        if (!entry.is_directory()) {
+            auto relative_path = fs::relative(entry, mod2BasePath);
+            std::string relative_path_string = Common::PathToU8(relative_path);
+            for (int i = 0; i < fileListMod1.size(); i++) {
+                if (fileListMod1[i] == relative_path_string) {
+                    conflictedFiles.push_back(relative_path_string);
+                    Log("Conflicted file found: " + QString::fromStdString(relative_path_string));
+                }
+            }
+        }
+    }
+
+    return conflictedFiles;
+}
+
+fs::path MergeEngine::GetUpdatedFile(fs::path relativePath) {
+    std::filesystem::path installUpdatePath = Common::GetUpdatePath(options.gamePath);
+    std::string relString = "dvdroot_ps4/" + relativePath.string();
+
+    if (fs::exists(installUpdatePath)) {
+        std::optional<fs::path> updatedPath =
+            Core::FileSys::ResolveGameFilePath(installUpdatePath, relString);
+        if (updatedPath.has_value()) {
+            return updatedPath.value();
+        }
+    }
+
+    fs::path path = "";
+    if (const auto resolved = Core::FileSys::ResolveGameFilePath(options.gamePath, relString)) {
+        path = *resolved;
+    }
+
+    return path;
+}
+
+bool MergeEngine::ChooseBaseFile(fs::path targetFile, fs::path mod1File, fs::path mod2File) {
+    if (RequestPriority() == ModPriority::NotSet) {
+        return false;
+    }
+
+    try {
+        if (currentPriority == ModPriority::Mod1) {
+            if (fs::exists(mod1File)) {
+                fs::copy_file(mod1File, targetFile, fs::copy_options::overwrite_existing);
+                QString msg = QString("Unresolvable conflict, using file: %1 prioritized mod: %2")
+                                  .arg(Common::PathToU8(mod1File.filename()), mod1Name);
+                Log(msg, Format::Yellow);
+            }
+        } else if (currentPriority == ModPriority::Mod2) {
+            if (fs::exists(mod2File)) {
+                fs::copy_file(mod2File, targetFile, fs::copy_options::overwrite_existing);
+                QString msg = QString("Unresolvable conflict, using file: %1 prioritized mod: %2")
+                                  .arg(Common::PathToU8(mod2File.filename()), mod2Name);
+                Log(msg, Format::Yellow);
+            }
+        }
+    } catch (const std::exception& e) {
+        Log("Filesystem error copying files: " + QString(e.what()), Format::BoldRed);
+        return false;
+    }
+
+    return true;
+}
+
+fs::path MergeEngine::StandardizeBasePath(fs::path basePath) {
+    if (fs::exists(basePath / "dvdroot_ps4")) {
+        basePath = basePath / "dvdroot_ps4";
+    }
+
+    return basePath;
+}
+
+void MergeEngine::Log(QString msg, Format format) {
+    // lines from a file being merged are held back so each file's log comes out in one piece
+    if (activeFileLog) {
+        activeFileLog->push_back({std::move(msg), format});
+        return;
+    }
+
+    LogLine line{std::move(msg), format};
+    WriteLog({&line, 1});
+}
+
+std::vector<MergeEngine::LogLine>* MergeEngine::RedirectLog(std::vector<LogLine>* buffer) {
+    return std::exchange(activeFileLog, buffer);
+}
+
+void MergeEngine::AppendLog(const std::vector<LogLine>& lines) {
+    if (activeFileLog) {
+        activeFileLog->insert(activeFileLog->end(), lines.begin(), lines.end());
+        return;
+    }
+
+    WriteLog(lines);
+}
+
+MergeEngine::LogStats MergeEngine::GetLogStats() const {
+    return {loggedLines.load(std::memory_order_relaxed),
+            logNanoseconds.load(std::memory_order_relaxed) / 1e9};
+}
+
+QThreadPool* MergeEngine::EntryPool() {
+    return entryPool.maxThreadCount() > 0 ? &entryPool : nullptr;
+}
+
+int MergeEngine::ThreadBudget() const {
+    return options.threads > 0 ? options.threads : QThread::idealThreadCount();
+}
+
+void MergeEngine::FlushFileLogs(size_t index) {
+    std::lock_guard lock(fileLogMutex);
+    fileLogsDone[index] = true;
+
+    // released in conflictedFiles order, whatever order the files finish in
+    while (nextFileLog < fileLogs.size() && fileLogsDone[nextFileLog]) {
+        WriteLog(fileLogs[nextFileLog]);
+        fileLogs[nextFileLog].clear();
+        nextFileLog++;
+    }
+}
+
+void MergeEngine::WriteLog(std::span<const LogLine> lines) {
+    if (lines.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    logger.WriteBatch(lines);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    loggedLines.fetch_add(lines.size(), std::memory_order_relaxed);
+    logNanoseconds.fetch_add(std::chrono::nanoseconds(elapsed).count(), std::memory_order_relaxed);
+}
+
+MergeEngine::ModPriority MergeEngine::GetModPriority() {
+    return currentPriority;
+}
+
+MergeEngine::ModPriority MergeEngine::RequestPriority(const std::vector<std::string>& conflicts) {
+    // files merging in parallel share one decision, the first to need it asks and the others
+    // wait here for the answer
+    std::lock_guard lock(priorityMutex);
+    if (!priorityAsked) {
+        priorityAsked = true;
+        currentPriority = policy.Decide(mod1Name, mod2Name, conflicts);
+    }
+
+    return currentPriority;
+}
+
+std::string MergeEngine::Mod1Name() {
+    return mod1Name;
+}
+
+std::string MergeEngine::Mod2Name() {
+    return mod2Name;
+}
+
+fs::path MergeEngine::MergedFolder() {
+    fs::path mergedFolder = options.outputFolder / options.mod1Folder.filename();
+    mergedFolder += " + ";
+    mergedFolder += options.mod2Folder.filename();
+    return mergedFolder;
+}
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include <QString>
+#include <QThreadPool>
+
+namespace FileHelper {
+class VanillaCache;
+}
+
+// where merge output goes. called from merge worker threads, so implementations must be safe to
+// call concurrently. a file's lines arrive together, in conflicted file order
+class MergeLogger {
+public:
+    enum class Format : int { Default, Yellow, BoldRed, BoldGreen };
+
+    struct Line {
+        QString msg;
+        Format format;
+    };
+
+    virtual ~MergeLogger() = default;
+    virtual void Write(const QString& msg, Format format) = 0;
+
+    // a finished file's lines in one call, loggers that pay per call can take them all at once
+    virtual void WriteBatch(std::span<const Line> lines) {
+        for (const Line& line : lines) {
+            Write(line.msg, line.format);
+        }
+    }
+};
+
+// settles data both mods changed in a way that can't be merged. asked at most once per merge,
+// whatever it answers applies to every later conflict and NotSet aborts the merge
+class PriorityPolicy {
+public:
+    enum class ModPriority : int { NotSet, Mod1, Mod2 };
+
+    virtual ~PriorityPolicy() = default;
+    virtual ModPriority Decide(const std::string& mod1Name, const std::string& mod2Name,
+                               const std::vector<std::string>& conflicts) = 0;
+};
+
+// three-way merge of two mod folders against the game files, with no ui of its own. the launcher
+// dialog and the bbl-merge command line tool both drive it
+class MergeEngine {
+public:
+    using Format = MergeLogger::Format;
+    using ModPriority = PriorityPolicy::ModPriority;
+
+    struct Options {
+        std::filesystem::path mod1Folder;
+        std::filesystem::path mod2Folder;
+        // the merged mod is written here as "<mod1> + <mod2>", replacing an older one
+        std::filesystem::path outputFolder;
+        // scratch space, wiped before and after the merge
+        std::filesystem::path workFolder;
+        std::filesystem::path gamePath;
+        std::filesystem::path cacheFolder;
+        uint64_t cacheBytes = 0;
+        int threads = 0; // 0 uses every core
+        int compressionThreads = 0;
+        int compressionLevel = 9;
+    };
+
+    using LogLine = MergeLogger::Line;
+
+    // what logging cost so far: lines handed to the logger and the time spent in its calls
+    struct LogStats {
+        uint64_t lines = 0;
+        double seconds = 0.0;
+    };
+
+    MergeEngine(Options options, MergeLogger& logger, PriorityPolicy& policy);
+
+    // files present in both mods, relative to their dvdroot_ps4
+    const std::vector<std::string>& FindConflicts();
+    // merges the conflicted files and writes the merged mod, false when aborted
+    bool Run();
+
+    std::string Mod1Name();
+    std::string Mod2Name();
+    std::filesystem::path MergedFolder();
+    ModPriority GetModPriority();
+    // asks the policy the first time it is needed, NotSet afterwards means abort. conflicts
+    // names what is being settled, for the prompt
+    ModPriority RequestPriority(const std::vector<std::string>& conflicts = {});
+
+    void Log(QString msg, Format format = Format::Default);
+
+    // sends Log calls from the current thread into buffer, returns the previous target so it can
+    // be restored. nullptr logs directly
+    static std::vector<LogLine>* RedirectLog(std::vector<LogLine>* buffer);
+    // replays buffered lines through the current thread's log target
+    void AppendLog(const std::vector<LogLine>& lines);
+
+    LogStats GetLogStats() const;
+
+    // where the entries of a binder are merged in parallel, bounded by the thread budget.
+    // nullptr when the budget leaves no threads beyond the callers', entries then merge in place
+    QThreadPool* EntryPool();
+
+private:
+    int ThreadBudget() const;
+    bool MergeAll();
+    bool MergeFile(const std::string& file, FileHelper::VanillaCache& vanillaCache,
+                   int deflateThreads);
+    void FlushFileLogs(size_t index);
+    void WriteLog(std::span<const LogLine> lines);
+
+    bool CombineModFiles();
+    bool GetMergeFiles();
+    bool ChooseBaseFile(std::filesystem::path targetFile, std::filesystem::path mod1File,
+                        std::filesystem::path mod2File);
+
+    std::filesystem::path StandardizeBasePath(std::filesystem::path basePath);
+    std::filesystem::path GetUpdatedFile(std::filesystem::path relative_path);
+
+    Options options;
+    MergeLogger& logger;
+    PriorityPolicy& policy;
+
+    std::string mod1Name;
+    std::string mod2Name;
+    std::filesystem::path mod1BasePath;
+    std::filesystem::path mod2BasePath;
+    std::filesystem::path baseTempPath;
+    std::filesystem::path mod1TempPath;
+    std::filesystem::path mod2TempPath;
+
+    std::vector<std::string> conflictedFiles;
+    QThreadPool entryPool;
+
+    std::atomic<ModPriority> currentPriority = ModPriority::NotSet;
+    std::mutex priorityMutex;
+    bool priorityAsked = false;
+
+    static thread_local std::vector<LogLine>* activeFileLog;
+    std::vector<std::vector<LogLine>> fileLogs;
+    std::vector<bool> fileLogsDone;
+    size_t nextFileLog = 0;
+    std::mutex fileLogMutex;
+
+    std::atomic<uint64_t> loggedLines = 0;
+    std::atomic<uint64_t> logNanoseconds = 0;
+};
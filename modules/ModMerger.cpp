@@ -2,16 +2,13 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <QMessageBox>
+#include <QThread>
 #include <QtConcurrent/QtConcurrentRun>
 
 #include "ModMerger.h"
-#include "modules/BBFormats/BBFormats.h"
-#include "modules/BBFormats/ConflictHandler.h"
-#include "modules/BBFormats/Dcx.h"
-#include "modules/Zar/game_backend.h"
+#include "settings/config.h"
 #include "ui_ModMerger.h"
 
-using namespace FileHelper;
 namespace fs = std::filesystem;
 
 ModMerger::ModMerger(QWidget* parent) : QDialog(parent), ui(new Ui::ModMerger) {
@@ -22,6 +19,10 @@ ModMerger::ModMerger(QWidget* parent) : QDialog(parent), ui(new Ui::ModMerger) {
 
     RefreshModList();
 
+    // a merge logs a line per entry, appending them one by one keeps the ui thread busy
+    logTimer.setInterval(50);
+    connect(&logTimer, &QTimer::timeout, this, &ModMerger::DrainLog);
+
     ui->modList->setSelectionMode(QAbstractItemView::ExtendedSelection);
     connect(ui->modList, &QListWidget::itemSelectionChanged, this, &ModMerger::EnforceTwoItemLimit);
 
@@ -32,13 +33,20 @@ ModMerger::ModMerger(QWidget* parent) : QDialog(parent), ui(new Ui::ModMerger) {
             return;
         }
 
-        mod1Name = selectedList.at(0)->text().toStdString();
-        mod2Name = selectedList.at(1)->text().toStdString();
-        currentPriority = ModPriority::NotSet;
-        conflictedFiles.clear();
-
-        GetConflictedFiles();
-        if (conflictedFiles.empty()) {
+        MergeEngine::Options options;
+        options.mod1Folder = modPath / selectedList.at(0)->text().toStdString();
+        options.mod2Folder = modPath / selectedList.at(1)->text().toStdString();
+        options.outputFolder = Common::ModPath;
+        options.workFolder = Common::GetBBLFilesPath() / "Temp" / "ModMerge";
+        options.gamePath = Common::installPath;
+        options.cacheFolder = Common::GetBBLFilesPath() / "Cache" / "Vanilla";
+        options.cacheBytes = static_cast<uint64_t>(std::max(Config::MergeCacheSizeMB, 0)) << 20;
+        options.threads = Config::MergeThreads;
+        options.compressionThreads = Config::MergeCompressionThreads;
+        options.compressionLevel = Config::MergeCompressionLevel;
+
+        engine = std::make_unique<MergeEngine>(options, *this, *this);
+        if (engine->FindConflicts().empty()) {
             Log("No conflicted files found for these two mods, merge is not required",
                 Format::Yellow);
             return;
@@ -48,334 +56,68 @@ ModMerger::ModMerger(QWidget* parent) : QDialog(parent), ui(new Ui::ModMerger) {
         ui->mergeStatusText->clear();
         ui->mergeButton->setEnabled(false);
         ui->buttonBox->setEnabled(false);
-        activeMerge = QtConcurrent::run(&ModMerger::AttemptMerge, this);
+        logTimer.start();
+        activeMerge = QtConcurrent::run([this] { emit MergeFinished(!engine->Run()); });
     });
 
-    connect(this, &ModMerger::CleanUpRequested, this, [this](bool aborted) {
-        std::error_code ec;
-        fs::remove_all(Common::GetBBLFilesPath() / "Temp" / "ModMerge", ec);
-
-        if (ec) {
-            Log(QString("Cleanup delayed: %1").arg(QString::fromStdString(ec.message())));
-        }
-
+    connect(this, &ModMerger::MergeFinished, this, [this](bool aborted) {
+        logTimer.stop();
         ui->waitLabel->setVisible(false);
         ui->mergeButton->setEnabled(true);
         ui->buttonBox->setEnabled(true);
 
+        MergeEngine::LogStats logStats = engine->GetLogStats();
+        Log(QString("Logged %1 lines in %2 ms")
+                .arg(logStats.lines)
+                .arg(logStats.seconds * 1e3, 0, 'f', 1));
+
         if (aborted) {
             Log("Mod merge attempt aborted", Format::BoldRed);
         } else {
             Log("Mod merge complete", Format::BoldGreen);
         }
     });
-
-    connect(this, &ModMerger::LogRequested, this, [this](QString msg) {
-        ui->mergeStatusText->append(msg);
-        ui->mergeStatusText->moveCursor(QTextCursor::End);
-    });
-}
-
-void ModMerger::AttemptMerge() {
-    if (fs::exists(Common::GetBBLFilesPath() / "Temp" / "ModMerge"))
-        fs::remove_all(Common::GetBBLFilesPath() / "Temp" / "ModMerge");
-
-    fs::path mod1BasePath = StandardizeBasePath(Common::ModPath / mod1Name);
-    fs::path mod2BasePath = StandardizeBasePath(Common::ModPath / mod2Name);
-    if (!GetMergeFiles(mod1BasePath, mod2BasePath)) {
-        emit CleanUpRequested(true);
-        return;
-    }
-
-    for (const auto& file : conflictedFiles) {
-        bool canExtract = true;
-        fs::path basefile = baseTempPath / file;
-        fs::path mod1file = mod1TempPath / file;
-        fs::path mod2file = mod2TempPath / file;
-
-        if (!fs::exists(basefile)) {
-            Log("Skipping file not present in original game " + QString::fromStdString(file),
-                Format::Yellow);
-            continue;
-        }
-
-        std::string fileExt = file.substr(file.length() - 3);
-        std::transform(fileExt.begin(), fileExt.end(), fileExt.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-
-        std::vector<char> baseData;
-
-        Dcx origDcx(this);
-        // first level extration, only dcx (maybe hks later on)
-        if (fileExt == "dcx") {
-            if (!origDcx.UnpackDcx(basefile, baseData)) {
-                emit CleanUpRequested(true);
-                return;
-            }
-        } else {
-            canExtract = false;
-        }
-
-        std::string filetype;
-        // what can be extracted after DCX, maybe esd/emevd after
-        if (canExtract) {
-            filetype = GetFileType(baseData);
-            canExtract = filetype.contains("TPF") || filetype.contains("BND4");
-            // not yet ready
-            // || filetype.contains("EVD")  || filetype.contains("MSB") || filetype.contains("ESD");
-        }
-
-        if (!canExtract) {
-            if (!ChooseBaseFile(basefile, mod1file, mod2file)) {
-                emit CleanUpRequested(true);
-                return;
-            }
-            continue;
-        }
-
-        std::vector<char> mod1Data;
-        std::vector<char> mod2Data;
-
-        Dcx mod1Dcx(this);
-        if (!mod1Dcx.UnpackDcx(mod1file, mod1Data)) {
-            emit CleanUpRequested(true);
-            return;
-        }
-
-        Dcx mod2Dcx(this);
-        if (!mod2Dcx.UnpackDcx(mod2file, mod2Data)) {
-            emit CleanUpRequested(true);
-            return;
-        }
-
-        ConflictHandler handler = ConflictHandler(filetype, this);
-        if (!filetype.contains("BND4")) {
-            if (!handler.HandleItemConflict(baseData, mod1Data, mod2Data)) {
-                emit CleanUpRequested(true);
-                return;
-            } else {
-                origDcx.RepackDcx(baseData);
-            }
-        } else {
-            if (!handler.HandleBinderConflict(baseData, mod1Data, mod2Data)) {
-                emit CleanUpRequested(true);
-            } else {
-                origDcx.RepackDcx(baseData);
-            }
-        }
-    }
-
-    CombineModFiles();
-    emit CleanUpRequested(false);
-}
-
-bool ModMerger::GetMergeFiles(std::filesystem::path mod1Base, std::filesystem::path mod2Base) {
-    try {
-        for (const auto& file : conflictedFiles) {
-            fs::path origFilePathOld = GetUpdatedFile(file);
-            fs::path origFilePath = baseTempPath / file;
-
-            if (!fs::exists(origFilePath.parent_path())) {
-                fs::create_directories(origFilePath.parent_path());
-            }
-
-            if (fs::exists(origFilePathOld)) {
-                fs::copy_file(origFilePathOld, origFilePath);
-            } else {
-                Log("Skipping file not present in original game " + QString::fromStdString(file),
-                    Format::Yellow);
-                continue;
-            }
-
-            fs::path mod1BasePath = StandardizeBasePath(Common::ModPath / mod1Name);
-            fs::path mod1filePathOld = StandardizeBasePath(Common::ModPath / mod1Name) / file;
-            fs::path mod1filePath = mod1TempPath / file;
-
-            if (!fs::exists(mod1filePath.parent_path())) {
-                fs::create_directories(mod1filePath.parent_path());
-            }
-            fs::copy_file(mod1filePathOld, mod1filePath);
-
-            fs::path mod2BasePath = StandardizeBasePath(Common::ModPath / mod2Name);
-            fs::path mod2filePathOld = StandardizeBasePath(Common::ModPath / mod2Name) / file;
-            fs::path mod2filePath = mod2TempPath / file;
-
-            if (!fs::exists(mod2filePath.parent_path())) {
-                fs::create_directories(mod2filePath.parent_path());
-            }
-            fs::copy_file(mod2filePathOld, mod2filePath);
-
-            Log(QString("Copied %1 to temporary folder").arg(file));
-        }
-    } catch (const std::exception& e) {
-        Log("ERROR: File operations failed: " + QString(e.what()), Format::BoldRed);
-        return false;
-    }
-
-    return true;
-}
-
-std::string ModMerger::GetFileType(const std::vector<char>& filedata) {
-    if (filedata.size() < 8)
-        return "";
-
-    std::stringstream s(std::string(filedata.begin(), filedata.end()),
-                        std::ios_base::in | std::ios_base::binary);
-
-    std::string strBuffer(8, '\0');
-    s.read(&strBuffer[0], 8);
-    strBuffer.erase(std::remove(strBuffer.begin(), strBuffer.end(), '\0'), strBuffer.end());
-
-    return strBuffer;
 }
 
-void ModMerger::CombineModFiles() {
-    fs::path mod1Folder = StandardizeBasePath(Common::ModPath / mod1Name);
-    for (const auto& FileEntry : fs::recursive_directory_iterator(mod1Folder)) {
-        if (!FileEntry.is_directory()) {
-            const auto relativePath = fs::relative(FileEntry, mod1Folder);
-            if (!fs::exists(baseTempPath / relativePath)) {
-                if (!fs::exists(baseTempPath / relativePath.parent_path())) {
-                    fs::create_directories(baseTempPath / relativePath.parent_path());
-                }
-                fs::copy_file(FileEntry, baseTempPath / relativePath);
-            }
-        }
-    }
-
-    fs::path mod2Folder = StandardizeBasePath(Common::ModPath / mod2Name);
-    for (const auto& FileEntry : fs::recursive_directory_iterator(mod2Folder)) {
-        if (!FileEntry.is_directory()) {
-            const auto relativePath = fs::relative(FileEntry, mod2Folder);
-            if (!fs::exists(baseTempPath / relativePath)) {
-
-                if (!fs::exists(baseTempPath / relativePath.parent_path())) {
-                    fs::create_directories(baseTempPath / relativePath.parent_path());
-                }
-                fs::copy_file(FileEntry, baseTempPath / relativePath);
-            }
-        }
-    }
-
-    std::string newName = mod1Name + " + " + mod2Name;
-
-    try {
-        if (fs::exists(Common::ModPath / newName))
-            fs::remove_all(Common::ModPath / newName);
-
-        fs::rename(baseTempPath, Common::ModPath / newName);
-    } catch (std::exception& e) {
-        Log("Moving mod files to mod folder failed: " + QString(e.what()), Format::BoldRed);
-    }
-}
-
-void ModMerger::GetConflictedFiles() {
-    fs::path mod1Path = StandardizeBasePath(modPath / mod1Name);
-    fs::path mod2Path = StandardizeBasePath(modPath / mod2Name);
-
-    std::vector<std::string> fileListMod1;
-    for (const auto& FileEntry : fs::recursive_directory_iterator(mod1Path)) {
-        if (!FileEntry.is_directory()) {
-            auto relative_path = fs::relative(FileEntry, mod1Path);
-            const auto u8_string = Common::PathToU8(relative_path);
-            std::string relative_path_string{u8_string.begin(), u8_string.end()};
-            fileListMod1.push_back(relative_path_string);
-        }
-    }
-
-    for (const auto& entry : fs::recursive_directory_iterator(mod2Path)) {
-        if (!entry.is_directory()) {
-            auto relative_path = fs::relative(entry, mod2Path);
-            std::string relative_path_string = Common::PathToU8(relative_path);
-            for (int i = 0; i < fileListMod1.size(); i++) {
-                if (fileListMod1[i] == relative_path_string) {
-                    conflictedFiles.push_back(relative_path_string);
-                    Log("Conflicted file found: " + QString::fromStdString(relative_path_string));
-                }
-            }
-        }
-    }
-}
-
-fs::path ModMerger::GetUpdatedFile(fs::path relativePath) {
-    std::filesystem::path installUpdatePath = Common::GetUpdatePath(Common::installPath);
-    std::string relString = "dvdroot_ps4/" + relativePath.string();
-
-    if (fs::exists(installUpdatePath)) {
-        std::optional<fs::path> updatedPath =
-            Core::FileSys::ResolveGameFilePath(installUpdatePath, relString);
-        if (updatedPath.has_value()) {
-            return updatedPath.value();
-        }
-    }
-
-    fs::path path = "";
-    if (const auto resolved = Core::FileSys::ResolveGameFilePath(Common::installPath, relString)) {
-        path = *resolved;
-    }
+void ModMerger::OpenPriorityDialog() {
+    QDialog* dialog = new QDialog(this);
+    dialog->setWindowTitle("Handle data conflict");
+    dialog->setMinimumWidth(500);
 
-    return path;
-}
+    QString text = "The same information is modified for both mods. You can force the merge "
+                   "attempt to continue by choosing which mod files to prioritize, but the final "
+                   "merged mod will likely not work correctly when there are unresolvable "
+                   "conflicts";
 
-bool ModMerger::ChooseBaseFile(fs::path targetFile, fs::path mod1File, fs::path mod2File) {
-    if (currentPriority == ModPriority::NotSet) {
-        QMetaObject::invokeMethod(this, &ModMerger::OpenPriorityDialog,
-                                  Qt::BlockingQueuedConnection);
-        if (currentPriority == ModPriority::NotSet) {
-            return false;
+    // batched requests list what the choice applies to, capped so the dialog stays readable
+    constexpr size_t maxListed = 10;
+    if (!priorityConflicts.empty()) {
+        text += "\n\nConflicting files:";
+        for (size_t i = 0; i < std::min(priorityConflicts.size(), maxListed); i++) {
+            text += "\n  " + QString::fromStdString(priorityConflicts[i]);
         }
-    }
-
-    try {
-        if (currentPriority == ModPriority::Mod1) {
-            if (fs::exists(mod1File)) {
-                fs::copy_file(mod1File, targetFile, fs::copy_options::overwrite_existing);
-                QString msg = QString("Unresolvable conflict, using file: %1 prioritized mod: %2")
-                                  .arg(Common::PathToU8(mod1File.filename()), mod1Name);
-                Log(msg, Format::Yellow);
-            }
-        } else if (currentPriority == ModPriority::Mod2) {
-            if (fs::exists(mod2File)) {
-                fs::copy_file(mod2File, targetFile, fs::copy_options::overwrite_existing);
-                QString msg = QString("Unresolvable conflict, using file: %1 prioritized mod: %2")
-                                  .arg(Common::PathToU8(mod2File.filename()), mod2Name);
-                Log(msg, Format::Yellow);
-            }
+        if (priorityConflicts.size() > maxListed) {
+            text += QString("\n  ...and %1 more").arg(priorityConflicts.size() - maxListed);
         }
-    } catch (const std::exception& e) {
-        Log("Filesystem error copying files: " + QString(e.what()), Format::BoldRed);
-        return false;
     }
 
-    return true;
-}
-
-void ModMerger::OpenPriorityDialog() {
-    QDialog* dialog = new QDialog(this);
-    dialog->setWindowTitle("Handle data conflict");
-    dialog->setMinimumWidth(500);
-
-    QLabel* label = new QLabel(
-        "The same information is modified for both mods. You can force the merge attempt to "
-        "continue by choosing which mod files to prioritize, but the final merged "
-        "mod will likely not work correctly when there are unresolvable conflicts",
-        dialog);
+    QLabel* label = new QLabel(text, dialog);
     label->setWordWrap(true);
 
     QPushButton* btn1 =
-        new QPushButton("Use data from " + QString::fromStdString(mod1Name), dialog);
+        new QPushButton("Use data from " + QString::fromStdString(engine->Mod1Name()), dialog);
     QPushButton* btn2 =
-        new QPushButton("Use data from " + QString::fromStdString(mod2Name), dialog);
+        new QPushButton("Use data from " + QString::fromStdString(engine->Mod2Name()), dialog);
     QPushButton* btn3 = new QPushButton("Abort merge attempt", dialog);
 
     QObject::connect(btn1, &QPushButton::clicked, [this, dialog]() {
-        currentPriority = ModPriority::Mod1;
+        dialogChoice = ModPriority::Mod1;
         dialog->accept();
         dialog->deleteLater();
     });
 
     QObject::connect(btn2, &QPushButton::clicked, [this, dialog]() {
-        currentPriority = ModPriority::Mod2;
+        dialogChoice = ModPriority::Mod2;
         dialog->accept();
         dialog->deleteLater();
     });
@@ -395,14 +137,6 @@ void ModMerger::OpenPriorityDialog() {
     dialog->exec();
 }
 
-fs::path ModMerger::StandardizeBasePath(fs::path basePath) {
-    if (fs::exists(basePath / "dvdroot_ps4")) {
-        basePath = basePath / "dvdroot_ps4";
-    }
-
-    return basePath;
-}
-
 void ModMerger::RefreshModList() {
     ui->modList->clear();
 
@@ -456,28 +190,46 @@ QString ModMerger::FormatTextForBrowser(QString input, Format format) {
 }
 
 void ModMerger::Log(QString msg, Format format) {
-    msg = FormatTextForBrowser(msg, format);
+    pendingLog.Push({{std::move(msg), format}});
 
-    // ensures thread-safe logging from merge thread
-    emit LogRequested(msg);
+    // outside a merge nothing else drains, lines from the ui thread itself show up right away
+    if (QThread::currentThread() == thread()) {
+        DrainLog();
+    }
 }
 
-void ModMerger::Log(QString msg, int logFormat) {
-    Format format = static_cast<Format>(logFormat);
-
+void ModMerger::Write(const QString& msg, Format format) {
     Log(msg, format);
 }
 
-ModMerger::ModPriority ModMerger::GetModPriority() {
-    return currentPriority;
+void ModMerger::WriteBatch(std::span<const Line> lines) {
+    pendingLog.Push({lines.begin(), lines.end()});
 }
 
-std::string ModMerger::Mod1Name() {
-    return mod1Name;
+void ModMerger::DrainLog() {
+    std::vector<Line> lines = pendingLog.Drain();
+    if (lines.empty()) {
+        return;
+    }
+
+    QStringList html;
+    html.reserve(lines.size());
+    for (const Line& line : lines) {
+        html.append(FormatTextForBrowser(line.msg, line.format));
+    }
+
+    ui->mergeStatusText->append(html.join("<br>"));
+    ui->mergeStatusText->moveCursor(QTextCursor::End);
 }
 
-std::string ModMerger::Mod2Name() {
-    return mod2Name;
+ModMerger::ModPriority ModMerger::Decide(const std::string&, const std::string&,
+                                         const std::vector<std::string>& conflicts) {
+    // the engine serialises requests, so the dialog state is only touched by one thread at a time
+    dialogChoice = ModPriority::NotSet;
+    priorityConflicts = conflicts;
+    QMetaObject::invokeMethod(this, &ModMerger::OpenPriorityDialog, Qt::BlockingQueuedConnection);
+    priorityConflicts.clear();
+    return dialogChoice;
 }
 
 ModMerger::~ModMerger() {
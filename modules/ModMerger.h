@@ -3,72 +3,64 @@
 
 #pragma once
 
+#include <memory>
 #include <QDialog>
 #include <QFuture>
 #include <QListWidget>
 #include <QTextBrowser>
+#include <QTimer>
 
+#include "modules/BatchQueue.h"
 #include "modules/Common.h"
+#include "modules/MergeEngine.h"
 
 namespace Ui {
 class ModMerger;
 }
 
-class ModMerger : public QDialog {
+class ModMerger : public QDialog, private MergeLogger, private PriorityPolicy {
     Q_OBJECT
 
 signals:
-    void CleanUpRequested(bool aborted);
-    void LogRequested(QString msg);
+    void MergeFinished(bool aborted);
 
 public:
     explicit ModMerger(QWidget* parent = nullptr);
     ~ModMerger();
 
-    enum class ModPriority : int { NotSet, Mod1, Mod2 };
-    enum class Format : int { Default, Yellow, BoldRed, BoldGreen };
+    using ModPriority = PriorityPolicy::ModPriority;
+    using Format = MergeLogger::Format;
 
-    std::string Mod1Name();
-    std::string Mod2Name();
-    ModPriority GetModPriority();
     void OpenPriorityDialog();
 
     QString FormatTextForBrowser(QString input, Format format);
     void Log(QString msg, Format = Format::Default);
-    void Log(QString msg, int format);
 
 private:
-    void AttemptMerge();
-    void GetConflictedFiles();
-
-    void CombineModFiles();
-    bool GetMergeFiles(std::filesystem::path mod1Base, std::filesystem::path mod2Base);
-    std::string GetFileType(const std::vector<char>& filedata);
-    bool ChooseBaseFile(std::filesystem::path targetFile, std::filesystem::path mod1File,
-                        std::filesystem::path mod2File);
-
-    std::filesystem::path StandardizeBasePath(std::filesystem::path basePath);
-    std::filesystem::path GetUpdatedFile(std::filesystem::path relative_path);
+    // engine callbacks, they all arrive on merge worker threads
+    void Write(const QString& msg, Format format) override;
+    void WriteBatch(std::span<const Line> lines) override;
+    ModPriority Decide(const std::string& mod1Name, const std::string& mod2Name,
+                       const std::vector<std::string>& conflicts) override;
 
     void EnforceTwoItemLimit();
     void RefreshModList();
+    // appends everything logged since the last call to the status text in one go
+    void DrainLog();
 
     Ui::ModMerger* ui;
     QList<QListWidgetItem*> selectedHistory;
-    std::vector<std::string> conflictedFiles;
+    std::unique_ptr<MergeEngine> engine;
     QFuture<void> activeMerge;
 
-    std::string mod1Name = "";
-    std::string mod2Name = "";
-    ModPriority currentPriority = ModPriority::NotSet;
+    // lines from any thread wait here, the ui thread drains them on logTimer while a merge runs
+    BatchQueue<Line> pendingLog;
+    QTimer logTimer;
+
+    ModPriority dialogChoice = ModPriority::NotSet;
+    std::vector<std::string> priorityConflicts;
 
     const std::filesystem::path modPath = Common::GetBBLFilesPath() / "Mods";
-    const std::filesystem::path baseTempPath =
-        Common::GetBBLFilesPath() / "Temp" / "ModMerge" / "merged";
-    const std::filesystem::path mod1TempPath =
-        Common::GetBBLFilesPath() / "Temp" / "ModMerge" / "1";
-    const std::filesystem::path mod2TempPath =
-        Common::GetBBLFilesPath() / "Temp" / "ModMerge" / "2";
 
     const std::vector<std::string> BBFolders = {
         "dvdroot_ps4", "action", "adhoc", "chr",    "event", "facegen", "map",      "menu",
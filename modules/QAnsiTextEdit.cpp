@@ -1,5 +1,8 @@
 #include "QAnsiTextEdit.h"
 #include <QtCore/QDebug>
+#include <QtGui/QTextCursor>
+#include <QtGui/QTextDocument>
+#include <QtWidgets/QScrollBar>
 
 // clang-format off
 
@@ -16,257 +19,270 @@ QAnsiTextEditFormattedText::QAnsiTextEditFormattedText(const QString& txt, const
 //
 QList<QAnsiTextEditFormattedText> QAnsiTextEditEscapeCodeHandler::parseText (const QAnsiTextEditFormattedText& input) {
 
-    enum AnsiEscapeCodes {
-        ResetFormat            =  0,
-        BoldText               =  1,
-        UnderLinedText         =  4,
-        TextColorStart         = 30,
-        TextColorEnd           = 37,
-        RgbTextColor           = 38,
-        DefaultTextColor       = 39,
-        BackgroundColorStart   = 40,
-        BackgroundColorEnd     = 47,
-        RgbBackgroundColor     = 48,
-        DefaultBackgroundColor = 49
-    };
-
-    const QString escape        = "\x1b[";
-    const QChar semicolon       = ';';
+    const QChar escape          = QChar(0x1b);
+    const QChar bell            = QChar(7);
     const QChar colorTerminator = 'm';
-    const QChar eraseToEol      = 'K';
 
     QList<QAnsiTextEditFormattedText> outputData;
     QTextCharFormat                   charFormat = _previousFormatClosed ? input.format : _previousFormat;
-    QString                           strippedText;
 
-    if (_pendingText.isEmpty()) {
-        strippedText = input.text;
-    }else{
-        strippedText = _pendingText.append(input.text);
-        _pendingText.clear();
-    }
+    const QString& text  = input.text;
+    qsizetype      start = 0;
 
-    while (!strippedText.isEmpty()) {
-        if (_waitingForTerminator) {
-            // We ignore all escape codes taking string arguments.
-            QString terminator = "\x1b\\";
-            int terminatorPos = strippedText.indexOf(terminator);
-            if (terminatorPos == -1 && !_alternateTerminator.isEmpty()) {
-                terminator    = _alternateTerminator;
-                terminatorPos = strippedText.indexOf(terminator);
-            }
-            if (terminatorPos == -1) {
-                _pendingText = strippedText;
-                break;
-            }
-            _waitingForTerminator = false;
-            _alternateTerminator.clear();
-            strippedText.remove(0, terminatorPos + terminator.length());
-            if (strippedText.isEmpty()) {
-                break;
-            }
+    // Plain text is cut out in runs, neighbouring runs with the same format are merged.
+    auto addRun = [&](qsizetype end) {
+        if (end <= start) {
+            return;
         }
-
-        const int escapePos = strippedText.indexOf(escape.at(0));
-        if (escapePos < 0) {
-            outputData << QAnsiTextEditFormattedText(strippedText, charFormat);
-            break;
-        }else if (escapePos != 0) {
-            outputData << QAnsiTextEditFormattedText(strippedText.left(escapePos), charFormat);
-            strippedText.remove(0, escapePos);
+        if (!outputData.isEmpty() && outputData.last().format == charFormat) {
+            outputData.last().text += QStringView(text).sliced(start, end - start);
+        }else{
+            outputData << QAnsiTextEditFormattedText(text.mid(start, end - start), charFormat);
         }
+    };
 
-        while (!strippedText.isEmpty() && escape.at(0) == strippedText.at(0)) {
+    qsizetype i = 0;
+    while (i < text.size()) {
+        const QChar c = text.at(i);
 
-            if (escape.startsWith(strippedText)) {
-                // control secquence is not complete
-                _pendingText += strippedText;
-                strippedText.clear();
+        switch (_state) {
+            case State::Text:
+                if (c == escape) {
+                    addRun(i);
+                    _state = State::Escape;
+                }
+                ++i;
                 break;
-            }
 
-            if (!strippedText.startsWith(escape)) {
-                switch (strippedText.at(1).toLatin1()) {
+            case State::Escape:
+                switch (c.toLatin1()) {
+                    case '[':
+                        _params.clear();
+                        _param           = 0;
+                        _hasParam        = false;
+                        _privateSequence = false;
+                        _state           = State::ControlSequence;
+                        break;
                     case '\\': // Unexpected terminator sequence.
                         Q_FALLTHROUGH();
                     case 'N': case 'O': // Ignore unsupported single-character sequences.
-                        strippedText.remove(0, 2);
+                        _state = State::Text;
+                        start  = i + 1;
                         break;
                     case ']':
-                        _alternateTerminator = QChar(7);
-                        Q_FALLTHROUGH();
+                        _bellTerminates = true;
+                        _state          = State::String;
+                        break;
                     case 'P':  case 'X': case '^': case '_':
-                        strippedText.remove(0, 2);
-                        _waitingForTerminator = true;
+                        // We ignore all escape codes taking string arguments.
+                        _bellTerminates = false;
+                        _state          = State::String;
                         break;
                     default:
-                        // not a control sequence
-                        _pendingText.clear();
-                        outputData << QAnsiTextEditFormattedText(strippedText.left(1), charFormat);
-                        strippedText.remove(0, 1);
+                        // not a control sequence, the escape is shown and c is read as text
+                        if (!outputData.isEmpty() && outputData.last().format == charFormat) {
+                            outputData.last().text += escape;
+                        }else{
+                            outputData << QAnsiTextEditFormattedText(QString(escape), charFormat);
+                        }
+                        _state = State::Text;
+                        start  = i;
                         continue;
                 }
+                ++i;
                 break;
-            }
-
-            _pendingText += strippedText.mid(0, escape.length());
-            strippedText.remove(0, escape.length());
-
-            // \e[K is not supported. Just strip it.
-            if (strippedText.startsWith(eraseToEol)) {
-                _pendingText.clear();
-                strippedText.remove(0, 1);
-                continue;
-            }
-
-            // get the number
-            QString     strNumber;
-            QStringList numbers;
 
-            while (!strippedText.isEmpty()) {
-                if (strippedText.at(0).isDigit()) {
-                    strNumber += strippedText.at(0);
-                }else{
-                    if (!strNumber.isEmpty()) {
-                        numbers << strNumber;
+            case State::ControlSequence:
+                if (c.isDigit()) {
+                    // clamped, a colour never needs more and it can't overflow
+                    _param    = qMin(_param * 10 + uint(c.digitValue()), 9999u);
+                    _hasParam = true;
+                }else if (c == ';') {
+                    _params << _param;
+                    _param    = 0;
+                    _hasParam = false;
+                }else if (c.unicode() >= 0x20 && c.unicode() <= 0x3f) {
+                    // private parameters and intermediates, e.g. \e[?25l
+                    _privateSequence = true;
+                }else if (c.unicode() >= 0x40 && c.unicode() <= 0x7e) {
+                    if (_hasParam || !_params.isEmpty()) {
+                        _params << _param;
                     }
-                    if (strNumber.isEmpty() || strippedText.at(0) != semicolon) {
-                        break;
+                    // Only colours are supported, everything else (\e[K, cursor movement) is stripped.
+                    if (c == colorTerminator && !_privateSequence) {
+                        applyRendition(charFormat, input.format);
                     }
-                    strNumber.clear();
+                    _state = State::Text;
+                    start  = i + 1;
+                }else{
+                    // broken sequence, drop it and read c as text
+                    _state = State::Text;
+                    start  = i;
+                    continue;
                 }
-                _pendingText += strippedText.mid(0, 1);
-                strippedText.remove(0, 1);
-            }
+                ++i;
+                break;
 
-            if (strippedText.isEmpty()) {
+            case State::String:
+                if (c == escape) {
+                    _state = State::StringEscape;
+                }else if (c == bell && _bellTerminates) {
+                    _state = State::Text;
+                    start  = i + 1;
+                }
+                ++i;
                 break;
-            }
 
-            // remove terminating char
-            if (!strippedText.startsWith(colorTerminator)) {
-                _pendingText.clear();
-                strippedText.remove(0, 1);
+            case State::StringEscape:
+                if (c == '\\') {
+                    _state = State::Text;
+                    start  = i + 1;
+                }else if (c != escape) {
+                    _state = State::String;
+                }
+                ++i;
                 break;
-            }
+        }
+    }
 
-            // got consistent control sequence, ok to clear pending text
-            _pendingText.clear();
-            strippedText.remove(0, 1);
+    if (_state == State::Text) {
+        addRun(text.size());
+    }
 
-            if (numbers.isEmpty()) {
-                charFormat = input.format;
-                endFormatScope();
-            }
+    return outputData;
+}
+
+void QAnsiTextEditEscapeCodeHandler::applyRendition (QTextCharFormat& charFormat, const QTextCharFormat& defaultFormat) {
+
+    enum AnsiEscapeCodes {
+        ResetFormat            =  0,
+        BoldText               =  1,
+        UnderLinedText         =  4,
+        TextColorStart         = 30,
+        TextColorEnd           = 37,
+        RgbTextColor           = 38,
+        DefaultTextColor       = 39,
+        BackgroundColorStart   = 40,
+        BackgroundColorEnd     = 47,
+        RgbBackgroundColor     = 48,
+        DefaultBackgroundColor = 49
+    };
+
+    const QList<uint>& numbers = _params;
+
+    if (numbers.isEmpty()) {
+        charFormat = defaultFormat;
+        endFormatScope();
+    }
 
-            for (int i = 0; i < numbers.size(); ++i) {
+    for (int i = 0; i < numbers.size(); ++i) {
 
-                const uint code = numbers.at(i).toUInt();
+        const uint code = numbers.at(i);
 
-                if (code >= TextColorStart && code <= TextColorEnd) {
-                    //qDebug() << "TextColorStart/TextColorEnd called";
-                    charFormat.setForeground(ansiColor(code - TextColorStart));
+        if (code >= TextColorStart && code <= TextColorEnd) {
+            //qDebug() << "TextColorStart/TextColorEnd called";
+            charFormat.setForeground(ansiColor(code - TextColorStart));
+            setFormatScope(charFormat);
+        }else if (code >= BackgroundColorStart && code <= BackgroundColorEnd) {
+            //qDebug() << "BackgroundColorStart/BackgroundColorEnd called";
+            charFormat.setBackground(ansiColor(code - BackgroundColorStart));
+            setFormatScope(charFormat);
+        }else{
+            switch (code) {
+                case ResetFormat:
+                    //qDebug() << "ResetFormat called";
+                    charFormat.setFontWeight(QFont::Normal);
+                    charFormat.setFontUnderline(false);
+                    charFormat.setForeground(defaultFormat.foreground());
+                    charFormat.setBackground(defaultFormat.background());
                     setFormatScope(charFormat);
-                }else if (code >= BackgroundColorStart && code <= BackgroundColorEnd) {
-                    //qDebug() << "BackgroundColorStart/BackgroundColorEnd called";
-                    charFormat.setBackground(ansiColor(code - BackgroundColorStart));
+                    endFormatScope();
+                    break;
+                case BoldText:
+                    //qDebug() << "BoldText called";
+                    charFormat.setFontWeight(QFont::ExtraBold);
                     setFormatScope(charFormat);
-                }else{
-                    switch (code) {
-                        case ResetFormat:
-                            //qDebug() << "ResetFormat called";
-                            charFormat.setFontWeight(QFont::Normal);
-                            charFormat.setFontUnderline(false);
-                            charFormat.setForeground(input.format.foreground());
-                            charFormat.setBackground(input.format.background());
-                            setFormatScope(charFormat);
-                            endFormatScope();
-                            break;
-                        case BoldText:
-                            //qDebug() << "BoldText called";
-                            charFormat.setFontWeight(QFont::ExtraBold);
-                            setFormatScope(charFormat);
-                            break;
-                        case UnderLinedText:
-                            //qDebug() << "UnderLinedText called";
-                            charFormat.setFontUnderline(true);
-                            setFormatScope(charFormat);
-                            break;
-                        case DefaultTextColor:
-                            //qDebug() << "DefaultTextColor called";
-                            charFormat.setForeground(input.format.foreground());
-                            setFormatScope(charFormat);
-                            break;
-                        case DefaultBackgroundColor:
-                            //qDebug() << "DefaultBackgroundColor called";
-                            charFormat.setBackground(input.format.background());
-                            setFormatScope(charFormat);
+                    break;
+                case UnderLinedText:
+                    //qDebug() << "UnderLinedText called";
+                    charFormat.setFontUnderline(true);
+                    setFormatScope(charFormat);
+                    break;
+                case DefaultTextColor:
+                    //qDebug() << "DefaultTextColor called";
+                    charFormat.setForeground(defaultFormat.foreground());
+                    setFormatScope(charFormat);
+                    break;
+                case DefaultBackgroundColor:
+                    //qDebug() << "DefaultBackgroundColor called";
+                    charFormat.setBackground(defaultFormat.background());
+                    setFormatScope(charFormat);
+                    break;
+                case RgbTextColor:
+                case RgbBackgroundColor:
+                    //qDebug() << "RgbTextColor/RgbBackgroundColor called";
+                    // See http://en.wikipedia.org/wiki/ANSI_escape_code#Colors
+                    if (++i >= numbers.size()) {
+                        break;
+                    }
+
+                    switch (numbers.at(i)) {
+                        case 2:
+                            // RGB set with format: 38;2;<r>;<g>;<b>
+                            if ((i + 3) < numbers.size()) {
+                                (code == RgbTextColor) ?
+                                    charFormat.setForeground(QColor(int(numbers.at(i + 1)),
+                                                int(numbers.at(i + 2)),
+                                                int(numbers.at(i + 3)))) :
+                                    charFormat.setBackground(QColor(int(numbers.at(i + 1)),
+                                                int(numbers.at(i + 2)),
+                                                int(numbers.at(i + 3))));
+                                setFormatScope(charFormat);
+                            }
+                            i += 3;
                             break;
-                        case RgbTextColor:
-                        case RgbBackgroundColor:
-                            //qDebug() << "RgbTextColor/RgbBackgroundColor called";
-                            // See http://en.wikipedia.org/wiki/ANSI_escape_code#Colors
-                            if (++i >= numbers.size()) {
+                        case 5: {
+                            // 256 color mode with format: 38;5;<i>
+                            if ((i + 1) >= numbers.size()) {
                                 break;
                             }
+                            uint index = numbers.at(i + 1);
+
+                            QColor color;
+                            if (index < 8) {
+                                // The first 8 colors are standard low-intensity ANSI colors.
+                                color = ansiColor(index);
+                            }else if (index < 16) {
+                                // The next 8 colors are standard high-intensity ANSI colors.
+                                color = ansiColor(index - 8).lighter(150);
+                            }else if (index < 232) {
+                                // The next 216 colors are a 6x6x6 RGB cube.
+                                uint o = index - 16;
+                                color = QColor((o / 36) * 51, ((o / 6) % 6) * 51, (o % 6) * 51);
+                            }else{
+                                // The last 24 colors are a greyscale gradient.
+                                int grey = int((qMin(index, 255u) - 232) * 11);
+                                color = QColor(grey, grey, grey);
+                            }
 
-                            switch (numbers.at(i).toInt()) {
-                                case 2:
-                                    // RGB set with format: 38;2;<r>;<g>;<b>
-                                    if ((i + 3) < numbers.size()) {
-                                        (code == RgbTextColor) ?
-                                            charFormat.setForeground(QColor(numbers.at(i + 1).toInt(),
-                                                        numbers.at(i + 2).toInt(),
-                                                        numbers.at(i + 3).toInt())) :
-                                            charFormat.setBackground(QColor(numbers.at(i + 1).toInt(),
-                                                        numbers.at(i + 2).toInt(),
-                                                        numbers.at(i + 3).toInt()));
-                                        setFormatScope(charFormat);
-                                    }
-                                    i += 3;
-                                    break;
-                                case 5:
-                                    // 256 color mode with format: 38;5;<i>
-                                    uint index = numbers.at(i + 1).toUInt();
-
-                                    QColor color;
-                                    if (index < 8) {
-                                        // The first 8 colors are standard low-intensity ANSI colors.
-                                        color = ansiColor(index);
-                                    }else if (index < 16) {
-                                        // The next 8 colors are standard high-intensity ANSI colors.
-                                        color = ansiColor(index - 8).lighter(150);
-                                    }else if (index < 232) {
-                                        // The next 216 colors are a 6x6x6 RGB cube.
-                                        uint o = index - 16;
-                                        color = QColor((o / 36) * 51, ((o / 6) % 6) * 51, (o % 6) * 51);
-                                    }else{
-                                        // The last 24 colors are a greyscale gradient.
-                                        int grey = int((index - 232) * 11);
-                                        color = QColor(grey, grey, grey);
-                                    }
-
-                                    if (code == RgbTextColor) {
-                                        charFormat.setForeground(color);
-                                    }else{
-                                        charFormat.setBackground(color);
-                                    }
-
-                                    setFormatScope(charFormat);
-                                    ++i;
-                                    break;
+                            if (code == RgbTextColor) {
+                                charFormat.setForeground(color);
+                            }else{
+                                charFormat.setBackground(color);
                             }
+
+                            setFormatScope(charFormat);
+                            ++i;
                             break;
-                        default:
-                            qDebug() << "Unkown code:" << code;
-                            break;
+                        }
                     }
-                }
+                    break;
+                default:
+                    qDebug() << "Unkown code:" << code;
+                    break;
             }
         }
     }
-
-    return outputData;
 }
 
 void QAnsiTextEditEscapeCodeHandler::endFormatScope () {
@@ -295,9 +311,15 @@ QColor QAnsiTextEditEscapeCodeHandler::ansiColor(uint code) {
 //
 //
 QAnsiTextEdit::QAnsiTextEdit (QWidget* parent) : QPlainTextEdit(parent) {
+
+    // One frame. The timer is not restarted by later lines, so a steady stream
+    // still gets drawn.
+    _flushTimer.setSingleShot(true);
+    _flushTimer.setInterval(16);
+    connect(&_flushTimer, &QTimer::timeout, this, &QAnsiTextEdit::flushAnsiLines);
 }
 
-QAnsiTextEdit::QAnsiTextEdit (const QString& text, QWidget* parent) : QPlainTextEdit(parent) {
+QAnsiTextEdit::QAnsiTextEdit (const QString& text, QWidget* parent) : QAnsiTextEdit(parent) {
 
     setAnsiText(text);
 }
@@ -325,6 +347,8 @@ void QAnsiTextEdit::setAnsiText (const QString& text) {
 
 void QAnsiTextEdit::appendAnsiText (const QString& text) {
 
+    flushAnsiLines();
+
     //
     // Use the 'append' method for the first sub text, then
     // the 'insert' method for every sub text after that.
@@ -364,6 +388,8 @@ void QAnsiTextEdit::appendAnsiText (const QString& text) {
 
 void QAnsiTextEdit::insertAnsiText (const QString& text) {
 
+    flushAnsiLines();
+
     //
     // Use the 'insert' method for every sub text.
     //
@@ -393,7 +419,71 @@ void QAnsiTextEdit::insertAnsiText (const QString& text) {
 }
 
 void QAnsiTextEdit::appendGrayText (const QString& text) {
+    flushAnsiLines();
     QString msg = "<span style='color: gray;'>" + text + "</span>";
     appendHtml(msg);
 }
 
+void QAnsiTextEdit::queueAnsiLines (const QStringList& lines) {
+
+    _pendingLines += lines;
+
+    if (!_flushTimer.isActive()) {
+        _flushTimer.start();
+    }
+}
+
+void QAnsiTextEdit::flushAnsiLines () {
+
+    _flushTimer.stop();
+
+    if (_pendingLines.isEmpty()) {
+        return;
+    }
+
+    QStringList lines = std::move(_pendingLines);
+    _pendingLines.clear();
+
+    QAnsiTextEditFormattedText ftext;
+    ftext.format = currentCharFormat();
+
+    //
+    // With a line limit set the document keeps only the newest lines. Lines
+    // that would be trimmed right away are never inserted, they only go through
+    // the parser for the colour they leave behind.
+    //
+    const int limit = maximumBlockCount();
+
+    qsizetype first = 0;
+    if (limit > 0 && lines.size() > limit) {
+        first = lines.size() - limit;
+        ftext.text = lines.mid(0, first).join('\n') + '\n';
+        _escapeCodeHandler.parseText(ftext);
+    }
+
+    // The whole batch is one parse and one edit, so layout and the scroll bar
+    // are only updated once.
+    ftext.text = lines.mid(first).join('\n');
+    QList<QAnsiTextEditFormattedText> ftexts = _escapeCodeHandler.parseText(ftext);
+
+    if (ftexts.isEmpty()) {
+        return;
+    }
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+
+    if (!document()->isEmpty()) {
+        cursor.insertBlock();
+    }
+
+    for (const QAnsiTextEditFormattedText& ftext : ftexts) {
+        cursor.insertText(ftext.text, ftext.format);
+    }
+
+    cursor.endEditBlock();
+
+    QScrollBar* sb = verticalScrollBar();
+    sb->setValue(sb->maximum());
+}
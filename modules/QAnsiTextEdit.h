@@ -5,7 +5,9 @@
 #include <QtGui/QColor>
 #include <QtGui/QTextCharFormat>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QList>
+#include <QtCore/QTimer>
 
 // clang-format off
 
@@ -26,13 +28,28 @@ class QAnsiTextEditEscapeCodeHandler {
         QTextCharFormat                     formatScope         () const;
 
     private:
+        // Where the parser stopped in the previous chunk. A sequence split across
+        // chunks is picked up from here instead of re-parsing text already seen.
+        enum class State {
+            Text,
+            Escape,                 // after ESC
+            ControlSequence,        // after ESC [
+            String,                 // OSC/DCS/SOS/PM/APC body, ignored
+            StringEscape            // ESC inside a string, maybe its terminator
+        };
+
+        void                                applyRendition      (QTextCharFormat& charFormat, const QTextCharFormat& defaultFormat);
         QColor                              ansiColor           (uint code);
 
         bool                                _previousFormatClosed = true;
-        bool                                _waitingForTerminator = false;
-        QString                             _alternateTerminator;
         QTextCharFormat                     _previousFormat;
-        QString                             _pendingText;
+
+        State                               _state = State::Text;
+        QList<uint>                         _params;
+        uint                                _param = 0;
+        bool                                _hasParam = false;
+        bool                                _privateSequence = false;
+        bool                                _bellTerminates = false;
 };
 
 class QAnsiTextEdit : public QPlainTextEdit {
@@ -53,8 +70,14 @@ class QAnsiTextEdit : public QPlainTextEdit {
         void            insertAnsiText          (const QString& text);
         void            appendGrayText          (const QString& text);
 
+        // Lines are collected and appended together at most once per frame.
+        void            queueAnsiLines          (const QStringList& lines);
+        void            flushAnsiLines          ();
+
     private:
         QAnsiTextEditEscapeCodeHandler      _escapeCodeHandler;
+        QStringList                         _pendingLines;
+        QTimer                              _flushTimer;
 
 };
 
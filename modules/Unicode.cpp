@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+#include "Unicode.h"
+
+namespace {
+
+// code points between the ascii blocks go through the scalar path this many units or bytes at a
+// time before the next block is tried
+constexpr size_t scalarRun = 16;
+
+uint16_t GetUnit(const char* units, size_t index) {
+    uint16_t unit;
+    std::memcpy(&unit, units + index * 2, sizeof(unit));
+    if constexpr (std::endian::native == std::endian::big) {
+        unit = std::byteswap(unit);
+    }
+    return unit;
+}
+
+void PutUnit(char*& out, uint32_t unit) {
+    uint16_t value = static_cast<uint16_t>(unit);
+    if constexpr (std::endian::native == std::endian::big) {
+        value = std::byteswap(value);
+    }
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+// encodes the code point at units[i], two units for a surrogate pair. returns the next index
+size_t EncodeOne(const char* units, size_t i, size_t count, char*& out) {
+    uint32_t cp = GetUnit(units, i++);
+
+    if (cp >= 0xD800 && cp <= 0xDBFF && i < count) {
+        uint32_t low = GetUnit(units, i);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            ++i;
+        }
+    }
+
+    if (cp <= 0x7F) {
+        *out++ = static_cast<char>(cp);
+    } else if (cp <= 0x7FF) {
+        *out++ = static_cast<char>(0xC0 | ((cp >> 6) & 0x1F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp <= 0xFFFF) {
+        *out++ = static_cast<char>(0xE0 | ((cp >> 12) & 0x0F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | ((cp >> 18) & 0x07));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return i;
+}
+
+// decodes the sequence at text[i] and moves i past it. stray continuation bytes are skipped,
+// false when the sequence is cut off by the end of the text
+bool DecodeOne(std::string_view text, size_t& i, char*& out) {
+    uint32_t cp = 0;
+    uint8_t b1 = static_cast<uint8_t>(text[i]);
+
+    if (b1 <= 0x7F) {
+        cp = b1;
+        i += 1;
+    } else if ((b1 & 0xE0) == 0xC0) {
+        if (i + 1 >= text.size())
+            return false;
+        uint8_t b2 = static_cast<uint8_t>(text[i + 1]);
+        cp = ((b1 & 0x1F) << 6) | (b2 & 0x3F);
+        i += 2;
+    } else if ((b1 & 0xF0) == 0xE0) {
+        if (i + 2 >= text.size())
+            return false;
+        uint8_t b2 = static_cast<uint8_t>(text[i + 1]);
+        uint8_t b3 = static_cast<uint8_t>(text[i + 2]);
+        cp = ((b1 & 0x0F) << 12) | ((b2 & 0x3F) << 6) | (b3 & 0x3F);
+        i += 3;
+    } else if ((b1 & 0xF8) == 0xF0) {
+        if (i + 3 >= text.size())
+            return false;
+        uint8_t b2 = static_cast<uint8_t>(text[i + 1]);
+        uint8_t b3 = static_cast<uint8_t>(text[i + 2]);
+        uint8_t b4 = static_cast<uint8_t>(text[i + 3]);
+        cp = ((b1 & 0x07) << 18) | ((b2 & 0x3F) << 12) | ((b3 & 0x3F) << 6) | (b4 & 0x3F);
+        i += 4;
+    } else {
+        i += 1;
+        return true;
+    }
+
+    if (cp <= 0xFFFF) {
+        PutUnit(out, cp);
+    } else if (cp <= 0x10FFFF) {
+        cp -= 0x10000;
+        PutUnit(out, 0xD800 + ((cp >> 10) & 0x03FF));
+        PutUnit(out, 0xDC00 + (cp & 0x03FF));
+    }
+    return true;
+}
+
+#if defined(__AVX2__)
+
+// 16 units per block: a zero compare for the terminator, a test against ~0x7F for ascii and a
+// saturating pack down to bytes, or a zero extend up to units the other way
+bool NulBlocks(const char* units, size_t count, size_t& i) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 16 <= count; i += 16) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(units + i * 2));
+        __m256i zeros = _mm256_cmpeq_epi16(block, zero);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(zeros));
+        if (mask != 0) {
+            i += std::countr_zero(mask) / 2;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsciiUnitBlocks(const char* units, size_t count, size_t& i, char*& out) {
+    const __m256i nonAscii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 16 <= count; i += 16, out += 16) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(units + i * 2));
+        if (!_mm256_testz_si256(block, nonAscii)) {
+            return;
+        }
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(block),
+                                         _mm256_extracti128_si256(block, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+    }
+}
+
+void AsciiByteBlocks(std::string_view text, size_t& i, char*& out) {
+    for (; i + 16 <= text.size(); i += 16, out += 32) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        if (_mm_movemask_epi8(block) != 0) {
+            return;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(block));
+    }
+}
+
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+
+// the same blocks on neon, narrowing moves stand in for the pack and the widening ones for the
+// zero extend
+bool NulBlocks(const char* units, size_t count, size_t& i) {
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t block =
+            vreinterpretq_u16_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(units + i * 2)));
+        uint8x8_t zeros = vmovn_u16(vceqzq_u16(block));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(zeros), 0);
+        if (mask != 0) {
+            i += std::countr_zero(mask) / 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsciiUnitBlocks(const char* units, size_t count, size_t& i, char*& out) {
+    for (; i + 16 <= count; i += 16, out += 16) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(units + i * 2);
+        uint16x8_t low = vreinterpretq_u16_u8(vld1q_u8(src));
+        uint16x8_t high = vreinterpretq_u16_u8(vld1q_u8(src + 16));
+        if (vmaxvq_u16(vorrq_u16(low, high)) > 0x7F) {
+            return;
+        }
+        vst1q_u8(reinterpret_cast<uint8_t*>(out), vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+}
+
+void AsciiByteBlocks(std::string_view text, size_t& i, char*& out) {
+    for (; i + 16 <= text.size(); i += 16, out += 32) {
+        uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(text.data() + i));
+        if (vmaxvq_u8(block) > 0x7F) {
+            return;
+        }
+        uint8_t* dest = reinterpret_cast<uint8_t*>(out);
+        vst1q_u8(dest, vreinterpretq_u8_u16(vmovl_u8(vget_low_u8(block))));
+        vst1q_u8(dest + 16, vreinterpretq_u8_u16(vmovl_high_u8(block)));
+    }
+}
+
+#else
+
+bool NulBlocks(const char*, size_t, size_t&) {
+    return false;
+}
+
+void AsciiUnitBlocks(const char*, size_t, size_t&, char*&) {}
+
+void AsciiByteBlocks(std::string_view, size_t&, char*&) {}
+
+#endif
+
+} // namespace
+
+namespace Unicode {
+
+size_t Utf16Length(std::span<const char> utf16) {
+    const size_t count = utf16.size() / 2;
+    size_t i = 0;
+    if (NulBlocks(utf16.data(), count, i)) {
+        return i;
+    }
+
+    for (; i < count; i++) {
+        if (GetUnit(utf16.data(), i) == 0) {
+            return i;
+        }
+    }
+    return count;
+}
+
+size_t Utf16ToUtf8(std::span<const char> utf16, char* out) {
+    const char* units = utf16.data();
+    const size_t count = utf16.size() / 2;
+    char* start = out;
+
+    size_t i = 0;
+    while (i < count) {
+        AsciiUnitBlocks(units, count, i, out);
+        const size_t runEnd = std::min(count, i + scalarRun);
+        while (i < runEnd) {
+            i = EncodeOne(units, i, count, out);
+        }
+    }
+    return out - start;
+}
+
+size_t Utf8ToUtf16(std::string_view utf8, char* out) {
+    char* start = out;
+
+    size_t i = 0;
+    while (i < utf8.size()) {
+        AsciiByteBlocks(utf8, i, out);
+        const size_t runEnd = std::min(utf8.size(), i + scalarRun);
+        while (i < runEnd) {
+            if (!DecodeOne(utf8, i, out)) {
+                return out - start;
+            }
+        }
+    }
+    return out - start;
+}
+
+size_t Utf16LengthScalar(std::span<const char> utf16) {
+    const size_t count = utf16.size() / 2;
+    for (size_t i = 0; i < count; i++) {
+        if (GetUnit(utf16.data(), i) == 0) {
+            return i;
+        }
+    }
+    return count;
+}
+
+size_t Utf16ToUtf8Scalar(std::span<const char> utf16, char* out) {
+    const size_t count = utf16.size() / 2;
+    char* start = out;
+    for (size_t i = 0; i < count;) {
+        i = EncodeOne(utf16.data(), i, count, out);
+    }
+    return out - start;
+}
+
+size_t Utf8ToUtf16Scalar(std::string_view utf8, char* out) {
+    char* start = out;
+    for (size_t i = 0; i < utf8.size();) {
+        if (!DecodeOne(utf8, i, out)) {
+            break;
+        }
+    }
+    return out - start;
+}
+
+} // namespace Unicode
@@ -0,0 +1,31 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+// utf-16le <-> utf-8 over spans. runs of ascii go through simd, everything else one code point at
+// a time. nothing is validated: unpaired surrogates come out as their three byte form and go back
+// to the same unit, so any utf-16 text survives a round trip through utf-8 unchanged
+namespace Unicode {
+
+// code units before the first nul of utf-16le data, all of them when there is none
+size_t Utf16Length(std::span<const char> utf16);
+
+// writes the utf-8 form of utf-16le data to out, which needs room for three bytes per code
+// unit. returns the bytes written
+size_t Utf16ToUtf8(std::span<const char> utf16, char* out);
+
+// writes the utf-16le form of utf-8 text to out, which needs room for two bytes per input byte.
+// a sequence cut off by the end of the text ends the conversion. returns the bytes written
+size_t Utf8ToUtf16(std::string_view utf8, char* out);
+
+// scalar reference paths, kept exported so the simd paths can be benchmarked against them
+size_t Utf16LengthScalar(std::span<const char> utf16);
+size_t Utf16ToUtf8Scalar(std::span<const char> utf16, char* out);
+size_t Utf8ToUtf16Scalar(std::string_view utf8, char* out);
+
+} // namespace Unicode
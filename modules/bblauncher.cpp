@@ -9,7 +9,6 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QProcess>
-#include <QScrollBar>
 
 #include "Log.h"
 #include "bblauncher.h"
@@ -110,6 +109,7 @@ BBLauncher::BBLauncher(bool noGUI, bool noInstanceRunning, QWidget* parent)
     ui->logLayout->addWidget(logDisplay);
 
     Config::LoadSettings();
+    Config::SetTheme(Config::theme);
 
     UserSettings.Load();
     m_emu_settings->Load();
@@ -153,6 +153,9 @@ BBLauncher::BBLauncher(bool noGUI, bool noInstanceRunning, QWidget* parent)
     ui->logLayout->addWidget(logDisplay);
     logDisplay->setPalette(palette);
     logDisplay->setReadOnly(true);
+    // the oldest lines are dropped past the limit, a long trace session stays bounded
+    logDisplay->setUndoRedoEnabled(false);
+    logDisplay->setMaximumBlockCount(std::max(Config::LogDisplayLines, 0));
     logDisplay->appendHtml("<span style=\"color: gray; font-weight: bold;\">Log Display</span>");
     LogSettings();
 
@@ -178,7 +181,7 @@ BBLauncher::BBLauncher(bool noGUI, bool noInstanceRunning, QWidget* parent)
     }
 #endif
 
-    connect(m_ipc_client.get(), &IpcClient::LogEntrySent, this, &BBLauncher::PrintLog);
+    connect(m_ipc_client.get(), &IpcClient::LogEntriesSent, this, &BBLauncher::PrintLog);
     connect(ui->ShadSelectButton, &QPushButton::pressed, this,
             &BBLauncher::ShadSelectButton_isPressed);
     connect(launchButton, &QPushButton::pressed, this,
@@ -435,10 +438,8 @@ BBLauncher::BBLauncher(bool noGUI, bool noInstanceRunning, QWidget* parent)
         StartGameWithArgs({});
 }
 
-void BBLauncher::PrintLog(QString entry) {
-    logDisplay->appendAnsiText(entry);
-    QScrollBar* sb = logDisplay->verticalScrollBar();
-    sb->setValue(sb->maximum());
+void BBLauncher::PrintLog(QStringList entries) {
+    logDisplay->queueAnsiLines(entries);
 }
 
 void BBLauncher::ShadSelectButton_isPressed() {
@@ -31,7 +31,7 @@ public slots:
 private slots:
     void ShadSelectButton_isPressed();
     void onGameClosed();
-    void PrintLog(QString entry);
+    void PrintLog(QStringList entries);
     void OpenFolders();
 
 private:
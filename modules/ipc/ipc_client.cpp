@@ -21,6 +21,7 @@ void IpcClient::startEmulator(const QFileInfo& exe, const QStringList& args,
         process->deleteLater();
         process = nullptr;
     }
+    stdoutBuffer.clear();
     process = new QProcess(this);
 
     connect(process, &QProcess::readyReadStandardOutput, this, [=, this] { onStdout(); });
@@ -38,8 +39,8 @@ void IpcClient::startEmulator(const QFileInfo& exe, const QStringList& args,
         if (std::filesystem::exists(Config::CustomUserFolder)) {
             userPath = Config::CustomUserFolder.parent_path();
         } else {
-            emit LogEntrySent(
-                "Custom user folder does not exist, falling back to default location");
+            emit LogEntriesSent(
+                {"Custom user folder does not exist, falling back to default location"});
             userPath = Common::shadPs4Executable.parent_path();
         }
     } else {
@@ -193,11 +194,25 @@ void IpcClient::onStderr() {
 }
 
 void IpcClient::onStdout() {
-    QByteArray data = process->readAllStandardOutput();
-    QString dataString = QString::fromUtf8(data);
+    stdoutBuffer.append(process->readAllStandardOutput());
+
+    // a read can end mid line, the rest of it comes with the next one
+    qsizetype end = stdoutBuffer.lastIndexOf('\n');
+    if (end == -1) {
+        return;
+    }
+    QString dataString = QString::fromUtf8(stdoutBuffer.constData(), end);
+    stdoutBuffer.remove(0, end + 1);
+
     QStringList lines = dataString.split('\n');
+    QStringList entries;
+    entries.reserve(lines.size());
 #define ESC "\x1b"
     for (QString& entry : lines) {
+        entry = entry.trimmed();
+        if (entry.isEmpty()) {
+            continue;
+        }
 
 #ifdef Q_OS_WIN
         const char* color = "";
@@ -214,13 +229,24 @@ void IpcClient::onStdout() {
 
         entry = color + entry;
 #endif
-        emit LogEntrySent(entry.trimmed());
+        entries.append(std::move(entry));
     }
 
 #undef ESC
+    // one signal per read, the log view batches further
+    if (!entries.isEmpty()) {
+        emit LogEntriesSent(entries);
+    }
 }
 
 void IpcClient::onProcessClosed() {
+    if (process) {
+        // a last line without a newline
+        stdoutBuffer.append('\n');
+        onStdout();
+        stdoutBuffer.clear();
+    }
+
     gameClosedFunc();
     if (process) {
         process->disconnect();
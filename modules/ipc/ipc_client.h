@@ -33,7 +33,7 @@ class IpcClient : public QObject {
     Q_OBJECT
 
 signals:
-    void LogEntrySent(QString entry);
+    void LogEntriesSent(QStringList entries);
 
 public:
     explicit IpcClient(QObject* parent = nullptr);
@@ -75,6 +75,7 @@ private:
 
     QProcess* process = nullptr;
     QByteArray buffer;
+    QByteArray stdoutBuffer;
     bool pendingRestart = false;
 
     ParsingState parsingState;
@@ -1,12 +1,11 @@
 // SPDX-FileCopyrightText: Copyright 2024 BBLauncher Project
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include <QApplication>
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QMessageBox>
 #include <QRegularExpression>
+#include <SDL3/SDL_messagebox.h>
 
 #include "config.h"
 #include "emulator_settings.h"
@@ -22,6 +21,7 @@ std::string Config::ApiKey = "";
 std::string Config::theme = "Dark";
 bool Config::SoundFixEnabled = true;
 bool Config::AutoUpdateEnabled = false;
+int Config::LogDisplayLines = 10000;
 Config::FolderLocation Config::UserFolderLocation = Config::FolderLocation::BuildFolder;
 std::filesystem::path Config::CustomUserFolder = "";
 
@@ -41,11 +41,21 @@ std::string Config::DefaultFolderString = "";
 
 std::string Config::TrophyKey = "";
 
+int Config::MergeThreads = 0;
+int Config::MergeCompressionLevel = 9;
+int Config::MergeCompressionThreads = 0;
+int Config::MergeCacheSizeMB = 2048;
+
 bool Config::GameRunning = false;
 bool Config::GameSpecificConfigUsed = false;
 
 static std::string SelectedGamepad = "";
 
+// config is part of the merge core that bbl-merge links too, so errors are shown without widgets
+static void ShowFilesystemError(const std::string& message) {
+    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Filesystem error", message.c_str(), nullptr);
+}
+
 namespace Config {
 
 void LoadSettings() {
@@ -65,16 +75,16 @@ void LoadSettings() {
         ifs.open(SettingsFile, std::ios_base::binary);
         data = toml::parse(ifs, std::string{fmt::UTF(SettingsFile.filename().u8string()).data});
     } catch (std::exception& ex) {
-        QMessageBox::critical(NULL, "Filesystem error", ex.what());
+        ShowFilesystemError(ex.what());
         return;
     }
 
     ApiKey = toml::find_or<std::string>(data, "Launcher", "ApiKey", "");
     theme = toml::find_or<std::string>(data, "Launcher", "Theme", "Dark");
-    Config::SetTheme(theme);
 
     SoundFixEnabled = toml::find_or<bool>(data, "Launcher", "SoundFixEnabled", true);
     AutoUpdateEnabled = toml::find_or<bool>(data, "Launcher", "AutoUpdateEnabled", false);
+    LogDisplayLines = toml::find_or<int>(data, "Launcher", "LogDisplayLines", 10000);
     UserFolderLocation = static_cast<FolderLocation>(
         toml::find_or<int>(data, "Launcher", "UserFolderLocation",
                            static_cast<int>(FolderLocation::BuildFolder)));
@@ -95,6 +105,11 @@ void LoadSettings() {
     ClearCacheAfterUpdate =
         toml::find_or<bool>(data, "shadUpdater", "ClearCacheAfterUpdate", false);
 
+    MergeThreads = toml::find_or<int>(data, "ModMerger", "Threads", 0);
+    MergeCompressionLevel = toml::find_or<int>(data, "ModMerger", "CompressionLevel", 9);
+    MergeCompressionThreads = toml::find_or<int>(data, "ModMerger", "CompressionThreads", 0);
+    MergeCacheSizeMB = toml::find_or<int>(data, "ModMerger", "CacheSizeMB", 2048);
+
     if (data.contains("Launcher")) {
         const toml::value& launcher = data.at("Launcher");
 
@@ -212,6 +227,7 @@ void CreateSettingsFile() {
     data["Launcher"]["Theme"] = "Dark";
     data["Launcher"]["SoundFixEnabled"] = true;
     data["Launcher"]["AutoUpdateEnabled"] = false;
+    data["Launcher"]["LogDisplayLines"] = 10000;
     data["Launcher"]["UserFolderLocation"] = 0;
     data["Launcher"]["CustomUserFolder"] = "";
     data["Launcher"]["ApiKey"] = "";
@@ -229,6 +245,11 @@ void CreateSettingsFile() {
     data["shadUpdater"]["AutoUpdateShadEnabled"] = false;
     data["shadUpdater"]["ClearCacheAfterUpdate"] = false;
 
+    data["ModMerger"]["Threads"] = 0;
+    data["ModMerger"]["CompressionLevel"] = 9;
+    data["ModMerger"]["CompressionThreads"] = 0;
+    data["ModMerger"]["CacheSizeMB"] = 2048;
+
     std::ofstream file(SettingsFile, std::ios::binary);
     file << data;
     file.close();
@@ -245,19 +266,19 @@ void SaveLauncherSettings() {
             ifs.open(SettingsFile, std::ios_base::binary);
             data = toml::parse(ifs, std::string{fmt::UTF(SettingsFile.filename().u8string()).data});
         } catch (const std::exception& ex) {
-            QMessageBox::critical(NULL, "Filesystem error", ex.what());
+            ShowFilesystemError(ex.what());
             return;
         }
     } else {
         if (error) {
-            QMessageBox::critical(NULL, "Filesystem error",
-                                  QString::fromStdString(error.message()));
+            ShowFilesystemError(error.message());
         }
     }
     data["Launcher"]["ApiKey"] = ApiKey;
     data["Launcher"]["Theme"] = theme;
     data["Launcher"]["SoundFixEnabled"] = SoundFixEnabled;
     data["Launcher"]["AutoUpdateEnabled"] = AutoUpdateEnabled;
+    data["Launcher"]["LogDisplayLines"] = LogDisplayLines;
     data["Launcher"]["installPath"] = std::string{fmt::UTF(Common::installPath.u8string()).data};
     data["Launcher"]["shadPath-New"] =
         std::string{fmt::UTF(Common::shadPs4Executable.u8string()).data};
@@ -278,44 +299,16 @@ void SaveLauncherSettings() {
     data["shadUpdater"]["AutoUpdateShadEnabled"] = AutoUpdateShadEnabled;
     data["shadUpdater"]["ClearCacheAfterUpdate"] = ClearCacheAfterUpdate;
 
+    data["ModMerger"]["Threads"] = MergeThreads;
+    data["ModMerger"]["CompressionLevel"] = MergeCompressionLevel;
+    data["ModMerger"]["CompressionThreads"] = MergeCompressionThreads;
+    data["ModMerger"]["CacheSizeMB"] = MergeCacheSizeMB;
+
     std::ofstream file(SettingsFile, std::ios::binary);
     file << data;
     file.close();
 }
 
-void SetTheme(std::string theme) {
-    QPalette themePalette;
-    if (theme == "Dark") {
-        themePalette.setColor(QPalette::Window, QColor(50, 50, 50));
-        themePalette.setColor(QPalette::WindowText, Qt::white);
-        themePalette.setColor(QPalette::Base, QColor(20, 20, 20));
-        themePalette.setColor(QPalette::AlternateBase, QColor(53, 53, 53));
-        themePalette.setColor(QPalette::ToolTipBase, Qt::white);
-        themePalette.setColor(QPalette::ToolTipText, Qt::white);
-        themePalette.setColor(QPalette::Text, Qt::white);
-        themePalette.setColor(QPalette::Button, QColor(53, 53, 53));
-        themePalette.setColor(QPalette::ButtonText, Qt::white);
-        themePalette.setColor(QPalette::BrightText, Qt::red);
-        themePalette.setColor(QPalette::Link, QColor(42, 130, 218));
-        themePalette.setColor(QPalette::Highlight, QColor(42, 130, 218));
-        themePalette.setColor(QPalette::HighlightedText, Qt::black);
-    } else if (theme == "Light") {
-        themePalette.setColor(QPalette::Window, QColor(240, 240, 240));   // Light gray
-        themePalette.setColor(QPalette::WindowText, Qt::black);           // Black
-        themePalette.setColor(QPalette::Base, QColor(230, 230, 230, 80)); // Grayish
-        themePalette.setColor(QPalette::ToolTipBase, Qt::black);          // Black
-        themePalette.setColor(QPalette::ToolTipText, Qt::black);          // Black
-        themePalette.setColor(QPalette::Text, Qt::black);                 // Black
-        themePalette.setColor(QPalette::Button, QColor(240, 240, 240));   // Light gray
-        themePalette.setColor(QPalette::ButtonText, Qt::black);           // Black
-        themePalette.setColor(QPalette::BrightText, Qt::red);             // Red
-        themePalette.setColor(QPalette::Link, QColor(42, 130, 218));      // Blue
-        themePalette.setColor(QPalette::Highlight, QColor(42, 130, 218)); // Blue
-        themePalette.setColor(QPalette::HighlightedText, Qt::white);      // White
-    }
-    qApp->setPalette(themePalette);
-}
-
 std::string_view GetDefaultKeyboardConfig() {
     return R"(#Feeling lost? Check out the Help section!
 
@@ -447,13 +440,12 @@ Build GetCurrentBuildInfo() {
             data = toml::parse(
                 ifs, std::string{fmt::UTF(Config::SettingsFile.filename().u8string()).data});
         } catch (const std::exception& ex) {
-            QMessageBox::critical(nullptr, "Filesystem error", ex.what());
+            ShowFilesystemError(ex.what());
             return {};
         }
     } else {
         if (error) {
-            QMessageBox::critical(nullptr, "Filesystem error",
-                                  QString::fromStdString(error.message()));
+            ShowFilesystemError(error.message());
         }
     }
 
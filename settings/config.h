@@ -24,7 +24,7 @@ struct Build {
 
 void LoadSettings();
 void CreateSettingsFile();
-void SetTheme(std::string theme);
+void SetTheme(std::string theme); // launcher only, defined in theme.cpp
 std::filesystem::path GetFoolproofKbmConfigFile(const std::string& game_id);
 std::string_view GetDefaultKeyboardConfig();
 void CreateSettingsFile();
@@ -46,6 +46,7 @@ extern bool BackupSaveEnabled;
 extern int BackupInterval;
 extern int BackupNumber;
 extern bool AutoUpdateEnabled;
+extern int LogDisplayLines; // 0 keeps every line
 extern std::string ApiKey;
 
 extern bool ShowEarnedTrophy;
@@ -63,6 +64,11 @@ extern bool GameSpecificConfigUsed;
 
 extern std::string TrophyKey;
 
+extern int MergeCompressionLevel;
+extern int MergeThreads;            // 0 uses every hardware thread
+extern int MergeCompressionThreads; // 0 splits what MergeThreads leaves between files
+extern int MergeCacheSizeMB;        // 0 disables the vanilla file cache
+
 const std::filesystem::path SettingsFile = Common::GetBBLFilesPath() / "LauncherSettings.toml";
 
 } // namespace Config
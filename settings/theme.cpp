@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <QApplication>
+#include <QPalette>
+
+#include "config.h"
+
+// kept out of config.cpp, which the command line merger links without any gui
+namespace Config {
+
+void SetTheme(std::string theme) {
+    QPalette themePalette;
+    if (theme == "Dark") {
+        themePalette.setColor(QPalette::Window, QColor(50, 50, 50));
+        themePalette.setColor(QPalette::WindowText, Qt::white);
+        themePalette.setColor(QPalette::Base, QColor(20, 20, 20));
+        themePalette.setColor(QPalette::AlternateBase, QColor(53, 53, 53));
+        themePalette.setColor(QPalette::ToolTipBase, Qt::white);
+        themePalette.setColor(QPalette::ToolTipText, Qt::white);
+        themePalette.setColor(QPalette::Text, Qt::white);
+        themePalette.setColor(QPalette::Button, QColor(53, 53, 53));
+        themePalette.setColor(QPalette::ButtonText, Qt::white);
+        themePalette.setColor(QPalette::BrightText, Qt::red);
+        themePalette.setColor(QPalette::Link, QColor(42, 130, 218));
+        themePalette.setColor(QPalette::Highlight, QColor(42, 130, 218));
+        themePalette.setColor(QPalette::HighlightedText, Qt::black);
+    } else if (theme == "Light") {
+        themePalette.setColor(QPalette::Window, QColor(240, 240, 240));   // Light gray
+        themePalette.setColor(QPalette::WindowText, Qt::black);           // Black
+        themePalette.setColor(QPalette::Base, QColor(230, 230, 230, 80)); // Grayish
+        themePalette.setColor(QPalette::ToolTipBase, Qt::black);          // Black
+        themePalette.setColor(QPalette::ToolTipText, Qt::black);          // Black
+        themePalette.setColor(QPalette::Text, Qt::black);                 // Black
+        themePalette.setColor(QPalette::Button, QColor(240, 240, 240));   // Light gray
+        themePalette.setColor(QPalette::ButtonText, Qt::black);           // Black
+        themePalette.setColor(QPalette::BrightText, Qt::red);             // Red
+        themePalette.setColor(QPalette::Link, QColor(42, 130, 218));      // Blue
+        themePalette.setColor(QPalette::Highlight, QColor(42, 130, 218)); // Blue
+        themePalette.setColor(QPalette::HighlightedText, Qt::white);      // White
+    }
+    qApp->setPalette(themePalette);
+}
+
+} // namespace Config
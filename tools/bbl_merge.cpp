@@ -0,0 +1,247 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// bbl-merge: merges mods against the game files without the launcher ui
+//   bbl-merge --game <install folder> [options] <mod> <mod> [<mod>...]
+// mods are folder names in the mods folder or paths. more than two are folded left to right, the
+// merge of the first two is merged with the third and so on, only the last result is kept
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QMap>
+
+#include "modules/Common.h"
+#include "modules/MergeEngine.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class ConsoleLogger : public MergeLogger {
+public:
+    explicit ConsoleLogger(bool quiet) : quiet(quiet) {}
+
+    void Write(const QString& msg, Format format) override {
+        if (quiet && format == Format::Default) {
+            return;
+        }
+
+        std::lock_guard lock(outputMutex);
+        std::FILE* stream = Print(msg, format);
+        std::fflush(stream);
+    }
+
+    // one lock and one flush per file instead of per line
+    void WriteBatch(std::span<const Line> lines) override {
+        std::lock_guard lock(outputMutex);
+        bool flushErr = false;
+        for (const Line& line : lines) {
+            if (!quiet || line.format != Format::Default) {
+                flushErr |= Print(line.msg, line.format) == stderr;
+            }
+        }
+        std::fflush(stdout);
+        if (flushErr) {
+            std::fflush(stderr);
+        }
+    }
+
+private:
+    std::FILE* Print(const QString& msg, Format format) {
+        std::FILE* stream = format == Format::BoldRed ? stderr : stdout;
+        std::fprintf(stream, "%s\n", msg.toStdString().c_str());
+        return stream;
+    }
+
+    bool quiet;
+    std::mutex outputMutex;
+};
+
+class ConsolePriority : public PriorityPolicy {
+public:
+    enum class Mode { Ask, First, Last, Abort };
+
+    explicit ConsolePriority(Mode mode) : mode(mode) {}
+
+    ModPriority Decide(const std::string& mod1Name, const std::string& mod2Name,
+                       const std::vector<std::string>& conflicts) override {
+        if (mode == Mode::First) {
+            return ModPriority::Mod1;
+        } else if (mode == Mode::Last) {
+            return ModPriority::Mod2;
+        } else if (mode == Mode::Abort) {
+            return ModPriority::NotSet;
+        }
+
+        constexpr size_t maxListed = 10;
+        std::printf("The same information is modified by both mods:\n");
+        for (size_t i = 0; i < std::min(conflicts.size(), maxListed); i++) {
+            std::printf("  %s\n", conflicts[i].c_str());
+        }
+        if (conflicts.size() > maxListed) {
+            std::printf("  ...and %zu more\n", conflicts.size() - maxListed);
+        }
+        std::printf("[1] use data from %s\n[2] use data from %s\n[a] abort merge attempt\n> ",
+                    mod1Name.c_str(), mod2Name.c_str());
+        std::fflush(stdout);
+
+        // no answer, as with a closed stdin in a script, aborts
+        std::string answer;
+        std::getline(std::cin, answer);
+        if (answer == "1") {
+            return ModPriority::Mod1;
+        } else if (answer == "2") {
+            return ModPriority::Mod2;
+        }
+
+        return ModPriority::NotSet;
+    }
+
+private:
+    Mode mode;
+};
+
+fs::path ResolveMod(const QString& arg, const fs::path& modsFolder) {
+    fs::path path = arg.toStdU16String();
+    if (fs::is_directory(path)) {
+        return path;
+    }
+
+    return modsFolder / path;
+}
+
+int ReadInt(const QCommandLineParser& parser, const QCommandLineOption& option, int fallback) {
+    bool ok = false;
+    int value = parser.value(option).toInt(&ok);
+    return ok ? value : fallback;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bbl-merge");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Merges Bloodborne mods without the launcher ui");
+    parser.addHelpOption();
+    parser.addPositionalArgument("mods", "Mod folder names or paths, at least two", "<mod>...");
+
+    QCommandLineOption gameOption({"g", "game"}, "Game install folder or .zar", "path");
+    QCommandLineOption modsOption({"m", "mods-dir"}, "Folder mod names are looked up in", "path",
+                                  QString::fromStdU16String(Common::ModPath.u16string()));
+    QCommandLineOption outputOption({"o", "output"}, "Folder the merged mod is written to",
+                                    "path");
+    QCommandLineOption priorityOption(
+        {"p", "priority"}, "Unresolvable conflicts: ask, first, last or abort", "policy", "ask");
+    QCommandLineOption threadsOption({"j", "threads"}, "Merge threads, 0 uses every core", "n",
+                                     "0");
+    QCommandLineOption compressionThreadsOption(
+        "compression-threads", "Deflate threads per file, 0 splits what is left", "n", "0");
+    QCommandLineOption levelOption("level", "Deflate compression level", "n", "9");
+    QCommandLineOption cacheOption("cache-mb", "Vanilla file cache size, 0 disables it", "mb",
+                                   "2048");
+    QCommandLineOption workOption("work-dir", "Folder for scratch files", "path");
+    QCommandLineOption quietOption({"q", "quiet"}, "Only print warnings and errors");
+    parser.addOptions({gameOption, modsOption, outputOption, priorityOption, threadsOption,
+                       compressionThreadsOption, levelOption, cacheOption, workOption,
+                       quietOption});
+    parser.process(app);
+
+    const QStringList mods = parser.positionalArguments();
+    if (mods.size() < 2 || !parser.isSet(gameOption)) {
+        std::fprintf(stderr, "%s\n", parser.helpText().toStdString().c_str());
+        return 2;
+    }
+
+    const QMap<QString, ConsolePriority::Mode> modes = {{"ask", ConsolePriority::Mode::Ask},
+                                                        {"first", ConsolePriority::Mode::First},
+                                                        {"last", ConsolePriority::Mode::Last},
+                                                        {"abort", ConsolePriority::Mode::Abort}};
+    const QString priority = parser.value(priorityOption);
+    if (!modes.contains(priority)) {
+        std::fprintf(stderr, "Unknown priority policy: %s\n", priority.toStdString().c_str());
+        return 2;
+    }
+
+    fs::path gamePath = parser.value(gameOption).toStdU16String();
+    if (!fs::exists(gamePath)) {
+        std::fprintf(stderr, "Game not found: %s\n", Common::PathToU8(gamePath).c_str());
+        return 2;
+    }
+
+    fs::path modsFolder = parser.value(modsOption).toStdU16String();
+    fs::path outputFolder =
+        parser.isSet(outputOption) ? fs::path(parser.value(outputOption).toStdU16String())
+                                   : modsFolder;
+    // scratch files go in a folder of their own so parallel runs never share one
+    fs::path workBase = parser.isSet(workOption)
+                            ? fs::path(parser.value(workOption).toStdU16String())
+                            : fs::temp_directory_path();
+    fs::path workRoot =
+        workBase / ("bbl-merge-" + std::to_string(QCoreApplication::applicationPid()));
+
+    std::vector<fs::path> modFolders;
+    for (const QString& mod : mods) {
+        modFolders.push_back(ResolveMod(mod, modsFolder));
+        if (!fs::is_directory(modFolders.back())) {
+            std::fprintf(stderr, "Mod not found: %s\n", mod.toStdString().c_str());
+            return 2;
+        }
+    }
+
+    ConsoleLogger logger(parser.isSet(quietOption));
+    ConsolePriority policy(modes.value(priority));
+
+    MergeEngine::Options options;
+    options.gamePath = gamePath;
+    options.workFolder = workRoot / "merge";
+    options.cacheFolder = Common::GetBBLFilesPath() / "Cache" / "Vanilla";
+    options.cacheBytes = static_cast<uint64_t>(std::max(ReadInt(parser, cacheOption, 2048), 0))
+                         << 20;
+    options.threads = ReadInt(parser, threadsOption, 0);
+    options.compressionThreads = ReadInt(parser, compressionThreadsOption, 0);
+    options.compressionLevel = ReadInt(parser, levelOption, 9);
+
+    // intermediate merges of a longer list live in the work folder, only the last one is output
+    fs::path current = modFolders[0];
+    bool merged = true;
+    for (size_t i = 1; i < modFolders.size() && merged; i++) {
+        bool last = i + 1 == modFolders.size();
+        options.mod1Folder = current;
+        options.mod2Folder = modFolders[i];
+        options.outputFolder = last ? outputFolder : workRoot / "stage" / std::to_string(i);
+
+        MergeEngine engine(options, logger, policy);
+        if (engine.FindConflicts().empty()) {
+            logger.Write(QString("No conflicted files between %1 and %2, combining them as is")
+                             .arg(QString::fromStdString(engine.Mod1Name()),
+                                  QString::fromStdString(engine.Mod2Name())),
+                         MergeLogger::Format::Yellow);
+        }
+
+        merged = engine.Run();
+        current = engine.MergedFolder();
+
+        MergeEngine::LogStats logStats = engine.GetLogStats();
+        logger.Write(QString("Logged %1 lines in %2 ms")
+                         .arg(logStats.lines)
+                         .arg(logStats.seconds * 1e3, 0, 'f', 1));
+    }
+
+    std::error_code ec;
+    fs::remove_all(workRoot, ec);
+
+    if (!merged) {
+        logger.Write("Mod merge attempt aborted", MergeLogger::Format::BoldRed);
+        return 1;
+    }
+
+    logger.Write("Mod merge complete: " + QString::fromStdString(Common::PathToU8(current)),
+                 MergeLogger::Format::BoldGreen);
+    return 0;
+}
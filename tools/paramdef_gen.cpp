@@ -0,0 +1,299 @@
+// SPDX-FileCopyrightText: Copyright 2026 BBLauncher Project
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// paramdef-gen: compiles paramdef xmls into the constexpr tables behind ParamDefs::Find
+//   paramdef-gen <output.cpp> <paramdef.xml> [<paramdef.xml>...]
+// field layouts are packed here, and the seed of the param type hash is searched until every
+// type gets its own slot, so the launcher only indexes tables
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <pugixml.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "modules/BBFormats/ParamDefs.h"
+
+namespace fs = std::filesystem;
+using namespace FileHelper::ParamDefs;
+
+namespace {
+
+struct Field {
+    std::string name;
+    DefType type;
+    int arrayLength = 1;
+    int bitSize = -1;
+};
+
+struct Def {
+    std::string paramType;
+    std::string source;
+    std::vector<Field> fields;
+    std::vector<Column> columns;
+    uint32_t rowSize = 0;
+};
+
+const std::map<std::string, DefType> defTypes = {
+    {"s8", DefType::s8},         {"u8", DefType::u8},           {"s16", DefType::s16},
+    {"u16", DefType::u16},       {"s32", DefType::s32},         {"u32", DefType::u32},
+    {"b32", DefType::b32},       {"f32", DefType::f32},         {"angle32", DefType::angle32},
+    {"f64", DefType::f64},       {"dummy8", DefType::dummy8},   {"fixstr", DefType::fixstr},
+    {"fixstrW", DefType::fixstrW},
+};
+
+const char* TypeName(DefType type) {
+    for (const auto& [name, defType] : defTypes) {
+        if (defType == type) {
+            return name.c_str();
+        }
+    }
+    return "u8";
+}
+
+uint32_t TypeSize(DefType type) {
+    switch (type) {
+    case DefType::s16:
+    case DefType::u16:
+    case DefType::fixstrW:
+        return 2;
+    case DefType::s32:
+    case DefType::u32:
+    case DefType::b32:
+    case DefType::f32:
+    case DefType::angle32:
+        return 4;
+    case DefType::f64:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+// "type name", "type name[length]" or "type name:bits", each with an optional "= default"
+bool ParseDef(const std::string& text, Field& field) {
+    std::string def = text.substr(0, text.find('='));
+    std::istringstream stream(def);
+    std::string type;
+    std::string name;
+    if (!(stream >> type >> name)) {
+        return false;
+    }
+
+    auto defType = defTypes.find(type);
+    if (defType == defTypes.end()) {
+        return false;
+    }
+    field.type = defType->second;
+
+    try {
+        if (size_t bracket = name.find('['); bracket != std::string::npos) {
+            field.arrayLength = std::stoi(name.substr(bracket + 1));
+            name.erase(bracket);
+        } else if (size_t colon = name.find(':'); colon != std::string::npos) {
+            field.bitSize = std::stoi(name.substr(colon + 1));
+            name.erase(colon);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    field.name = name;
+    return !name.empty() && field.arrayLength > 0;
+}
+
+// bit fields fill a unit of their type's size until the next field doesn't fit or isn't a bit
+// field of the same size, the way the game packs them
+void PackColumns(Def& def) {
+    uint32_t offset = 0;
+    uint32_t unitSize = 0;
+    uint32_t bitOffset = 0;
+    for (const Field& field : def.fields) {
+        uint32_t size = TypeSize(field.type);
+        if (field.bitSize > 0 && size <= 4) {
+            if (unitSize != size || bitOffset + field.bitSize > size * 8) {
+                offset += unitSize;
+                unitSize = size;
+                bitOffset = 0;
+            }
+
+            uint32_t mask = field.bitSize >= 32 ? ~0u : ((1u << field.bitSize) - 1) << bitOffset;
+            def.columns.push_back({field.name, field.type, offset, size, mask});
+            bitOffset += field.bitSize;
+            continue;
+        }
+
+        offset += unitSize;
+        unitSize = 0;
+        bitOffset = 0;
+
+        size *= field.arrayLength;
+        def.columns.push_back({field.name, field.type, offset, size, 0});
+        offset += size;
+    }
+
+    def.rowSize = offset + unitSize;
+}
+
+bool LoadDef(const fs::path& path, Def& def) {
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_file(path.c_str());
+    if (!result) {
+        std::cerr << "ERROR: " << path.string() << ": " << result.description() << "\n";
+        return false;
+    }
+
+    pugi::xml_node root = doc.child("PARAMDEF");
+    def.paramType = root.child_value("ParamType");
+    def.source = path.filename().string();
+    if (def.paramType.empty()) {
+        std::cerr << "ERROR: " << path.string() << ": no ParamType\n";
+        return false;
+    }
+
+    for (pugi::xml_node node : root.child("Fields").children("Field")) {
+        Field field;
+        if (!ParseDef(node.attribute("Def").value(), field)) {
+            std::cerr << "ERROR: " << path.string() << ": bad field def '"
+                      << node.attribute("Def").value() << "'\n";
+            return false;
+        }
+        def.fields.push_back(field);
+    }
+    return true;
+}
+
+// smallest power of two table with room to spare, then the first seed without collisions
+bool FindSeed(const std::vector<Def>& defs, uint32_t& seed, std::vector<int>& slots) {
+    size_t tableSize = 1;
+    while (tableSize < defs.size() * 2) {
+        tableSize *= 2;
+    }
+
+    for (; tableSize <= (1u << 16); tableSize *= 2) {
+        for (seed = 0; seed < 1000000; seed++) {
+            slots.assign(tableSize, -1);
+            bool perfect = true;
+            for (size_t i = 0; i < defs.size() && perfect; i++) {
+                int& slot = slots[Hash(defs[i].paramType, seed) & (tableSize - 1)];
+                perfect = slot < 0;
+                slot = static_cast<int>(i);
+            }
+            if (perfect) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WriteTables(std::ostream& out, const std::vector<Def>& defs, uint32_t seed,
+                 const std::vector<int>& slots) {
+    out << "// generated by tools/paramdef_gen.cpp from modules/BBFormats/ParamDefs, don't edit\n\n"
+           "#include <iterator>\n\n"
+           "#include \"modules/BBFormats/ParamDefs.h\"\n\n"
+           "namespace FileHelper::ParamDefs {\n\n"
+           "namespace {\n\n";
+
+    for (size_t i = 0; i < defs.size(); i++) {
+        out << "// " << defs[i].source << "\n"
+            << "constexpr Column columns" << i << "[] = {\n";
+        for (const Column& column : defs[i].columns) {
+            out << "    {\"" << column.name << "\", DefType::" << TypeName(column.type) << ", "
+                << column.offset << ", " << column.size << ", 0x" << std::hex << column.mask
+                << std::dec << "},\n";
+        }
+        out << "};\n\n";
+    }
+
+    out << "constexpr Layout layouts[] = {\n";
+    for (size_t i = 0; i < defs.size(); i++) {
+        out << "    {\"" << defs[i].paramType << "\", " << defs[i].rowSize << ", columns" << i
+            << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr uint32_t seed = " << seed << ";\n\n"
+        << "constexpr int16_t slots[] = {";
+    for (size_t i = 0; i < slots.size(); i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << slots[i] << ",";
+    }
+    out << "\n};\n\n";
+
+    out << "constexpr uint32_t Slot(std::string_view paramType) {\n"
+           "    return Hash(paramType, seed) & (std::size(slots) - 1);\n"
+           "}\n\n"
+           "static_assert([] {\n"
+           "    for (size_t i = 0; i < std::size(layouts); i++) {\n"
+           "        if (slots[Slot(layouts[i].paramType)] != static_cast<int16_t>(i)) {\n"
+           "            return false;\n"
+           "        }\n"
+           "    }\n"
+           "    return true;\n"
+           "}());\n\n"
+           "} // namespace\n\n"
+           "const Layout* Find(std::string_view paramType) {\n"
+           "    const int16_t slot = slots[Slot(paramType)];\n"
+           "    if (slot < 0 || layouts[slot].paramType != paramType) {\n"
+           "        return nullptr;\n"
+           "    }\n"
+           "    return &layouts[slot];\n"
+           "}\n\n"
+           "} // namespace FileHelper::ParamDefs\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: paramdef-gen <output.cpp> <paramdef.xml> [<paramdef.xml>...]\n";
+        return 1;
+    }
+
+    std::vector<Def> defs;
+    for (int i = 2; i < argc; i++) {
+        Def def;
+        if (!LoadDef(argv[i], def)) {
+            return 1;
+        }
+
+        for (const Def& loaded : defs) {
+            if (loaded.paramType == def.paramType) {
+                std::cerr << "ERROR: " << def.paramType << " is defined by both "
+                          << loaded.source << " and " << def.source << "\n";
+                return 1;
+            }
+        }
+        defs.push_back(std::move(def));
+    }
+
+    // sorted so the output doesn't depend on the glob order
+    std::sort(defs.begin(), defs.end(),
+              [](const Def& a, const Def& b) { return a.paramType < b.paramType; });
+    // columns view the field names, so they're packed once the defs stopped moving
+    for (Def& def : defs) {
+        PackColumns(def);
+    }
+
+    uint32_t seed = 0;
+    std::vector<int> slots;
+    if (!FindSeed(defs, seed, slots)) {
+        std::cerr << "ERROR: no collision free seed for the param types\n";
+        return 1;
+    }
+
+    const fs::path output = argv[1];
+    std::error_code ec;
+    fs::create_directories(output.parent_path(), ec);
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    WriteTables(file, defs, seed, slots);
+    if (!file) {
+        std::cerr << "ERROR: could not write " << output.string() << "\n";
+        return 1;
+    }
+    return 0;
+}